@@ -33,6 +33,14 @@ struct SearchDest :
     };
     virtual void searchRequest ( epicsGuard < epicsMutex > &,
         const char * pbuf, size_t len ) = 0;
+    // send several search frames, by default one at a time
+    virtual void searchRequestBatch ( epicsGuard < epicsMutex > & guard,
+        const char * const * ppBuf, const size_t * pLen, unsigned nFrames )
+    {
+        for ( unsigned i = 0u; i < nFrames; i++ ) {
+            this->searchRequest ( guard, ppBuf[i], pLen[i] );
+        }
+    }
     virtual void show ( epicsGuard < epicsMutex > &, unsigned level ) const = 0;
 };
 
@@ -388,10 +388,15 @@ int epicsStdCall ca_clear_channel ( chid pChan )
         // o user doesnt periodically call a ca function
         // o user calls this function from an auxiliary thread
         //
-        CallbackGuard cbGuard ( cac.cbMutex );
-        epicsGuard < epicsMutex > guard ( cac.mutex );
-        pChan->destructor ( *cac.pCallbackGuard.get(), guard );
-        cac.oldChannelNotifyFreeList.release ( pChan );
+        {
+            cac.dispatchedCallbackLockWait ( true );
+            CallbackGuard cbGuard ( cac.cbMutex );
+            cac.dispatchedCallbackLockWait ( false );
+            epicsGuard < epicsMutex > guard ( cac.mutex );
+            pChan->destructor ( *cac.pCallbackGuard.get(), guard );
+            cac.oldChannelNotifyFreeList.release ( pChan );
+        }
+        cac.waitForDispatchedCallbacks ( pChan );
     }
     return ECA_NORMAL;
 }
@@ -690,6 +695,34 @@ unsigned epicsStdCall ca_beacon_anomaly_count ()
     return pcac->beaconAnomaliesSinceProgramStart ();
 }
 
+// extern "C"
+int epicsStdCall ca_connect_statistics ( ca_connect_stats * pStats )
+{
+    ca_client_context * pcac;
+    int caStatus = fetchClientContext ( & pcac );
+    if ( caStatus != ECA_NORMAL ) {
+        return caStatus;
+    }
+
+    if ( ! pcac->connectStatistics ( *pStats ) ) {
+        return ECA_UNAVAILINSERV;
+    }
+    return ECA_NORMAL;
+}
+
+// extern "C"
+int epicsStdCall ca_connect_statistics_reset ()
+{
+    ca_client_context * pcac;
+    int caStatus = fetchClientContext ( & pcac );
+    if ( caStatus != ECA_NORMAL ) {
+        return caStatus;
+    }
+
+    pcac->connectStatisticsReset ();
+    return ECA_NORMAL;
+}
+
 // extern "C"
 int epicsStdCall ca_channel_status ( epicsThreadId /* tid */ )
 {
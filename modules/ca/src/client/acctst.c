@@ -34,6 +34,8 @@
 #include "epicsMutex.h"
 #include "epicsEvent.h"
 #include "epicsTime.h"
+#include "epicsThread.h"
+#include "epicsString.h"
 #include "dbDefs.h"
 #include "envDefs.h"
 #include "caDiagnostics.h"
@@ -3396,6 +3398,356 @@ void verifyContextRundownChanStillExist (
     showProgressEnd ( interestLevel );
 }
 
+static unsigned long connectHistogramTotal ( const ca_connect_histogram * pHist )
+{
+    unsigned long total = 0u;
+    unsigned i;
+
+    for ( i = 0u; i < CA_CONNECT_STATS_BINS; i++ ) {
+        total += pHist->bin[i];
+    }
+    verify ( total == pHist->count );
+    verify ( pHist->count == 0u || pHist->max * pHist->count >= pHist->sum );
+    return total;
+}
+
+/*
+ * connect one channel in a private context and check the statistics
+ * that it kept, returns false if the context keeps none
+ */
+static int connectWithStatistics ( const char * pName, ca_connect_stats * pStats )
+{
+    unsigned long total;
+    chid chan;
+    int status;
+    unsigned i;
+
+    status = ca_context_create ( ca_disable_preemptive_callback );
+    SEVCHK ( status, "context create failed" );
+
+    status = ca_create_channel ( pName, 0, 0, 0, & chan );
+    SEVCHK ( status, NULL );
+    status = ca_pend_io ( timeoutToPendIO );
+    SEVCHK ( status, "channel connect failed" );
+
+    status = ca_connect_statistics ( pStats );
+    if ( status == ECA_UNAVAILINSERV ) {
+        ca_context_destroy ();
+        return 0;
+    }
+    SEVCHK ( status, "connect statistics failed" );
+
+    verify ( pStats->connects == 1u );
+    verify ( pStats->searchReplies + pStats->nameCacheClaims == 1u );
+    verify ( connectHistogramTotal ( & pStats->searchToReply ) ==
+        pStats->searchReplies );
+    verify ( connectHistogramTotal ( & pStats->replyToCreate ) == 1u );
+    verify ( connectHistogramTotal ( & pStats->createToConnect ) == 1u );
+
+    total = 0u;
+    for ( i = 0u; i < CA_CONNECT_STATS_TRIES; i++ ) {
+        total += pStats->searchTries[i];
+    }
+    verify ( total == pStats->searchReplies );
+    total = 0u;
+    for ( i = 0u; i < CA_CONNECT_STATS_STAGES; i++ ) {
+        total += pStats->timerStage[i];
+    }
+    verify ( total == pStats->searchReplies );
+
+    status = ca_connect_statistics_reset ();
+    SEVCHK ( status, "connect statistics reset failed" );
+    {
+        ca_connect_stats cleared;
+        status = ca_connect_statistics ( & cleared );
+        SEVCHK ( status, "connect statistics failed" );
+        verify ( cleared.connects == 0u );
+        verify ( cleared.searchReplies == 0u );
+        verify ( cleared.nameCacheClaims == 0u );
+        verify ( cleared.searchToReply.count == 0u );
+        verify ( connectHistogramTotal ( & cleared.createToConnect ) == 0u );
+    }
+
+    status = ca_clear_channel ( chan );
+    SEVCHK ( status, NULL );
+    ca_context_destroy ();
+    return 1;
+}
+
+void verifyConnectStatistics ( const char * pName, unsigned interestLevel )
+{
+    ca_connect_stats stats;
+
+    showProgressBegin ( "verifyConnectStatistics", interestLevel );
+    if ( ! connectWithStatistics ( pName, & stats ) ) {
+        printf ( "skipped - no statistics for local channels\n" );
+    }
+    showProgressEnd ( interestLevel );
+}
+
+/*
+ * A channel is found by searching, then claimed from the name cache
+ * by the next context, and searched for again once its entry expires.
+ */
+void verifyNameCache ( const char * pName, unsigned interestLevel )
+{
+#if defined ( __unix__ ) || defined ( __APPLE__ )
+    static const char * pCacheFile = "acctst.nameCache";
+    const char * pOldCache = getenv ( "EPICS_CA_NAME_CACHE" );
+    const char * pOldTTL = getenv ( "EPICS_CA_NAME_CACHE_TTL" );
+    char * pSavedCache = pOldCache ? epicsStrDup ( pOldCache ) : 0;
+    char * pSavedTTL = pOldTTL ? epicsStrDup ( pOldTTL ) : 0;
+    ca_connect_stats stats;
+
+    showProgressBegin ( "verifyNameCache", interestLevel );
+
+    remove ( pCacheFile );
+    epicsEnvSet ( "EPICS_CA_NAME_CACHE", pCacheFile );
+    epicsEnvSet ( "EPICS_CA_NAME_CACHE_TTL", "2" );
+
+    if ( connectWithStatistics ( pName, & stats ) ) {
+        /* empty cache, found by search */
+        verify ( stats.searchReplies == 1u );
+        verify ( stats.nameCacheClaims == 0u );
+        showProgress ( interestLevel );
+
+        /* cache hit, claimed without a search */
+        verify ( connectWithStatistics ( pName, & stats ) );
+        verify ( stats.searchReplies == 0u );
+        verify ( stats.nameCacheClaims == 1u );
+        verify ( stats.searchToReply.count == 0u );
+        showProgress ( interestLevel );
+
+        /* the entry expires, the name is searched for again */
+        epicsThreadSleep ( 3.5 );
+        verify ( connectWithStatistics ( pName, & stats ) );
+        verify ( stats.searchReplies == 1u );
+        verify ( stats.nameCacheClaims == 0u );
+    }
+    else {
+        printf ( "skipped - no name cache for local channels\n" );
+    }
+
+    if ( pSavedCache ) {
+        epicsEnvSet ( "EPICS_CA_NAME_CACHE", pSavedCache );
+        free ( pSavedCache );
+    }
+    else {
+        epicsEnvUnset ( "EPICS_CA_NAME_CACHE" );
+    }
+    if ( pSavedTTL ) {
+        epicsEnvSet ( "EPICS_CA_NAME_CACHE_TTL", pSavedTTL );
+        free ( pSavedTTL );
+    }
+    else {
+        epicsEnvUnset ( "EPICS_CA_NAME_CACHE_TTL" );
+    }
+    remove ( pCacheFile );
+
+    showProgressEnd ( interestLevel );
+#endif
+}
+
+typedef struct bufferedSubscrTest {
+    const dbr_double_t * pRetained;
+    dbr_double_t retainedValue;
+    dbr_double_t lastValue;
+    unsigned count;
+} bufferedSubscrTest;
+
+static void bufferedSubscrUpdate ( struct event_handler_args args )
+{
+    bufferedSubscrTest * pBST = ( bufferedSubscrTest * ) args.usr;
+    const dbr_double_t * pValue = ( const dbr_double_t * ) args.dbr;
+
+    if ( args.status != ECA_NORMAL ) {
+        return;
+    }
+    /* keep the first update, holding two references to it */
+    if ( ! pBST->pRetained ) {
+        ca_buffer_retain ( args.dbr );
+        ca_buffer_retain ( args.dbr );
+        pBST->pRetained = pValue;
+        pBST->retainedValue = *pValue;
+    }
+    pBST->lastValue = *pValue;
+    pBST->count++;
+}
+
+/*
+ * A retained update keeps its value while later updates arrive, after
+ * one of its references is released, and after its context is gone.
+ */
+void verifyBufferedSubscription ( const char * pName, unsigned interestLevel )
+{
+    bufferedSubscrTest test;
+    dbr_double_t value;
+    chid chan;
+    int status;
+    unsigned i, j;
+
+    showProgressBegin ( "verifyBufferedSubscription", interestLevel );
+
+    memset ( & test, 0, sizeof ( test ) );
+
+    status = ca_context_create ( ca_disable_preemptive_callback );
+    SEVCHK ( status, "context create failed" );
+
+    status = ca_create_channel ( pName, 0, 0, 0, & chan );
+    SEVCHK ( status, NULL );
+    status = ca_pend_io ( timeoutToPendIO );
+    SEVCHK ( status, "channel connect failed" );
+
+    status = ca_create_buffered_subscription ( DBR_DOUBLE, 1, chan,
+        DBE_VALUE, bufferedSubscrUpdate, & test, 0 );
+    SEVCHK ( status, "buffered subscription create failed" );
+
+    for ( i = 0; ! test.pRetained; i++ ) {
+        ca_pend_event ( 0.01 );
+        verify ( i < 1000 );
+    }
+
+    value = test.retainedValue;
+    for ( j = 0; j < 10; j++ ) {
+        value += 10.0;
+        status = ca_put ( DBR_DOUBLE, chan, & value );
+        SEVCHK ( status, "put failed" );
+        for ( i = 0; test.lastValue != value; i++ ) {
+            ca_pend_event ( 0.01 );
+            verify ( i < 1000 );
+        }
+    }
+    verify ( test.count > 10u );
+    verify ( *test.pRetained == test.retainedValue );
+    showProgress ( interestLevel );
+
+    ca_buffer_release ( test.pRetained );
+    verify ( *test.pRetained == test.retainedValue );
+
+    status = ca_clear_channel ( chan );
+    SEVCHK ( status, NULL );
+    ca_context_destroy ();
+
+    verify ( *test.pRetained == test.retainedValue );
+    ca_buffer_release ( test.pRetained );
+
+    showProgressEnd ( interestLevel );
+}
+
+typedef struct dispatchClearChan {
+    chid chan;
+    struct dispatchClearChan * pTarget; /* channel this one's callback clears */
+    int alive;              /* cleared once the target's clear returned */
+    int cleared;
+    unsigned lateReads;     /* callbacks that saw alive cleared */
+} dispatchClearChan;
+
+static void dispatchClearUpdate ( struct event_handler_args args )
+{
+    dispatchClearChan * pDC = ( dispatchClearChan * ) args.usr;
+    dispatchClearChan * pTarget = pDC->pTarget;
+
+    if ( ! pDC->alive ) {
+        pDC->lateReads++;
+    }
+    if ( pTarget && ! pTarget->cleared ) {
+        int status;
+        epicsThreadSleep ( 0.005 );
+        status = ca_clear_channel ( pTarget->chan );
+        SEVCHK ( status, "clear channel in dispatched callback" );
+        /*
+         * as if the user data were freed, any callback for the target
+         * still running must have returned by now
+         */
+        pTarget->alive = 0;
+        pTarget->cleared = 1;
+    }
+    else {
+        epicsThreadSleep ( 0.02 );
+    }
+    if ( ! pDC->alive ) {
+        pDC->lateReads++;
+    }
+}
+
+/*
+ * Channels are cleared from subscription callbacks run by several
+ * callback threads. Each clear must wait for a callback running for
+ * the cleared channel on another thread, and callbacks that clear
+ * each other's channels must not deadlock.
+ */
+void clearChannelInDispatchedCallbackTest ( const char * pName,
+                                            unsigned interestLevel )
+{
+    static const unsigned nPairs = 16u;
+    dispatchClearChan chans[2 * 16];
+    const char * pOldThreads = getenv ( "EPICS_CA_CALLBACK_THREADS" );
+    char * pSavedThreads = pOldThreads ? epicsStrDup ( pOldThreads ) : 0;
+    unsigned i, j;
+    int status;
+
+    showProgressBegin ( "clearChannelInDispatchedCallbackTest", interestLevel );
+
+    epicsEnvSet ( "EPICS_CA_CALLBACK_THREADS", "4" );
+    status = ca_context_create ( ca_enable_preemptive_callback );
+    SEVCHK ( status, "context create failed" );
+
+    memset ( chans, 0, sizeof ( chans ) );
+    for ( i = 0u; i < 2 * nPairs; i++ ) {
+        chans[i].alive = 1;
+        status = ca_create_channel ( pName, 0, 0, 0, & chans[i].chan );
+        SEVCHK ( status, NULL );
+    }
+    /* the first pairs clear one way, the rest clear each other */
+    for ( i = 0u; i < nPairs; i++ ) {
+        chans[2 * i].pTarget = & chans[2 * i + 1];
+        if ( i >= nPairs / 2u ) {
+            chans[2 * i + 1].pTarget = & chans[2 * i];
+        }
+    }
+    status = ca_pend_io ( timeoutToPendIO );
+    SEVCHK ( status, "channel connect failed" );
+
+    for ( i = 0u; i < 2 * nPairs; i++ ) {
+        status = ca_create_subscription ( DBR_DOUBLE, 1, chans[i].chan,
+            DBE_VALUE, dispatchClearUpdate, & chans[i], 0 );
+        SEVCHK ( status, "subscription create failed" );
+    }
+    status = ca_flush_io ();
+    SEVCHK ( status, NULL );
+
+    for ( i = 0u; i < nPairs; i++ ) {
+        for ( j = 0u; ! chans[2 * i].cleared &&
+                ! chans[2 * i + 1].cleared; j++ ) {
+            epicsThreadSleep ( 0.01 );
+            verify ( j < 1000u );
+        }
+    }
+    /* callbacks may still be returning from the mutual clears */
+    epicsThreadSleep ( 0.1 );
+
+    for ( i = 0u; i < nPairs / 2u; i++ ) {
+        verify ( chans[2 * i + 1].lateReads == 0u );
+    }
+    for ( i = 0u; i < 2 * nPairs; i++ ) {
+        if ( ! chans[i].cleared ) {
+            status = ca_clear_channel ( chans[i].chan );
+            SEVCHK ( status, NULL );
+        }
+    }
+    ca_context_destroy ();
+
+    if ( pSavedThreads ) {
+        epicsEnvSet ( "EPICS_CA_CALLBACK_THREADS", pSavedThreads );
+        free ( pSavedThreads );
+    }
+    else {
+        epicsEnvUnset ( "EPICS_CA_CALLBACK_THREADS" );
+    }
+
+    showProgressEnd ( interestLevel );
+}
+
 int acctst ( const char * pName, unsigned interestLevel, unsigned channelCount,
             unsigned repetitionCount, enum ca_preemptive_callback_select select )
 {
@@ -3543,6 +3895,10 @@ int acctst ( const char * pName, unsigned interestLevel, unsigned channelCount,
 
     verifyContextRundownFlush ( pName, interestLevel );
     verifyContextRundownChanStillExist ( pName, interestLevel );
+    verifyConnectStatistics ( pName, interestLevel );
+    verifyNameCache ( pName, interestLevel );
+    verifyBufferedSubscription ( pName, interestLevel );
+    clearChannelInDispatchedCallbackTest ( pName, interestLevel );
 
     free ( pChans );
 
@@ -0,0 +1,96 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <stdio.h>
+
+#include "beaconAnomalyTimer.h"
+
+static const double beaconAnomalyMaxDelay = 1.0; // sec
+
+beaconAnomalyTimer::beaconAnomalyTimer (
+    beaconAnomalyTimerNotify & iiuIn,
+    epicsTimerQueue & queueIn,
+    epicsMutex & mutexIn ) :
+        mutex ( mutexIn ), timer ( queueIn.createTimer () ),
+    iiu ( iiuIn ), nCoalesced ( 0u ), nBoosts ( 0u ), randomState ( 0u ),
+    pending ( false ), shutdownCmd ( false )
+{
+    // clients started together must not pick the same delays
+    epicsTimeStamp now;
+    epicsTimeGetCurrent ( & now );
+    this->randomState = now.nsec ^ ( now.secPastEpoch << 16u ) ^
+        static_cast < unsigned > ( reinterpret_cast < size_t > ( this ) );
+    if ( this->randomState == 0u ) {
+        this->randomState = 1u;
+    }
+}
+
+beaconAnomalyTimer::~beaconAnomalyTimer ()
+{
+    this->timer.destroy ();
+}
+
+// xorshift, uniform in [0, beaconAnomalyMaxDelay)
+double beaconAnomalyTimer::randomDelay ()
+{
+    unsigned x = this->randomState;
+    x ^= x << 13u;
+    x ^= x >> 17u;
+    x ^= x << 5u;
+    this->randomState = x;
+    return beaconAnomalyMaxDelay * ( x & 0xffffffu ) / 0x1000000;
+}
+
+void beaconAnomalyTimer::anomalyNotify (
+    epicsGuard < epicsMutex > & guard )
+{
+    guard.assertIdenticalMutex ( this->mutex );
+    if ( this->pending ) {
+        this->nCoalesced++;
+    }
+    else if ( ! this->shutdownCmd ) {
+        this->pending = true;
+        this->timer.start ( *this, this->randomDelay () );
+    }
+}
+
+void beaconAnomalyTimer::shutdown (
+    epicsGuard < epicsMutex > & cbGuard,
+    epicsGuard < epicsMutex > & guard )
+{
+    this->shutdownCmd = true;
+    {
+        epicsGuardRelease < epicsMutex > unguard ( guard );
+        {
+            epicsGuardRelease < epicsMutex > cbUnguard ( cbGuard );
+            this->timer.cancel ();
+        }
+    }
+    this->pending = false;
+}
+
+epicsTimerNotify::expireStatus beaconAnomalyTimer::expire (
+    const epicsTime & /* currentTime */ )
+{
+    epicsGuard < epicsMutex > guard ( this->mutex );
+    this->pending = false;
+    if ( ! this->shutdownCmd ) {
+        this->nBoosts++;
+        this->iiu.beaconAnomalyBoost ( guard );
+    }
+    return noRestart;
+}
+
+void beaconAnomalyTimer::show (
+    epicsGuard < epicsMutex > & guard, unsigned /* level */ ) const
+{
+    guard.assertIdenticalMutex ( this->mutex );
+    ::printf ( "beacon anomaly timer: %lu search boosts, %lu more "
+        "requests folded into a pending boost%s\n", this->nBoosts, this->nCoalesced,
+        this->pending ? ", boost pending" : "" );
+}
+
+beaconAnomalyTimerNotify::~beaconAnomalyTimerNotify () {}
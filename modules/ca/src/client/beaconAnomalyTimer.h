@@ -0,0 +1,54 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+//
+// Delays the search boost that follows a beacon anomaly by a random
+// fraction of a second. When many servers restart together every client
+// on the subnet sees their anomalies at the same moment, so the delay
+// spreads out the searches that the clients send in reply. Anomalies
+// seen while a boost is pending are folded into that boost.
+//
+
+#ifndef INC_beaconAnomalyTimer_H
+#define INC_beaconAnomalyTimer_H
+
+#include "epicsMutex.h"
+#include "epicsGuard.h"
+#include "epicsTimer.h"
+
+class beaconAnomalyTimerNotify {
+public:
+    virtual ~beaconAnomalyTimerNotify () = 0;
+    virtual void beaconAnomalyBoost (
+        epicsGuard < epicsMutex > & ) = 0;
+};
+
+class beaconAnomalyTimer : private epicsTimerNotify {
+public:
+    beaconAnomalyTimer (
+        class beaconAnomalyTimerNotify &, epicsTimerQueue &, epicsMutex & );
+    virtual ~beaconAnomalyTimer ();
+    void anomalyNotify ( epicsGuard < epicsMutex > & );
+    void shutdown (
+        epicsGuard < epicsMutex > & cbGuard,
+        epicsGuard < epicsMutex > & guard );
+    void show ( epicsGuard < epicsMutex > &, unsigned level ) const;
+private:
+    epicsMutex & mutex;
+    epicsTimer & timer;
+    class beaconAnomalyTimerNotify & iiu;
+    unsigned long nCoalesced;
+    unsigned long nBoosts;
+    unsigned randomState;
+    bool pending;
+    bool shutdownCmd;
+    double randomDelay ();
+    epicsTimerNotify::expireStatus expire ( const epicsTime & currentTime );
+    beaconAnomalyTimer ( const beaconAnomalyTimer & );
+    beaconAnomalyTimer & operator = ( const beaconAnomalyTimer & );
+};
+
+#endif // ifdef INC_beaconAnomalyTimer_H
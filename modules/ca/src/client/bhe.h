@@ -43,6 +43,15 @@ public:
     virtual void release ( void * ) = 0;
 };
 
+// a beacon received by the datagram circuit and waiting, with the
+// others that arrived in the same burst, for cac::beaconNotify ()
+struct beaconInfo {
+    ca_uint32_t addr; // network byte order
+    ca_uint32_t beaconNumber;
+    ca_uint16_t port; // network byte order
+    ca_uint16_t protocolRevision;
+};
+
 class bhe : public tsSLNode < bhe >, public inetAddrID {
 public:
     LIBCA_API bhe (
@@ -0,0 +1,344 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#if defined ( __unix__ ) || defined ( __APPLE__ )
+#   include <unistd.h>
+#   include <fcntl.h>
+#   include <sys/file.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   define CA_NAME_CACHE_MMAP
+#endif
+
+#include "epicsString.h"
+#include "epicsAtomic.h"
+#include "epicsTime.h"
+#include "errlog.h"
+
+#include "caNameCache.h"
+
+//
+// The file holds a header and a fixed size hash table of entries. An
+// entry is found by probing a few slots after the hash of its name.
+// Processes update the table without locking, so every entry carries
+// a checksum which is cleared while it is being written; a reader
+// that sees a bad checksum treats the entry as absent.
+//
+struct caNameCacheHeader {
+    char magic[8];
+    epicsUInt32 version;
+    epicsUInt32 nEntries;
+    epicsUInt32 entrySize;
+    epicsUInt32 spare[11];
+};
+
+struct caNameCacheEntry {
+    int check;                  // zero if unused or being written
+    epicsUInt32 expires;        // seconds past the EPICS epoch
+    epicsUInt32 addr;           // network byte order
+    epicsUInt16 port;           // network byte order
+    epicsUInt16 minorVersion;
+    char name[112];
+};
+
+static const char cacheMagic[8] = "CANAMES";
+static const epicsUInt32 cacheVersion = 1u;
+static const unsigned cacheEntries = 32768u; // a power of two
+static const unsigned maxProbe = 8u;
+
+// the string hash leaves the low bits poorly mixed for similar names
+static unsigned nameHash ( const char * pName, size_t nameLen )
+{
+    unsigned hash = epicsMemHash ( pName, nameLen, 0u );
+    hash ^= hash >> 16;
+    hash *= 0x45d9f3bu;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+static int entryCheck ( const caNameCacheEntry & entry )
+{
+    const size_t offset = offsetof ( caNameCacheEntry, expires );
+    unsigned hash = epicsMemHash (
+        reinterpret_cast < const char * > ( & entry ) + offset,
+        sizeof ( entry ) - offset, 0u );
+    return static_cast < int > ( hash | 1u );
+}
+
+// copy an entry out of the shared table, true if it is valid
+static bool entryRead ( const caNameCacheEntry & shared,
+    caNameCacheEntry & copy )
+{
+    int check = epicsAtomicGetIntT ( & shared.check );
+    if ( check == 0 ) {
+        return false;
+    }
+    memcpy ( & copy, & shared, sizeof ( copy ) );
+    return entryCheck ( copy ) == check &&
+        epicsAtomicGetIntT ( & shared.check ) == check;
+}
+
+static epicsUInt32 secondsNow ()
+{
+    epicsTimeStamp now;
+    if ( epicsTimeGetCurrent ( & now ) != epicsTimeOK ) {
+        return 0u;
+    }
+    return now.secPastEpoch;
+}
+
+caNameCache::caNameCache ( const char * pPathIn, void * pMap,
+        size_t mapSizeIn, unsigned nEntries, double timeToLiveIn,
+        bool readOnlyIn ) :
+    pHeader ( static_cast < caNameCacheHeader * > ( pMap ) ),
+    pEntries ( reinterpret_cast < caNameCacheEntry * > (
+        static_cast < caNameCacheHeader * > ( pMap ) + 1 ) ),
+    mapSize ( mapSizeIn ), entryMask ( nEntries - 1u ),
+    timeToLive ( static_cast < epicsUInt32 > ( timeToLiveIn ) ),
+    nHits ( 0u ), nMisses ( 0u ), nInserts ( 0u ), nRemoves ( 0u ),
+    readOnly ( readOnlyIn ), pPath ( epicsStrDup ( pPathIn ) )
+{
+}
+
+#ifdef CA_NAME_CACHE_MMAP
+
+static bool headerOk ( const caNameCacheHeader & header )
+{
+    return memcmp ( header.magic, cacheMagic, sizeof ( cacheMagic ) ) == 0 &&
+        header.version == cacheVersion &&
+        header.nEntries == cacheEntries &&
+        header.entrySize == sizeof ( caNameCacheEntry );
+}
+
+caNameCache * caNameCache::create ( const char * pPath, double timeToLive )
+{
+    const size_t mapSize = sizeof ( caNameCacheHeader ) +
+        cacheEntries * sizeof ( caNameCacheEntry );
+    int flags = 0;
+#   ifdef O_CLOEXEC
+        flags |= O_CLOEXEC;
+#   endif
+
+    bool readOnly = false;
+    int fd = open ( pPath, O_RDWR | O_CREAT | flags, 0666 );
+    if ( fd < 0 && ( errno == EACCES || errno == EROFS ) ) {
+        readOnly = true;
+        fd = open ( pPath, O_RDONLY | flags );
+    }
+    if ( fd < 0 ) {
+        errlogPrintf ( "CAC: unable to open name cache \"%s\" because \"%s\"\n",
+            pPath, strerror ( errno ) );
+        return 0;
+    }
+
+    caNameCacheHeader header;
+    struct stat st;
+    bool valid = fstat ( fd, & st ) == 0 &&
+        static_cast < size_t > ( st.st_size ) == mapSize &&
+        pread ( fd, & header, sizeof ( header ), 0 ) == sizeof ( header ) &&
+        headerOk ( header );
+    if ( ! valid && ! readOnly ) {
+        // initialize a new or incompatible file, but only once
+        flock ( fd, LOCK_EX );
+        valid = fstat ( fd, & st ) == 0 &&
+            static_cast < size_t > ( st.st_size ) == mapSize &&
+            pread ( fd, & header, sizeof ( header ), 0 ) == sizeof ( header ) &&
+            headerOk ( header );
+        if ( ! valid ) {
+            memset ( & header, 0, sizeof ( header ) );
+            memcpy ( header.magic, cacheMagic, sizeof ( cacheMagic ) );
+            header.version = cacheVersion;
+            header.nEntries = cacheEntries;
+            header.entrySize = sizeof ( caNameCacheEntry );
+            valid = ftruncate ( fd, 0 ) == 0 &&
+                ftruncate ( fd, static_cast < off_t > ( mapSize ) ) == 0 &&
+                pwrite ( fd, & header, sizeof ( header ), 0 ) == sizeof ( header );
+        }
+        flock ( fd, LOCK_UN );
+    }
+    if ( ! valid ) {
+        errlogPrintf ( "CAC: name cache \"%s\" is unusable\n", pPath );
+        close ( fd );
+        return 0;
+    }
+
+    void * pMap = mmap ( 0, mapSize,
+        readOnly ? PROT_READ : PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+    int mapErrno = errno;
+    close ( fd );
+    if ( pMap == MAP_FAILED ) {
+        errlogPrintf ( "CAC: unable to map name cache \"%s\" because \"%s\"\n",
+            pPath, strerror ( mapErrno ) );
+        return 0;
+    }
+    return new caNameCache ( pPath, pMap, mapSize, cacheEntries,
+        timeToLive, readOnly );
+}
+
+caNameCache::~caNameCache ()
+{
+    munmap ( static_cast < void * > ( this->pHeader ), this->mapSize );
+    free ( this->pPath );
+}
+
+#else /* CA_NAME_CACHE_MMAP */
+
+caNameCache * caNameCache::create ( const char *, double )
+{
+    return 0;
+}
+
+caNameCache::~caNameCache ()
+{
+    free ( this->pPath );
+}
+
+#endif /* CA_NAME_CACHE_MMAP */
+
+//
+// Returns the entry holding the name if there is one. Otherwise, when
+// inserting, returns the probed slot that is unused or expired or,
+// failing that, the one closest to expiring.
+//
+caNameCacheEntry * caNameCache::probe ( const char * pName, size_t nameLen,
+    epicsUInt32 now, bool forInsert )
+{
+    unsigned hash = nameHash ( pName, nameLen );
+    caNameCacheEntry * pVictim = 0;
+    epicsUInt32 victimExpires = 0u;
+    for ( unsigned i = 0u; i < maxProbe; i++ ) {
+        caNameCacheEntry & shared = this->pEntries[ ( hash + i ) & this->entryMask ];
+        caNameCacheEntry copy;
+        if ( entryRead ( shared, copy ) ) {
+            if ( strncmp ( copy.name, pName, sizeof ( copy.name ) ) == 0 ) {
+                return & shared;
+            }
+            if ( copy.expires > now ) {
+                if ( ! pVictim || copy.expires < victimExpires ) {
+                    pVictim = & shared;
+                    victimExpires = copy.expires;
+                }
+                continue;
+            }
+        }
+        // unused, expired, or being written by another process
+        if ( forInsert && ( ! pVictim || victimExpires != 0u ) ) {
+            pVictim = & shared;
+            victimExpires = 0u;
+        }
+    }
+    return forInsert ? pVictim : 0;
+}
+
+bool caNameCache::lookup ( const char * pName,
+    osiSockAddr & addr, unsigned & minorVersion )
+{
+    size_t nameLen = strlen ( pName );
+    if ( nameLen >= sizeof ( this->pEntries->name ) ) {
+        this->nMisses++;
+        return false;
+    }
+    epicsUInt32 now = secondsNow ();
+    caNameCacheEntry * pEntry = this->probe ( pName, nameLen, now, false );
+    caNameCacheEntry copy;
+    if ( ! pEntry || ! entryRead ( *pEntry, copy ) ||
+            strncmp ( copy.name, pName, sizeof ( copy.name ) ) != 0 ||
+            copy.expires <= now ) {
+        this->nMisses++;
+        return false;
+    }
+    memset ( & addr, 0, sizeof ( addr ) );
+    addr.ia.sin_family = AF_INET;
+    addr.ia.sin_addr.s_addr = copy.addr;
+    addr.ia.sin_port = copy.port;
+    minorVersion = copy.minorVersion;
+    this->nHits++;
+    return true;
+}
+
+void caNameCache::insert ( const char * pName,
+    const osiSockAddr & addr, unsigned minorVersion )
+{
+    size_t nameLen = strlen ( pName );
+    if ( this->readOnly || addr.sa.sa_family != AF_INET ||
+            nameLen >= sizeof ( this->pEntries->name ) ) {
+        return;
+    }
+    epicsUInt32 now = secondsNow ();
+    caNameCacheEntry * pEntry = this->probe ( pName, nameLen, now, true );
+    if ( ! pEntry ) {
+        return;
+    }
+    epicsAtomicSetIntT ( & pEntry->check, 0 );
+    pEntry->expires = now + this->timeToLive;
+    pEntry->addr = addr.ia.sin_addr.s_addr;
+    pEntry->port = addr.ia.sin_port;
+    pEntry->minorVersion = static_cast < epicsUInt16 > ( minorVersion );
+    memset ( pEntry->name, '\0', sizeof ( pEntry->name ) );
+    memcpy ( pEntry->name, pName, nameLen );
+    epicsAtomicSetIntT ( & pEntry->check, entryCheck ( *pEntry ) );
+    this->nInserts++;
+}
+
+void caNameCache::remove ( const char * pName )
+{
+    size_t nameLen = strlen ( pName );
+    if ( this->readOnly || nameLen >= sizeof ( this->pEntries->name ) ) {
+        return;
+    }
+    caNameCacheEntry * pEntry = this->probe ( pName, nameLen,
+        secondsNow (), false );
+    if ( pEntry ) {
+        epicsAtomicSetIntT ( & pEntry->check, 0 );
+        this->nRemoves++;
+    }
+}
+
+//
+// Forget every name held by a server that has gone away, so that they
+// are searched for instead of each waiting for its own failed claim.
+//
+void caNameCache::removeServer ( const osiSockAddr & addr )
+{
+    if ( this->readOnly || addr.sa.sa_family != AF_INET ) {
+        return;
+    }
+    for ( unsigned i = 0u; i <= this->entryMask; i++ ) {
+        caNameCacheEntry & shared = this->pEntries[i];
+        if ( epicsAtomicGetIntT ( & shared.check ) != 0 &&
+                shared.addr == addr.ia.sin_addr.s_addr &&
+                shared.port == addr.ia.sin_port ) {
+            epicsAtomicSetIntT ( & shared.check, 0 );
+            this->nRemoves++;
+        }
+    }
+}
+
+void caNameCache::show ( unsigned level ) const
+{
+    ::printf ( "\tCA name cache \"%s\"%s: %lu hits, %lu misses, "
+        "%lu inserts, %lu removals\n",
+        this->pPath, this->readOnly ? " (read only)" : "",
+        this->nHits, this->nMisses, this->nInserts, this->nRemoves );
+    if ( level > 0u ) {
+        epicsUInt32 now = secondsNow ();
+        unsigned nValid = 0u;
+        for ( unsigned i = 0u; i <= this->entryMask; i++ ) {
+            caNameCacheEntry copy;
+            if ( entryRead ( this->pEntries[i], copy ) && copy.expires > now ) {
+                nValid++;
+            }
+        }
+        ::printf ( "\t\t%u of %u entries in use, time to live %u sec\n",
+            nValid, this->entryMask + 1u, this->timeToLive );
+    }
+}
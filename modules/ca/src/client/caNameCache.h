@@ -0,0 +1,56 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+//
+// An optional cache of channel name to server address, kept in a
+// memory mapped file so that all CA client processes on a host can
+// share it. Entries are written when a claim (create channel request)
+// succeeds, and are used to claim a new channel directly from its
+// server without first searching for it. Only available where mmap()
+// is; create() returns 0 elsewhere.
+//
+
+#ifndef INC_caNameCache_H
+#define INC_caNameCache_H
+
+#include "osiSock.h"
+#include "epicsTypes.h"
+
+#include "libCaAPI.h"
+
+struct caNameCacheHeader;
+struct caNameCacheEntry;
+
+class caNameCache {
+public:
+    static caNameCache * create ( const char * pPath, double timeToLive );
+    ~caNameCache ();
+    bool lookup ( const char * pName, osiSockAddr &, unsigned & minorVersion );
+    void insert ( const char * pName, const osiSockAddr &, unsigned minorVersion );
+    void remove ( const char * pName );
+    void removeServer ( const osiSockAddr & );
+    void show ( unsigned level ) const;
+private:
+    caNameCacheHeader * pHeader;
+    caNameCacheEntry * pEntries;
+    size_t mapSize;
+    epicsUInt32 entryMask;
+    epicsUInt32 timeToLive;
+    unsigned long nHits;
+    unsigned long nMisses;
+    unsigned long nInserts;
+    unsigned long nRemoves;
+    bool readOnly;
+    char * pPath;
+    caNameCache ( const char * pPath, void * pMap, size_t mapSize,
+        unsigned nEntries, double timeToLive, bool readOnly );
+    caNameCacheEntry * probe ( const char * pName, size_t nameLen,
+        epicsUInt32 now, bool forInsert );
+    caNameCache ( const caNameCache & );
+    caNameCache & operator = ( const caNameCache & );
+};
+
+#endif // ifndef INC_caNameCache_H
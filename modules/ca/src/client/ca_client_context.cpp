@@ -32,12 +32,15 @@
 #include <stdio.h>
 
 #include "epicsExit.h"
+#include "envDefs.h"
 #include "errlog.h"
 #include "locationException.h"
 
 #include "iocinf.h"
 #include "oldAccess.h"
 #include "cac.h"
+#include "recvBufPool.h"
+#include "callbackDispatcher.h"
 
 epicsThreadPrivateId caClientCallbackThreadId;
 
@@ -62,6 +65,7 @@ ca_client_context::ca_client_context ( bool enablePreemptiveCallback ) :
     mutex(__FILE__, __LINE__),
     cbMutex(__FILE__, __LINE__),
     createdByThread ( epicsThreadGetIdSelf () ),
+    pUpdateBufPool ( 0 ), pDispatcher ( 0 ),
     ca_exception_func ( 0 ), ca_exception_arg ( 0 ),
     pVPrintfFunc ( errlogVprintf ), fdRegFunc ( 0 ), fdRegArg ( 0 ),
     pndRecvCnt ( 0u ), ioSeqNo ( 0u ), callbackThreadsPending ( 0u ),
@@ -160,6 +164,22 @@ ca_client_context::ca_client_context ( bool enablePreemptiveCallback ) :
 
     // multiple steps ensure exception safety
     this->pCallbackGuard = PTRMOVE(pCBGuard);
+
+    long nCallbackThreads = 0;
+    int status = envGetLongConfigParam ( &EPICS_CA_CALLBACK_THREADS,
+        &nCallbackThreads );
+    if ( ! status && nCallbackThreads > 0 ) {
+        if ( enablePreemptiveCallback ) {
+            this->pDispatcher = new callbackDispatcher ( *this,
+                static_cast < unsigned > ( nCallbackThreads ),
+                epicsThreadGetStackSize ( epicsThreadStackBig ),
+                epicsThreadGetPrioritySelf () );
+        }
+        else {
+            errlogPrintf ( "ca_client_context: EPICS_CA_CALLBACK_THREADS "
+                "is ignored unless preemptive callback is enabled\n" );
+        }
+    }
 }
 
 ca_client_context::~ca_client_context ()
@@ -172,6 +192,16 @@ ca_client_context::~ca_client_context ()
 
     osiSockRelease ();
 
+    // subscription updates are no longer queued once this is cleared,
+    // and callbacks in progress complete before the threads exit
+    callbackDispatcher * pDispatcherTmp;
+    {
+        epicsGuard < epicsMutex > guard ( this->mutex );
+        pDispatcherTmp = this->pDispatcher;
+        this->pDispatcher = 0;
+    }
+    delete pDispatcherTmp;
+
     // force a logical shutdown order
     // so that the cac class does not hang its
     // receive threads during their shutdown sequence
@@ -184,6 +214,10 @@ ca_client_context::~ca_client_context ()
     else {
         this->pServiceContext.reset ( 0 );
     }
+
+    if ( this->pUpdateBufPool ) {
+        this->pUpdateBufPool->destroy ();
+    }
 }
 
 void ca_client_context::destroyGetCopy (
@@ -214,10 +248,56 @@ void ca_client_context::destroySubscription (
     epicsGuard < epicsMutex > & guard, oldSubscription & os )
 {
     guard.assertIdenticalMutex ( this->mutex );
+    if ( this->pDispatcher ) {
+        this->pDispatcher->cancel ( & os );
+    }
     os.~oldSubscription ();
     this->subscriptionFreeList.release ( & os );
 }
 
+//
+// Queues a subscription update for one of the callback threads,
+// returning false if the callback must be called by the caller.
+//
+bool ca_client_context::dispatchCallback (
+    epicsGuard < epicsMutex > & guard, const void * pKey,
+    caEventCallBackFunc * pFunc, const struct event_handler_args & args,
+    const void * pBuf )
+{
+    guard.assertIdenticalMutex ( this->mutex );
+    if ( ! this->pDispatcher ) {
+        return false;
+    }
+    this->pDispatcher->post ( pKey, pFunc, args, pBuf );
+    return true;
+}
+
+// wait for subscription callbacks for a cleared channel to complete
+void ca_client_context::waitForDispatchedCallbacks ( const void * pChan )
+{
+    callbackDispatcher * pDispatcherTmp;
+    {
+        epicsGuard < epicsMutex > guard ( this->mutex );
+        pDispatcherTmp = this->pDispatcher;
+    }
+    if ( pDispatcherTmp ) {
+        pDispatcherTmp->waitForChannel ( pChan );
+    }
+}
+
+// marks a callback thread that is about to wait for the callback lock
+void ca_client_context::dispatchedCallbackLockWait ( bool blocking )
+{
+    callbackDispatcher * pDispatcherTmp;
+    {
+        epicsGuard < epicsMutex > guard ( this->mutex );
+        pDispatcherTmp = this->pDispatcher;
+    }
+    if ( pDispatcherTmp ) {
+        pDispatcherTmp->callbackLockWait ( blocking );
+    }
+}
+
 void ca_client_context::changeExceptionEvent (
     caExceptionHandler * pfunc, void * arg )
 {
@@ -428,6 +508,12 @@ void ca_client_context::show ( unsigned level ) const
 
     if ( level > 0u ) {
         this->pServiceContext->show ( guard, level - 1u );
+        if ( this->pUpdateBufPool ) {
+            this->pUpdateBufPool->show ( "subscription update copies", level );
+        }
+        if ( this->pDispatcher ) {
+            this->pDispatcher->show ( level );
+        }
         ::printf ( "\tpreemptive callback is %s\n",
             this->pCallbackGuard.get() ? "disabled" : "enabled" );
         ::printf ( "\tthere are %u unsatisfied IO operations blocking ca_pend_io()\n",
@@ -689,6 +775,44 @@ unsigned ca_client_context::beaconAnomaliesSinceProgramStart () const
     return this->pServiceContext->beaconAnomaliesSinceProgramStart ( guard );
 }
 
+bool ca_client_context::connectStatistics ( ca_connect_stats & stats ) const
+{
+    epicsGuard < epicsMutex > guard ( this->mutex );
+    return this->pServiceContext->connectStatistics ( guard, stats );
+}
+
+void ca_client_context::connectStatisticsReset ()
+{
+    epicsGuard < epicsMutex > guard ( this->mutex );
+    this->pServiceContext->connectStatisticsReset ( guard );
+}
+
+//
+// Returns a reference counted buffer holding a subscription update,
+// which is the buffer it arrived in when the service provides one,
+// and otherwise a copy.
+//
+const void * ca_client_context::retainUpdateBuffer (
+    epicsGuard < epicsMutex > & guard, const void * pData,
+    arrayElementCount nBytes )
+{
+    guard.assertIdenticalMutex ( this->mutex );
+    const void * pBuf =
+        this->pServiceContext->retainUpdateBuffer ( guard, pData );
+    if ( ! pBuf ) {
+        if ( ! this->pUpdateBufPool ) {
+            this->pUpdateBufPool = new recvBufPool ( 64u, 0u );
+        }
+        arrayElementCount capacity;
+        char * pCopy = this->pUpdateBufPool->allocateBuf ( nBytes, capacity );
+        if ( pCopy ) {
+            memcpy ( pCopy, pData, nBytes );
+        }
+        pBuf = pCopy;
+    }
+    return pBuf;
+}
+
 void ca_client_context::installCASG (
     epicsGuard < epicsMutex > & guard, CASG & sg )
 {
@@ -782,9 +906,14 @@ LIBCA_API int epicsStdCall ca_clear_subscription ( evid pMon )
       // o user doesnt periodically call a ca function
       // o user calls this function from an auxiliary thread
       //
-      CallbackGuard cbGuard ( cac.cbMutex );
-      epicsGuard < epicsMutex > guard ( cac.mutex );
-      pMon->cancel ( cbGuard, guard );
+      {
+        cac.dispatchedCallbackLockWait ( true );
+        CallbackGuard cbGuard ( cac.cbMutex );
+        cac.dispatchedCallbackLockWait ( false );
+        epicsGuard < epicsMutex > guard ( cac.mutex );
+        pMon->cancel ( cbGuard, guard );
+      }
+      cac.waitForDispatchedCallbacks ( & chan );
     }
     return ECA_NORMAL;
 }
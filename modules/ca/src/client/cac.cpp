@@ -24,6 +24,7 @@
 #include <new>
 #include <stdexcept>
 #include <string> // vxWorks 6.0 requires this include
+#include <climits>
 
 #include "epicsStdio.h"
 #include "dbDefs.h"
@@ -39,6 +40,8 @@
 #include "addrList.h"
 #include "iocinf.h"
 #include "cac.h"
+#include "tcpRecvEngine.h"
+#include "caNameCache.h"
 #include "inetAddrID.h"
 #include "caServerID.h"
 #include "virtualCircuit.h"
@@ -141,13 +144,18 @@ cac::cac (
     pUserName ( 0 ),
     pudpiiu ( 0 ),
     tcpSmallRecvBufFreeList ( 0 ),
-    tcpLargeRecvBufFreeList ( 0 ),
+    pLargeRecvBufPool ( 0 ),
+    pPooledUpdate ( 0 ),
+    pRecvEngine ( 0 ),
+    pNameCache ( 0 ),
     notify ( notifyIn ),
     initializingThreadsId ( epicsThreadGetIdSelf() ),
     initializingThreadsPriority ( epicsThreadGetPrioritySelf() ),
     maxRecvBytesTCP ( MAX_TCP ),
     maxContigFrames ( contiguousMsgCountWhichTriggersFlowControl ),
     beaconAnomalyCount ( 0u ),
+    beaconCount ( 0u ),
+    beaconBatchCount ( 0u ),
     iiuExistenceCount ( 0u ),
     cacShutdownInProgress ( false )
 {
@@ -224,24 +232,49 @@ cac::cac (
         if(envGetBoolConfigParam(&EPICS_CA_AUTO_ARRAY_BYTES, &autoMaxBytes))
             autoMaxBytes = 1;
 
-        if(!autoMaxBytes) {
-            freeListInitPvt ( &this->tcpLargeRecvBufFreeList, this->maxRecvBytesTCP, 1 );
-            if ( ! this->tcpLargeRecvBufFreeList ) {
-                throw std::bad_alloc ();
-            }
-        }
+        // without automatic array sizing messages larger than
+        // EPICS_CA_MAX_ARRAY_BYTES are ignored
+        this->pLargeRecvBufPool = new recvBufPool ( 2u * MAX_TCP,
+            autoMaxBytes ? 0u : this->maxRecvBytesTCP );
         unsigned bufsPerArray = this->maxRecvBytesTCP / comBuf::capacityBytes ();
         if ( bufsPerArray > 1u ) {
             maxContigFrames = bufsPerArray *
                 contiguousMsgCountWhichTriggersFlowControl;
         }
+
+        long nRecvThreads = 0;
+        status = envGetLongConfigParam ( &EPICS_CA_TCP_RECV_THREADS, &nRecvThreads );
+        if ( ! status && nRecvThreads > 0 ) {
+            this->pRecvEngine = tcpRecvEngine::create ( *this,
+                static_cast < unsigned > ( nRecvThreads ),
+                epicsThreadGetStackSize ( epicsThreadStackBig ),
+                highestPriorityLevelBelow ( this->initializingThreadsPriority ) );
+            if ( ! this->pRecvEngine ) {
+                errlogPrintf ( "cac: EPICS_CA_TCP_RECV_THREADS is not supported "
+                    "on this OS, using a receive thread per circuit\n" );
+            }
+        }
+
+        const char * pCachePath = envGetConfigParamPtr ( &EPICS_CA_NAME_CACHE );
+        if ( pCachePath ) {
+            double timeToLive = 3600.0;
+            status = envGetDoubleConfigParam ( &EPICS_CA_NAME_CACHE_TTL, &timeToLive );
+            if ( status || timeToLive <= 0.0 ) {
+                timeToLive = 3600.0;
+                errlogPrintf ( "EPICS \"%s\" must be a positive number of seconds\n",
+                    EPICS_CA_NAME_CACHE_TTL.name );
+                errlogPrintf ( "Defaulting \"%s\" = %f\n",
+                    EPICS_CA_NAME_CACHE_TTL.name, timeToLive );
+            }
+            this->pNameCache = caNameCache::create ( pCachePath, timeToLive );
+        }
     }
     catch ( ... ) {
         osiSockRelease ();
         delete [] this->pUserName;
         freeListCleanup ( this->tcpSmallRecvBufFreeList );
-        if ( this->tcpLargeRecvBufFreeList ) {
-            freeListCleanup ( this->tcpLargeRecvBufFreeList );
+        if ( this->pLargeRecvBufPool ) {
+            this->pLargeRecvBufPool->destroy ();
         }
         this->timerQueue.release ();
         throw;
@@ -328,10 +361,12 @@ cac::~cac ()
         delete this->pudpiiu;
     }
 
+    // all circuits are gone now
+    delete this->pRecvEngine;
+    delete this->pNameCache;
+
     freeListCleanup ( this->tcpSmallRecvBufFreeList );
-    if ( this->tcpLargeRecvBufFreeList ) {
-        freeListCleanup ( this->tcpLargeRecvBufFreeList );
-    }
+    this->pLargeRecvBufPool->destroy ();
 
     delete [] this->pUserName;
 
@@ -416,9 +451,22 @@ void cac::show (
     // warning message
     ::printf ( "\trevision \"%s\"\n", pVersionCAC );
 
+    if ( this->pRecvEngine ) {
+        this->pRecvEngine->show ( level );
+    }
+
+    if ( this->pNameCache ) {
+        this->pNameCache->show ( level );
+    }
+
     if ( level > 0u ) {
+        this->connStats.show ( level );
+        this->pLargeRecvBufPool->show ( "large message buffers", level );
         this->serverTable.show ( level - 1u );
         ::printf ( "\tconnection time out watchdog period %f\n", this->connTMO );
+        ::printf ( "\t%lu beacons in %lu bursts, %u beacon anomalies\n",
+            this->beaconCount, this->beaconBatchCount,
+            this->beaconAnomalyCount );
     }
 
     if ( level > 1u ) {
@@ -452,9 +500,11 @@ void cac::show (
 
 /*
  *  cac::beaconNotify
+ *
+ *  the beacons that arrived together in one burst
  */
-void cac::beaconNotify ( const inetAddrID & addr, const epicsTime & currentTime,
-                        ca_uint32_t beaconNumber, unsigned protocolRevision  )
+void cac::beaconNotify ( const beaconInfo * pBeacons, unsigned nBeacons,
+                        const epicsTime & currentTime )
 {
     epicsGuard < epicsMutex > guard ( this->mutex );
 
@@ -462,49 +512,67 @@ void cac::beaconNotify ( const inetAddrID & addr, const epicsTime & currentTime,
         return;
     }
 
-    /*
-     * look for it in the hash table
-     */
-    bhe *pBHE = this->beaconTable.lookup ( addr );
-    if ( pBHE ) {
+    this->beaconBatchCount++;
+    unsigned nAnomalies = 0u;
+    bhe *pBHE = 0;
+    for ( unsigned i = 0u; i < nBeacons; i++ ) {
+        const beaconInfo & beacon = pBeacons[i];
+        this->beaconCount++;
+
         /*
-         * return if the beacon period has not changed significantly
+         * look for it in the hash table, unless it is a copy of the
+         * previous beacon that came by another route
          */
-        if ( ! pBHE->updatePeriod ( guard, this->programBeginTime,
-                currentTime, beaconNumber, protocolRevision ) ) {
-            return;
+        if ( ! pBHE || beacon.addr != pBeacons[i-1].addr ||
+                beacon.port != pBeacons[i-1].port ) {
+            struct sockaddr_in ina;
+            memset ( &ina, 0, sizeof ( ina ) );
+            ina.sin_family = AF_INET;
+            ina.sin_addr.s_addr = beacon.addr;
+            ina.sin_port = beacon.port;
+            inetAddrID addr ( ina );
+            pBHE = this->beaconTable.lookup ( addr );
+            if ( ! pBHE ) {
+                /*
+                 * This is the first beacon seen from this server.
+                 * Wait until 2nd beacon is seen before deciding
+                 * if it is a new server (or just the first
+                 * time that we have seen a server's beacon
+                 * shortly after the program started up)
+                 */
+                pBHE = new ( this->bheFreeList )
+                        bhe ( this->mutex, currentTime, beacon.beaconNumber, addr );
+                if ( pBHE ) {
+                    if ( this->beaconTable.add ( *pBHE ) < 0 ) {
+                        pBHE->~bhe ();
+                        this->bheFreeList.release ( pBHE );
+                    }
+                }
+                pBHE = 0;
+                continue;
+            }
         }
-    }
-    else {
+
         /*
-         * This is the first beacon seen from this server.
-         * Wait until 2nd beacon is seen before deciding
-         * if it is a new server (or just the first
-         * time that we have seen a server's beacon
-         * shortly after the program started up)
+         * skip it if the beacon period has not changed significantly
          */
-        pBHE = new ( this->bheFreeList )
-                bhe ( this->mutex, currentTime, beaconNumber, addr );
-        if ( pBHE ) {
-            if ( this->beaconTable.add ( *pBHE ) < 0 ) {
-                pBHE->~bhe ();
-                this->bheFreeList.release ( pBHE );
+        if ( pBHE->updatePeriod ( guard, this->programBeginTime,
+                currentTime, beacon.beaconNumber, beacon.protocolRevision ) ) {
+            nAnomalies++;
+#           ifdef DEBUG
+            {
+                char buf[128];
+                pBHE->name ( buf, sizeof ( buf ) );
+                ::printf ( "New server available: %s\n", buf );
             }
+#           endif
         }
-        return;
     }
 
-    this->beaconAnomalyCount++;
-
-    this->pudpiiu->beaconAnomalyNotify ( guard );
-
-#   ifdef DEBUG
-    {
-        char buf[128];
-        addr.name ( buf, sizeof ( buf ) );
-        ::printf ( "New server available: %s\n", buf );
+    if ( nAnomalies ) {
+        this->beaconAnomalyCount += nAnomalies;
+        this->pudpiiu->beaconAnomalyNotify ( guard );
     }
-#   endif
 }
 
 cacChannel & cac::createChannel (
@@ -650,7 +718,7 @@ void cac::transferChanToVirtCircuit (
         guard, *pChan, currentTime );
     if ( piiu ) {
         piiu->installChannel (
-            guard, *pChan, sid, typeCode, count );
+            guard, *pChan, sid, typeCode, count, true );
 
         if ( newIIU ) {
             piiu->start ( guard );
@@ -965,8 +1033,10 @@ bool cac::eventRespAction ( callbackManager &, tcpiiu &iiu,
                 hdr.m_dataType, pMsgBdy, pMsgBdy, false, hdr.m_count );
         }
         if ( caStatus == ECA_NORMAL ) {
+            this->pPooledUpdate = iiu.pooledMsgBody ();
             pmiu->completion ( guard, *this,
                 hdr.m_dataType, hdr.m_count, pMsgBdy );
+            this->pPooledUpdate = 0;
         }
         else {
             pmiu->exception ( guard, *this, caStatus,
@@ -1135,7 +1205,8 @@ bool cac::accessRightsRespAction (
 
 bool cac::createChannelRespAction (
     callbackManager & mgr, tcpiiu & iiu,
-    const epicsTime &, const caHdrLargeArray & hdr, void * /* pMsgBody */ )
+    const epicsTime & currentTime, const caHdrLargeArray & hdr,
+    void * /* pMsgBody */ )
 {
     epicsGuard < epicsMutex > guard ( this->mutex );
     nciu * pChan = this->chanTable.lookup ( hdr.m_cid );
@@ -1149,6 +1220,14 @@ bool cac::createChannelRespAction (
         }
         bool wasExpected = iiu.connectNotify ( guard, *pChan );
         if ( wasExpected ) {
+            // the claim confirms the server, so remember it
+            pChan->setNameCacheHit ( guard, false );
+            this->connStats.connected (
+                pChan->connectPhaseEnd ( guard, currentTime ) );
+            if ( this->pNameCache && iiu.ca_v44_ok ( guard ) ) {
+                this->pNameCache->insert ( pChan->pName ( guard ),
+                    iiu.getNetworkAddress ( guard ), iiu.minorVersion ( guard ) );
+            }
             pChan->connect ( hdr.m_dataType, hdr.m_count, sidTmp,
                 mgr.cbGuard, guard );
         }
@@ -1186,10 +1265,14 @@ void cac::disconnectChannel (
 {
     guard.assertIdenticalMutex ( this->mutex );
     assert ( this->pudpiiu );
+    // a channel claimed using the name cache was never connected
+    bool wasCacheHit = chan.nameCacheHit ( guard );
     chan.disconnectAllIO ( cbGuard, guard );
     chan.getPIIU(guard)->uninstallChan ( guard, chan );
     this->pudpiiu->installDisconnectedChannel ( guard, chan );
-    chan.unresponsiveCircuitNotify ( cbGuard, guard );
+    if ( ! wasCacheHit ) {
+        chan.unresponsiveCircuitNotify ( cbGuard, guard );
+    }
 }
 
 bool cac::badTCPRespAction ( callbackManager &, tcpiiu & iiu,
@@ -1236,6 +1319,9 @@ void cac::destroyIIU ( tcpiiu & iiu )
             char hostNameTmp[64];
             iiu.getHostName ( guard, hostNameTmp, sizeof ( hostNameTmp ) );
             genLocalExcep ( mgr.cbGuard, guard, *this, ECA_DISCONN, hostNameTmp );
+            if ( this->pNameCache ) {
+                this->pNameCache->removeServer ( iiu.getNetworkAddress ( guard ) );
+            }
         }
         osiSockAddr addr = iiu.getNetworkAddress ( guard );
         if ( addr.sa.sa_family == AF_INET ) {
@@ -1272,6 +1358,35 @@ void cac::destroyIIU ( tcpiiu & iiu )
     // do not touch "this" after lock is released above
 }
 
+bool cac::connectStatistics (
+    epicsGuard < epicsMutex > & guard, ca_connect_stats & stats ) const
+{
+    guard.assertIdenticalMutex ( this->mutex );
+    this->connStats.get ( stats );
+    return true;
+}
+
+void cac::connectStatisticsReset ( epicsGuard < epicsMutex > & guard )
+{
+    guard.assertIdenticalMutex ( this->mutex );
+    this->connStats.reset ();
+}
+
+//
+// Updates of large arrays arrive in a pool buffer that the
+// application may keep, so that it need not copy them.
+//
+const void * cac::retainUpdateBuffer (
+    epicsGuard < epicsMutex > & guard, const void * pData )
+{
+    guard.assertIdenticalMutex ( this->mutex );
+    if ( pData && pData == this->pPooledUpdate ) {
+        recvBufPool::retainBuf ( pData );
+        return pData;
+    }
+    return 0;
+}
+
 double cac::beaconPeriod (
     epicsGuard < epicsMutex > & guard,
     const nciu & chan ) const
@@ -1297,6 +1412,50 @@ void cac::initiateConnect (
     guard.assertIdenticalMutex ( this->mutex );
     assert ( this->pudpiiu );
     this->pudpiiu->installNewChannel ( guard, chan, piiu );
+
+    osiSockAddr addr;
+    unsigned minorVersion;
+    if ( this->pNameCache && ! this->cacShutdownInProgress &&
+            this->pNameCache->lookup ( chan.pName ( guard ), addr, minorVersion ) &&
+            CA_V46 ( minorVersion ) ) {
+        this->connectFromNameCache ( guard, chan, addr, minorVersion );
+    }
+}
+
+//
+// Claim the channel from the server that the name cache says has it,
+// skipping the search. If the server no longer has the channel then
+// it replies with CA_PROTO_CREATE_CH_FAIL, and the channel is searched
+// for as usual; see udpiiu::installDisconnectedChannel.
+//
+void cac::connectFromNameCache (
+    epicsGuard < epicsMutex > & guard, nciu & chan,
+    const osiSockAddr & addr, unsigned minorVersion )
+{
+    caServerID servID ( addr.ia, chan.getPriority ( guard ) );
+    tcpiiu * piiu = this->serverTable.lookup ( servID );
+    chan.connectPhaseBegin ( guard, epicsTime::getCurrent () );
+    bool newIIU = findOrCreateVirtCircuit (
+        guard, addr, chan.getPriority ( guard ), piiu, minorVersion );
+    if ( ! piiu || ! piiu->alive ( guard ) ) {
+        return;
+    }
+    chan.getPIIU ( guard )->uninstallChan ( guard, chan );
+    piiu->installChannel ( guard, chan, UINT_MAX, USHRT_MAX, 0u, false );
+    chan.setNameCacheHit ( guard, true );
+    if ( newIIU ) {
+        piiu->start ( guard );
+    }
+}
+
+void cac::nameCacheRemove (
+    epicsGuard < epicsMutex > & guard, nciu & chan )
+{
+    guard.assertIdenticalMutex ( this->mutex );
+    chan.setNameCacheHit ( guard, false );
+    if ( this->pNameCache ) {
+        this->pNameCache->remove ( chan.pName ( guard ) );
+    }
 }
 
 void *cacComBufMemoryManager::allocate ( size_t size )
@@ -39,11 +39,15 @@
 #include "netIO.h"
 #include "localHostName.h"
 #include "virtualCircuit.h"
+#include "connectStats.h"
+#include "recvBufPool.h"
 
 class netWriteNotifyIO;
 class netReadNotifyIO;
 class netSubscription;
 class tcpiiu;
+class tcpRecvEngine;
+class caNameCache;
 
 // used to control access to cac's recycle routines which
 // should only be indirectly invoked by CAC when its lock
@@ -108,8 +112,8 @@ public:
     virtual ~cac ();
 
     // beacon management
-    void beaconNotify ( const inetAddrID & addr, const epicsTime & currentTime,
-        ca_uint32_t beaconNumber, unsigned protocolRevision );
+    void beaconNotify ( const beaconInfo * pBeacons, unsigned nBeacons,
+        const epicsTime & currentTime );
     unsigned beaconAnomaliesSinceProgramStart (
         epicsGuard < epicsMutex > & ) const;
 
@@ -131,6 +135,8 @@ public:
         epicsGuard < epicsMutex > &, nciu & );
     void initiateConnect (
         epicsGuard < epicsMutex > &, nciu &, netiiu * & );
+    void nameCacheRemove (
+        epicsGuard < epicsMutex > &, nciu & );
     nciu * lookupChannel (
         epicsGuard < epicsMutex > &, const cacChannel::ioid & );
 
@@ -187,6 +193,13 @@ public:
     double connectionTimeout ( epicsGuard < epicsMutex > & );
 
     unsigned maxContiguousFrames ( epicsGuard < epicsMutex > & ) const;
+    connectStats & connectStatsRef ( epicsGuard < epicsMutex > & );
+    bool connectStatistics (
+        epicsGuard < epicsMutex > &, ca_connect_stats & ) const;
+    void connectStatisticsReset ( epicsGuard < epicsMutex > & );
+    const void * retainUpdateBuffer (
+        epicsGuard < epicsMutex > &, const void * pData );
+    tcpRecvEngine * tcpReceiveEngine () const;
 
     // misc
     const char * userNamePointer () const;
@@ -258,13 +271,19 @@ private:
     char * pUserName;
     class udpiiu * pudpiiu;
     void * tcpSmallRecvBufFreeList;
-    void * tcpLargeRecvBufFreeList;
+    recvBufPool * pLargeRecvBufPool;
+    const void * pPooledUpdate; // pool buffer of the update being delivered
+    tcpRecvEngine * pRecvEngine;
+    caNameCache * pNameCache;
+    connectStats connStats;
     cacContextNotify & notify;
     epicsThreadId initializingThreadsId;
     unsigned initializingThreadsPriority;
     unsigned maxRecvBytesTCP;
     unsigned maxContigFrames;
     unsigned beaconAnomalyCount;
+    unsigned long beaconCount;
+    unsigned long beaconBatchCount;
     unsigned short _serverPort;
     unsigned iiuExistenceCount;
     bool cacShutdownInProgress;
@@ -279,6 +298,9 @@ private:
     void disconnectChannel (
         epicsGuard < epicsMutex > & cbGuard,
         epicsGuard < epicsMutex > & guard, nciu & chan );
+    void connectFromNameCache (
+        epicsGuard < epicsMutex > &, nciu &,
+        const osiSockAddr &, unsigned minorVersion );
 
     void ioExceptionNotify ( unsigned id, int status,
         const char * pContext, unsigned type, arrayElementCount count );
@@ -369,6 +391,18 @@ inline int cac :: varArgsPrintFormated (
     return this->notify.varArgsPrintFormated ( pformat, args );
 }
 
+inline connectStats & cac::connectStatsRef (
+    epicsGuard < epicsMutex > & guard )
+{
+    guard.assertIdenticalMutex ( this->mutex );
+    return this->connStats;
+}
+
+inline tcpRecvEngine * cac::tcpReceiveEngine () const
+{
+    return this->pRecvEngine;
+}
+
 inline void cac::attachToClientCtx ()
 {
     this->notify.attachToClientCtx ();
@@ -139,6 +139,23 @@ const char * cacChannel::pHostName (
 
 cacContext::~cacContext () {}
 
+bool cacContext::connectStatistics (
+    epicsGuard < epicsMutex > &, struct ca_connect_stats & ) const
+{
+    return false;
+}
+
+void cacContext::connectStatisticsReset (
+    epicsGuard < epicsMutex > & )
+{
+}
+
+const void * cacContext::retainUpdateBuffer (
+    epicsGuard < epicsMutex > &, const void * )
+{
+    return 0;
+}
+
 cacService::~cacService () {}
 
 
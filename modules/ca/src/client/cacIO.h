@@ -56,6 +56,7 @@
 
 
 class cacChannel;
+struct ca_connect_stats;
 
 typedef unsigned long arrayElementCount;
 
@@ -286,6 +287,17 @@ public:
         epicsGuard < epicsMutex > & ) const = 0;
     virtual void show (
         epicsGuard < epicsMutex > &, unsigned level ) const = 0;
+    // the default is to keep no connect statistics
+    virtual bool connectStatistics (
+        epicsGuard < epicsMutex > &, struct ca_connect_stats & ) const;
+    virtual void connectStatisticsReset (
+        epicsGuard < epicsMutex > & );
+    // While a subscription update is being delivered, returns pData
+    // with an added reference if it is held in a reference counted
+    // buffer (see ca_buffer_retain), and otherwise zero. The default
+    // is zero.
+    virtual const void * retainUpdateBuffer (
+        epicsGuard < epicsMutex > &, const void * pData );
 };
 
 class LIBCA_API cacContextNotify {
@@ -492,6 +492,41 @@ LIBCA_API int epicsStdCall ca_create_subscription
      evid *                 pEventID
 );
 
+/*
+ * ca_create_buffered_subscription ()
+ *
+ * As ca_create_subscription(), except that each value passed to the
+ * callback in args.dbr is held in a reference counted buffer. The
+ * callback may keep the buffer after it returns by calling
+ * ca_buffer_retain(args.dbr), and must then later pass args.dbr to
+ * ca_buffer_release(). Large arrays are delivered in the buffer that
+ * they were received into from the network, already converted to
+ * host byte order, so no copy of the value is made.
+ */
+LIBCA_API int epicsStdCall ca_create_buffered_subscription
+(
+     chtype                 type,
+     unsigned long          count,
+     chid                   chanId,
+     long                   mask,
+     caEventCallBackFunc *  pFunc,
+     void *                 pArg,
+     evid *                 pEventID
+);
+
+/*
+ * ca_buffer_retain()
+ * ca_buffer_release()
+ *
+ * Add and remove a reference to a buffer passed to the callback of a
+ * buffered subscription. These may be called from any thread, and a
+ * buffer may be released after its context has been destroyed.
+ *
+ * pDbr     R   args.dbr as passed to the callback
+ */
+LIBCA_API void epicsStdCall ca_buffer_retain ( const void * pDbr );
+LIBCA_API void epicsStdCall ca_buffer_release ( const void * pDbr );
+
 /************************************************************************/
 /*  Remove a function from a list of those specified to run             */
 /*  whenever significant changes occur to a channel                     */
@@ -836,6 +871,59 @@ LIBCA_API unsigned epicsStdCall ca_search_attempts (chid chan);
 LIBCA_API double epicsStdCall ca_beacon_period (chid chan);
 LIBCA_API double epicsStdCall ca_receive_watchdog_delay (chid chan);
 
+/*
+ * ca_connect_statistics()
+ *
+ * Copies statistics, accumulated since the context was created or last
+ * reset, about how its channels connected. Each connection is split into
+ * three intervals: from the start of the search until a server replies
+ * (search to reply), from the reply until the create channel request is
+ * sent (reply to create), and from that request until the server answers
+ * it (create to connected). A channel claimed using the name cache has no
+ * search interval, and its reply to create interval starts when it was
+ * created.
+ *
+ * Histogram bin 0 counts intervals shorter than 1 mS, bin n counts those
+ * from 2^(n-1) up to 2^n mS, and the last bin also counts all longer ones.
+ *
+ * pStats   W   statistics copied here
+ *
+ * returns ECA_UNAVAILINSERV if the context keeps no statistics
+ */
+#define CA_CONNECT_STATS_BINS 16u
+#define CA_CONNECT_STATS_TRIES 8u
+#define CA_CONNECT_STATS_STAGES 18u
+
+typedef struct ca_connect_histogram {
+    unsigned long count;
+    double sum;             /* seconds */
+    double max;             /* seconds */
+    unsigned long bin[CA_CONNECT_STATS_BINS];
+} ca_connect_histogram;
+
+typedef struct ca_connect_stats {
+    unsigned long searchReplies;    /* channels found by a search */
+    unsigned long nameCacheClaims;  /* channels claimed using the name cache */
+    unsigned long connects;         /* create channel requests answered */
+    unsigned long searchRetries;    /* search requests beyond the first */
+    /* replies by number of search requests sent, the last bin and over */
+    unsigned long searchTries[CA_CONNECT_STATS_TRIES];
+    /* replies by the search timer, slowest last, that the channel was in */
+    unsigned long timerStage[CA_CONNECT_STATS_STAGES];
+    ca_connect_histogram searchToReply;
+    ca_connect_histogram replyToCreate;
+    ca_connect_histogram createToConnect;
+} ca_connect_stats;
+
+LIBCA_API int epicsStdCall ca_connect_statistics (ca_connect_stats *pStats);
+
+/*
+ * ca_connect_statistics_reset()
+ *
+ * clears the statistics returned by ca_connect_statistics()
+ */
+LIBCA_API int epicsStdCall ca_connect_statistics_reset (void);
+
 /*
  * used when an auxiliary thread needs to join a CA client context started
  * by another thread
@@ -0,0 +1,402 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <string>
+
+#include <stdio.h>
+
+#include "iocinf.h"
+#include "oldAccess.h"
+#include "recvBufPool.h"
+#include "callbackDispatcher.h"
+
+// a thread waiting in waitForChannel()
+struct callbackDispatchWaiter : public tsDLNode < callbackDispatchWaiter > {
+    epicsEvent wakeup;
+};
+
+class callbackDispatchThread : private epicsThreadRunable {
+public:
+    callbackDispatchThread ( callbackDispatcher &, ca_client_context &,
+        unsigned index, unsigned stackSize, unsigned priority );
+    ~callbackDispatchThread ();
+    void start ();
+    void post ( const void * pKey, caEventCallBackFunc *,
+        const struct event_handler_args &, const void * pBuf );
+    void cancel ( const void * pKey );
+    bool isRunning ( const void * pChan ) const;
+    void waiterAttach ();
+    void waiterDetach ();
+    bool isCurrentThread () const;
+    void show ( unsigned index, unsigned level ) const;
+    // guarded by the dispatcher's waitMutex
+    const callbackDispatchThread * pWaitingFor;
+    bool lockBlocked; // about to wait for the callback lock
+private:
+    tsDLList < callbackDispatchEntry > queue;
+    tsFreeList < callbackDispatchEntry, 256, epicsMutexNOOP > freeList;
+    epicsThread thread;
+    callbackDispatcher & dispatcher;
+    ca_client_context & ctx;
+    mutable epicsMutex mutex;
+    epicsEvent wakeup;
+    const void * pRunningChan; // channel of the callback in progress
+    unsigned long nDispatched;
+    unsigned maxQueued;
+    unsigned nWaiters; // threads in waitForChannel() for this thread
+    bool exitRequest;
+    void run ();
+    void discard ( callbackDispatchEntry * );
+};
+
+static std::string threadName ( unsigned index )
+{
+    char buf[32];
+    sprintf ( buf, "CAC-callback-%u", index );
+    return buf;
+}
+
+callbackDispatchThread::callbackDispatchThread (
+        callbackDispatcher & dispatcherIn, ca_client_context & ctxIn,
+        unsigned index, unsigned stackSize, unsigned priority ) :
+    pWaitingFor ( 0 ), lockBlocked ( false ),
+    thread ( *this, threadName ( index ).c_str (), stackSize, priority ),
+    dispatcher ( dispatcherIn ), ctx ( ctxIn ), pRunningChan ( 0 ),
+    nDispatched ( 0ul ), maxQueued ( 0u ), nWaiters ( 0u ),
+    exitRequest ( false )
+{
+}
+
+// updates still queued are discarded
+callbackDispatchThread::~callbackDispatchThread ()
+{
+    {
+        epicsGuard < epicsMutex > guard ( this->mutex );
+        this->exitRequest = true;
+    }
+    this->wakeup.signal ();
+    this->thread.exitWait ();
+    while ( callbackDispatchEntry * pEntry = this->queue.get () ) {
+        this->discard ( pEntry );
+    }
+}
+
+void callbackDispatchThread::start ()
+{
+    this->thread.start ();
+}
+
+void callbackDispatchThread::discard ( callbackDispatchEntry * pEntry )
+{
+    if ( pEntry->pBuf ) {
+        recvBufPool::releaseBuf ( pEntry->pBuf );
+    }
+    epicsGuard < epicsMutex > guard ( this->mutex );
+    pEntry->~callbackDispatchEntry ();
+    this->freeList.release ( pEntry );
+}
+
+void callbackDispatchThread::post ( const void * pKey,
+    caEventCallBackFunc * pFunc, const struct event_handler_args & args,
+    const void * pBuf )
+{
+    bool wasEmpty;
+    {
+        epicsGuard < epicsMutex > guard ( this->mutex );
+        callbackDispatchEntry * pEntry =
+            new ( this->freeList.allocate ( sizeof ( callbackDispatchEntry ) ) )
+                callbackDispatchEntry;
+        pEntry->pKey = pKey;
+        pEntry->pFunc = pFunc;
+        pEntry->args = args;
+        pEntry->pBuf = pBuf;
+        wasEmpty = this->queue.count () == 0u;
+        this->queue.add ( *pEntry );
+        if ( this->queue.count () > this->maxQueued ) {
+            this->maxQueued = this->queue.count ();
+        }
+    }
+    if ( wasEmpty ) {
+        this->wakeup.signal ();
+    }
+}
+
+// remove the updates queued for a subscription that is being canceled
+void callbackDispatchThread::cancel ( const void * pKey )
+{
+    tsDLList < callbackDispatchEntry > canceled;
+    {
+        epicsGuard < epicsMutex > guard ( this->mutex );
+        tsDLIter < callbackDispatchEntry > pEntry = this->queue.firstIter ();
+        while ( pEntry.valid () ) {
+            tsDLIter < callbackDispatchEntry > pNext = pEntry;
+            pNext++;
+            if ( pEntry->pKey == pKey ) {
+                this->queue.remove ( *pEntry );
+                canceled.add ( *pEntry );
+            }
+            pEntry = pNext;
+        }
+    }
+    while ( callbackDispatchEntry * pEntry = canceled.get () ) {
+        this->discard ( pEntry );
+    }
+}
+
+bool callbackDispatchThread::isRunning ( const void * pChan ) const
+{
+    epicsGuard < epicsMutex > guard ( this->mutex );
+    return this->pRunningChan == pChan;
+}
+
+// while attached, run() wakes the waiters after each callback
+void callbackDispatchThread::waiterAttach ()
+{
+    epicsGuard < epicsMutex > guard ( this->mutex );
+    this->nWaiters++;
+}
+
+void callbackDispatchThread::waiterDetach ()
+{
+    epicsGuard < epicsMutex > guard ( this->mutex );
+    this->nWaiters--;
+}
+
+bool callbackDispatchThread::isCurrentThread () const
+{
+    return this->thread.isCurrentThread ();
+}
+
+void callbackDispatchThread::run ()
+{
+    // callbacks are called from here, so the same restrictions apply
+    // to this thread as to a receive thread
+    epicsThreadPrivateSet ( caClientCallbackThreadId, this );
+    ca_attach_context ( &this->ctx );
+
+    while ( true ) {
+        callbackDispatchEntry * pEntry = 0;
+        {
+            epicsGuard < epicsMutex > guard ( this->mutex );
+            while ( ! this->exitRequest &&
+                    ! ( pEntry = this->queue.get () ) ) {
+                epicsGuardRelease < epicsMutex > unguard ( guard );
+                this->wakeup.wait ();
+            }
+            if ( this->exitRequest ) {
+                if ( pEntry ) {
+                    this->queue.push ( *pEntry );
+                }
+                return;
+            }
+            this->pRunningChan = pEntry->args.chid;
+        }
+
+        ( *pEntry->pFunc ) ( pEntry->args );
+
+        if ( pEntry->pBuf ) {
+            recvBufPool::releaseBuf ( pEntry->pBuf );
+        }
+        bool waitersPresent;
+        {
+            epicsGuard < epicsMutex > guard ( this->mutex );
+            this->pRunningChan = 0;
+            this->nDispatched++;
+            pEntry->~callbackDispatchEntry ();
+            this->freeList.release ( pEntry );
+            waitersPresent = this->nWaiters > 0u;
+        }
+        if ( waitersPresent ) {
+            this->dispatcher.waitStateChange ();
+        }
+    }
+}
+
+void callbackDispatchThread::show ( unsigned index, unsigned level ) const
+{
+    epicsGuard < epicsMutex > guard ( this->mutex );
+    ::printf ( "\tCA callback thread %u: %lu callbacks, %u queued, "
+        "at most %u\n", index, this->nDispatched, this->queue.count (),
+        this->maxQueued );
+    if ( level > 0u ) {
+        ::printf ( "\t\tcallback in progress for channel %p\n",
+            this->pRunningChan );
+    }
+}
+
+callbackDispatcher::callbackDispatcher ( ca_client_context & ctx,
+        unsigned nThreadsIn, unsigned stackSize, unsigned priority ) :
+    ppThreads ( new callbackDispatchThread * [ nThreadsIn ] ),
+    nThreads ( nThreadsIn )
+{
+    unsigned i = 0u;
+    try {
+        for ( ; i < this->nThreads; i++ ) {
+            this->ppThreads[i] = new callbackDispatchThread ( *this, ctx, i,
+                stackSize, priority );
+        }
+    }
+    catch ( ... ) {
+        while ( i-- > 0u ) {
+            delete this->ppThreads[i];
+        }
+        delete [] this->ppThreads;
+        throw;
+    }
+    for ( i = 0u; i < this->nThreads; i++ ) {
+        this->ppThreads[i]->start ();
+    }
+}
+
+callbackDispatcher::~callbackDispatcher ()
+{
+    for ( unsigned i = 0u; i < this->nThreads; i++ ) {
+        delete this->ppThreads[i];
+    }
+    delete [] this->ppThreads;
+}
+
+callbackDispatchThread & callbackDispatcher::threadFor (
+    const void * pChan ) const
+{
+    // channels come from a free list and so their addresses
+    // differ mostly in the middle bits
+    epicsUInt32 hash = static_cast < epicsUInt32 > (
+        reinterpret_cast < size_t > ( pChan ) >> 3u );
+    hash *= 2654435761u;
+    // the upper bits of the product are the well mixed ones
+    return *this->ppThreads[ ( ( hash >> 16u ) * this->nThreads ) >> 16u ];
+}
+
+callbackDispatchThread * callbackDispatcher::currentDispatchThread () const
+{
+    for ( unsigned i = 0u; i < this->nThreads; i++ ) {
+        if ( this->ppThreads[i]->isCurrentThread () ) {
+            return this->ppThreads[i];
+        }
+    }
+    return 0;
+}
+
+//
+// The buffer holding args.dbr, if any, is released after the
+// callback returns.
+//
+void callbackDispatcher::post ( const void * pKey,
+    caEventCallBackFunc * pFunc, const struct event_handler_args & args,
+    const void * pBuf )
+{
+    this->threadFor ( args.chid ).post ( pKey, pFunc, args, pBuf );
+}
+
+void callbackDispatcher::cancel ( const void * pKey )
+{
+    for ( unsigned i = 0u; i < this->nThreads; i++ ) {
+        this->ppThreads[i]->cancel ( pKey );
+    }
+}
+
+//
+// Waiting for the target thread would deadlock if it is waiting,
+// directly or through other callback threads, for the caller, or for
+// the callback lock that the caller holds.
+//
+bool callbackDispatcher::waitWouldDeadlock (
+    const callbackDispatchThread * pSelf,
+    const callbackDispatchThread & target, bool holdsCallbackLock ) const
+{
+    const callbackDispatchThread * pThread = & target;
+    for ( unsigned i = 0u; pThread && i <= this->nThreads; i++ ) {
+        if ( pThread == pSelf ||
+                ( holdsCallbackLock && pThread->lockBlocked ) ) {
+            return true;
+        }
+        pThread = pThread->pWaitingFor;
+    }
+    return false;
+}
+
+//
+// Once a subscription has been canceled, this makes sure that its
+// callback is no longer running. A callback thread never waits for
+// itself, as the callback running there is the caller. Where waiting
+// would deadlock the wait is skipped, and the callback for the channel
+// may still be running when this returns.
+//
+void callbackDispatcher::waitForChannel ( const void * pChan )
+{
+    callbackDispatchThread & target = this->threadFor ( pChan );
+    callbackDispatchThread * pSelf = this->currentDispatchThread ();
+    if ( pSelf == & target ) {
+        return;
+    }
+    // the other callback threads call their callbacks with the
+    // callback lock held
+    bool holdsCallbackLock = ! pSelf &&
+        epicsThreadPrivateGet ( caClientCallbackThreadId );
+
+    callbackDispatchWaiter waiter;
+    epicsGuard < epicsMutex > guard ( this->waitMutex );
+    this->waiters.add ( waiter );
+    target.waiterAttach ();
+    while ( target.isRunning ( pChan ) &&
+            ! this->waitWouldDeadlock ( pSelf, target, holdsCallbackLock ) ) {
+        if ( pSelf && ! pSelf->pWaitingFor ) {
+            pSelf->pWaitingFor = & target;
+            // threads waiting for this one may now be in a cycle
+            this->wakeWaiters ( guard );
+        }
+        epicsGuardRelease < epicsMutex > unguard ( guard );
+        waiter.wakeup.wait ();
+    }
+    if ( pSelf ) {
+        pSelf->pWaitingFor = 0;
+    }
+    target.waiterDetach ();
+    this->waiters.remove ( waiter );
+}
+
+//
+// A callback thread sets this while it waits for the callback lock,
+// which a thread that holds the lock must then not wait for.
+//
+void callbackDispatcher::callbackLockWait ( bool blocking )
+{
+    callbackDispatchThread * pSelf = this->currentDispatchThread ();
+    if ( pSelf ) {
+        {
+            epicsGuard < epicsMutex > guard ( this->waitMutex );
+            pSelf->lockBlocked = blocking;
+        }
+        if ( blocking ) {
+            this->waitStateChange ();
+        }
+    }
+}
+
+// wake the threads in waitForChannel() to check their conditions again
+void callbackDispatcher::waitStateChange ()
+{
+    epicsGuard < epicsMutex > guard ( this->waitMutex );
+    this->wakeWaiters ( guard );
+}
+
+void callbackDispatcher::wakeWaiters ( epicsGuard < epicsMutex > & guard )
+{
+    guard.assertIdenticalMutex ( this->waitMutex );
+    tsDLIter < callbackDispatchWaiter > pWaiter = this->waiters.firstIter ();
+    while ( pWaiter.valid () ) {
+        pWaiter->wakeup.signal ();
+        pWaiter++;
+    }
+}
+
+void callbackDispatcher::show ( unsigned level ) const
+{
+    for ( unsigned i = 0u; i < this->nThreads; i++ ) {
+        this->ppThreads[i]->show ( i, level );
+    }
+}
@@ -0,0 +1,70 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+//
+// A pool of threads that calls subscription update callbacks for a
+// preemptive callback context, so that a slow callback does not stop a
+// receive thread from reading its circuit. All of the updates for one
+// channel are queued to the same thread and so are delivered in order.
+// The callbacks are called without the callback lock, and so callbacks
+// for different channels may run at the same time.
+//
+// Clearing a channel waits for a callback already running for it on
+// another thread. A thread that would wait for a callback which is
+// itself waiting, directly or through other threads, for the first
+// thread or for the callback lock it holds, returns without waiting
+// instead of deadlocking.
+//
+
+#ifndef INC_callbackDispatcher_H
+#define INC_callbackDispatcher_H
+
+#include "epicsMutex.h"
+#include "epicsEvent.h"
+#include "epicsThread.h"
+#include "tsDLList.h"
+#include "tsFreeList.h"
+
+#include "cadef.h"
+
+class ca_client_context;
+class callbackDispatchThread;
+struct callbackDispatchWaiter;
+
+struct callbackDispatchEntry : public tsDLNode < callbackDispatchEntry > {
+    const void * pKey; // the subscription
+    caEventCallBackFunc * pFunc;
+    struct event_handler_args args;
+    const void * pBuf; // reference counted buffer holding args.dbr
+};
+
+class callbackDispatcher {
+public:
+    callbackDispatcher ( ca_client_context &, unsigned nThreads,
+        unsigned stackSize, unsigned priority );
+    ~callbackDispatcher ();
+    void post ( const void * pKey, caEventCallBackFunc *,
+        const struct event_handler_args &, const void * pBuf );
+    void cancel ( const void * pKey );
+    void waitForChannel ( const void * pChan );
+    void callbackLockWait ( bool blocking );
+    void waitStateChange ();
+    void show ( unsigned level ) const;
+private:
+    tsDLList < callbackDispatchWaiter > waiters;
+    callbackDispatchThread ** ppThreads;
+    unsigned nThreads;
+    mutable epicsMutex waitMutex;
+    callbackDispatchThread & threadFor ( const void * pChan ) const;
+    callbackDispatchThread * currentDispatchThread () const;
+    void wakeWaiters ( epicsGuard < epicsMutex > & );
+    bool waitWouldDeadlock ( const callbackDispatchThread * pSelf,
+        const callbackDispatchThread & target, bool holdsCallbackLock ) const;
+    callbackDispatcher ( const callbackDispatcher & );
+    callbackDispatcher & operator = ( const callbackDispatcher & );
+};
+
+#endif // ifndef INC_callbackDispatcher_H
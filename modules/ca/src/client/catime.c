@@ -441,6 +441,40 @@ static void printSearchStat ( const ti * pi, unsigned iterations )
         mean, stdDev, min, max);
 }
 
+/*
+ * printConnectStat()
+ */
+static void printConnectPhase ( const char * pName,
+    const ca_connect_histogram * pHist )
+{
+    if ( pHist->count == 0u ) {
+        return;
+    }
+    printf ( "%s - count = %lu mean = %3.3f mS max = %3.3f mS\n",
+        pName, pHist->count, 1e3 * pHist->sum / pHist->count,
+        1e3 * pHist->max );
+}
+
+static void printConnectStat ( void )
+{
+    ca_connect_stats stats;
+    unsigned i;
+
+    if ( ca_connect_statistics ( &stats ) != ECA_NORMAL ) {
+        return;
+    }
+    printConnectPhase ( "Search to reply", &stats.searchToReply );
+    printConnectPhase ( "Reply to create", &stats.replyToCreate );
+    printConnectPhase ( "Create to connected", &stats.createToConnect );
+    printf ( "Search retries = %lu, name cache claims = %lu, "
+        "replies by search timer =",
+        stats.searchRetries, stats.nameCacheClaims );
+    for ( i = 0u; i < CA_CONNECT_STATS_STAGES; i++ ) {
+        printf ( " %lu", stats.timerStage[i] );
+    }
+    printf ( "\n" );
+}
+
 /*
  * timeIt ()
  */
@@ -580,8 +614,10 @@ int catime ( const char * channelName,
 
     printf ( "Channel Connect Test\n" );
     printf ( "--------------------\n" );
+    ca_connect_statistics_reset ();
     timeIt ( test_search, pItemList, channelCount, nBytesSent, nBytesRecv );
     printSearchStat ( pItemList, channelCount );
+    printConnectStat ();
 
     for ( i = 0; i < channelCount; i++ ) {
         size_t count = ca_element_count ( pItemList[i].chix );
@@ -0,0 +1,148 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "connectStats.h"
+
+static void histogramAdd ( ca_connect_histogram & hist, double delay )
+{
+    if ( delay < 0.0 ) {
+        delay = 0.0;
+    }
+    hist.count++;
+    hist.sum += delay;
+    if ( delay > hist.max ) {
+        hist.max = delay;
+    }
+    unsigned index = 0u;
+    double limit = 1e-3;
+    while ( delay >= limit && index < CA_CONNECT_STATS_BINS - 1u ) {
+        index++;
+        limit *= 2.0;
+    }
+    hist.bin[index]++;
+}
+
+// upper bound in mS of the bin holding the fraction of the samples
+static double histogramQuantile ( const ca_connect_histogram & hist,
+    double fraction )
+{
+    unsigned long target =
+        static_cast < unsigned long > ( fraction * hist.count );
+    unsigned long sum = 0u;
+    double limit = 1.0;
+    for ( unsigned i = 0u; i < CA_CONNECT_STATS_BINS; i++ ) {
+        if ( i > 0u ) {
+            limit *= 2.0;
+        }
+        sum += hist.bin[i];
+        if ( sum > target ) {
+            break;
+        }
+    }
+    return limit;
+}
+
+static void histogramShow ( const char * pName,
+    const ca_connect_histogram & hist, unsigned level )
+{
+    if ( hist.count == 0u ) {
+        ::printf ( "\t\t%s: none\n", pName );
+        return;
+    }
+    ::printf ( "\t\t%s: %lu, mean %.3f mS, max %.3f mS, "
+        "50%% < %g mS, 90%% < %g mS\n",
+        pName, hist.count, 1e3 * hist.sum / hist.count, 1e3 * hist.max,
+        histogramQuantile ( hist, 0.5 ), histogramQuantile ( hist, 0.9 ) );
+    if ( level > 1u ) {
+        double limit = 1.0;
+        for ( unsigned i = 0u; i < CA_CONNECT_STATS_BINS; i++ ) {
+            if ( i > 0u ) {
+                limit *= 2.0;
+            }
+            if ( hist.bin[i] == 0u ) {
+                continue;
+            }
+            if ( i < CA_CONNECT_STATS_BINS - 1u ) {
+                ::printf ( "\t\t\t< %g mS: %lu\n", limit, hist.bin[i] );
+            }
+            else {
+                ::printf ( "\t\t\t>= %g mS: %lu\n", limit / 2.0, hist.bin[i] );
+            }
+        }
+    }
+}
+
+connectStats::connectStats ()
+{
+    this->reset ();
+}
+
+void connectStats::searchReply ( double delay,
+    unsigned tries, unsigned timerStage )
+{
+    this->stats.searchReplies++;
+    if ( tries > 1u ) {
+        this->stats.searchRetries += tries - 1u;
+    }
+    unsigned index = tries > 0u ? tries - 1u : 0u;
+    if ( index >= CA_CONNECT_STATS_TRIES ) {
+        index = CA_CONNECT_STATS_TRIES - 1u;
+    }
+    this->stats.searchTries[index]++;
+    if ( timerStage < CA_CONNECT_STATS_STAGES ) {
+        this->stats.timerStage[timerStage]++;
+    }
+    histogramAdd ( this->stats.searchToReply, delay );
+}
+
+void connectStats::claimSent ( double delay, bool fromNameCache )
+{
+    if ( fromNameCache ) {
+        this->stats.nameCacheClaims++;
+    }
+    histogramAdd ( this->stats.replyToCreate, delay );
+}
+
+void connectStats::connected ( double delay )
+{
+    this->stats.connects++;
+    histogramAdd ( this->stats.createToConnect, delay );
+}
+
+void connectStats::get ( ca_connect_stats & copy ) const
+{
+    copy = this->stats;
+}
+
+void connectStats::reset ()
+{
+    memset ( & this->stats, 0, sizeof ( this->stats ) );
+}
+
+void connectStats::show ( unsigned level ) const
+{
+    ::printf ( "\tchannel connect statistics: %lu connected, "
+        "%lu found by search with %lu retries, %lu from the name cache\n",
+        this->stats.connects, this->stats.searchReplies,
+        this->stats.searchRetries, this->stats.nameCacheClaims );
+    histogramShow ( "search to reply", this->stats.searchToReply, level );
+    histogramShow ( "reply to create", this->stats.replyToCreate, level );
+    histogramShow ( "create to connected", this->stats.createToConnect, level );
+    if ( level > 1u ) {
+        ::printf ( "\t\tsearch requests per reply:" );
+        for ( unsigned i = 0u; i < CA_CONNECT_STATS_TRIES; i++ ) {
+            ::printf ( " %lu", this->stats.searchTries[i] );
+        }
+        ::printf ( "\n\t\treplies by search timer:" );
+        for ( unsigned i = 0u; i < CA_CONNECT_STATS_STAGES; i++ ) {
+            ::printf ( " %lu", this->stats.timerStage[i] );
+        }
+        ::printf ( "\n" );
+    }
+}
@@ -0,0 +1,31 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+//
+// Accumulates, for a client context, how long each stage of connecting
+// its channels took. Protected by the context's primary mutex.
+//
+
+#ifndef INC_connectStats_H
+#define INC_connectStats_H
+
+#include "cadef.h"
+
+class connectStats {
+public:
+    connectStats ();
+    void searchReply ( double delay, unsigned tries, unsigned timerStage );
+    void claimSent ( double delay, bool fromNameCache );
+    void connected ( double delay );
+    void get ( ca_connect_stats & ) const;
+    void reset ();
+    void show ( unsigned level ) const;
+    static const unsigned noTimerStage = ~0u;
+private:
+    ca_connect_stats stats;
+};
+
+#endif // ifndef INC_connectStats_H
@@ -48,7 +48,8 @@ nciu::nciu ( cac & cacIn, netiiu & iiuIn, cacChannelNotify & chanIn,
     retry ( 0u ),
     nameLength ( 0u ),
     typeCode ( USHRT_MAX ),
-    priority ( static_cast <ca_uint8_t> ( pri ) )
+    priority ( static_cast <ca_uint8_t> ( pri ) ),
+    cacheHit ( false )
 {
     size_t nameLengthTmp = strlen ( pNameIn ) + 1;
 
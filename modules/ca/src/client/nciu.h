@@ -29,6 +29,7 @@
 #include "tsDLList.h"
 #include "tsFreeList.h"
 #include "epicsMutex.h"
+#include "epicsTime.h"
 #include "compilerDependencies.h"
 
 #include "libCaAPI.h"
@@ -199,6 +200,16 @@ public:
         epicsGuard < epicsMutex > &, epicsGuard < epicsMutex > & );
     bool connected ( epicsGuard < epicsMutex > & ) const;
     unsigned getcount() const { return count; }
+    void setNameCacheHit (
+        epicsGuard < epicsMutex > &, bool );
+    bool nameCacheHit (
+        epicsGuard < epicsMutex > & ) const;
+    unsigned searchAttempts (
+        epicsGuard < epicsMutex > & ) const;
+    void connectPhaseBegin (
+        epicsGuard < epicsMutex > &, const epicsTime & currentTime );
+    double connectPhaseEnd (
+        epicsGuard < epicsMutex > &, const epicsTime & currentTime );
 
 private:
     tsDLList < class baseNMIU > eventq;
@@ -212,6 +223,8 @@ private:
     unsigned short nameLength; // channel name length
     ca_uint16_t typeCode;
     ca_uint8_t priority;
+    bool cacheHit; // claimed using the name cache, not yet connected
+    epicsTime phaseBegin; // start of the current stage of connecting
     virtual void destroy (
         CallbackGuard & callbackGuard,
         epicsGuard < epicsMutex > & mutualExclusionGuard );
@@ -255,8 +268,6 @@ private:
         epicsGuard < epicsMutex > & ) const;
     caAccessRights accessRights (
         epicsGuard < epicsMutex > & ) const;
-    unsigned searchAttempts (
-        epicsGuard < epicsMutex > & ) const;
     double beaconPeriod (
         epicsGuard < epicsMutex > & ) const;
     double receiveWatchdogDelay (
@@ -289,6 +300,33 @@ inline void nciu::operator delete ( void * pCadaver,
 }
 #endif
 
+inline void nciu::setNameCacheHit (
+    epicsGuard < epicsMutex > &, bool hit )
+{
+    this->cacheHit = hit;
+}
+
+inline bool nciu::nameCacheHit (
+    epicsGuard < epicsMutex > & ) const
+{
+    return this->cacheHit;
+}
+
+inline void nciu::connectPhaseBegin (
+    epicsGuard < epicsMutex > &, const epicsTime & currentTime )
+{
+    this->phaseBegin = currentTime;
+}
+
+// returns the duration of the stage that ends, and begins the next
+inline double nciu::connectPhaseEnd (
+    epicsGuard < epicsMutex > &, const epicsTime & currentTime )
+{
+    double delay = currentTime - this->phaseBegin;
+    this->phaseBegin = currentTime;
+    return delay;
+}
+
 inline ca_uint32_t nciu::getSID (
     epicsGuard < epicsMutex > & ) const
 {
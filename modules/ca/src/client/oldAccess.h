@@ -100,10 +100,10 @@ public:
         chid pChan );
     friend int epicsStdCall ca_v42_ok (
         chid pChan );
-    friend int epicsStdCall ca_create_subscription (
+    friend int createSubscription (
         chtype type, arrayElementCount count, chid pChan,
         long mask, caEventCallBackFunc * pCallBack,
-        void * pCallBackArg, evid * monixptr );
+        void * pCallBackArg, evid * monixptr, bool buffered );
     friend enum channel_state epicsStdCall ca_state (
         chid pChan );
     friend double epicsStdCall ca_receive_watchdog_delay (
@@ -257,7 +257,7 @@ public:
         oldChannelNotify & chanIn, cacChannel & io,
         unsigned type, arrayElementCount nElem, unsigned mask,
         caEventCallBackFunc * pFuncIn, void * pPrivateIn,
-        evid * );
+        evid *, bool buffered );
     ~oldSubscription ();
     oldChannelNotify & channel () const;
     // The primary mutex must be released when calling the user's
@@ -279,6 +279,7 @@ private:
     cacChannel::ioid id;
     caEventCallBackFunc * pFunc;
     void * pPrivate;
+    bool buffered; // the update is passed in a reference counted buffer
     void current (
         epicsGuard < epicsMutex > &, unsigned type,
         arrayElementCount count, const void *pData );
@@ -316,6 +317,10 @@ public:
     unsigned sequenceNumberOfOutstandingIO (
         epicsGuard < epicsMutex > & ) const;
     unsigned beaconAnomaliesSinceProgramStart () const;
+    bool connectStatistics ( ca_connect_stats & ) const;
+    const void * retainUpdateBuffer ( epicsGuard < epicsMutex > &,
+        const void * pData, arrayElementCount nBytes );
+    void connectStatisticsReset ();
     void incrementOutstandingIO (
         epicsGuard < epicsMutex > &, unsigned ioSeqNo );
     void decrementOutstandingIO (
@@ -346,6 +351,12 @@ public:
     void destroyGetCallback ( epicsGuard < epicsMutex > &, getCallback & );
     void destroyPutCallback ( epicsGuard < epicsMutex > &, putCallback & );
     void destroySubscription ( epicsGuard < epicsMutex > &, oldSubscription & );
+    bool dispatchCallback ( epicsGuard < epicsMutex > &, const void * pKey,
+        caEventCallBackFunc *, const struct event_handler_args &,
+        const void * pBuf );
+    bool callbacksAreDispatched ( epicsGuard < epicsMutex > & ) const;
+    void waitForDispatchedCallbacks ( const void * pChan );
+    void dispatchedCallbackLockWait ( bool blocking );
     epicsMutex & mutexRef () const;
 
     template < class T >
@@ -366,10 +377,10 @@ public:
     friend int epicsStdCall ca_array_put_callback ( chtype type,
         arrayElementCount count, chid pChan, const void * pValue,
         caEventCallBackFunc *pfunc, void *usrarg );
-    friend int epicsStdCall ca_create_subscription (
+    friend int createSubscription (
         chtype type, arrayElementCount count, chid pChan,
         long mask, caEventCallBackFunc * pCallBack, void * pCallBackArg,
-        evid *monixptr );
+        evid *monixptr, bool buffered );
     friend int epicsStdCall ca_flush_io ();
     friend int epicsStdCall ca_clear_subscription ( evid pMon );
     friend int epicsStdCall ca_sg_create ( CA_SYNC_GID * pgid );
@@ -406,6 +417,8 @@ private:
     epicsThreadId createdByThread;
     ca::auto_ptr < CallbackGuard > pCallbackGuard;
     ca::auto_ptr < cacContext > pServiceContext;
+    class recvBufPool * pUpdateBufPool;
+    class callbackDispatcher * pDispatcher;
     caExceptionHandler * ca_exception_func;
     void * ca_exception_arg;
     caPrintfFunc * pVPrintfFunc;
@@ -570,6 +583,13 @@ inline bool ca_client_context::preemptiveCallbakIsEnabled () const
     return this->pCallbackGuard.get () == 0;
 }
 
+inline bool ca_client_context::callbacksAreDispatched (
+    epicsGuard < epicsMutex > & guard ) const
+{
+    guard.assertIdenticalMutex ( this->mutex );
+    return this->pDispatcher != 0;
+}
+
 inline bool ca_client_context::ioComplete () const
 {
     return ( this->pndRecvCnt == 0u );
@@ -528,10 +528,10 @@ int epicsStdCall ca_array_put ( chtype type, arrayElementCount count,
     return caStatus;
 }
 
-int epicsStdCall ca_create_subscription (
+int createSubscription (
         chtype type, arrayElementCount count, chid pChan,
         long mask, caEventCallBackFunc * pCallBack, void * pCallBackArg,
-        evid * monixptr )
+        evid * monixptr, bool buffered )
 {
     if ( type < 0 ) {
         return ECA_BADTYPE;
@@ -570,7 +570,7 @@ int epicsStdCall ca_create_subscription (
         new ( pChan->getClientCtx().subscriptionFreeList )
             oldSubscription  (
                 guard, *pChan, pChan->io, tmpType, count, mask,
-                pCallBack, pCallBackArg, monixptr );
+                pCallBack, pCallBackArg, monixptr, buffered );
         // don't touch object created after above new because
         // the first callback might have canceled, and therefore
         // destroyed, it
@@ -609,6 +609,34 @@ int epicsStdCall ca_create_subscription (
     }
 }
 
+int epicsStdCall ca_create_subscription (
+        chtype type, arrayElementCount count, chid pChan,
+        long mask, caEventCallBackFunc * pCallBack, void * pCallBackArg,
+        evid * monixptr )
+{
+    return createSubscription ( type, count, pChan, mask,
+        pCallBack, pCallBackArg, monixptr, false );
+}
+
+int epicsStdCall ca_create_buffered_subscription (
+        chtype type, arrayElementCount count, chid pChan,
+        long mask, caEventCallBackFunc * pCallBack, void * pCallBackArg,
+        evid * monixptr )
+{
+    return createSubscription ( type, count, pChan, mask,
+        pCallBack, pCallBackArg, monixptr, true );
+}
+
+void epicsStdCall ca_buffer_retain ( const void * pDbr )
+{
+    recvBufPool::retainBuf ( pDbr );
+}
+
+void epicsStdCall ca_buffer_release ( const void * pDbr )
+{
+    recvBufPool::releaseBuf ( pDbr );
+}
+
 void oldChannelNotify::write (
     epicsGuard < epicsMutex > & guard, unsigned type, arrayElementCount count,
     const void * pValue, cacWriteNotify & notify, cacChannel::ioid * pId )
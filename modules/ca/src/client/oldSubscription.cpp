@@ -25,15 +25,16 @@
 
 #include "iocinf.h"
 #include "oldAccess.h"
+#include "recvBufPool.h"
 
 oldSubscription::oldSubscription  (
     epicsGuard < epicsMutex > & guard,
     oldChannelNotify & chanIn, cacChannel & io,
     unsigned type, arrayElementCount nElem, unsigned mask,
     caEventCallBackFunc * pFuncIn, void * pPrivateIn,
-    evid * pEventId ) :
+    evid * pEventId, bool bufferedIn ) :
     chan ( chanIn ), id ( UINT_MAX ), pFunc ( pFuncIn ),
-        pPrivate ( pPrivateIn )
+        pPrivate ( pPrivateIn ), buffered ( bufferedIn )
 {
     // The users event id *must* be set prior to potentially
     // calling his callback from within subscribe.
@@ -61,10 +62,26 @@ void oldSubscription::current (
     args.count = static_cast < long > ( count );
     args.status = ECA_NORMAL;
     args.dbr = pData;
+    // an update queued for a callback thread must also outlive
+    // the receive buffer
+    ca_client_context & cac = this->chan.getClientCtx ();
+    const void * pBuf = 0;
+    if ( this->buffered || cac.callbacksAreDispatched ( guard ) ) {
+        pBuf = cac.retainUpdateBuffer (
+            guard, pData, dbr_size_n ( type, count ) );
+        args.dbr = pBuf;
+        if ( ! pBuf ) {
+            args.status = ECA_ALLOCMEM;
+        }
+    }
     caEventCallBackFunc * pFuncTmp = this->pFunc;
-    {
+    if ( ! cac.dispatchCallback ( guard, this, pFuncTmp, args, pBuf ) ) {
         epicsGuardRelease < epicsMutex > unguard ( guard );
         ( *pFuncTmp ) ( args );
+        // the callback may have canceled, and destroyed, this subscription
+        if ( pBuf ) {
+            recvBufPool::releaseBuf ( pBuf );
+        }
     }
 }
 
@@ -86,7 +103,8 @@ void oldSubscription::exception (
         args.status = status;
         args.dbr = 0;
         caEventCallBackFunc * pFuncTmp = this->pFunc;
-        {
+        ca_client_context & cac = this->chan.getClientCtx ();
+        if ( ! cac.dispatchCallback ( guard, this, pFuncTmp, args, 0 ) ) {
             epicsGuardRelease < epicsMutex > unguard ( guard );
             ( *pFuncTmp ) ( args );
         }
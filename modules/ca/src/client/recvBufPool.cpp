@@ -0,0 +1,219 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "epicsAssert.h"
+#include "epicsAtomic.h"
+
+#include "recvBufPool.h"
+
+struct recvBufPool::bufHeader {
+    recvBufPool * pPool;
+    bufHeader * pNext; // while idle
+    arrayElementCount capacity;
+    int refCount;
+};
+
+// the body follows the header at an alignment suitable for any DBR type
+static const size_t headerSize = 32u;
+
+// idle buffers kept for each size class, at least two but otherwise
+// no more than this many bytes or buffers
+static const arrayElementCount idleBytesPerClass = 4u * 1024u * 1024u;
+static const unsigned maxIdlePerClass = 64u;
+
+//
+// minBytes is the size of the smallest class, and maxBytes, if nonzero,
+// the size of the largest message that will be accepted
+//
+recvBufPool::recvBufPool (
+        arrayElementCount minBytes, arrayElementCount maxBytes ) :
+    maxBytes ( maxBytes ), inUseBytes ( 0u ), peakInUseBytes ( 0u ),
+    nOversize ( 0u ), nAllocFail ( 0u ), nRefs ( 1u )
+{
+    STATIC_ASSERT ( sizeof ( bufHeader ) <= headerSize );
+    arrayElementCount size = minBytes;
+    for ( unsigned i = 0u; i < nSizeClasses; i++ ) {
+        sizeClass & cls = this->classes[i];
+        cls.pIdle = 0;
+        cls.size = size;
+        cls.nIdle = 0u;
+        cls.maxIdle = 2u;
+        if ( idleBytesPerClass / size > cls.maxIdle ) {
+            cls.maxIdle = idleBytesPerClass / size < maxIdlePerClass ?
+                static_cast < unsigned > ( idleBytesPerClass / size ) :
+                maxIdlePerClass;
+        }
+        cls.nAllocate = 0u;
+        cls.nReuse = 0u;
+        cls.nFree = 0u;
+        size *= 2u;
+    }
+}
+
+recvBufPool::~recvBufPool ()
+{
+    for ( unsigned i = 0u; i < nSizeClasses; i++ ) {
+        while ( bufHeader * pBuf = this->classes[i].pIdle ) {
+            this->classes[i].pIdle = pBuf->pNext;
+            ::free ( pBuf );
+        }
+    }
+}
+
+//
+// Called by the owner in place of delete. The pool is freed when
+// the last buffer retained by the application is released.
+//
+void recvBufPool::destroy ()
+{
+    this->detach ();
+}
+
+void recvBufPool::detach ()
+{
+    bool last;
+    {
+        epicsGuard < epicsMutex > guard ( this->mutex );
+        last = --this->nRefs == 0u;
+    }
+    if ( last ) {
+        delete this;
+    }
+}
+
+// returns nSizeClasses if the message is larger than the largest class
+unsigned recvBufPool::sizeClassIndex ( arrayElementCount nBytes ) const
+{
+    unsigned i = 0u;
+    while ( i < nSizeClasses && this->classes[i].size < nBytes ) {
+        i++;
+    }
+    return i;
+}
+
+//
+// Returns a buffer with a reference count of one. Messages larger
+// than the largest class get a buffer of their own size which is
+// freed when it is released.
+//
+char * recvBufPool::allocateBuf (
+    arrayElementCount nBytes, arrayElementCount & capacity )
+{
+    unsigned index = this->sizeClassIndex ( nBytes );
+    bufHeader * pBuf = 0;
+    {
+        epicsGuard < epicsMutex > guard ( this->mutex );
+        if ( index < nSizeClasses ) {
+            sizeClass & cls = this->classes[index];
+            cls.nAllocate++;
+            capacity = cls.size;
+            if ( cls.pIdle ) {
+                pBuf = cls.pIdle;
+                cls.pIdle = pBuf->pNext;
+                cls.nIdle--;
+                cls.nReuse++;
+            }
+        }
+        else {
+            this->nOversize++;
+            capacity = nBytes;
+        }
+    }
+    // the heap is not called with the lock applied
+    if ( ! pBuf ) {
+        pBuf = static_cast < bufHeader * > ( ::malloc ( headerSize + capacity ) );
+    }
+    epicsGuard < epicsMutex > guard ( this->mutex );
+    if ( ! pBuf ) {
+        this->nAllocFail++;
+        return 0;
+    }
+    pBuf->pPool = this;
+    pBuf->pNext = 0;
+    pBuf->capacity = capacity;
+    pBuf->refCount = 1;
+    this->nRefs++;
+    this->inUseBytes += capacity;
+    if ( this->inUseBytes > this->peakInUseBytes ) {
+        this->peakInUseBytes = this->inUseBytes;
+    }
+    return reinterpret_cast < char * > ( pBuf ) + headerSize;
+}
+
+void recvBufPool::retainBuf ( const void * pBody )
+{
+    bufHeader * pBuf = reinterpret_cast < bufHeader * > (
+        static_cast < char * > ( const_cast < void * > ( pBody ) ) - headerSize );
+    epics::atomic::increment ( pBuf->refCount );
+}
+
+void recvBufPool::releaseBuf ( const void * pBody )
+{
+    bufHeader * pBuf = reinterpret_cast < bufHeader * > (
+        static_cast < char * > ( const_cast < void * > ( pBody ) ) - headerSize );
+    if ( epics::atomic::decrement ( pBuf->refCount ) == 0 ) {
+        pBuf->pPool->release ( pBuf );
+    }
+}
+
+void recvBufPool::release ( bufHeader * pBuf )
+{
+    unsigned index = this->sizeClassIndex ( pBuf->capacity );
+    bool idle = false;
+    {
+        epicsGuard < epicsMutex > guard ( this->mutex );
+        this->inUseBytes -= pBuf->capacity;
+        if ( index < nSizeClasses ) {
+            sizeClass & cls = this->classes[index];
+            if ( cls.nIdle < cls.maxIdle ) {
+                pBuf->pNext = cls.pIdle;
+                cls.pIdle = pBuf;
+                cls.nIdle++;
+                idle = true;
+            }
+            else {
+                cls.nFree++;
+            }
+        }
+    }
+    if ( ! idle ) {
+        ::free ( pBuf );
+    }
+    this->detach ();
+}
+
+void recvBufPool::show ( const char * pName, unsigned level ) const
+{
+    epicsGuard < epicsMutex > guard ( this->mutex );
+    arrayElementCount idleBytes = 0u;
+    unsigned long nAllocate = this->nOversize;
+    unsigned long nReuse = 0u;
+    for ( unsigned i = 0u; i < nSizeClasses; i++ ) {
+        idleBytes += this->classes[i].nIdle * this->classes[i].size;
+        nAllocate += this->classes[i].nAllocate;
+        nReuse += this->classes[i].nReuse;
+    }
+    ::printf ( "\t%s: %lu in use bytes (peak %lu), "
+        "%lu idle bytes, %lu allocated, %lu reused, %lu oversize, "
+        "%lu failed\n", pName,
+        this->inUseBytes, this->peakInUseBytes, idleBytes,
+        nAllocate, nReuse, this->nOversize, this->nAllocFail );
+    if ( level > 1u ) {
+        for ( unsigned i = 0u; i < nSizeClasses; i++ ) {
+            const sizeClass & cls = this->classes[i];
+            if ( cls.nAllocate == 0u && cls.nIdle == 0u ) {
+                continue;
+            }
+            ::printf ( "\t\t%lu bytes: %lu allocated, %lu reused, "
+                "%lu freed, %u of %u idle\n",
+                cls.size, cls.nAllocate, cls.nReuse, cls.nFree,
+                cls.nIdle, cls.maxIdle );
+        }
+    }
+}
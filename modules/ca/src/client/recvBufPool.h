@@ -0,0 +1,67 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+//
+// Reference counted message body buffers, shared by all of the circuits
+// of a client context, for responses too large for the fixed size body
+// cache that each circuit has. Buffers are handed out in power of two
+// size classes and a circuit releases its buffer as soon as the message
+// has been processed, so that a few idle buffers of each class serve all
+// of the circuits. A buffered subscription may retain the buffer that
+// its update arrived in beyond its callback, and the pool is not freed
+// until the last such buffer is released.
+//
+
+#ifndef INC_recvBufPool_H
+#define INC_recvBufPool_H
+
+#include "epicsMutex.h"
+
+#include "cacIO.h"
+
+class recvBufPool {
+public:
+    recvBufPool ( arrayElementCount minBytes, arrayElementCount maxBytes );
+    void destroy ();
+    bool withinLimit ( arrayElementCount nBytes ) const;
+    char * allocateBuf ( arrayElementCount nBytes, arrayElementCount & capacity );
+    static void retainBuf ( const void * pBuf );
+    static void releaseBuf ( const void * pBuf );
+    void show ( const char * pName, unsigned level ) const;
+private:
+    struct bufHeader;
+    struct sizeClass {
+        bufHeader * pIdle;
+        arrayElementCount size;
+        unsigned nIdle;
+        unsigned maxIdle;
+        unsigned long nAllocate;
+        unsigned long nReuse;
+        unsigned long nFree;
+    };
+    enum { nSizeClasses = 16 };
+    sizeClass classes [ nSizeClasses ];
+    mutable epicsMutex mutex;
+    arrayElementCount maxBytes;
+    arrayElementCount inUseBytes;
+    arrayElementCount peakInUseBytes;
+    unsigned long nOversize;
+    unsigned long nAllocFail;
+    unsigned nRefs; // the owner and each buffer in use
+    ~recvBufPool ();
+    unsigned sizeClassIndex ( arrayElementCount nBytes ) const;
+    void release ( bufHeader * );
+    void detach ();
+    recvBufPool ( const recvBufPool & );
+    recvBufPool & operator = ( const recvBufPool & );
+};
+
+inline bool recvBufPool::withinLimit ( arrayElementCount nBytes ) const
+{
+    return this->maxBytes == 0u || nBytes <= this->maxBytes;
+}
+
+#endif // ifndef INC_recvBufPool_H
@@ -32,6 +32,7 @@
 
 static const unsigned initialTriesPerFrame = 1u; // initial UDP frames per search try
 static const unsigned maxTriesPerFrame = 64u; // max UDP frames per search try
+static const unsigned minAttemptsToJudge = 8u; // min requests in a pass to detect loss
 
 //
 // searchTimer::searchTimer ()
@@ -48,14 +49,18 @@ searchTimer::searchTimer (
     mutex ( mutexIn ),
     framesPerTry ( initialTriesPerFrame ),
     framesPerTryCongestThresh ( DBL_MAX ),
+    respRatioMean ( -1.0 ),
     retry ( 0 ),
     searchAttempts ( 0u ),
     searchResponses ( 0u ),
+    framesThisPass ( 0u ),
     index ( indexIn ),
     dgSeqNoAtTimerExpireBegin ( 0u ),
     dgSeqNoAtTimerExpireEnd ( 0u ),
+    dgSeqNoAtLastSend ( 0u ),
     boostPossible ( boostPossibleIn ),
-    stopped ( false )
+    stopped ( false ),
+    passInProgress ( false )
 {
 }
 
@@ -119,13 +124,10 @@ void searchTimer::moveChannels (
 }
 
 //
-// searchTimer::expire ()
+// searchTimer::endOfPass ()
 //
-epicsTimerNotify::expireStatus searchTimer::expire (
-    const epicsTime & currentTime )
+void searchTimer::endOfPass ( epicsGuard < epicsMutex > & guard )
 {
-    epicsGuard < epicsMutex > guard ( this->mutex );
-
     while ( nciu * pChan = this->chanListRespPending.get () ) {
         pChan->channelNode::listMember =
             channelNode::cs_none;
@@ -133,8 +135,6 @@ epicsTimerNotify::expireStatus searchTimer::expire (
             guard, *pChan, this->index );
     }
 
-    this->timeAtLastSend = currentTime;
-
     // boost search period for channels not recently
     // searched for if there was some success
     if ( this->searchResponses && this->boostPossible ) {
@@ -226,14 +226,64 @@ epicsTimerNotify::expireStatus searchTimer::expire (
 #endif
     }
 
+    //
+    // Tell the shared search rate limit about loss. Names which no
+    // server has are never answered, so the response ratio of this
+    // timer is compared with its own recent history rather than with
+    // 100%. Passes without any responses, or with too few requests to
+    // judge, say nothing either way.
+    //
+    if ( this->searchResponses && this->searchAttempts >= minAttemptsToJudge ) {
+        double ratio = static_cast < double > ( this->searchResponses ) /
+            this->searchAttempts;
+        if ( this->respRatioMean < 0.0 ) {
+            this->respRatioMean = ratio;
+        }
+        else {
+            if ( ratio < this->respRatioMean * 0.875 ) {
+                this->iiu.searchLossNotify ( guard, true );
+            }
+            else if ( ratio >= this->respRatioMean * 0.9375 ) {
+                this->iiu.searchLossNotify ( guard, false );
+            }
+            this->respRatioMean += 0.125 * ( ratio - this->respRatioMean );
+        }
+    }
+
     this->dgSeqNoAtTimerExpireBegin =
         this->iiu.datagramSeqNumber ( guard );
 
     this->searchAttempts = 0;
     this->searchResponses = 0;
+    this->framesThisPass = 0u;
+}
+
+//
+// searchTimer::expire ()
+//
+epicsTimerNotify::expireStatus searchTimer::expire (
+    const epicsTime & currentTime )
+{
+    epicsGuard < epicsMutex > guard ( this->mutex );
+
+    // a pass through the request list which was interrupted by the
+    // search rate limit continues where it stopped
+    if ( ! this->passInProgress ) {
+        this->endOfPass ( guard );
+    }
+
+    this->timeAtLastSend = currentTime;
+    this->dgSeqNoAtLastSend = this->iiu.datagramSeqNumber ( guard );
+
+    double frameLimit = this->framesPerTry - this->framesThisPass;
+    double allowed = this->iiu.searchFramesAllowed ( guard, currentTime );
+    bool rateLimited = allowed < frameLimit;
+    if ( rateLimited ) {
+        frameLimit = allowed;
+    }
 
     unsigned nFrameSent = 0u;
-    while ( true ) {
+    while ( frameLimit >= 1.0 ) {
         nciu * pChan = this->chanListReqPending.get ();
         if ( ! pChan ) {
             break;
@@ -246,7 +296,9 @@ epicsTimerNotify::expireStatus searchTimer::expire (
         if ( ! success ) {
             if ( this->iiu.datagramFlush ( guard, currentTime ) ) {
                 nFrameSent++;
-                if ( nFrameSent < this->framesPerTry ) {
+                // start another frame only if a whole token is left
+                // for it, the final flush below sends it regardless
+                if ( nFrameSent < frameLimit && nFrameSent + 1.0 <= allowed ) {
                     success = pChan->searchMsg ( guard );
                 }
             }
@@ -271,6 +323,8 @@ epicsTimerNotify::expireStatus searchTimer::expire (
     if ( this->iiu.datagramFlush ( guard, currentTime ) ) {
         nFrameSent++;
     }
+    this->iiu.datagramSend ( guard );
+    this->framesThisPass += nFrameSent;
 
     this->dgSeqNoAtTimerExpireEnd =
         this->iiu.datagramSeqNumber ( guard ) - 1u;
@@ -284,6 +338,12 @@ epicsTimerNotify::expireStatus searchTimer::expire (
         }
 #   endif
 
+    if ( rateLimited && this->chanListReqPending.count () ) {
+        this->passInProgress = true;
+        return expireStatus ( restart, this->iiu.searchFrameDelay ( guard ) );
+    }
+    this->passInProgress = false;
+
     return expireStatus ( restart, this->period ( guard ) );
 }
 
@@ -342,8 +402,12 @@ void searchTimer::uninstallChanDueToSuccessfulSearchResponse (
     // if we receive a successful response then reset to a
     // reasonable timer period
     if ( validResponse ) {
-        double measured = currentTime - this->timeAtLastSend;
-        this->iiu.updateRTTE ( guard, measured );
+        // only responses to the most recent send time the round trip
+        if ( ! seqNumberIsValid ||
+                respDatagramSeqNo >= this->dgSeqNoAtLastSend ) {
+            double measured = currentTime - this->timeAtLastSend;
+            this->iiu.updateRTTE ( guard, measured );
+        }
 
         if ( this->searchResponses < UINT_MAX ) {
             this->searchResponses++;
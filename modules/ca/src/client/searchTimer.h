@@ -48,6 +48,17 @@ public:
         const epicsTime & currentTime ) = 0;
     virtual ca_uint32_t datagramSeqNumber (
         epicsGuard < epicsMutex > & ) const = 0;
+    virtual void datagramSend ( epicsGuard < epicsMutex > & ) = 0;
+    // search frames that the shared search rate limit allows now
+    virtual double searchFramesAllowed (
+        epicsGuard < epicsMutex > &, const epicsTime & currentTime ) = 0;
+    // delay until the rate limit allows another search frame
+    virtual double searchFrameDelay (
+        epicsGuard < epicsMutex > & ) const = 0;
+    // the response ratio of a completed pass was as usual, or
+    // low enough to suggest that requests or responses were lost
+    virtual void searchLossNotify (
+        epicsGuard < epicsMutex > &, bool lossDetected ) = 0;
 };
 
 class searchTimer : private epicsTimerNotify {
@@ -81,17 +92,22 @@ private:
     epicsMutex & mutex;
     double framesPerTry; /* # of UDP frames per search try */
     double framesPerTryCongestThresh; /* one half N tries w congest */
+    double respRatioMean; /* typical response ratio, negative if unknown */
     unsigned retry;
     unsigned searchAttempts; /* num search tries after last timer expiration */
     unsigned searchResponses; /* num search resp after last timer expiration */
+    unsigned framesThisPass; /* frames sent since the pass began */
     const unsigned index;
     ca_uint32_t dgSeqNoAtTimerExpireBegin;
     ca_uint32_t dgSeqNoAtTimerExpireEnd;
+    ca_uint32_t dgSeqNoAtLastSend;
     const bool boostPossible;
     bool stopped;
+    bool passInProgress; /* rate limit interrupted the pass */
 
     expireStatus expire ( const epicsTime & currentTime );
     double period ( epicsGuard < epicsMutex > & ) const;
+    void endOfPass ( epicsGuard < epicsMutex > & );
     searchTimer ( const searchTimer & ); // not implemented
     searchTimer & operator = ( const searchTimer & ); // not implemented
 };
@@ -0,0 +1,278 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <stdexcept>
+#include <string>
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#if defined ( __linux__ )
+#   include <unistd.h>
+#   include <sys/epoll.h>
+#   include <sys/eventfd.h>
+#   define CA_RECV_ENGINE_EPOLL
+#endif
+
+#include "errlog.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
+
+#include "iocinf.h"
+#include "cac.h"
+#include "virtualCircuit.h"
+#include "tcpRecvEngine.h"
+
+#ifdef CA_RECV_ENGINE_EPOLL
+
+class tcpRecvEngineThread : private epicsThreadRunable {
+public:
+    tcpRecvEngineThread ( cac &, unsigned index,
+        unsigned stackSize, unsigned priority );
+    ~tcpRecvEngineThread ();
+    void start ();
+    void install ( tcpRecvThread & );
+    unsigned circuitCount () const;
+    void show ( unsigned index, unsigned level ) const;
+private:
+    epicsThread thread;
+    cac & cacRef;
+    mutable epicsMutex mutex;
+    epicsTime startTime;
+    double busySeconds;
+    unsigned long nEvents;
+    unsigned nCircuits;
+    int epfd;
+    int wakeFd;
+    bool exitRequest;
+    void run ();
+    enum { eventBatch = 64 };
+};
+
+static std::string threadName ( unsigned index )
+{
+    char buf[32];
+    sprintf ( buf, "CAC-TCP-recv-%u", index );
+    return buf;
+}
+
+tcpRecvEngineThread::tcpRecvEngineThread ( cac & cacIn, unsigned index,
+        unsigned stackSize, unsigned priority ) :
+    thread ( *this, threadName ( index ).c_str (), stackSize, priority ),
+    cacRef ( cacIn ), startTime ( epicsTime::getCurrent () ),
+    busySeconds ( 0.0 ), nEvents ( 0ul ), nCircuits ( 0u ),
+    epfd ( -1 ), wakeFd ( -1 ), exitRequest ( false )
+{
+    this->epfd = epoll_create ( eventBatch );
+    this->wakeFd = eventfd ( 0, 0 );
+    if ( this->epfd < 0 || this->wakeFd < 0 ) {
+        std::string reason = "CAC: receive engine creation failure because \"";
+        reason += strerror ( errno );
+        reason += "\"";
+        if ( this->epfd >= 0 ) close ( this->epfd );
+        if ( this->wakeFd >= 0 ) close ( this->wakeFd );
+        throw std::runtime_error ( reason );
+    }
+    struct epoll_event ev;
+    memset ( &ev, 0, sizeof ( ev ) );
+    ev.events = EPOLLIN;
+    ev.data.ptr = 0;
+    epoll_ctl ( this->epfd, EPOLL_CTL_ADD, this->wakeFd, &ev );
+}
+
+tcpRecvEngineThread::~tcpRecvEngineThread ()
+{
+    {
+        epicsGuard < epicsMutex > guard ( this->mutex );
+        this->exitRequest = true;
+    }
+    epicsUInt64 one = 1u;
+    if ( write ( this->wakeFd, &one, sizeof ( one ) ) != sizeof ( one ) ) {
+        errlogPrintf ( "CAC: receive engine wakeup failed\n" );
+    }
+    this->thread.exitWait ();
+    close ( this->epfd );
+    close ( this->wakeFd );
+}
+
+void tcpRecvEngineThread::start ()
+{
+    this->thread.start ();
+}
+
+void tcpRecvEngineThread::install ( tcpRecvThread & recv )
+{
+    struct epoll_event ev;
+    memset ( &ev, 0, sizeof ( ev ) );
+    ev.events = EPOLLIN;
+    ev.data.ptr = &recv;
+    {
+        epicsGuard < epicsMutex > guard ( this->mutex );
+        this->nCircuits++;
+    }
+    if ( epoll_ctl ( this->epfd, EPOLL_CTL_ADD, recv.socket (), &ev ) < 0 ) {
+        {
+            epicsGuard < epicsMutex > guard ( this->mutex );
+            this->nCircuits--;
+        }
+        std::string reason = "CAC: receive engine add failure because \"";
+        reason += strerror ( errno );
+        reason += "\"";
+        throw std::runtime_error ( reason );
+    }
+}
+
+unsigned tcpRecvEngineThread::circuitCount () const
+{
+    epicsGuard < epicsMutex > guard ( this->mutex );
+    return this->nCircuits;
+}
+
+void tcpRecvEngineThread::run ()
+{
+    // as for a receive thread, callbacks are called from here
+    epicsThreadPrivateSet ( caClientCallbackThreadId, this );
+    this->cacRef.attachToClientCtx ();
+
+    while ( true ) {
+        struct epoll_event events[eventBatch];
+        int n = epoll_wait ( this->epfd, events, eventBatch, -1 );
+        if ( n < 0 ) {
+            if ( errno != EINTR ) {
+                errlogPrintf ( "CAC: receive engine epoll_wait failed: %s\n",
+                    strerror ( errno ) );
+                epicsThreadSleep ( 1.0 );
+            }
+            continue;
+        }
+
+        epicsTime begin = epicsTime::getCurrent ();
+        unsigned nFinished = 0u;
+        for ( int i = 0; i < n; i++ ) {
+            tcpRecvThread * pRecv =
+                static_cast < tcpRecvThread * > ( events[i].data.ptr );
+            if ( ! pRecv ) {
+                epicsGuard < epicsMutex > guard ( this->mutex );
+                if ( this->exitRequest ) {
+                    return;
+                }
+                continue;
+            }
+            // a circuit that shuts down appears only once in a batch
+            if ( ! pRecv->receive () ) {
+                struct epoll_event ev;
+                memset ( &ev, 0, sizeof ( ev ) );
+                epoll_ctl ( this->epfd, EPOLL_CTL_DEL, pRecv->socket (), &ev );
+                nFinished++;
+                // the circuit may be destroyed once this returns
+                pRecv->finish ();
+            }
+        }
+        double busy = epicsTime::getCurrent () - begin;
+
+        epicsGuard < epicsMutex > guard ( this->mutex );
+        this->busySeconds += busy;
+        this->nEvents += static_cast < unsigned long > ( n );
+        this->nCircuits -= nFinished;
+    }
+}
+
+void tcpRecvEngineThread::show ( unsigned index, unsigned level ) const
+{
+    epicsGuard < epicsMutex > guard ( this->mutex );
+    double elapsed = epicsTime::getCurrent () - this->startTime;
+    double load = elapsed > 0.0 ? 100.0 * this->busySeconds / elapsed : 0.0;
+    ::printf ( "\tCA receive engine thread %u: %u circuits, "
+        "%lu events, load %.1f%%\n",
+        index, this->nCircuits, this->nEvents, load );
+    if ( level > 0u ) {
+        ::printf ( "\t\tbusy %.3f of %.3f sec, epoll fd %d\n",
+            this->busySeconds, elapsed, this->epfd );
+    }
+}
+
+tcpRecvEngine * tcpRecvEngine::create ( cac & cacIn, unsigned nThreads,
+    unsigned stackSize, unsigned priority )
+{
+    tcpRecvEngineThread ** ppThreads = new tcpRecvEngineThread * [ nThreads ];
+    unsigned i = 0u;
+    try {
+        for ( ; i < nThreads; i++ ) {
+            ppThreads[i] = new tcpRecvEngineThread ( cacIn, i,
+                stackSize, priority );
+        }
+    }
+    catch ( ... ) {
+        while ( i-- > 0u ) {
+            delete ppThreads[i];
+        }
+        delete [] ppThreads;
+        throw;
+    }
+    for ( i = 0u; i < nThreads; i++ ) {
+        ppThreads[i]->start ();
+    }
+    return new tcpRecvEngine ( ppThreads, nThreads );
+}
+
+tcpRecvEngine::tcpRecvEngine ( tcpRecvEngineThread ** ppThreadsIn,
+        unsigned nThreadsIn ) :
+    ppThreads ( ppThreadsIn ), nThreads ( nThreadsIn )
+{
+}
+
+tcpRecvEngine::~tcpRecvEngine ()
+{
+    for ( unsigned i = 0u; i < this->nThreads; i++ ) {
+        delete this->ppThreads[i];
+    }
+    delete [] this->ppThreads;
+}
+
+void tcpRecvEngine::install ( tcpRecvThread & recv )
+{
+    // the least loaded thread gets the new circuit
+    unsigned best = 0u;
+    unsigned bestCount = this->ppThreads[0]->circuitCount ();
+    for ( unsigned i = 1u; i < this->nThreads; i++ ) {
+        unsigned count = this->ppThreads[i]->circuitCount ();
+        if ( count < bestCount ) {
+            best = i;
+            bestCount = count;
+        }
+    }
+    this->ppThreads[best]->install ( recv );
+}
+
+void tcpRecvEngine::show ( unsigned level ) const
+{
+    for ( unsigned i = 0u; i < this->nThreads; i++ ) {
+        this->ppThreads[i]->show ( i, level );
+    }
+}
+
+#else /* CA_RECV_ENGINE_EPOLL */
+
+tcpRecvEngine * tcpRecvEngine::create ( cac &, unsigned,
+    unsigned, unsigned )
+{
+    return 0;
+}
+
+tcpRecvEngine::~tcpRecvEngine ()
+{
+}
+
+void tcpRecvEngine::install ( tcpRecvThread & )
+{
+}
+
+void tcpRecvEngine::show ( unsigned ) const
+{
+}
+
+#endif /* CA_RECV_ENGINE_EPOLL */
@@ -0,0 +1,44 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+//
+// A small pool of threads that services the receive side of all of a
+// context's virtual circuits, instead of one receive thread per
+// circuit. Each thread waits in epoll for any of its sockets to become
+// readable. Only available on Linux; create() returns 0 elsewhere.
+//
+// Callbacks for incoming messages run on the engine thread that read
+// them, so a callback that blocks stalls every circuit on that thread
+// until it returns. Subscription updates can be moved off the engine
+// threads with EPICS_CA_CALLBACK_THREADS; connection, get and put
+// callbacks cannot.
+//
+
+#ifndef INC_tcpRecvEngine_H
+#define INC_tcpRecvEngine_H
+
+#include "libCaAPI.h"
+
+class cac;
+class tcpRecvThread;
+class tcpRecvEngineThread;
+
+class tcpRecvEngine {
+public:
+    static tcpRecvEngine * create ( cac &, unsigned nThreads,
+        unsigned stackSize, unsigned priority );
+    ~tcpRecvEngine ();
+    void install ( tcpRecvThread & );
+    void show ( unsigned level ) const;
+private:
+    tcpRecvEngineThread ** ppThreads;
+    unsigned nThreads;
+    tcpRecvEngine ( tcpRecvEngineThread ** ppThreads, unsigned nThreads );
+    tcpRecvEngine ( const tcpRecvEngine & );
+    tcpRecvEngine & operator = ( const tcpRecvEngine & );
+};
+
+#endif // ifndef INC_tcpRecvEngine_H
@@ -29,6 +29,7 @@
 #include <string>
 
 #include <stdlib.h>
+#include <float.h>
 
 #include "errlog.h"
 
@@ -44,6 +45,7 @@
 #include "epicsSignal.h"
 #include "caerr.h"
 #include "udpiiu.h"
+#include "tcpRecvEngine.h"
 
 using namespace std;
 
@@ -74,6 +76,11 @@ void tcpSendThread::exitWait ()
 
 void tcpSendThread::run ()
 {
+    // with a receive engine there is no receive thread to connect
+    if ( ! this->iiu.recvThread.engineConnect () ) {
+        return;
+    }
+
     try {
         epicsGuard < epicsMutex > guard ( this->iiu.mutex );
 
@@ -114,8 +121,15 @@ void tcpSendThread::run ()
                 this->iiu.echoRequest ( guard );
             }
 
+            epicsTime claimTime;
+            if ( this->iiu.createReqPend.count () ) {
+                claimTime = epicsTime::getCurrent ();
+            }
             while ( nciu * pChan = this->iiu.createReqPend.get () ) {
                 this->iiu.createChannelRequest ( *pChan, guard );
+                this->iiu.cacRef.connectStatsRef ( guard ).claimSent (
+                    pChan->connectPhaseEnd ( guard, claimTime ),
+                    pChan->nameCacheHit ( guard ) );
 
                 if ( CA_V42 ( this->iiu.minorProtocolVersion ) ) {
                     this->iiu.createRespPend.add ( *pChan );
@@ -379,32 +393,75 @@ void tcpiiu::recvBytes (
 tcpRecvThread::tcpRecvThread (
     class tcpiiu & iiuIn, class epicsMutex & cbMutexIn,
     cacContextNotify & ctxNotifyIn, const char * pName,
-    unsigned int stackSize, unsigned int priority  ) :
-    thread ( *this, pName, stackSize, priority ),
+    unsigned int stackSize, unsigned int priority,
+    tcpRecvEngine * pEngineIn ) :
+    pThread ( 0 ), pEngine ( pEngineIn ),
         iiu ( iiuIn ), cbMutex ( cbMutexIn ),
-        ctxNotify ( ctxNotifyIn ) {}
+        ctxNotify ( ctxNotifyIn ), pComBuf ( 0 ),
+        finished ( false )
+{
+    if ( ! this->pEngine ) {
+        this->pThread = new epicsThread ( *this, pName, stackSize, priority );
+    }
+}
 
 tcpRecvThread::~tcpRecvThread ()
 {
+    delete this->pThread;
 }
 
 void tcpRecvThread::start ()
 {
-    this->thread.start ();
+    if ( this->pThread ) {
+        this->pThread->start ();
+    }
+    else {
+        // the send thread connects the circuit
+        this->iiu.sendThread.start ();
+    }
 }
 
 void tcpRecvThread::show ( unsigned /* level */ ) const
 {
+    if ( this->pEngine ) {
+        ::printf ( "\t\tserviced by a receive engine thread\n" );
+    }
 }
 
 bool tcpRecvThread::exitWait ( double delay )
 {
-    return this->thread.exitWait ( delay );
+    if ( this->pThread ) {
+        return this->pThread->exitWait ( delay );
+    }
+    epicsGuard < epicsMutex > guard ( this->iiu.mutex );
+    if ( ! this->finished ) {
+        epicsGuardRelease < epicsMutex > unguard ( guard );
+        this->exitEvent.wait ( delay );
+    }
+    return this->finished;
 }
 
 void tcpRecvThread::exitWait ()
 {
-    this->thread.exitWait ();
+    if ( this->pThread ) {
+        this->pThread->exitWait ();
+        return;
+    }
+    while ( ! this->exitWait ( DBL_MAX ) ) {
+    }
+}
+
+// the engine must not touch this object once finished is set
+void tcpRecvThread::finish ()
+{
+    epicsGuard < epicsMutex > guard ( this->iiu.mutex );
+    this->finished = true;
+    this->exitEvent.signal ();
+}
+
+SOCKET tcpRecvThread::socket () const
+{
+    return this->iiu.sock;
 }
 
 bool tcpRecvThread::validFillStatus (
@@ -434,148 +491,217 @@ bool tcpRecvThread::validFillStatus (
     return false;
 }
 
-void tcpRecvThread::run ()
+// returns false, after destroying the circuit, if it didn't connect
+bool tcpRecvThread::connectCircuit ()
 {
+    bool connectSuccess = false;
+    {
+        epicsGuard < epicsMutex > guard ( this->iiu.mutex );
+        this->connect ( guard );
+        connectSuccess = this->iiu.state == tcpiiu::iiucs_connected;
+    }
+    if ( ! connectSuccess ) {
+        if ( this->pEngine ) {
+            this->finish ();
+        }
+        this->iiu.recvDog.shutdown ();
+        this->iiu.cacRef.destroyIIU ( this->iiu );
+        return false;
+    }
+    if ( this->iiu.isNameService () ) {
+        this->iiu.pSearchDest->setCircuit ( &this->iiu );
+        this->iiu.pSearchDest->enable ();
+    }
+    return true;
+}
+
+// called by the send thread before it starts
+bool tcpRecvThread::engineConnect ()
+{
+    if ( ! this->pEngine ) {
+        return true;
+    }
     try {
-        {
-            bool connectSuccess = false;
-            {
-                epicsGuard < epicsMutex > guard ( this->iiu.mutex );
-                this->connect ( guard );
-                connectSuccess = this->iiu.state == tcpiiu::iiucs_connected;
-            }
-            if ( ! connectSuccess ) {
-                this->iiu.recvDog.shutdown ();
-                this->iiu.cacRef.destroyIIU ( this->iiu );
-                return;
-            }
-            if ( this->iiu.isNameService () ) {
-                this->iiu.pSearchDest->setCircuit ( &this->iiu );
-                this->iiu.pSearchDest->enable ();
-            }
+        if ( ! this->connectCircuit () ) {
+            return false;
         }
+        this->pEngine->install ( *this );
+    }
+    catch ( ... ) {
+        errlogPrintf (
+            "CA client library tcp circuit connect "
+            "terminating due to C++ exception\n" );
+        epicsGuard < epicsMutex > guard ( this->iiu.mutex );
+        this->iiu.initiateAbortShutdown ( guard );
+        this->finish ();
+    }
+    return true;
+}
 
-        this->iiu.sendThread.start ();
-        epicsThreadPrivateSet ( caClientCallbackThreadId, &this->iiu );
-        this->iiu.cacRef.attachToClientCtx ();
+void tcpRecvThread::run ()
+{
+    try {
+        if ( ! this->connectCircuit () ) {
+            return;
+        }
+    }
+    catch ( ... ) {
+        errlogPrintf (
+            "CA client library tcp receive thread "
+            "terminating due to C++ exception\n" );
+        epicsGuard < epicsMutex > guard ( this->iiu.mutex );
+        this->iiu.initiateCleanShutdown ( guard );
+        return;
+    }
 
-        comBuf * pComBuf = 0;
-        while ( true ) {
+    this->iiu.sendThread.start ();
+    epicsThreadPrivateSet ( caClientCallbackThreadId, &this->iiu );
+    this->iiu.cacRef.attachToClientCtx ();
 
-            //
-            // We leave the bytes pending and fetch them after
-            // callbacks are enabled when running in the old preemptive
-            // call back disabled mode so that asynchronous wakeup via
-            // file manager call backs works correctly. This does not
-            // appear to impact performance.
-            //
-            if ( ! pComBuf ) {
-                pComBuf = new ( this->iiu.comBufMemMgr ) comBuf;
-            }
+    while ( this->receive () ) {
+    }
+}
 
-            statusWireIO stat;
-            pComBuf->fillFromWire ( this->iiu, stat );
+void tcpRecvThread::releaseComBuf ()
+{
+    if ( this->pComBuf ) {
+        this->pComBuf->~comBuf ();
+        this->iiu.comBufMemMgr.release ( this->pComBuf );
+        this->pComBuf = 0;
+    }
+}
 
-            epicsTime currentTime = epicsTime::getCurrent ();
+//
+// Receive and process one buffer from the wire. This returns false
+// when the circuit has shut down and there will be nothing more to do.
+//
+bool tcpRecvThread::receive ()
+{
+    try {
+        //
+        // We leave the bytes pending and fetch them after
+        // callbacks are enabled when running in the old preemptive
+        // call back disabled mode so that asynchronous wakeup via
+        // file manager call backs works correctly. This does not
+        // appear to impact performance.
+        //
+        // the rest of a large array is received where it will
+        // be converted, rather than being copied there from comBufs
+        char * pBody;
+        unsigned nBodyBytes = this->iiu.largeMsgBodyWanted ( pBody );
+
+        statusWireIO stat;
+        if ( nBodyBytes ) {
+            this->iiu.recvBytes ( pBody, nBodyBytes, stat );
+        }
+        else {
+            if ( ! this->pComBuf ) {
+                this->pComBuf = new ( this->iiu.comBufMemMgr ) comBuf;
+            }
+            this->pComBuf->fillFromWire ( this->iiu, stat );
+        }
 
-            {
-                epicsGuard < epicsMutex > guard ( this->iiu.mutex );
+        epicsTime currentTime = epicsTime::getCurrent ();
 
-                if ( ! this->validFillStatus ( guard, stat ) ) {
-                    break;
-                }
-                if ( stat.bytesCopied == 0u ) {
-                    continue;
-                }
+        {
+            epicsGuard < epicsMutex > guard ( this->iiu.mutex );
 
-                this->iiu.recvQue.pushLastComBufReceived ( *pComBuf );
-                pComBuf = 0;
+            if ( ! this->validFillStatus ( guard, stat ) ) {
+                this->releaseComBuf ();
+                return false;
+            }
+            if ( stat.bytesCopied == 0u ) {
+                return true;
+            }
 
-                this->iiu._receiveThreadIsBusy = true;
+            if ( nBodyBytes ) {
+                this->iiu.largeMsgBodyReceived ( stat.bytesCopied );
+            }
+            else {
+                this->iiu.recvQue.pushLastComBufReceived ( *this->pComBuf );
+                this->pComBuf = 0;
             }
 
-            bool sendWakeupNeeded = false;
-            {
-                // only one recv thread at a time may call callbacks
-                // - pendEvent() blocks until threads waiting for
-                // this lock get a chance to run
-                callbackManager mgr ( this->ctxNotify, this->cbMutex );
-
-                epicsGuard < epicsMutex > guard ( this->iiu.mutex );
-
-                // route legacy V42 channel connect through the recv thread -
-                // the only thread that should be taking the callback lock
-                while ( nciu * pChan = this->iiu.v42ConnCallbackPend.first () ) {
-                    this->iiu.connectNotify ( guard, *pChan );
-                    pChan->connect ( mgr.cbGuard, guard );
-                }
+            this->iiu._receiveThreadIsBusy = true;
+        }
 
-                this->iiu.unacknowledgedSendBytes = 0u;
+        bool sendWakeupNeeded = false;
+        {
+            // only one recv thread at a time may call callbacks
+            // - pendEvent() blocks until threads waiting for
+            // this lock get a chance to run
+            callbackManager mgr ( this->ctxNotify, this->cbMutex );
+
+            epicsGuard < epicsMutex > guard ( this->iiu.mutex );
+
+            // route legacy V42 channel connect through the recv thread -
+            // the only thread that should be taking the callback lock
+            while ( nciu * pChan = this->iiu.v42ConnCallbackPend.first () ) {
+                this->iiu.connectNotify ( guard, *pChan );
+                pChan->connect ( mgr.cbGuard, guard );
+            }
 
-                bool protocolOK = false;
-                {
-                    epicsGuardRelease < epicsMutex > unguard ( guard );
-                    // execute receive labor
-                    protocolOK = this->iiu.processIncoming ( currentTime, mgr );
-                }
+            this->iiu.unacknowledgedSendBytes = 0u;
 
-                if ( ! protocolOK ) {
-                    this->iiu.initiateAbortShutdown ( guard );
-                    break;
-                }
-                this->iiu._receiveThreadIsBusy = false;
-                // reschedule connection activity watchdog
-                this->iiu.recvDog.messageArrivalNotify ( guard );
-                //
-                // if this thread has connected channels with subscriptions
-                // that need to be sent then wakeup the send thread
-                if ( this->iiu.subscripReqPend.count() ) {
-                    sendWakeupNeeded = true;
-                }
+            bool protocolOK = false;
+            {
+                epicsGuardRelease < epicsMutex > unguard ( guard );
+                // execute receive labor
+                protocolOK = this->iiu.processIncoming ( currentTime, mgr );
             }
 
+            if ( ! protocolOK ) {
+                this->iiu.initiateAbortShutdown ( guard );
+                return false;
+            }
+            this->iiu._receiveThreadIsBusy = false;
+            // reschedule connection activity watchdog
+            this->iiu.recvDog.messageArrivalNotify ( guard );
             //
-            // we don't feel comfortable calling this with a lock applied
-            // (it might block for longer than we like)
-            //
-            // we would prefer to improve efficiency by trying, first, a
-            // recv with the new MSG_DONTWAIT flag set, but there isn't
-            // universal support
-            //
-            bool bytesArePending = this->iiu.bytesArePendingInOS ();
-            {
-                epicsGuard < epicsMutex > guard ( this->iiu.mutex );
-                if ( bytesArePending ) {
-                    if ( ! this->iiu.busyStateDetected ) {
-                        this->iiu.contigRecvMsgCount++;
-                        if ( this->iiu.contigRecvMsgCount >=
-                            this->iiu.cacRef.maxContiguousFrames ( guard ) ) {
-                            this->iiu.busyStateDetected = true;
-                            sendWakeupNeeded = true;
-                        }
-                    }
-                }
-                else {
-                    // if no bytes are pending then we must immediately
-                    // switch off flow control w/o waiting for more
-                    // data to arrive
-                    this->iiu.contigRecvMsgCount = 0u;
-                    if ( this->iiu.busyStateDetected ) {
+            // if this thread has connected channels with subscriptions
+            // that need to be sent then wakeup the send thread
+            if ( this->iiu.subscripReqPend.count() ) {
+                sendWakeupNeeded = true;
+            }
+        }
+
+        //
+        // we don't feel comfortable calling this with a lock applied
+        // (it might block for longer than we like)
+        //
+        // we would prefer to improve efficiency by trying, first, a
+        // recv with the new MSG_DONTWAIT flag set, but there isn't
+        // universal support
+        //
+        bool bytesArePending = this->iiu.bytesArePendingInOS ();
+        {
+            epicsGuard < epicsMutex > guard ( this->iiu.mutex );
+            if ( bytesArePending ) {
+                if ( ! this->iiu.busyStateDetected ) {
+                    this->iiu.contigRecvMsgCount++;
+                    if ( this->iiu.contigRecvMsgCount >=
+                        this->iiu.cacRef.maxContiguousFrames ( guard ) ) {
+                        this->iiu.busyStateDetected = true;
                         sendWakeupNeeded = true;
-                        this->iiu.busyStateDetected = false;
                     }
                 }
             }
-
-            if ( sendWakeupNeeded ) {
-                this->iiu.sendThreadFlushEvent.signal ();
+            else {
+                // if no bytes are pending then we must immediately
+                // switch off flow control w/o waiting for more
+                // data to arrive
+                this->iiu.contigRecvMsgCount = 0u;
+                if ( this->iiu.busyStateDetected ) {
+                    sendWakeupNeeded = true;
+                    this->iiu.busyStateDetected = false;
+                }
             }
         }
 
-        if ( pComBuf ) {
-            pComBuf->~comBuf ();
-            this->iiu.comBufMemMgr.release ( pComBuf );
+        if ( sendWakeupNeeded ) {
+            this->iiu.sendThreadFlushEvent.signal ();
         }
+        return true;
     }
     catch ( std::bad_alloc & ) {
         errlogPrintf (
@@ -600,6 +726,8 @@ void tcpRecvThread::run ()
         epicsGuard < epicsMutex > guard ( this->iiu.mutex );
         this->iiu.initiateCleanShutdown ( guard );
     }
+    this->releaseComBuf ();
+    return false;
 }
 
 /*
@@ -675,7 +803,8 @@ tcpiiu::tcpiiu (
     hostNameCacheInstance ( addrIn, engineIn ),
     recvThread ( *this, cbMutexIn, ctxNotifyIn, "CAC-TCP-recv",
         epicsThreadGetStackSize ( epicsThreadStackBig ),
-        cac::highestPriorityLevelBelow ( cac.getInitializingThreadsPriority() ) ),
+        cac::highestPriorityLevelBelow ( cac.getInitializingThreadsPriority() ),
+        cac.tcpReceiveEngine () ),
     sendThread ( *this, "CAC-TCP-send",
         epicsThreadGetStackSize ( epicsThreadStackMedium ),
         cac::lowestPriorityLevelAbove (
@@ -691,6 +820,7 @@ tcpiiu::tcpiiu (
     comBufMemMgr ( comBufMemMgrIn ),
     cacRef ( cac ),
     pCurData ( (char*) freeListMalloc(this->cacRef.tcpSmallRecvBufFreeList) ),
+    pSmallData ( this->pCurData ),
     pSearchDest ( pSearchDestIn ),
     mutex ( mutexIn ),
     cbMutex ( cbMutexIn ),
@@ -1028,17 +1158,8 @@ tcpiiu :: ~tcpiiu ()
     }
 
     // free message body cache
-    if ( this->pCurData ) {
-        if ( this->curDataMax <= MAX_TCP ) {
-            freeListFree(this->cacRef.tcpSmallRecvBufFreeList, this->pCurData);
-        }
-        else if ( this->cacRef.tcpLargeRecvBufFreeList ) {
-            freeListFree(this->cacRef.tcpLargeRecvBufFreeList, this->pCurData);
-        }
-        else {
-            free ( this->pCurData );
-        }
-    }
+    this->releaseLargeMsgBody ();
+    freeListFree ( this->cacRef.tcpSmallRecvBufFreeList, this->pSmallData );
 }
 
 void tcpiiu::show ( unsigned level ) const
@@ -1203,49 +1324,23 @@ bool tcpiiu::processIncoming (
         }
 
         //
-        // make sure we have a large enough message body cache
+        // make sure we have a large enough message body cache, taking
+        // a right sized buffer from the context's pool for large arrays
         //
         if ( this->curMsg.m_postsize > this->curDataMax ) {
-            assert (this->curMsg.m_postsize > MAX_TCP);
-
-            char * newbuf = NULL;
-            arrayElementCount newsize;
-
-            if ( !this->cacRef.tcpLargeRecvBufFreeList ) {
-                // round size up to multiple of 4K
-                newsize = ((this->curMsg.m_postsize-1)|0xfff)+1;
-
-                if ( this->curDataMax <= MAX_TCP ) {
-                    // small -> large
-                    newbuf = (char*)malloc(newsize);
-
-                } else {
-                    // expand large to larger
-                    newbuf = (char*)realloc(this->pCurData, newsize);
+            assert ( this->curMsg.m_postsize > MAX_TCP );
+            recvBufPool & pool = *this->cacRef.pLargeRecvBufPool;
+            if ( pool.withinLimit ( this->curMsg.m_postsize ) ) {
+                arrayElementCount newsize;
+                char * newbuf = pool.allocateBuf ( this->curMsg.m_postsize, newsize );
+                if ( newbuf ) {
+                    this->pCurData = newbuf;
+                    this->curDataMax = newsize;
                 }
-
-            } else if ( this->curMsg.m_postsize <= this->cacRef.maxRecvBytesTCP ) {
-                newbuf = (char*) freeListMalloc(this->cacRef.tcpLargeRecvBufFreeList);
-                newsize = this->cacRef.maxRecvBytesTCP;
-
-            }
-
-            if ( newbuf) {
-                if (this->curDataMax <= MAX_TCP) {
-                    freeListFree(this->cacRef.tcpSmallRecvBufFreeList, this->pCurData );
-
-                } else if (this->cacRef.tcpLargeRecvBufFreeList) {
-                    freeListFree(this->cacRef.tcpLargeRecvBufFreeList, this->pCurData );
-
-                } else {
-                    // called realloc()
+                else {
+                    this->printFormated ( mgr.cbGuard,
+                        "CAC: not enough memory for message body cache (ignoring response message)\n");
                 }
-                this->pCurData = newbuf;
-                this->curDataMax = newsize;
-
-            } else {
-                this->printFormated ( mgr.cbGuard,
-                    "CAC: not enough memory for message body cache (ignoring response message)\n");
             }
         }
 
@@ -1286,6 +1381,40 @@ bool tcpiiu::processIncoming (
         this->oldMsgHeaderAvailable = false;
         this->msgHeaderAvailable = false;
         this->curDataBytes = 0u;
+        this->releaseLargeMsgBody ();
+    }
+}
+
+//
+// When only part of a large message body has arrived, and nothing
+// else is waiting in the receive queue, the rest of the body can be
+// read from the socket directly into the message body cache.
+//
+unsigned tcpiiu::largeMsgBodyWanted ( char * & pBuf ) const
+{
+    if ( this->pCurData == this->pSmallData ||
+            ! this->msgHeaderAvailable ||
+            this->curDataBytes >= this->curMsg.m_postsize ||
+            this->recvQue.occupiedBytes () > 0u ) {
+        return 0u;
+    }
+    pBuf = & this->pCurData[this->curDataBytes];
+    arrayElementCount nBytes = this->curMsg.m_postsize - this->curDataBytes;
+    return nBytes < INT_MAX ? static_cast < unsigned > ( nBytes ) : INT_MAX;
+}
+
+void tcpiiu::largeMsgBodyReceived ( unsigned nBytes )
+{
+    this->curDataBytes += nBytes;
+}
+
+// return the message body buffer to the pool
+void tcpiiu::releaseLargeMsgBody ()
+{
+    if ( this->pCurData != this->pSmallData ) {
+        recvBufPool::releaseBuf ( this->pCurData );
+        this->pCurData = this->pSmallData;
+        this->curDataMax = MAX_TCP;
     }
 }
 
@@ -1943,7 +2072,8 @@ void tcpiiu::unlinkAllChannels (
 void tcpiiu::installChannel (
     epicsGuard < epicsMutex > & guard,
     nciu & chan, unsigned sidIn,
-    ca_uint16_t typeIn, arrayElementCount countIn )
+    ca_uint16_t typeIn, arrayElementCount countIn,
+    bool flushNow )
 {
     guard.assertIdenticalMutex ( this->mutex );
 
@@ -1952,8 +2082,11 @@ void tcpiiu::installChannel (
     chan.channelNode::listMember = channelNode::cs_createReqPend;
     chan.searchReplySetUp ( *this, sidIn, typeIn, countIn, guard );
     // The tcp send thread runs at a priority below the udp thread
-    // so that this will not send small packets
-    this->sendThreadFlushEvent.signal ();
+    // so that this will not send small packets. Otherwise the
+    // request is sent when the application flushes.
+    if ( flushNow ) {
+        this->sendThreadFlushEvent.signal ();
+    }
 }
 
 bool tcpiiu :: connectNotify (
@@ -2038,7 +2171,8 @@ int tcpiiu :: printFormated (
 
 void tcpiiu::flushRequest ( epicsGuard < epicsMutex > & )
 {
-    if ( this->sendQue.occupiedBytes () > 0 ) {
+    if ( this->sendQue.occupiedBytes () > 0 ||
+            this->createReqPend.count () > 0u ) {
         this->sendThreadFlushEvent.signal ();
     }
 }
@@ -2086,7 +2220,10 @@ double tcpiiu::receiveWatchdogDelay (
  */
 void tcpRecvThread::interruptSocketRecv ()
 {
-    epicsThreadId threadId = this->thread.getId ();
+    if ( ! this->pThread ) {
+        return;
+    }
+    epicsThreadId threadId = this->pThread->getId ();
     if ( threadId ) {
         epicsSignalRaiseSigAlarm ( threadId );
     }
@@ -25,6 +25,10 @@
 
 #define epicsAssertAuthor "Jeff Hill johill@lanl.gov"
 
+#if defined ( __linux__ )
+#   define CA_UDP_SENDMMSG
+#endif
+
 #include "envDefs.h"
 #include "dbDefs.h"
 #include "osiProcess.h"
@@ -131,16 +135,32 @@ udpiiu::udpiiu (
     repeaterSubscribeTmr (
         m_repeaterTimerNotify, timerQueue, cbMutexIn, ctxNotifyIn ),
     govTmr ( *this, timerQueue, cacMutexIn ),
+    anomalyTmr ( *this, timerQueue, cacMutexIn ),
     maxPeriod ( getMaxPeriod() ),
     rtteMean ( minRoundTripEstimate ),
     rtteMeanDev ( 0 ),
+    searchTokenTime ( epicsTime::getCurrent () ),
+    searchTokens ( initialSearchWindow ),
+    searchWindow ( initialSearchWindow ),
+    searchWindowThresh ( maxSearchWindow ),
+    connectRateBegin ( searchTokenTime ),
+    connectRateLast ( searchTokenTime ),
+    connectRate ( 0.0 ),
+    connectRatePeak ( 0.0 ),
+    searchFrameCount ( 0u ),
+    searchNameCount ( 0u ),
+    searchRespCount ( 0u ),
+    searchLossCount ( 0u ),
+    connectRateCount ( 0u ),
     cacRef ( cac ),
     cbMutex ( cbMutexIn ),
     cacMutex ( cacMutexIn ),
     nTimers ( getNTimers(maxPeriod) ),
     ppSearchTmr ( nTimers ),
     nBytesInXmitBuf ( 0 ),
+    nXmitFrames ( 0 ),
     beaconAnomalyTimerIndex ( 0 ),
+    nBeaconsInBatch ( 0u ),
     sequenceNumber ( 0 ),
     lastReceivedSeqNo ( 0 ),
     sock ( 0 ),
@@ -335,6 +355,7 @@ void udpiiu::shutdown (
     epicsGuard < epicsMutex > & guard )
 {
     // stop all of the timers
+    this->anomalyTmr.shutdown ( cbGuard, guard );
     this->repeaterSubscribeTmr.shutdown ( cbGuard, guard );
     this->govTmr.shutdown ( cbGuard, guard );
     for ( unsigned i =0; i < this->nTimers; i++ ) {
@@ -438,6 +459,13 @@ void udpRecvThread::run ()
                 (arrayElementCount) status, epicsTime::getCurrent() );
         }
 
+        // the beacons of a burst, as after many servers restart,
+        // are handed to the client context together
+        if ( this->iiu.nBeaconsInBatch > 0u &&
+                ! this->iiu.datagramsPending () ) {
+            this->iiu.flushBeacons ();
+        }
+
     } while ( ! this->iiu.shutdownCmd );
 }
 
@@ -777,15 +805,37 @@ bool udpiiu::beaconAction (
          */
         ina.sin_port = htons ( this->serverPort );
     }
-    unsigned protocolRevision = msg.m_dataType;
-    ca_uint32_t beaconNumber = msg.m_cid;
-
-    this->cacRef.beaconNotify ( ina, currentTime,
-        beaconNumber, protocolRevision );
+    if ( this->nBeaconsInBatch == 0u ) {
+        this->beaconBatchTime = currentTime;
+    }
+    beaconInfo & beacon = this->beaconBatch [ this->nBeaconsInBatch++ ];
+    beacon.addr = ina.sin_addr.s_addr;
+    beacon.port = ina.sin_port;
+    beacon.protocolRevision = msg.m_dataType;
+    beacon.beaconNumber = msg.m_cid;
+    if ( this->nBeaconsInBatch >= maxBeaconBatch ) {
+        this->flushBeacons ();
+    }
 
     return true;
 }
 
+// called only by the receive thread
+void udpiiu::flushBeacons ()
+{
+    this->cacRef.beaconNotify ( this->beaconBatch,
+        this->nBeaconsInBatch, this->beaconBatchTime );
+    this->nBeaconsInBatch = 0u;
+}
+
+bool udpiiu::datagramsPending () const
+{
+    osiSockIoctl_t bytesPending = 0;
+    int status = socket_ioctl ( this->sock,
+                            FIONREAD, & bytesPending );
+    return status >= 0 && bytesPending > 0;
+}
+
 bool udpiiu::repeaterAckAction (
     const caHdr &,
     const osiSockAddr &, const epicsTime &)
@@ -933,15 +983,16 @@ bool udpiiu::pushDatagramMsg ( epicsGuard < epicsMutex > & guard,
     arrayElementCount msgsize = sizeof ( caHdr ) + alignedExtSize;
 
     /* fail out if max message size exceeded */
-    if ( msgsize >= sizeof ( this->xmitBuf ) - 7 ) {
+    if ( msgsize >= sizeof ( this->xmitBuf[0] ) - 7 ) {
         return false;
     }
 
-    if ( msgsize + this->nBytesInXmitBuf > sizeof ( this->xmitBuf ) ) {
+    if ( msgsize + this->nBytesInXmitBuf > sizeof ( this->xmitBuf[0] ) ) {
         return false;
     }
 
-    caHdr * pbufmsg = ( caHdr * ) &this->xmitBuf[this->nBytesInXmitBuf];
+    char * pFrame = this->xmitBuf[this->nXmitFrames];
+    caHdr * pbufmsg = ( caHdr * ) &pFrame[this->nBytesInXmitBuf];
     *pbufmsg = msg;
     if ( extsize && pExt ) {
         memcpy ( pbufmsg + 1, pExt, extsize );
@@ -973,57 +1024,111 @@ void udpiiu :: SearchDestUDP :: searchRequest (
         int status = sendto ( _udpiiu.sock, const_cast<char *>(pBuf), bufSizeAsInt, 0,
                 & _destAddr.sa, sizeof ( _destAddr.sa ) );
         if ( status == bufSizeAsInt ) {
-            if ( _lastError ) {
-                char buf[64];
-                sockAddrToDottedIP ( &_destAddr.sa, buf, sizeof ( buf ) );
-                errlogPrintf (
-                    "CAC: ok sending UDP msg to %s\n", buf);
-            }
-            _lastError = 0;
+            this->sendOk ();
             break;
         }
         if ( status >= 0 ) {
             errlogPrintf ( "CAC: UDP sendto () call returned strange xmit count?\n" );
             break;
         }
-        else {
-            int localErrno = SOCKERRNO;
+        else if ( ! this->sendFailed ( SOCKERRNO ) ) {
+            break;
+        }
+    }
+}
 
-            if ( localErrno == SOCK_EINTR ) {
-                if ( _udpiiu.shutdownCmd ) {
-                    break;
-                }
-                else {
-                    continue;
+#ifdef CA_UDP_SENDMMSG
+//
+// the whole batch goes to this destination in one system call
+//
+void udpiiu :: SearchDestUDP :: searchRequestBatch (
+    epicsGuard < epicsMutex > & guard, const char * const * ppBuf,
+    const size_t * pLen, unsigned nFrames )
+{
+    guard.assertIdenticalMutex ( _udpiiu.cacMutex );
+    assert ( nFrames <= maxSearchFrameBatch );
+    struct mmsghdr msgs [maxSearchFrameBatch];
+    struct iovec iov [maxSearchFrameBatch];
+    memset ( msgs, 0, sizeof ( msgs ) );
+    for ( unsigned i = 0u; i < nFrames; i++ ) {
+        iov[i].iov_base = const_cast < char * > ( ppBuf[i] );
+        iov[i].iov_len = pLen[i];
+        msgs[i].msg_hdr.msg_name = & _destAddr.sa;
+        msgs[i].msg_hdr.msg_namelen = sizeof ( _destAddr.sa );
+        msgs[i].msg_hdr.msg_iov = & iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    unsigned nSent = 0u;
+    while ( nSent < nFrames ) {
+        int status = sendmmsg ( _udpiiu.sock, & msgs[nSent],
+            nFrames - nSent, 0 );
+        if ( status > 0 ) {
+            for ( int i = 0; i < status; i++ ) {
+                if ( msgs[nSent + i].msg_len != pLen[nSent + i] ) {
+                    errlogPrintf ( "CAC: UDP sendmmsg () call returned strange xmit count?\n" );
                 }
             }
-            else if ( localErrno == SOCK_SHUTDOWN ) {
-                break;
-            }
-            else if ( localErrno == SOCK_ENOTSOCK ) {
-                break;
-            }
-            else if ( localErrno == SOCK_EBADF ) {
-                break;
-            }
-            else if ( localErrno == _lastError) {
-                break;
-            } else {
-                char sockErrBuf[64];
-                epicsSocketConvertErrnoToString (
-                    sockErrBuf, sizeof ( sockErrBuf ) );
-                char buf[64];
-                sockAddrToDottedIP ( &_destAddr.sa, buf, sizeof ( buf ) );
-                errlogPrintf (
-                    "CAC: error = \"%s\" sending UDP msg to %s\n",
-                    sockErrBuf, buf);
-
-                _lastError = localErrno;
-                break;
-            }
+            nSent += static_cast < unsigned > ( status );
+            this->sendOk ();
+        }
+        else if ( status == 0 || ! this->sendFailed ( SOCKERRNO ) ) {
+            // the rest of this batch is lost, as with sendto ()
+            break;
         }
     }
 }
+#else
+void udpiiu :: SearchDestUDP :: searchRequestBatch (
+    epicsGuard < epicsMutex > & guard, const char * const * ppBuf,
+    const size_t * pLen, unsigned nFrames )
+{
+    SearchDest :: searchRequestBatch ( guard, ppBuf, pLen, nFrames );
+}
+#endif
+
+void udpiiu :: SearchDestUDP :: sendOk ()
+{
+    if ( _lastError ) {
+        char buf[64];
+        sockAddrToDottedIP ( &_destAddr.sa, buf, sizeof ( buf ) );
+        errlogPrintf (
+            "CAC: ok sending UDP msg to %s\n", buf);
+    }
+    _lastError = 0;
+}
+
+//
+// returns true if the send should be tried again
+//
+bool udpiiu :: SearchDestUDP :: sendFailed ( int localErrno )
+{
+    if ( localErrno == SOCK_EINTR ) {
+        return ! _udpiiu.shutdownCmd;
+    }
+    else if ( localErrno == SOCK_SHUTDOWN ) {
+        return false;
+    }
+    else if ( localErrno == SOCK_ENOTSOCK ) {
+        return false;
+    }
+    else if ( localErrno == SOCK_EBADF ) {
+        return false;
+    }
+    else if ( localErrno == _lastError) {
+        return false;
+    }
+    char sockErrBuf[64];
+    epicsSocketConvertErrnoToString (
+        sockErrBuf, sizeof ( sockErrBuf ) );
+    char buf[64];
+    sockAddrToDottedIP ( &_destAddr.sa, buf, sizeof ( buf ) );
+    errlogPrintf (
+        "CAC: error = \"%s\" sending UDP msg to %s\n",
+        sockErrBuf, buf);
+
+    _lastError = localErrno;
+    return false;
+}
 
 void udpiiu :: SearchDestUDP :: show (
     epicsGuard < epicsMutex > & guard, unsigned level ) const
@@ -1124,18 +1229,116 @@ bool udpiiu :: datagramFlush (
         return false;
     }
 
+    // each frame takes one token from the search rate limit
+    this->searchTokens -= 1.0;
+    this->searchFrameCount++;
+
+    this->xmitFrameBytes[this->nXmitFrames] = this->nBytesInXmitBuf;
+    this->nXmitFrames++;
+    this->nBytesInXmitBuf = 0u;
+    if ( this->nXmitFrames >= maxSearchFrameBatch ) {
+        this->datagramSend ( guard );
+    }
+
+    this->pushVersionMsg ();
+
+    return true;
+}
+
+void udpiiu :: datagramSend ( epicsGuard < epicsMutex > & guard )
+{
+    guard.assertIdenticalMutex ( cacMutex );
+
+    if ( this->nXmitFrames == 0u ) {
+        return;
+    }
+
+    const char * pFrames [maxSearchFrameBatch];
+    for ( unsigned i = 0u; i < this->nXmitFrames; i++ ) {
+        pFrames[i] = this->xmitBuf[i];
+    }
+
     tsDLIter < SearchDest > iter ( _searchDestList.firstIter () );
     while ( iter.valid () )
     {
-        iter->searchRequest ( guard, this->xmitBuf, this->nBytesInXmitBuf );
+        iter->searchRequestBatch ( guard, pFrames,
+            this->xmitFrameBytes, this->nXmitFrames );
         iter++;
     }
 
-    this->nBytesInXmitBuf = 0u;
+    // move any partly built frame to the start of the batch
+    if ( this->nBytesInXmitBuf > 0u && this->nXmitFrames < maxSearchFrameBatch ) {
+        memmove ( this->xmitBuf[0], this->xmitBuf[this->nXmitFrames],
+            this->nBytesInXmitBuf );
+    }
+    this->nXmitFrames = 0u;
+}
 
-    this->pushVersionMsg ();
+//
+// Search frames are paced by a token bucket which is shared by all of
+// the search timers. Tokens accumulate at searchWindow frames per
+// estimated round trip time, and at most one window may be sent in a
+// burst. The window grows while the search response ratio stays
+// normal, and is halved when it drops, in the same spirit as TCP
+// congestion control.
+//
+double udpiiu :: searchFramesAllowed (
+    epicsGuard < epicsMutex > & guard, const epicsTime & currentTime )
+{
+    guard.assertIdenticalMutex ( cacMutex );
+    double elapsed = currentTime - this->searchTokenTime;
+    if ( elapsed > 0.0 ) {
+        this->searchTokens += elapsed * this->searchWindow / this->getRTTE ( guard );
+        if ( this->searchTokens > this->searchWindow ) {
+            this->searchTokens = this->searchWindow;
+        }
+        this->searchTokenTime = currentTime;
+    }
+    return this->searchTokens;
+}
 
-    return true;
+double udpiiu :: searchFrameDelay ( epicsGuard < epicsMutex > & guard ) const
+{
+    guard.assertIdenticalMutex ( cacMutex );
+    // the timer queue expires a timer again at the same current time
+    // if the delay is shorter than its quantum, so never ask for less
+    double delay = ( 1.0 - this->searchTokens ) *
+        this->getRTTE ( guard ) / this->searchWindow;
+    double quantum = epicsThreadSleepQuantum ();
+    if ( delay < quantum ) {
+        delay = quantum;
+    }
+    return delay;
+}
+
+void udpiiu :: searchLossNotify (
+    epicsGuard < epicsMutex > & guard, bool lossDetected )
+{
+    guard.assertIdenticalMutex ( cacMutex );
+    if ( lossDetected ) {
+        this->searchLossCount++;
+        this->searchWindowThresh = this->searchWindow / 2.0;
+        if ( this->searchWindowThresh < minSearchWindow ) {
+            this->searchWindowThresh = minSearchWindow;
+        }
+        this->searchWindow = this->searchWindowThresh;
+        if ( this->searchTokens > this->searchWindow ) {
+            this->searchTokens = this->searchWindow;
+        }
+        debugPrintf ( ( "Search loss - window %g frames\n", this->searchWindow ) );
+    }
+    else if ( this->searchWindow < this->searchWindowThresh ) {
+        this->searchWindow *= 2.0;
+        if ( this->searchWindow > this->searchWindowThresh ) {
+            this->searchWindow = this->searchWindowThresh;
+        }
+    }
+    else {
+        this->searchWindow += 1.0;
+    }
+    if ( this->searchWindow > maxSearchWindow ) {
+        this->searchWindow = maxSearchWindow;
+    }
 }
 
 void udpiiu :: show ( unsigned level ) const
@@ -1143,6 +1346,24 @@ void udpiiu :: show ( unsigned level ) const
     epicsGuard < epicsMutex > guard ( this->cacMutex );
 
     ::printf ( "Datagram IO circuit (and disconnected channel repository)\n");
+    ::printf ( "\tsearch frames %lu, names %lu, responses %lu, loss events %lu\n",
+        this->searchFrameCount, this->searchNameCount,
+        this->searchRespCount, this->searchLossCount );
+    ::printf ( "\tsearch window %g frames per %g sec round trip, %.1f frames/sec\n",
+        this->searchWindow, this->getRTTE ( guard ),
+        this->searchWindow / this->getRTTE ( guard ) );
+    double rate = this->connectRate;
+    double peak = this->connectRatePeak;
+    double interval = this->connectRateLast - this->connectRateBegin;
+    if ( this->connectRateCount > 1u && interval > 0.0 ) {
+        // the interval in progress
+        rate = this->connectRateCount / interval;
+        if ( rate > peak ) {
+            peak = rate;
+        }
+    }
+    ::printf ( "\tconnect rate %.1f channels/sec, peak %.1f channels/sec\n",
+        rate, peak );
     if ( level > 1u ) {
         ::printf ("\trepeater port %u\n", this->repeaterPort );
         ::printf ("\tdefault server port %u\n", this->serverPort );
@@ -1166,6 +1387,7 @@ void udpiiu :: show ( unsigned level ) const
         this->recvThread.show ( level - 2u );
         this->repeaterSubscribeTmr.show ( level - 2u );
         this->govTmr.show ( level - 2u );
+        this->anomalyTmr.show ( guard, level - 2u );
     }
     if ( level > 3u ) {
         for ( unsigned i =0; i < this->nTimers; i++ ) {
@@ -1195,8 +1417,15 @@ bool udpiiu::wakeupMsg ()
     return status == sizeof (msg);
 }
 
+// the search boost is delayed by the anomaly timer
 void udpiiu::beaconAnomalyNotify (
     epicsGuard < epicsMutex > & cacGuard )
+{
+    this->anomalyTmr.anomalyNotify ( cacGuard );
+}
+
+void udpiiu::beaconAnomalyBoost (
+    epicsGuard < epicsMutex > & cacGuard )
 {
     for ( unsigned i = this->beaconAnomalyTimerIndex+1u;
             i < this->nTimers; i++ ) {
@@ -1209,13 +1438,38 @@ void udpiiu::uninstallChanDueToSuccessfulSearchResponse (
     epicsGuard < epicsMutex > & guard, nciu & chan,
     const epicsTime & currentTime )
 {
+    // the connect rate is measured over intervals of about one second
+    // that begin with the first search response after the last one
+    this->searchRespCount++;
+    if ( this->connectRateCount == 0u ) {
+        this->connectRateBegin = currentTime;
+    }
+    this->connectRateCount++;
+    this->connectRateLast = currentTime;
+    double interval = currentTime - this->connectRateBegin;
+    if ( interval >= 1.0 ) {
+        this->connectRate = this->connectRateCount / interval;
+        if ( this->connectRate > this->connectRatePeak ) {
+            this->connectRatePeak = this->connectRate;
+        }
+        this->connectRateCount = 0u;
+    }
+
     channelNode::channelState chanState =
         chan.channelNode::listMember;
+    unsigned timerStage = connectStats::noTimerStage;
+    if ( chanState != channelNode::cs_disconnGov ) {
+        timerStage = chan.getSearchTimerIndex ( guard );
+    }
+    this->cacRef.connectStatsRef ( guard ).searchReply (
+        chan.connectPhaseEnd ( guard, currentTime ),
+        chan.searchAttempts ( guard ), timerStage );
+
     if ( chanState == channelNode::cs_disconnGov ) {
         this->govTmr.uninstallChan ( guard, chan );
     }
     else {
-        this->ppSearchTmr[ chan.getSearchTimerIndex ( guard ) ]->
+        this->ppSearchTmr[ timerStage ]->
             uninstallChanDueToSuccessfulSearchResponse (
             guard, chan, this->lastReceivedSeqNo,
             this->lastReceivedSeqNoIsValid, currentTime );
@@ -1246,14 +1500,19 @@ bool udpiiu::searchMsg (
     AlignedWireRef < epicsUInt16 > ( msg.m_dataType ) = DONTREPLY;
     AlignedWireRef < epicsUInt16 > ( msg.m_count ) = CA_MINOR_PROTOCOL_REVISION;
     AlignedWireRef < epicsUInt32 > ( msg.m_cid ) = id;
-    return this->pushDatagramMsg (
+    bool success = this->pushDatagramMsg (
         guard, msg, pName, (ca_uint16_t) nameLength );
+    if ( success ) {
+        this->searchNameCount++;
+    }
+    return success;
 }
 
 void udpiiu::installNewChannel (
     epicsGuard < epicsMutex > & guard, nciu & chan, netiiu * & piiu )
 {
     piiu = this;
+    chan.connectPhaseBegin ( guard, epicsTime::getCurrent () );
     this->ppSearchTmr[0]->installChannel ( guard, chan );
 }
 
@@ -1261,6 +1520,14 @@ void udpiiu::installDisconnectedChannel (
     epicsGuard < epicsMutex > & guard, nciu & chan )
 {
     chan.setServerAddressUnknown ( *this, guard );
+    if ( chan.nameCacheHit ( guard ) ) {
+        // the name cache was wrong, so search now without the
+        // delay intended for channels that were connected
+        this->cacRef.nameCacheRemove ( guard, chan );
+        chan.connectPhaseBegin ( guard, epicsTime::getCurrent () );
+        this->ppSearchTmr[0]->installChannel ( guard, chan );
+        return;
+    }
     this->govTmr.installChan ( guard, chan );
 }
 
@@ -1287,6 +1554,7 @@ void udpiiu::boostChannel (
 void udpiiu::govExpireNotify (
     epicsGuard < epicsMutex > & guard, nciu & chan )
 {
+    chan.connectPhaseBegin ( guard, epicsTime::getCurrent () );
     this->ppSearchTmr[0]->installChannel ( guard, chan );
 }
 
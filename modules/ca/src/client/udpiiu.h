@@ -35,8 +35,10 @@
 
 #include "libCaAPI.h"
 #include "netiiu.h"
+#include "bhe.h"
 #include "searchTimer.h"
 #include "disconnectGovernorTimer.h"
+#include "beaconAnomalyTimer.h"
 #include "repeaterSubscribeTimer.h"
 #include "SearchDest.h"
 
@@ -87,11 +89,17 @@ static const double maxRoundTripEstimate = 30; // seconds
 static const double maxSearchPeriodDefault = 5.0 * 60.0; // seconds
 static const double maxSearchPeriodLowerLimit = 60.0; // seconds
 static const double beaconAnomalySearchPeriod = 5.0; // seconds
+static const double initialSearchWindow = 16.0; // search frames per round trip
+static const double minSearchWindow = 1.0; // search frames per round trip
+static const double maxSearchWindow = 1024.0; // search frames per round trip
+static const unsigned maxSearchFrameBatch = 24u; // search frames per send call
+static const unsigned maxBeaconBatch = 64u; // beacons per call to cac::beaconNotify
 
 class udpiiu :
     private netiiu,
     private searchTimerNotify,
-    private disconnectGovernorNotify {
+    private disconnectGovernorNotify,
+    private beaconAnomalyTimerNotify {
 public:
     udpiiu (
         epicsGuard < epicsMutex > & cacGuard,
@@ -123,12 +131,17 @@ private:
         SearchDestUDP ( const osiSockAddr &, udpiiu & );
         void searchRequest (
             epicsGuard < epicsMutex > &, const char * pBuf, size_t bufLen );
+        void searchRequestBatch (
+            epicsGuard < epicsMutex > &, const char * const * ppBuf,
+            const size_t * pLen, unsigned nFrames );
         void show (
             epicsGuard < epicsMutex > &, unsigned level ) const;
     private:
         int _lastError;
         osiSockAddr _destAddr;
         udpiiu & _udpiiu;
+        void sendOk ();
+        bool sendFailed ( int localErrno );
     };
     class SearchRespCallback :
         public SearchDest :: Callback {
@@ -157,16 +170,35 @@ private:
     private:
         udpiiu & m_udpiiu;
     };
-    char xmitBuf [MAX_UDP_SEND];
+    // search frames are queued and sent in batches
+    char xmitBuf [maxSearchFrameBatch][MAX_UDP_SEND];
+    size_t xmitFrameBytes [maxSearchFrameBatch];
     char recvBuf [MAX_UDP_RECV];
+    // beacons received in one burst, used only by the receive thread
+    beaconInfo beaconBatch [maxBeaconBatch];
+    epicsTime beaconBatchTime;
     udpRecvThread recvThread;
     M_repeaterTimerNotify m_repeaterTimerNotify;
     repeaterSubscribeTimer repeaterSubscribeTmr;
     disconnectGovernorTimer govTmr;
+    beaconAnomalyTimer anomalyTmr;
     tsDLList < SearchDest > _searchDestList;
     const double maxPeriod;
     double rtteMean;
     double rtteMeanDev;
+    epicsTime searchTokenTime;
+    double searchTokens;
+    double searchWindow;
+    double searchWindowThresh;
+    epicsTime connectRateBegin;
+    epicsTime connectRateLast;
+    double connectRate;
+    double connectRatePeak;
+    unsigned long searchFrameCount;
+    unsigned long searchNameCount;
+    unsigned long searchRespCount;
+    unsigned long searchLossCount;
+    unsigned connectRateCount;
     cac & cacRef;
     epicsMutex & cbMutex;
     epicsMutex & cacMutex;
@@ -182,7 +214,9 @@ private:
         SearchArray& operator=(const SearchArray&);
     } ppSearchTmr;
     unsigned nBytesInXmitBuf;
+    unsigned nXmitFrames;
     unsigned beaconAnomalyTimerIndex;
+    unsigned nBeaconsInBatch;
     ca_uint32_t sequenceNumber;
     ca_uint32_t lastReceivedSeqNo;
     SOCKET sock;
@@ -193,6 +227,8 @@ private:
     bool lastReceivedSeqNoIsValid;
 
     bool wakeupMsg ();
+    bool datagramsPending () const;
+    void flushBeacons ();
 
     void postMsg (
             const osiSockAddr & net_addr,
@@ -301,11 +337,20 @@ private:
         epicsGuard < epicsMutex > &, const epicsTime & currentTime );
     ca_uint32_t datagramSeqNumber (
         epicsGuard < epicsMutex > & ) const;
+    void datagramSend ( epicsGuard < epicsMutex > & );
+    double searchFramesAllowed (
+        epicsGuard < epicsMutex > &, const epicsTime & currentTime );
+    double searchFrameDelay ( epicsGuard < epicsMutex > & ) const;
+    void searchLossNotify ( epicsGuard < epicsMutex > &, bool lossDetected );
 
     // disconnectGovernorNotify
     void govExpireNotify (
         epicsGuard < epicsMutex > &, nciu & );
 
+    // beaconAnomalyTimerNotify
+    void beaconAnomalyBoost (
+        epicsGuard < epicsMutex > & );
+
     udpiiu ( const udpiiu & );
     udpiiu & operator = ( const udpiiu & );
 
@@ -52,29 +52,46 @@ struct caHdrLargeArray {
 };
 
 class ipAddrToAsciiEngine;
+class tcpRecvEngine;
 
+//
+// When a tcpRecvEngine is supplied no thread is created here. The
+// send thread connects the circuit and hands it to the engine, which
+// calls receive() whenever the socket is readable.
+//
 class tcpRecvThread : private epicsThreadRunable {
 public:
     tcpRecvThread (
         class tcpiiu & iiuIn, epicsMutex & cbMutexIn, cacContextNotify &,
-        const char * pName, unsigned int stackSize, unsigned int priority );
+        const char * pName, unsigned int stackSize, unsigned int priority,
+        tcpRecvEngine * pEngine );
     virtual ~tcpRecvThread ();
     void start ();
     void exitWait ();
     bool exitWait ( double delay );
     void interruptSocketRecv ();
     void show ( unsigned level ) const;
+    bool engineConnect ();
+    bool receive ();
+    void finish ();
+    SOCKET socket () const;
 private:
-    epicsThread thread;
+    epicsThread * pThread;
+    tcpRecvEngine * pEngine;
     class tcpiiu & iiu;
     epicsMutex & cbMutex;
     cacContextNotify & ctxNotify;
+    comBuf * pComBuf;
+    epicsEvent exitEvent;
+    bool finished;
     void run ();
+    bool connectCircuit ();
     void connect (
         epicsGuard < epicsMutex > & guard );
     bool validFillStatus (
         epicsGuard < epicsMutex > & guard,
         const statusWireIO & stat );
+    void releaseComBuf ();
 };
 
 class tcpSendThread : private epicsThreadRunable {
@@ -164,6 +181,10 @@ public:
         epicsGuard < epicsMutex > & ) const;
     bool ca_v49_ok (
         epicsGuard < epicsMutex > & ) const;
+    unsigned minorVersion (
+        epicsGuard < epicsMutex > & ) const;
+    // only called from the receive thread while processing a message
+    const void * pooledMsgBody () const;
 
     unsigned getHostName (
         epicsGuard < epicsMutex > &,
@@ -189,7 +210,8 @@ public:
         epicsGuard < epicsMutex > & guard );
     void installChannel (
         epicsGuard < epicsMutex > &, nciu & chan,
-        unsigned sidIn, ca_uint16_t typeIn, arrayElementCount countIn );
+        unsigned sidIn, ca_uint16_t typeIn, arrayElementCount countIn,
+        bool flushNow );
     void uninstallChan (
         epicsGuard < epicsMutex > & guard, nciu & chan );
     bool connectNotify (
@@ -227,6 +249,7 @@ private:
     comBufMemoryManager & comBufMemMgr;
     cac & cacRef;
     char * pCurData;
+    char * pSmallData; // the body cache when pCurData is a pool buffer
     SearchDestTCP * pSearchDest;
     epicsMutex & mutex;
     epicsMutex & cbMutex;
@@ -264,6 +287,9 @@ private:
         unsigned nBytesInBuf, const epicsTime & currentTime );
     void recvBytes (
         void * pBuf, unsigned nBytesInBuf, statusWireIO & );
+    unsigned largeMsgBodyWanted ( char * & pBuf ) const;
+    void largeMsgBodyReceived ( unsigned nBytes );
+    void releaseLargeMsgBody ();
     const char * pHostName (
         epicsGuard < epicsMutex > & ) const throw ();
     double receiveWatchdogDelay (
@@ -351,6 +377,11 @@ inline void tcpiiu::operator delete ( void * pCadaver,
 }
 #endif
 
+inline const void * tcpiiu::pooledMsgBody () const
+{
+    return this->pCurData != this->pSmallData ? this->pCurData : 0;
+}
+
 inline bool tcpiiu::ca_v41_ok (
     epicsGuard < epicsMutex > & ) const
 {
@@ -369,6 +400,12 @@ inline bool tcpiiu::ca_v49_ok (
     return CA_V49 ( this->minorProtocolVersion );
 }
 
+inline unsigned tcpiiu::minorVersion (
+    epicsGuard < epicsMutex > & ) const
+{
+    return this->minorProtocolVersion;
+}
+
 inline bool tcpiiu::alive (
     epicsGuard < epicsMutex > & ) const
 {
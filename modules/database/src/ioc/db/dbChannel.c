@@ -16,6 +16,7 @@
 
 #include <stdio.h>
 #include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 
 #define EPICS_PRIVATE_API
@@ -34,6 +35,7 @@
 #include "dbChannel.h"
 #include "dbCommon.h"
 #include "dbEvent.h"
+#include "dbExtractArray.h"
 #include "dbLock.h"
 #include "dbStaticLib.h"
 #include "link.h"
@@ -52,6 +54,11 @@ typedef struct parseContext {
 static void *dbChannelFreeList;
 static void *chFilterFreeList;
 
+/* Filter functions that accept array views */
+#define MAX_VIEW_FUNCS 32
+static chPostEventFunc *viewFuncs[MAX_VIEW_FUNCS];
+static int nViewFuncs;
+
 void dbChannelExit(void)
 {
     freeListCleanup(dbChannelFreeList);
@@ -531,30 +538,181 @@ finish:
     return chan;
 }
 
-db_field_log* dbChannelRunPreChain(dbChannel *chan, db_field_log *pLogIn) {
+static void freeViewCopy(db_field_log *pfl)
+{
+    if (pfl->u.r.pvt)
+        freeListFree(pfl->u.r.pvt, pfl->u.r.field);
+    else
+        free(pfl->u.r.field);
+}
+
+/*
+ * Copy the elements of a view, which ends it. Views are only made by
+ * filter functions that accept them, the chains below clear the view
+ * of a field log before passing it to the first of these.
+ *
+ * While a view refers to the record's field, the chains keep the record
+ * locked from before the first filter that may make the view until it is
+ * copied here, so the view and the copy are of the same elements. The
+ * lock is released here if locked is set.
+ */
+static db_field_log* resolveView(dbChannel *chan, db_field_log *pfl,
+    int locked)
+{
+    long start = pfl->u.r.start;
+    long incr = pfl->u.r.incr;
+    long n = pfl->no_elements;
+    void *pSource = pfl->u.r.field;
+    void *pTarget = NULL;
+    void *freeList = NULL;
+    long nSource, capacity, offset = 0;
+    size_t size = n * pfl->field_size;
+
+    pfl->u.r.start = 0;
+    pfl->u.r.incr = 0;
+    if (n > 0) {
+        freeList = chan->view_free_list;
+        if (freeList && size <= chan->view_size)
+            pTarget = freeListMalloc(freeList);
+        else {
+            freeList = NULL;
+            pTarget = malloc(size);
+        }
+    }
+    if (pTarget) {
+        if (!pfl->dtor) {
+            capacity = nSource = dbChannelElements(chan);
+            dbChannelGetArrayInfo(chan, &pSource, &nSource, &offset);
+            offset = (offset + start) % capacity;
+        }
+        else {
+            capacity = start + (n - 1) * incr + 1;
+            offset = start;
+        }
+        dbExtractArray(pSource, pTarget, pfl->field_size,
+            n, capacity, offset, incr);
+    }
+    if (locked)
+        dbScanUnlock(dbChannelRecord(chan));
+    if (n <= 0)
+        return pfl;
+
+    if (pfl->dtor) pfl->dtor(pfl);
+    pfl->u.r.field = pTarget;
+    pfl->u.r.pvt = freeList;
+    pfl->dtor = pTarget ? freeViewCopy : NULL;
+    pfl->no_elements = pTarget ? n : 0;
+    return pfl;
+}
+
+/* Run the pre-chain from node on */
+static db_field_log* runPreChain(dbChannel *chan, ELLNODE *node,
+    db_field_log *pLogIn)
+{
     chFilter *filter;
-    ELLNODE *node;
     db_field_log *pLog = pLogIn;
+    int inView = 0;
+    int locked = 0;
 
-    for (node = ellFirst(&chan->pre_chain); node && pLog; node = ellNext(node)) {
+    for (; node && pLog; node = ellNext(node)) {
         filter = CONTAINER(node, chFilter, pre_node);
+        if (!filter->pre_views) {
+            if (inView)
+                pLog = resolveView(chan, pLog, locked);
+            locked = 0;
+        }
+        else if (!inView && pLog->type == dbfl_type_ref) {
+            pLog->u.r.start = pLog->u.r.incr = 0;
+            if (!pLog->dtor) {
+                dbScanLock(dbChannelRecord(chan));
+                locked = 1;
+            }
+        }
         pLog = filter->pre_func(filter->pre_arg, chan, pLog);
+        inView = pLog && filter->pre_views && dbfl_has_view(pLog);
+        if (locked && !inView) {
+            dbScanUnlock(dbChannelRecord(chan));
+            locked = 0;
+        }
     }
+    if (inView)
+        pLog = resolveView(chan, pLog, locked);
     return pLog;
 }
 
+db_field_log* dbChannelRunPreChain(dbChannel *chan, db_field_log *pLogIn) {
+    return runPreChain(chan, ellFirst(&chan->pre_chain), pLogIn);
+}
+
+db_field_log* dbChannelRunPreChainFrom(dbChannel *chan, chFilter *first,
+    db_field_log *pLogIn)
+{
+    return runPreChain(chan, &first->pre_node, pLogIn);
+}
+
 db_field_log* dbChannelRunPostChain(dbChannel *chan, db_field_log *pLogIn) {
     chFilter *filter;
     ELLNODE *node;
     db_field_log *pLog = pLogIn;
+    int inView = 0;
+    int locked = 0;
 
     for (node = ellFirst(&chan->post_chain); node && pLog; node = ellNext(node)) {
         filter = CONTAINER(node, chFilter, post_node);
+        if (!filter->post_views) {
+            if (inView)
+                pLog = resolveView(chan, pLog, locked);
+            locked = 0;
+        }
+        else if (!inView && pLog->type == dbfl_type_ref) {
+            pLog->u.r.start = pLog->u.r.incr = 0;
+            if (!pLog->dtor) {
+                dbScanLock(dbChannelRecord(chan));
+                locked = 1;
+            }
+        }
         pLog = filter->post_func(filter->post_arg, chan, pLog);
+        inView = pLog && filter->post_views && dbfl_has_view(pLog);
+        if (locked && !inView) {
+            dbScanUnlock(dbChannelRecord(chan));
+            locked = 0;
+        }
     }
+    if (inView)
+        pLog = resolveView(chan, pLog, locked);
     return pLog;
 }
 
+static int acceptsViews(chPostEventFunc *func)
+{
+    int i;
+
+    for (i = 0; i < nViewFuncs; i++)
+        if (viewFuncs[i] == func)
+            return 1;
+    return 0;
+}
+
+/* A view is no larger than the data that the filter making it gets */
+static void maxViewSize(size_t *pSize, const db_field_log *probe)
+{
+    size_t size = probe->no_elements * probe->field_size;
+
+    if (probe->no_elements > 1 && size > *pSize)
+        *pSize = size;
+}
+
+void dbChannelAcceptViews(chPostEventFunc *func)
+{
+    if (acceptsViews(func))
+        return;
+    if (nViewFuncs >= MAX_VIEW_FUNCS) {
+        errlogPrintf("dbChannelAcceptViews: Too many filter functions\n");
+        return;
+    }
+    viewFuncs[nViewFuncs++] = func;
+}
+
 long dbChannelOpen(dbChannel *chan)
 {
     chFilter *filter;
@@ -564,6 +722,7 @@ long dbChannelOpen(dbChannel *chan)
     ELLNODE *node;
     db_field_log probe;
     db_field_log p;
+    size_t viewSize = 0;
 
     for (node = ellFirst(&chan->filters); node; node = ellNext(node)) {
         filter = CONTAINER(node, chFilter, list_node);
@@ -596,6 +755,9 @@ long dbChannelOpen(dbChannel *chan)
                 ellAdd(&chan->pre_chain, &filter->pre_node);
                 filter->pre_func = func;
                 filter->pre_arg  = arg;
+                filter->pre_views = acceptsViews(func);
+                if (filter->pre_views)
+                    maxViewSize(&viewSize, &probe);
                 probe = p;
             }
         }
@@ -610,6 +772,9 @@ long dbChannelOpen(dbChannel *chan)
                 ellAdd(&chan->post_chain, &filter->post_node);
                 filter->post_func = func;
                 filter->post_arg  = arg;
+                filter->post_views = acceptsViews(func);
+                if (filter->post_views)
+                    maxViewSize(&viewSize, &probe);
                 probe = p;
             }
         }
@@ -620,6 +785,11 @@ long dbChannelOpen(dbChannel *chan)
     chan->final_field_size   = probe.field_size;
     chan->final_type         = probe.field_type;
 
+    if (viewSize > 0 && !chan->view_free_list) {
+        freeListInitPvt(&chan->view_free_list, viewSize, 2);
+        chan->view_size = viewSize;
+    }
+
     return 0;
 }
 
@@ -708,6 +878,8 @@ void dbChannelDelete(dbChannel *chan)
         filter->plug->fif->channel_close(filter);
         freeListFree(chFilterFreeList, filter);
     }
+    if (chan->view_free_list)
+        freeListCleanup(chan->view_free_list);
     free((char *) chan->name);
     freeListFree(dbChannelFreeList, chan);
 }
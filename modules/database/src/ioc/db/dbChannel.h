@@ -68,6 +68,8 @@ struct evSubscrip {
     char                callBackInProgress;
     /* this node added to dbCommon::mlis */
     char                enabled;
+    /* unique to this subscription, for filters that keep state for each */
+    size_t              id;
 };
 #endif
 
@@ -90,6 +92,8 @@ typedef struct dbChannel {
     ELLLIST filters;          /**< Filters used by dbChannel */
     ELLLIST pre_chain;        /**< Filters on pre-event-queue chain */
     ELLLIST post_chain;       /**< Filters on post-event-queue chain */
+    void *view_free_list;     /**< Buffers for the copies of array views */
+    size_t view_size;         /**< Size of these buffers */
 } dbChannel;
 
 /** \brief Event filter function type
@@ -335,6 +339,8 @@ struct chFilter {
     chPostEventFunc *post_func; /**< \brief post-chain filter function */
     void *post_arg;             /**< \brief post-chain context pointer */
     void *puser;                /**< \brief For use by the plugin */
+    char pre_views;             /**< \brief pre_func accepts array views */
+    char post_views;            /**< \brief post_func accepts array views */
 };
 
 struct dbCommon;
@@ -578,10 +584,33 @@ DBCORE_API db_field_log* dbChannelRunPreChain(dbChannel *chan,
     db_field_log *pLogIn);
 DBCORE_API db_field_log* dbChannelRunPostChain(dbChannel *chan,
     db_field_log *pLogIn);
+
+/** \brief Run part of the pre-chain.
+ *
+ * Runs the filters of the pre-chain from first, which must be in the
+ * pre-chain of chan, to its end. This is for filters that post updates
+ * of their own, which the filters before them have already seen.
+ */
+DBCORE_API db_field_log* dbChannelRunPreChainFrom(dbChannel *chan,
+    chFilter *first, db_field_log *pLogIn);
 DBCORE_API const chFilterPlugin * dbFindFilter(const char *key, size_t len);
 DBCORE_API void dbChannelGetArrayInfo(dbChannel *chan,
         void **pfield, long *no_elements, long *offset);
 
+/** \brief Declare that a filter function accepts array views.
+ *
+ * Filter functions declared here may be passed field logs that are
+ * array views (see db_field_log.h), and may return views. This should be
+ * called when the filter is registered. Filter functions which only
+ * pass the array data on, or which select elements of it, should be
+ * declared so that the filter chain only copies the data once.
+ * When such a function is passed data that still belongs to the record,
+ * the record is already locked, and it stays locked until the chain has
+ * copied the view, so these functions must not block.
+ * \param func The filter function.
+ */
+DBCORE_API void dbChannelAcceptViews(chPostEventFunc *func);
+
 #ifdef __cplusplus
 }
 #endif
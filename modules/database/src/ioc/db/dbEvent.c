@@ -31,6 +31,7 @@
 #include "cantProceed.h"
 #include "dbDefs.h"
 #include "epicsAssert.h"
+#include "epicsAtomic.h"
 #include "epicsEvent.h"
 #include "epicsMutex.h"
 #include "epicsThread.h"
@@ -128,6 +129,9 @@ static void *dbevEventQueueFreeList;
 static void *dbevEventSubscriptionFreeList;
 static void *dbevFieldLogFreeList;
 
+/* the last evSubscrip::id given out */
+static size_t lastSubscriptionId;
+
 static char *EVENT_PEND_NAME = "eventTask";
 
 static epicsMutexId stopSync;
@@ -484,6 +488,7 @@ dbEventSubscription db_add_event (
     pevent->callBackInProgress = FALSE;
     pevent->enabled =   FALSE;
     pevent->ev_que =    ev_que;
+    pevent->id =        epicsAtomicIncrSizeT ( &lastSubscriptionId );
 
     /*
      * Simple types values queued up for reliable interprocess
@@ -740,6 +745,7 @@ db_field_log* db_create_event_log (struct evSubscrip *pevent)
     if (pLog) {
         pLog->mask = pevent->select;
         pLog->ctx  = dbfl_context_event;
+        pLog->sub_id = pevent->id;
     }
     return pLog;
 }
@@ -899,6 +905,46 @@ unsigned int    caEventMask
 
 }
 
+/*
+ *  DB_POST_FILTER_EVENTS()
+ *
+ *  Posts an event to the subscriptions made through the channel of a
+ *  filter, for channel filters which release updates on their own
+ *  schedule. It only runs that filter and those after it in the
+ *  pre-chain, the filters before it have already seen the updates.
+ *
+ *  NOTE: This assumes that the db scan lock is already applied
+ *
+ */
+int db_post_filter_events (
+struct chFilter     *filter,
+unsigned int        caEventMask
+)
+{
+    struct dbChannel  * const chan = filter->chan;
+    struct dbCommon   * const prec = dbChannelRecord(chan);
+    struct evSubscrip *pevent;
+
+    if (prec->mlis.count == 0) return DB_EVENT_OK;       /* no monitors set */
+
+    LOCKREC (prec);
+
+    for (pevent = (struct evSubscrip *) prec->mlis.node.next;
+        pevent; pevent = (struct evSubscrip *) pevent->node.next){
+
+        if (pevent->chan == chan && (caEventMask & pevent->select)) {
+            db_field_log *pLog = db_create_event_log(pevent);
+            if(pLog)
+                pLog->mask = caEventMask & pevent->select;
+            pLog = dbChannelRunPreChainFrom(chan, filter, pLog);
+            if (pLog) db_queue_event_log(pevent, pLog);
+        }
+    }
+
+    UNLOCKREC (prec);
+    return DB_EVENT_OK;
+}
+
 /*
  *  DB_POST_SINGLE_EVENT()
  */
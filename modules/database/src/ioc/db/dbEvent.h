@@ -29,6 +29,7 @@ extern "C" {
 #endif
 
 struct dbChannel;
+struct chFilter;
 struct db_field_log;
 struct evSubscrip;
 
@@ -47,6 +48,8 @@ DBCORE_API int dbel (
     const char *name, unsigned level);
 DBCORE_API int db_post_events (
     void *pRecord, void *pField, unsigned caEventMask );
+DBCORE_API int db_post_filter_events (
+    struct chFilter *filter, unsigned caEventMask );
 
 typedef void EXTRALABORFUNC (void *extralabor_arg);
 DBCORE_API dbEventCtx db_init_events (void);
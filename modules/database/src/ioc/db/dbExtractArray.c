@@ -21,6 +21,7 @@
 #include <string.h>
 #include <assert.h>
 
+#include "epicsArrayKernels.h"
 #include "epicsTypes.h"
 
 #include "dbAddr.h"
@@ -47,9 +48,21 @@ void dbExtractArray(const void *pfrom, void *pto, short field_size,
             memcpy(pdst + (field_size * nUpperPart), psrc,
                 field_size * (nRequest - nUpperPart));
     } else {
-        for (; nRequest > 0; nRequest--, pdst += field_size, offset += increment) {
-            offset %= no_elements;
-            memcpy(pdst, psrc + (offset * field_size), field_size);
+        /* an increment beyond the end wraps around to the same elements */
+        increment %= no_elements;
+
+        /* copy the runs of elements between two wrap-arounds */
+        while (nRequest > 0) {
+            long n = increment ?
+                (no_elements - 1 - offset) / increment + 1 : nRequest;
+
+            if (n > nRequest)
+                n = nRequest;
+            epicsArrayStride(pdst, psrc + offset * field_size, field_size,
+                n, increment);
+            pdst += n * field_size;
+            nRequest -= n;
+            offset = (offset + n * increment) % no_elements;
         }
     }
 }
@@ -19,6 +19,8 @@
 #ifndef INCLdb_field_logh
 #define INCLdb_field_logh
 
+#include <stddef.h>
+
 #include <epicsTime.h>
 #include <epicsTypes.h>
 
@@ -104,8 +106,27 @@ struct dbfl_val {
 struct dbfl_ref {
     void              *pvt;   /* Private pointer */
     void              *field; /* Field value */
+    long              start;  /* First element of a view */
+    long              incr;   /* Element increment of a view, 0 if none */
 };
 
+/*
+ * Array views.
+ * A filter that selects elements of an array may describe the selection
+ * instead of copying it, if the filter function was declared with
+ * dbChannelAcceptViews(). The no_elements elements of a view are every
+ * incr'th element of the referenced data, starting with element start.
+ * If the data is still owned by the record, start counts from the first
+ * element reported by the record's get_array_info routine.
+ * Views are only seen by filter functions that accept them: the filter
+ * chain copies the selected elements before calling any other filter,
+ * and at the end of the chain, so that later filters narrow the view
+ * rather than each making its own copy. Outside of the filter functions
+ * start and incr have no meaning.
+ */
+#define dbfl_has_view(p)\
+ ((p)->type==dbfl_type_ref && (p)->u.r.incr > 0)
+
 /*
  * Note that field_size may be larger than MAX_STRING_SIZE.
  */
@@ -115,6 +136,7 @@ typedef struct db_field_log {
     unsigned int      ctx:1;  /* context (operation type) */
     /* only for dbfl_context_event */
     unsigned char      mask;  /* DBE_* mask */
+    size_t           sub_id;  /* evSubscrip::id of the subscription */
     /* the following are used for value and reference types */
     epicsTimeStamp     time;  /* Time stamp */
     epicsUTag          utag;
@@ -122,6 +122,18 @@ typedef struct tempListNode {
 static ELLLIST tempList = ELLLIST_INIT;
 static void *freeListPvt = NULL;
 static int duplicate = FALSE;
+
+/* Input lines parsed into macro templates, kept while dbLoadTemplate()
+ * reads the same database files for each set of substitutions */
+typedef struct lineTemplate {
+    ELLNODE     node;
+    MAC_TEMPLATE *tmpl;
+    char        line[1];
+}lineTemplate;
+
+static struct gphPvt *lineTemplateTable = NULL;
+static ELLLIST lineTemplateList = ELLLIST_INIT;
+static int lineTemplateUsers = 0;
 
 static void yyerrorAbort(char *str)
 {
@@ -353,6 +365,50 @@ long dbReadDatabaseFP(DBBASE **ppdbbase,FILE *fp,
         const char *path,const char *substitutions)
 {return (dbReadCOM(ppdbbase,0,fp,path,substitutions));}
 
+void dbLineTemplatesBegin(void)
+{
+    if (lineTemplateUsers++ == 0)
+        gphInitPvt(&lineTemplateTable, 1024);
+}
+
+void dbLineTemplatesEnd(void)
+{
+    lineTemplate *plt;
+
+    if (lineTemplateUsers <= 0 || --lineTemplateUsers > 0)
+        return;
+    gphFreeMem(lineTemplateTable);
+    lineTemplateTable = NULL;
+    while ((plt = (lineTemplate *)ellGet(&lineTemplateList))) {
+        macDeleteTemplate(plt->tmpl);
+        free(plt);
+    }
+}
+
+/* Returns NULL if the line can't be added, it is expanded directly then */
+static const MAC_TEMPLATE *lineTemplateFind(const char *line)
+{
+    GPHENTRY *pgph = gphFind(lineTemplateTable, line, &lineTemplateList);
+    lineTemplate *plt;
+
+    if (pgph)
+        return ((lineTemplate *)pgph->userPvt)->tmpl;
+    plt = malloc(sizeof(lineTemplate) + strlen(line));
+    if (!plt)
+        return NULL;
+    strcpy(plt->line, line);
+    plt->tmpl = macCompileTemplate(line);
+    pgph = plt->tmpl ? gphAdd(lineTemplateTable, plt->line, &lineTemplateList) : NULL;
+    if (!pgph) {
+        macDeleteTemplate(plt->tmpl);
+        free(plt);
+        return NULL;
+    }
+    pgph->userPvt = plt;
+    ellAdd(&lineTemplateList, &plt->node);
+    return plt->tmpl;
+}
+
 static int db_yyinput(char *buf, int max_size)
 {
     size_t  l,n;
@@ -365,8 +421,13 @@ static int db_yyinput(char *buf, int max_size)
                 fgetsRtn = fgets(mac_input_buffer,MY_BUFFER_SIZE,
                         pinputFileNow->fp);
                 if(fgetsRtn) {
-                    int exp = macExpandString(macHandle,mac_input_buffer,
-                        my_buffer,MY_BUFFER_SIZE);
+                    const MAC_TEMPLATE *tmpl = lineTemplateTable ?
+                        lineTemplateFind(mac_input_buffer) : NULL;
+                    int exp = tmpl ?
+                        macExpandTemplate(macHandle,tmpl,
+                            my_buffer,MY_BUFFER_SIZE) :
+                        macExpandString(macHandle,mac_input_buffer,
+                            my_buffer,MY_BUFFER_SIZE);
                     if (exp < 0) {
                         fprintf(stderr, "Warning: '%s' line %d has undefined macros\n",
                             pinputFileNow->filename, pinputFileNow->line_num+1);
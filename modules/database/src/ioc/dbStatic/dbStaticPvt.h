@@ -120,6 +120,11 @@ void dbPvdFreeMem(DBBASE *pdbbase);
 DBCORE_API
 char** dbCompleteRecord(const char *word);
 
+/*The following are in dbLexRoutines.c*/
+/*keep parsed input lines for database files that are read repeatedly*/
+void dbLineTemplatesBegin(void);
+void dbLineTemplatesEnd(void);
+
 #ifdef __cplusplus
 }
 #endif
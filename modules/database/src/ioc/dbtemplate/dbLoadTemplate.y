@@ -20,6 +20,7 @@
 
 #include "epicsExport.h"
 #include "dbAccess.h"
+#include "dbStaticPvt.h"
 #include "dbLoadTemplate.h"
 
 static int line_num;
@@ -377,7 +378,10 @@ int dbLoadTemplate(const char *sub_file, const char *cmd_collect)
         yyrestart(fp);
     }
 
+    /* each substitution set reads the same database file again */
+    dbLineTemplatesBegin();
     yyparse();
+    dbLineTemplatesEnd();
 
     for (i = 0; i < var_count; i++) {
         dbmfFree(vars[i]);
@@ -12,6 +12,7 @@
 
 #include <string>
 #include <list>
+#include <map>
 
 #include <stdlib.h>
 #include <stddef.h>
@@ -84,6 +85,8 @@ static void addMacroReplacements(MAC_HANDLE * const macPvt,
 static void makeSubstitutions(inputData * const inputPvt,
                               MAC_HANDLE * const macPvt,
                               const char * const templateName);
+static const MAC_TEMPLATE *compiledLine(const char * const line);
+static void freeCompiledLines(void);
 
 /*Global variables */
 static int opt_V = 0;
@@ -213,6 +216,7 @@ int main(int argc,char **argv)
         substituteDestruct(substitutePvt);
     }
     macDeleteHandle(macPvt);
+    freeCompiledLines();
     errlogFlush();  // macLib calls errlogPrintf()
     inputDestruct(inputPvt);
     if (opt_D) {
@@ -271,6 +275,35 @@ static void addMacroReplacements(MAC_HANDLE * const macPvt,
     }
 }
 
+/* Template lines are read again for every substitution set, so each
+ * distinct line is parsed once and kept as a macLib template */
+typedef std::map<std::string, MAC_TEMPLATE *> lineMap;
+static lineMap compiledLines;
+
+static const MAC_TEMPLATE *compiledLine(const char * const line)
+{
+    lineMap::iterator it = compiledLines.find(line);
+
+    if (it == compiledLines.end()) {
+        MAC_TEMPLATE *tmpl = macCompileTemplate(line);
+
+        if (!tmpl) {
+            fprintf(stderr, "msi: Out of memory\n");
+            abortExit(1);
+        }
+        it = compiledLines.insert(lineMap::value_type(line, tmpl)).first;
+    }
+    return it->second;
+}
+
+static void freeCompiledLines(void)
+{
+    for (lineMap::iterator it = compiledLines.begin();
+         it != compiledLines.end(); ++it)
+        macDeleteTemplate(it->second);
+    compiledLines.clear();
+}
+
 typedef enum {cmdInclude,cmdSubstitute} cmdType;
 static const char *cmdNames[] = {"include","substitute"};
 
@@ -354,7 +387,8 @@ static void makeSubstitutions(inputData * const inputPvt,
 endcmd:
         if (expand && !opt_D) {
             STEP("Expanding to output stream");
-            n = macExpandString(macPvt, input, buffer, MAX_BUFFER_SIZE - 1);
+            n = macExpandTemplate(macPvt, compiledLine(input), buffer,
+                MAX_BUFFER_SIZE - 1);
             fputs(buffer, stdout);
             if (opt_V == 1 && n < 0) {
                 fprintf(stderr, "msi: Error - undefined macros present\n");
@@ -0,0 +1,347 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* aSubArrayFunctions.c */
+
+/*
+ * Array math for the aSub record. Each routine is named in SNAM, reads
+ * its inputs from A, B and C and writes VALA, setting NEVA. They are
+ * described in aSubRecord.dbd.pod.
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "dbDefs.h"
+#include "dbAccess.h"
+#include "epicsArrayKernels.h"
+#include "epicsTypes.h"
+#include "menuFtype.h"
+#include "registryFunction.h"
+#include "aSubRecord.h"
+#include "epicsExport.h"
+
+/* number of elements converted at a time through a buffer */
+#define CONVERT_BLOCK 256
+
+/*
+ * Conversion kernels. Integers are converted to and from epicsUInt64,
+ * which gives the same values as a cast from one integer type to the
+ * other. Doubles are converted to an integer type with saturation, a NaN
+ * gives 0; the bounds are the first values beyond the range of the type.
+ */
+#define INT_CONVERT(suffix, attr, type, lo, hi, min, max) \
+attr static void type##_to_uint64##suffix(epicsUInt64 *py, const void *px, \
+    epicsUInt32 n) \
+{ \
+    const type *x = (const type *) px; \
+    epicsUInt32 i; \
+\
+    for (i = 0; i < n; i++) \
+        py[i] = (epicsUInt64) x[i]; \
+} \
+\
+attr static void uint64_to_##type##suffix(void *py, const epicsUInt64 *px, \
+    epicsUInt32 n) \
+{ \
+    type *y = (type *) py; \
+    epicsUInt32 i; \
+\
+    for (i = 0; i < n; i++) \
+        y[i] = (type) px[i]; \
+} \
+\
+attr static void double_to_##type##suffix(void *py, const double *px, \
+    epicsUInt32 n) \
+{ \
+    type *y = (type *) py; \
+    epicsUInt32 i; \
+\
+    for (i = 0; i < n; i++) { \
+        double x = px[i]; \
+\
+        y[i] = (x > (lo) && x < (hi)) ? (type) x : \
+            x >= (hi) ? (type) (max) : x <= (lo) ? (type) (min) : 0; \
+    } \
+} \
+\
+TO_DOUBLE(suffix, attr, type)
+
+#define TO_DOUBLE(suffix, attr, type) \
+attr static void type##_to_double##suffix(double *py, const void *px, \
+    epicsUInt32 n) \
+{ \
+    const type *x = (const type *) px; \
+    epicsUInt32 i; \
+\
+    for (i = 0; i < n; i++) \
+        py[i] = (double) x[i]; \
+}
+
+#define CONVERT_KERNELS(suffix, attr) \
+INT_CONVERT(suffix, attr, epicsInt8, -129.0, 128.0, -128, 127) \
+INT_CONVERT(suffix, attr, epicsUInt8, -1.0, 256.0, 0, 255) \
+INT_CONVERT(suffix, attr, epicsInt16, -32769.0, 32768.0, -32768, 32767) \
+INT_CONVERT(suffix, attr, epicsUInt16, -1.0, 65536.0, 0, 65535) \
+INT_CONVERT(suffix, attr, epicsInt32, -2147483649.0, 2147483648.0, \
+    -2147483647 - 1, 2147483647) \
+INT_CONVERT(suffix, attr, epicsUInt32, -1.0, 4294967296.0, \
+    0, 4294967295u) \
+INT_CONVERT(suffix, attr, epicsInt64, -9223372036854775808.0, \
+    9223372036854775808.0, -9223372036854775807LL - 1, \
+    9223372036854775807LL) \
+INT_CONVERT(suffix, attr, epicsUInt64, -1.0, 18446744073709551616.0, \
+    0, 18446744073709551615ULL) \
+TO_DOUBLE(suffix, attr, epicsFloat32) \
+\
+attr static void double_to_epicsFloat32##suffix(void *py, const double *px, \
+    epicsUInt32 n) \
+{ \
+    epicsFloat32 *y = (epicsFloat32 *) py; \
+    epicsUInt32 i; \
+\
+    for (i = 0; i < n; i++) \
+        y[i] = (epicsFloat32) px[i]; \
+} \
+\
+static const toUInt64Func toUInt64##suffix[N_INTEGER] = { \
+    epicsInt8_to_uint64##suffix, epicsUInt8_to_uint64##suffix, \
+    epicsInt16_to_uint64##suffix, epicsUInt16_to_uint64##suffix, \
+    epicsInt32_to_uint64##suffix, epicsUInt32_to_uint64##suffix, \
+    epicsInt64_to_uint64##suffix, epicsUInt64_to_uint64##suffix \
+}; \
+static const fromUInt64Func fromUInt64##suffix[N_INTEGER] = { \
+    uint64_to_epicsInt8##suffix, uint64_to_epicsUInt8##suffix, \
+    uint64_to_epicsInt16##suffix, uint64_to_epicsUInt16##suffix, \
+    uint64_to_epicsInt32##suffix, uint64_to_epicsUInt32##suffix, \
+    uint64_to_epicsInt64##suffix, uint64_to_epicsUInt64##suffix \
+}; \
+static const toDoubleFunc toDouble##suffix[N_CONVERT] = { \
+    epicsInt8_to_double##suffix, epicsUInt8_to_double##suffix, \
+    epicsInt16_to_double##suffix, epicsUInt16_to_double##suffix, \
+    epicsInt32_to_double##suffix, epicsUInt32_to_double##suffix, \
+    epicsInt64_to_double##suffix, epicsUInt64_to_double##suffix, \
+    epicsFloat32_to_double##suffix \
+}; \
+static const fromDoubleFunc fromDouble##suffix[N_CONVERT] = { \
+    double_to_epicsInt8##suffix, double_to_epicsUInt8##suffix, \
+    double_to_epicsInt16##suffix, double_to_epicsUInt16##suffix, \
+    double_to_epicsInt32##suffix, double_to_epicsUInt32##suffix, \
+    double_to_epicsInt64##suffix, double_to_epicsUInt64##suffix, \
+    double_to_epicsFloat32##suffix \
+};
+
+typedef void (*toUInt64Func)(epicsUInt64 *py, const void *px, epicsUInt32 n);
+typedef void (*fromUInt64Func)(void *py, const epicsUInt64 *px,
+    epicsUInt32 n);
+typedef void (*toDoubleFunc)(double *py, const void *px, epicsUInt32 n);
+typedef void (*fromDoubleFunc)(void *py, const double *px, epicsUInt32 n);
+
+/* indexed by menuFtype - menuFtypeCHAR, the integers and then FLOAT */
+#define N_INTEGER (menuFtypeFLOAT - menuFtypeCHAR)
+#define N_CONVERT (N_INTEGER + 1)
+
+EPICS_ARRAY_KERNEL_VARIANTS(CONVERT_KERNELS)
+
+static epicsUInt32 min2(epicsUInt32 a, epicsUInt32 b)
+{
+    return a < b ? a : b;
+}
+
+/* the first nIn inputs and VALA must be arrays of doubles */
+static int notDouble(aSubRecord *prec, int nIn)
+{
+    int i;
+
+    for (i = 0; i < nIn; i++)
+        if ((&prec->fta)[i] != menuFtypeDOUBLE)
+            return 1;
+    return prec->ftva != menuFtypeDOUBLE;
+}
+
+/* VALA = A * B + C */
+static long aSubArrayScale(aSubRecord *prec)
+{
+    epicsUInt32 n = min2(prec->nea, prec->nova);
+
+    if (notDouble(prec, 3) || prec->neb < 1 || prec->nec < 1)
+        return -1;
+    epicsArrayScaleOffset(prec->vala, prec->a, n, *(double *) prec->b,
+        *(double *) prec->c);
+    prec->neva = n;
+    return 0;
+}
+
+/* VALA = A + B */
+static long aSubArrayAdd(aSubRecord *prec)
+{
+    epicsUInt32 n = min2(min2(prec->nea, prec->neb), prec->nova);
+
+    if (notDouble(prec, 2))
+        return -1;
+    epicsArrayAdd(prec->vala, prec->a, prec->b, n);
+    prec->neva = n;
+    return 0;
+}
+
+/* VALA = A * B */
+static long aSubArrayMul(aSubRecord *prec)
+{
+    epicsUInt32 n = min2(min2(prec->nea, prec->neb), prec->nova);
+
+    if (notDouble(prec, 2))
+        return -1;
+    epicsArrayMul(prec->vala, prec->a, prec->b, n);
+    prec->neva = n;
+    return 0;
+}
+
+/* VALA = sum of A * B */
+static long aSubArrayDot(aSubRecord *prec)
+{
+    if (notDouble(prec, 2))
+        return -1;
+    *(double *) prec->vala = epicsArrayDot(prec->a, prec->b,
+        min2(prec->nea, prec->neb));
+    prec->neva = 1;
+    return 0;
+}
+
+/* VALA[i] = sum of B[k] * A[i-k], with A zero before its first element */
+static long aSubArrayFir(aSubRecord *prec)
+{
+    epicsUInt32 n = min2(prec->nea, prec->nova);
+    const double *taps = (const double *) prec->b;
+    double *y = (double *) prec->vala;
+    epicsUInt32 k;
+
+    if (notDouble(prec, 2))
+        return -1;
+    memset(y, 0, n * sizeof(double));
+    for (k = 0; k < prec->neb && k < n; k++)
+        epicsArrayAxpy(y + k, prec->a, n - k, taps[k]);
+    prec->neva = n;
+    return 0;
+}
+
+/* VALA[j] = mean of the B elements of A from j*B on */
+static long aSubArrayDecimate(aSubRecord *prec)
+{
+    const double *a = (const double *) prec->a;
+    double *y = (double *) prec->vala;
+    double factor;
+    epicsUInt32 m, n, j;
+
+    if (notDouble(prec, 2) || prec->neb < 1)
+        return -1;
+    factor = *(double *) prec->b;
+    if (!(factor >= 1.0 && factor <= prec->noa))
+        return -1;
+    m = (epicsUInt32) factor;
+    n = min2(prec->nea / m, prec->nova);
+    for (j = 0; j < n; j++)
+        y[j] = epicsArraySum(a + j * m, m) / m;
+    prec->neva = n;
+    return 0;
+}
+
+/* VALA[i] = sum of A[0..i]; this one can't be split into lanes */
+static long aSubArrayCumSum(aSubRecord *prec)
+{
+    const double *a = (const double *) prec->a;
+    double *y = (double *) prec->vala;
+    epicsUInt32 n = min2(prec->nea, prec->nova);
+    double sum = 0.0;
+    epicsUInt32 i;
+
+    if (notDouble(prec, 1))
+        return -1;
+    for (i = 0; i < n; i++)
+        y[i] = sum += a[i];
+    prec->neva = n;
+    return 0;
+}
+
+/* index into the conversion tables, ENUM is USHORT, -1 for STRING */
+static int convertIndex(epicsEnum16 ftype)
+{
+    if (ftype == menuFtypeENUM)
+        return menuFtypeUSHORT - menuFtypeCHAR;
+    if (ftype < menuFtypeCHAR || ftype > menuFtypeDOUBLE)
+        return -1;
+    return ftype - menuFtypeCHAR;
+}
+
+/*
+ * VALA = A converted from FTA to FTVA, directly between integer types
+ * and through double if either is FLOAT or DOUBLE
+ */
+static long aSubArrayConvert(aSubRecord *prec)
+{
+    epicsUInt32 n = min2(prec->nea, prec->nova);
+    int from = convertIndex(prec->fta);
+    int to = convertIndex(prec->ftva);
+    const char *px = (const char *) prec->a;
+    char *py = (char *) prec->vala;
+    size_t fromSize, toSize;
+    epicsUInt32 i;
+
+    if (from < 0 || to < 0)
+        return -1;
+    fromSize = dbValueSize(prec->fta);
+    toSize = dbValueSize(prec->ftva);
+
+    if (from == to)
+        memcpy(py, px, n * toSize);
+    else if (from < N_INTEGER && to < N_INTEGER) {
+        const toUInt64Func *toUInt64 = EPICS_ARRAY_KERNEL_PICK(toUInt64);
+        const fromUInt64Func *fromUInt64 =
+            EPICS_ARRAY_KERNEL_PICK(fromUInt64);
+        epicsUInt64 buf[CONVERT_BLOCK];
+
+        for (i = 0; i < n; i += CONVERT_BLOCK) {
+            epicsUInt32 m = min2(n - i, CONVERT_BLOCK);
+
+            toUInt64[from](buf, px + i * fromSize, m);
+            fromUInt64[to](py + i * toSize, buf, m);
+        }
+    }
+    else if (from == N_CONVERT)
+        EPICS_ARRAY_KERNEL_PICK(fromDouble)[to](py, (const double *) px, n);
+    else if (to == N_CONVERT)
+        EPICS_ARRAY_KERNEL_PICK(toDouble)[from]((double *) py, px, n);
+    else {
+        const toDoubleFunc *toDouble = EPICS_ARRAY_KERNEL_PICK(toDouble);
+        const fromDoubleFunc *fromDouble =
+            EPICS_ARRAY_KERNEL_PICK(fromDouble);
+        double buf[CONVERT_BLOCK];
+
+        for (i = 0; i < n; i += CONVERT_BLOCK) {
+            epicsUInt32 m = min2(n - i, CONVERT_BLOCK);
+
+            toDouble[from](buf, px + i * fromSize, m);
+            fromDouble[to](py + i * toSize, buf, m);
+        }
+    }
+    prec->neva = n;
+    return 0;
+}
+
+static registryFunctionRef aSubArrayRef[] = {
+    {"aSubArrayScale", (REGISTRYFUNCTION) aSubArrayScale},
+    {"aSubArrayAdd", (REGISTRYFUNCTION) aSubArrayAdd},
+    {"aSubArrayMul", (REGISTRYFUNCTION) aSubArrayMul},
+    {"aSubArrayDot", (REGISTRYFUNCTION) aSubArrayDot},
+    {"aSubArrayFir", (REGISTRYFUNCTION) aSubArrayFir},
+    {"aSubArrayDecimate", (REGISTRYFUNCTION) aSubArrayDecimate},
+    {"aSubArrayCumSum", (REGISTRYFUNCTION) aSubArrayCumSum},
+    {"aSubArrayConvert", (REGISTRYFUNCTION) aSubArrayConvert}
+};
+
+static void aSubArray(void)
+{
+    registryFunctionRefAdd(aSubArrayRef, NELEMENTS(aSubArrayRef));
+}
+epicsExportRegistrar(aSubArray);
@@ -0,0 +1,335 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Aggregation filter: collects the updates of a scalar channel over a
+ * time window and sends one update per window with their mean, minimum,
+ * maximum, last value or count.
+ *
+ * The window starts with the first update after an idle period. The
+ * windows of all channels are ended by one shared timer queue thread,
+ * which posts the result through db_post_filter_events(), so only this
+ * filter and those after it see it. Everything below the settings in
+ * myStruct is protected by the record's lock.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "alarm.h"
+#include "caeventmask.h"
+#include "chfPlugin.h"
+#include "dbAccessDefs.h"
+#include "dbChannel.h"
+#include "dbDefs.h"
+#include "dbEvent.h"
+#include "dbLock.h"
+#include "db_field_log.h"
+#include "epicsExit.h"
+#include "epicsThread.h"
+#include "epicsTimer.h"
+#include "freeList.h"
+#include "epicsExport.h"
+
+enum aggOp {
+    aggMean = 0,
+    aggMin = 1,
+    aggMax = 2,
+    aggLast = 3,
+    aggCount = 4
+};
+
+static const chfPluginEnumType opEnum[] = {
+    {"mean", aggMean}, {"min", aggMin}, {"max", aggMax},
+    {"last", aggLast}, {"count", aggCount},
+    {NULL, 0}
+};
+
+typedef struct myStruct {
+    double period;
+    int op;
+
+    dbChannel *chan;
+    epicsTimerQueueId queue;
+    epicsTimerId timer;
+    int armed;          /* a window is open */
+    int flushing;       /* posting the result of a window */
+    unsigned char mask; /* DBE_* of the updates in the window */
+    unsigned long n;
+    double sum, lo, hi;
+    db_field_log last;
+    unsigned short stat, sevr;
+    char amsg[40];
+    unsigned long nUpdates, nWindows;
+} myStruct;
+
+static void *myStructFreeList;
+
+static const chfPluginArgDef opts[] = {
+    chfDouble(myStruct, period, "period", 1, 1),
+    chfEnum(myStruct, op, "op", 0, 0, opEnum),
+    chfPluginArgEnd
+};
+
+static void * allocPvt(void)
+{
+    myStruct *my = (myStruct*) freeListCalloc(myStructFreeList);
+    if (!my) return NULL;
+
+    my->op = aggMean;
+    return (void *) my;
+}
+
+static void freePvt(void *pvt)
+{
+    freeListFree(myStructFreeList, pvt);
+}
+
+static int parse_ok(void *pvt)
+{
+    myStruct *my = (myStruct*) pvt;
+
+    if (!(my->period > 0.0))
+        return -1;
+    return 0;
+}
+
+static double fl_value(const db_field_log *pfl)
+{
+    const union native_value *pv = &pfl->u.v.field;
+
+    switch (pfl->field_type) {
+    case DBF_CHAR:      return pv->dbf_char;
+    case DBF_UCHAR:     return pv->dbf_uchar;
+    case DBF_SHORT:     return pv->dbf_short;
+    case DBF_USHORT:    return pv->dbf_ushort;
+    case DBF_LONG:      return pv->dbf_long;
+    case DBF_ULONG:     return pv->dbf_ulong;
+    case DBF_INT64:     return (double) pv->dbf_int64;
+    case DBF_UINT64:    return (double) pv->dbf_uint64;
+    case DBF_FLOAT:     return pv->dbf_float;
+    case DBF_DOUBLE:    return pv->dbf_double;
+    case DBF_ENUM:
+    case DBF_MENU:
+    case DBF_DEVICE:    return pv->dbf_enum;
+    }
+    return 0.0;
+}
+
+static void accumulate(myStruct *my, const db_field_log *pfl)
+{
+    double value = fl_value(pfl);
+
+    if (my->n == 0) {
+        my->sum = 0.0;
+        my->lo = my->hi = value;
+        my->sevr = NO_ALARM;
+        my->stat = NO_ALARM;
+        my->amsg[0] = '\0';
+    }
+    my->n++;
+    my->sum += value;
+    if (value < my->lo) my->lo = value;
+    if (value > my->hi) my->hi = value;
+    if (my->n == 1 || pfl->sevr > my->sevr) {
+        my->sevr = pfl->sevr;
+        my->stat = pfl->stat;
+        strcpy(my->amsg, pfl->amsg);
+    }
+    my->last = *pfl;
+    my->mask |= pfl->mask;
+    my->nUpdates++;
+}
+
+/* turn the update posted at the end of a window into its result */
+static void fillResult(myStruct *my, db_field_log *pfl)
+{
+    if (pfl->type == dbfl_type_ref && pfl->dtor) {
+        pfl->dtor(pfl);
+        pfl->dtor = NULL;
+    }
+    pfl->type = dbfl_type_val;
+    pfl->no_elements = 1;
+    pfl->time = my->last.time;
+    pfl->utag = my->last.utag;
+    pfl->stat = my->stat;
+    pfl->sevr = my->sevr;
+    strcpy(pfl->amsg, my->amsg);
+
+    switch (my->op) {
+    case aggLast:
+        pfl->field_type = my->last.field_type;
+        pfl->field_size = my->last.field_size;
+        pfl->u.v.field = my->last.u.v.field;
+        break;
+    case aggCount:
+        pfl->field_type = DBF_ULONG;
+        pfl->field_size = sizeof(epicsUInt32);
+        pfl->u.v.field.dbf_ulong = my->n;
+        break;
+    default:
+        pfl->field_type = DBF_DOUBLE;
+        pfl->field_size = sizeof(epicsFloat64);
+        pfl->u.v.field.dbf_double = my->op == aggMin ? my->lo :
+            my->op == aggMax ? my->hi : my->sum / my->n;
+    }
+}
+
+static db_field_log* filter(void* pvt, dbChannel *chan, db_field_log *pfl)
+{
+    myStruct *my = (myStruct*) pvt;
+
+    if (pfl->ctx == dbfl_context_read || (pfl->mask & DBE_PROPERTY) ||
+            pfl->type != dbfl_type_val)
+        return pfl;
+
+    if (my->flushing) {
+        fillResult(my, pfl);
+        return pfl;
+    }
+
+    accumulate(my, pfl);
+    db_delete_field_log(pfl);
+    if (!my->armed) {
+        my->armed = 1;
+        epicsTimerStartDelay(my->timer, my->period);
+    }
+    return NULL;
+}
+
+/* the filter of the channel that this is the pre-chain function of */
+static chFilter * aggFilter(myStruct *my)
+{
+    ELLNODE *node;
+
+    for (node = ellFirst(&my->chan->pre_chain); node; node = ellNext(node)) {
+        chFilter *filter = CONTAINER(node, chFilter, pre_node);
+
+        if (filter->pre_arg == my)
+            return filter;
+    }
+    return NULL;
+}
+
+/* called by the timer queue thread at the end of a window */
+static void windowEnd(void *pvt)
+{
+    myStruct *my = (myStruct*) pvt;
+    struct dbCommon *prec = dbChannelRecord(my->chan);
+    chFilter *filter;
+
+    dbScanLock(prec);
+    filter = aggFilter(my);
+    if (my->n > 0 && filter) {
+        my->flushing = 1;
+        db_post_filter_events(filter, my->mask);
+        my->flushing = 0;
+        my->n = 0;
+        my->mask = 0;
+        my->nWindows++;
+        epicsTimerStartDelay(my->timer, my->period);
+    }
+    else {
+        my->armed = 0;
+    }
+    dbScanUnlock(prec);
+}
+
+static long channel_open(dbChannel *chan, void *pvt)
+{
+    myStruct *my = (myStruct*) pvt;
+
+    my->chan = chan;
+    my->queue = epicsTimerQueueAllocate(1, epicsThreadPriorityScanLow);
+    if (!my->queue)
+        return -1;
+    my->timer = epicsTimerQueueCreateTimer(my->queue, windowEnd, my);
+    if (!my->timer) {
+        epicsTimerQueueRelease(my->queue);
+        my->queue = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+static void channelRegisterPre(dbChannel *chan, void *pvt,
+    chPostEventFunc **cb_out, void **arg_out, db_field_log *probe)
+{
+    myStruct *my = (myStruct*) pvt;
+
+    /* numeric scalars only */
+    if (probe->no_elements != 1 ||
+            probe->field_type < DBF_CHAR || probe->field_type > DBF_ENUM)
+        return;
+
+    switch (my->op) {
+    case aggLast:
+        break;
+    case aggCount:
+        probe->field_type = DBF_ULONG;
+        probe->field_size = sizeof(epicsUInt32);
+        break;
+    default:
+        probe->field_type = DBF_DOUBLE;
+        probe->field_size = sizeof(epicsFloat64);
+    }
+    *cb_out = filter;
+    *arg_out = pvt;
+}
+
+static void channel_report(dbChannel *chan, void *pvt, int level,
+    const unsigned short indent)
+{
+    myStruct *my = (myStruct*) pvt;
+    printf("%*sAggregate (agg): period=%g, op=%s, %lu updates in %lu windows\n",
+           indent, "", my->period, chfPluginEnumString(opEnum, my->op, "?"),
+           my->nUpdates, my->nWindows);
+}
+
+/* waits for a window being ended by the timer thread */
+static void channel_close(dbChannel *chan, void *pvt)
+{
+    myStruct *my = (myStruct*) pvt;
+
+    if (my->timer)
+        epicsTimerQueueDestroyTimer(my->queue, my->timer);
+    if (my->queue)
+        epicsTimerQueueRelease(my->queue);
+    my->timer = NULL;
+    my->queue = NULL;
+}
+
+static chfPluginIf pif = {
+    allocPvt,
+    freePvt,
+
+    NULL, /* parse_error, */
+    parse_ok,
+
+    channel_open,
+    channelRegisterPre,
+    NULL, /* channelRegisterPost, */
+    channel_report,
+    channel_close
+};
+
+static void aggShutdown(void* ignore)
+{
+    if (myStructFreeList)
+        freeListCleanup(myStructFreeList);
+    myStructFreeList = NULL;
+}
+
+static void aggInitialize(void)
+{
+    if (!myStructFreeList)
+        freeListInitPvt(&myStructFreeList, sizeof(myStruct), 64);
+
+    chfPluginRegister("agg", &pif, opts);
+    epicsAtExit(aggShutdown, NULL);
+}
+
+epicsExportRegistrar(aggInitialize);
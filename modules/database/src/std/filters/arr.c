@@ -15,7 +15,6 @@
 
 #include "chfPlugin.h"
 #include "dbAccessDefs.h"
-#include "dbExtractArray.h"
 #include "db_field_log.h"
 #include "dbLock.h"
 #include "epicsExit.h"
@@ -26,7 +25,6 @@ typedef struct myStruct {
     epicsInt32 start;
     epicsInt32 incr;
     epicsInt32 end;
-    void *arrayFreeList;
     long no_elements;
 } myStruct;
 
@@ -53,9 +51,6 @@ static void * allocPvt(void)
 
 static void freePvt(void *pvt)
 {
-    myStruct *my = (myStruct*) pvt;
-
-    if (my->arrayFreeList) freeListCleanup(my->arrayFreeList);
     freeListFree(myStructFreeList, pvt);
 }
 
@@ -67,13 +62,6 @@ static int parse_ok(void *pvt)
     return 0;
 }
 
-static void freeArray(db_field_log *pfl)
-{
-    if (pfl->type == dbfl_type_ref) {
-        freeListFree(pfl->u.r.pvt, pfl->u.r.field);
-    }
-}
-
 static long wrapArrayIndices(long *start, const long increment, long *end,
     const long no_elements)
 {
@@ -91,17 +79,19 @@ static long wrapArrayIndices(long *start, const long increment, long *end,
         return 0;
 }
 
+/*
+ * The selection is returned as a view on the incoming data, or narrows
+ * the incoming view, so that the chain makes a single copy at its end.
+ */
 static db_field_log* filter(void* pvt, dbChannel *chan, db_field_log *pfl)
 {
     myStruct *my = (myStruct*) pvt;
-    int must_lock;
     long start = my->start;
     long end = my->end;
     long nTarget;
-    void *pTarget;
-    long offset = 0;
     long nSource = pfl->no_elements;
-    void *pSource = pfl->u.r.field;
+    long first = 0;
+    long incr = 1;
 
     switch (pfl->type) {
     case dbfl_type_val:
@@ -109,29 +99,24 @@ static db_field_log* filter(void* pvt, dbChannel *chan, db_field_log *pfl)
         break;
 
     case dbfl_type_ref:
-        must_lock = !pfl->dtor;
-        if (must_lock) {
-            dbScanLock(dbChannelRecord(chan));
+        if (dbfl_has_view(pfl)) {
+            first = pfl->u.r.start;
+            incr = pfl->u.r.incr;
+        }
+        else if (!pfl->dtor) {
+            /* the chain keeps the record locked until the view is copied */
+            void *pSource = pfl->u.r.field;
+            long offset = 0;
+
             dbChannelGetArrayInfo(chan, &pSource, &nSource, &offset);
+            if (nSource > pfl->no_elements)
+                nSource = pfl->no_elements;
         }
         nTarget = wrapArrayIndices(&start, my->incr, &end, nSource);
-        if (nTarget > 0) {
-            /* copy the data */
-            pTarget = freeListCalloc(my->arrayFreeList);
-            if (!pTarget) break;
-            /* must do the wrap-around with the original no_elements */
-            offset = (offset + start) % pfl->no_elements;
-            dbExtractArray(pSource, pTarget, pfl->field_size,
-                nTarget, pfl->no_elements, offset, my->incr);
-            if (pfl->dtor) pfl->dtor(pfl);
-            pfl->u.r.field = pTarget;
-            pfl->dtor = freeArray;
-            pfl->u.r.pvt = my->arrayFreeList;
-        }
+        pfl->u.r.start = first + start * incr;
+        pfl->u.r.incr = incr * my->incr;
         /* adjust no_elements (even if zero elements remain) */
         pfl->no_elements = nTarget;
-        if (must_lock)
-            dbScanUnlock(dbChannelRecord(chan));
         break;
     }
     return pfl;
@@ -148,11 +133,6 @@ static void channelRegisterPost(dbChannel *chan, void *pvt,
     if (probe->no_elements <= 1) return;    /* array data only */
 
     max = wrapArrayIndices(&start, my->incr, &end, probe->no_elements);
-    if (max) {
-        if (!my->arrayFreeList)
-            freeListInitPvt(&my->arrayFreeList, max * probe->field_size, 2);
-        if (!my->arrayFreeList) return;
-    }
     probe->no_elements = my->no_elements = max;
     *cb_out = filter;
     *arg_out = pvt;
@@ -193,6 +173,7 @@ static void arrInitialize(void)
         freeListInitPvt(&myStructFreeList, sizeof(myStruct), 64);
 
     chfPluginRegister("arr", &pif, opts);
+    dbChannelAcceptViews(filter);
     epicsAtExit(arrShutdown, NULL);
 }
 
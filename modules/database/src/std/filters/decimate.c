@@ -117,6 +117,7 @@ static void decInitialize(void)
         freeListInitPvt(&myStructFreeList, sizeof(myStruct), 64);
 
     chfPluginRegister("dec", &pif, opts);
+    dbChannelAcceptViews(filter);
     epicsAtExit(decShutdown, NULL);
 }
 
@@ -0,0 +1,271 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Delta filter: sends the ranges of an array that changed since the
+ * previous update, encoded by epicsDeltaEncode() as a UCHAR array.
+ *
+ * It runs in the post-chain, so the previous update is the one that was
+ * actually delivered and not one that the event queue replaced. The
+ * post-chain runs for each subscription to the channel, so the array last
+ * sent is kept for each one, for up to MAX_SUBS of them. A subscription
+ * whose state was dropped for a newer one gets a full frame.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "chfPlugin.h"
+#include "dbAccessDefs.h"
+#include "dbExtractArray.h"
+#include "dbLock.h"
+#include "db_field_log.h"
+#include "epicsDeltaCodec.h"
+#include "epicsExit.h"
+#include "epicsMutex.h"
+#include "freeList.h"
+#include "epicsExport.h"
+
+/* subscriptions with a state of their own */
+#define MAX_SUBS 8
+
+/* what was sent to one subscription */
+typedef struct deltaSub {
+    size_t id;          /* evSubscrip::id, 0 if unused */
+    void *prev;         /* the array last sent */
+    long nPrev;
+    unsigned long count;
+    unsigned long lastUsed;
+} deltaSub;
+
+typedef struct myStruct {
+    epicsInt32 key;
+    epicsMutexId lock;  /* taken after the record lock */
+    void *msgFreeList;
+    long capacity;      /* elements */
+    short field_size;
+    void *scratch;      /* for arrays that wrap around */
+    deltaSub subs[MAX_SUBS];
+    unsigned long count, nFull;
+    double bytesIn, bytesOut;
+} myStruct;
+
+static void *myStructFreeList;
+
+/* updates between full frames, unless given */
+#define DEFAULT_KEY 100
+
+static const chfPluginArgDef opts[] = {
+    chfInt32(myStruct, key, "key", 0, 1),
+    chfPluginArgEnd
+};
+
+static void * allocPvt(void)
+{
+    myStruct *my = (myStruct*) freeListCalloc(myStructFreeList);
+
+    if (!my)
+        return NULL;
+    my->lock = epicsMutexCreate();
+    if (!my->lock) {
+        freeListFree(myStructFreeList, my);
+        return NULL;
+    }
+    my->key = DEFAULT_KEY;
+    return (void *) my;
+}
+
+static void freePvt(void *pvt)
+{
+    myStruct *my = (myStruct*) pvt;
+    int i;
+
+    if (my->msgFreeList) freeListCleanup(my->msgFreeList);
+    for (i = 0; i < MAX_SUBS; i++)
+        free(my->subs[i].prev);
+    free(my->scratch);
+    epicsMutexDestroy(my->lock);
+    freeListFree(myStructFreeList, pvt);
+}
+
+static int parse_ok(void *pvt)
+{
+    myStruct *my = (myStruct*) pvt;
+
+    if (my->key < 0)
+        return -1;
+    return 0;
+}
+
+static void freeMsg(db_field_log *pfl)
+{
+    freeListFree(pfl->u.r.pvt, pfl->u.r.field);
+}
+
+/* The state of a subscription, a new one replaces the least recently used */
+static deltaSub * findSub(myStruct *my, size_t id)
+{
+    deltaSub *sub = &my->subs[0];
+    int i;
+
+    for (i = 0; i < MAX_SUBS; i++) {
+        if (my->subs[i].id == id)
+            return &my->subs[i];
+        if (my->subs[i].lastUsed < sub->lastUsed)
+            sub = &my->subs[i];
+    }
+    if (!sub->prev)
+        sub->prev = malloc(my->capacity * my->field_size);
+    if (!sub->prev)
+        return NULL;
+    sub->id = id;
+    sub->nPrev = 0;
+    sub->count = 0;
+    return sub;
+}
+
+static db_field_log* filter(void* pvt, dbChannel *chan, db_field_log *pfl)
+{
+    myStruct *my = (myStruct*) pvt;
+    int event = pfl->ctx == dbfl_context_event && pfl->sub_id != 0;
+    deltaSub *sub = NULL;
+    int must_lock;
+    void *pSource = pfl->u.r.field;
+    long nSource = pfl->no_elements;
+    long offset = 0;
+    const void *pcur;
+    int full;
+    void *pmsg;
+    size_t size;
+
+    if (pfl->type != dbfl_type_ref || pfl->field_size != my->field_size)
+        return pfl;
+
+    pmsg = freeListMalloc(my->msgFreeList);
+    if (!pmsg)
+        return pfl;
+
+    must_lock = !pfl->dtor && pfl->no_elements > 0;
+    if (must_lock) {
+        dbScanLock(dbChannelRecord(chan));
+        dbChannelGetArrayInfo(chan, &pSource, &nSource, &offset);
+    }
+    epicsMutexMustLock(my->lock);
+    if (event)
+        sub = findSub(my, pfl->sub_id);
+    if (nSource > my->capacity)
+        nSource = my->capacity;
+    if (offset == 0 || nSource == 0) {
+        pcur = pSource;
+    }
+    else {
+        /* must do the wrap-around with the original no_elements */
+        dbExtractArray(pSource, my->scratch, pfl->field_size,
+            nSource, pfl->no_elements, offset % pfl->no_elements, 1);
+        pcur = my->scratch;
+    }
+
+    /* reads get the whole array and leave the monitors' state alone */
+    full = !sub || sub->count == 0 ||
+        (my->key > 0 && sub->count % my->key == 0);
+    size = epicsDeltaEncode(pmsg, full ? NULL : sub->prev, full ? 0 :
+        sub->nPrev, pcur, nSource, pfl->field_size);
+    if (event) {
+        my->count++;
+        if (sub) {
+            if (nSource > 0)
+                memcpy(sub->prev, pcur, nSource * pfl->field_size);
+            sub->nPrev = nSource;
+            sub->count++;
+            sub->lastUsed = my->count;
+        }
+        if (full || epicsDeltaIsFullFrame(pmsg, size))
+            my->nFull++;
+        my->bytesIn += (double) nSource * pfl->field_size;
+        my->bytesOut += size;
+    }
+    epicsMutexUnlock(my->lock);
+    if (must_lock)
+        dbScanUnlock(dbChannelRecord(chan));
+
+    if (pfl->dtor) pfl->dtor(pfl);
+    pfl->field_type = DBF_UCHAR;
+    pfl->field_size = 1;
+    pfl->no_elements = size;
+    pfl->u.r.field = pmsg;
+    pfl->u.r.pvt = my->msgFreeList;
+    pfl->dtor = freeMsg;
+    return pfl;
+}
+
+static void channelRegisterPost(dbChannel *chan, void *pvt,
+    chPostEventFunc **cb_out, void **arg_out, db_field_log *probe)
+{
+    myStruct *my = (myStruct*) pvt;
+    size_t maxSize;
+
+    /* numeric arrays only */
+    if (probe->no_elements <= 1 ||
+            probe->field_type < DBF_CHAR || probe->field_type > DBF_ENUM)
+        return;
+
+    my->capacity = probe->no_elements;
+    my->field_size = probe->field_size;
+    maxSize = epicsDeltaMaxSize(probe->field_size, probe->no_elements);
+    if (!my->msgFreeList)
+        freeListInitPvt(&my->msgFreeList, maxSize, 2);
+    my->scratch = malloc(my->capacity * my->field_size);
+    if (!my->msgFreeList || !my->scratch)
+        return;
+
+    probe->field_type = DBF_UCHAR;
+    probe->field_size = 1;
+    probe->no_elements = maxSize;
+    *cb_out = filter;
+    *arg_out = pvt;
+}
+
+static void channel_report(dbChannel *chan, void *pvt, int level,
+    const unsigned short indent)
+{
+    myStruct *my = (myStruct*) pvt;
+    printf("%*sDelta (delta): key=%d, %lu updates, %lu full, %.0f bytes "
+           "sent for %.0f\n", indent, "", my->key, my->count, my->nFull,
+           my->bytesOut, my->bytesIn);
+}
+
+static chfPluginIf pif = {
+    allocPvt,
+    freePvt,
+
+    NULL, /* parse_error, */
+    parse_ok,
+
+    NULL, /* channel_open, */
+    NULL, /* channelRegisterPre, */
+    channelRegisterPost,
+    channel_report,
+    NULL /* channel_close */
+};
+
+static void deltaShutdown(void* ignore)
+{
+    if (myStructFreeList)
+        freeListCleanup(myStructFreeList);
+    myStructFreeList = NULL;
+}
+
+static void deltaInitialize(void)
+{
+    if (!myStructFreeList)
+        freeListInitPvt(&myStructFreeList, sizeof(myStruct), 64);
+
+    chfPluginRegister("delta", &pif, opts);
+    epicsAtExit(deltaShutdown, NULL);
+}
+
+epicsExportRegistrar(deltaInitialize);
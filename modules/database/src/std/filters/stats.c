@@ -0,0 +1,321 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Statistics filter: replaces an array by its minimum, maximum, mean,
+ * root mean square and standard deviation, so that clients which only
+ * want these do not have to subscribe to the whole array.
+ */
+
+#include <stdio.h>
+#include <math.h>
+
+#include "chfPlugin.h"
+#include "dbAccessDefs.h"
+#include "dbLock.h"
+#include "db_field_log.h"
+#include "epicsArrayKernels.h"
+#include "epicsExit.h"
+#include "epicsMath.h"
+#include "freeList.h"
+#include "epicsExport.h"
+
+/* The quantities, in the order of the full result */
+enum statsQuantity {
+    statsAll = -1,
+    statsMin = 0,
+    statsMax = 1,
+    statsMean = 2,
+    statsRms = 3,
+    statsStd = 4,
+    statsCount
+};
+
+static const chfPluginEnumType quantityEnum[] = {
+    {"all", statsAll}, {"min", statsMin}, {"max", statsMax},
+    {"mean", statsMean}, {"rms", statsRms}, {"std", statsStd},
+    {NULL, 0}
+};
+
+typedef struct myStruct {
+    int q;
+} myStruct;
+
+static void *myStructFreeList;
+static void *resultFreeList;
+
+static const chfPluginArgDef opts[] = {
+    chfEnum(myStruct, q, "q", 0, 0, quantityEnum),
+    chfPluginArgEnd
+};
+
+/*
+ * Running sums over one or more blocks of elements. The sums are of
+ * the differences from the first element, which keeps the variance
+ * accurate for data with a large offset.
+ */
+typedef struct statsAcc {
+    double lo, hi;
+    double shift;
+    double s1, s2;
+    long n;
+} statsAcc;
+
+typedef void (*statsKernel)(statsAcc *acc, const void *pv, long n);
+
+#define LANES EPICS_ARRAY_KERNEL_LANES
+
+/* Four partial results are kept so that the compiler can vectorize */
+#define STATS_KERNEL(type, suffix, attr) \
+attr static void stats_##type##suffix(statsAcc *acc, const void *pv, long n) \
+{ \
+    const type *p = (const type *) pv; \
+    double lo[LANES], hi[LANES]; \
+    double s1[LANES], s2[LANES]; \
+    double shift; \
+    long i; \
+    int k; \
+\
+    if (n <= 0) \
+        return; \
+    if (acc->n == 0) \
+        acc->shift = acc->lo = acc->hi = p[0]; \
+    shift = acc->shift; \
+    for (k = 0; k < LANES; k++) { \
+        lo[k] = acc->lo; \
+        hi[k] = acc->hi; \
+        s1[k] = s2[k] = 0.0; \
+    } \
+    for (i = 0; i + LANES <= n; i += LANES) { \
+        for (k = 0; k < LANES; k++) { \
+            double x = p[i + k]; \
+            lo[k] = x < lo[k] ? x : lo[k]; \
+            hi[k] = x > hi[k] ? x : hi[k]; \
+            x -= shift; \
+            s1[k] += x; \
+            s2[k] += x * x; \
+        } \
+    } \
+    for (; i < n; i++) { \
+        double x = p[i]; \
+        lo[0] = x < lo[0] ? x : lo[0]; \
+        hi[0] = x > hi[0] ? x : hi[0]; \
+        x -= shift; \
+        s1[0] += x; \
+        s2[0] += x * x; \
+    } \
+    for (k = 0; k < LANES; k++) { \
+        acc->lo = lo[k] < acc->lo ? lo[k] : acc->lo; \
+        acc->hi = hi[k] > acc->hi ? hi[k] : acc->hi; \
+    } \
+    acc->s1 += (s1[0] + s1[1]) + (s1[2] + s1[3]); \
+    acc->s2 += (s2[0] + s2[1]) + (s2[2] + s2[3]); \
+    acc->n += n; \
+}
+
+/* Indexed by DBF type, DBF_ENUM is read as epicsUInt16 */
+#define STATS_KERNELS(suffix, attr) \
+    STATS_KERNEL(epicsInt8, suffix, attr) \
+    STATS_KERNEL(epicsUInt8, suffix, attr) \
+    STATS_KERNEL(epicsInt16, suffix, attr) \
+    STATS_KERNEL(epicsUInt16, suffix, attr) \
+    STATS_KERNEL(epicsInt32, suffix, attr) \
+    STATS_KERNEL(epicsUInt32, suffix, attr) \
+    STATS_KERNEL(epicsInt64, suffix, attr) \
+    STATS_KERNEL(epicsUInt64, suffix, attr) \
+    STATS_KERNEL(epicsFloat32, suffix, attr) \
+    STATS_KERNEL(epicsFloat64, suffix, attr) \
+\
+static const statsKernel kernels##suffix[DBF_ENUM + 1] = { \
+    NULL, \
+    stats_epicsInt8##suffix, stats_epicsUInt8##suffix, \
+    stats_epicsInt16##suffix, stats_epicsUInt16##suffix, \
+    stats_epicsInt32##suffix, stats_epicsUInt32##suffix, \
+    stats_epicsInt64##suffix, stats_epicsUInt64##suffix, \
+    stats_epicsFloat32##suffix, stats_epicsFloat64##suffix, \
+    stats_epicsUInt16##suffix \
+};
+
+EPICS_ARRAY_KERNEL_VARIANTS(STATS_KERNELS)
+
+static void statsResult(const statsAcc *acc, double result[statsCount])
+{
+    double mean, var;
+    int i;
+
+    if (acc->n == 0) {
+        for (i = 0; i < statsCount; i++)
+            result[i] = epicsNAN;
+        return;
+    }
+    mean = acc->s1 / acc->n;
+    var = acc->s2 / acc->n - mean * mean;
+    if (var < 0.0)
+        var = 0.0;
+    mean += acc->shift;
+    result[statsMin] = acc->lo;
+    result[statsMax] = acc->hi;
+    result[statsMean] = mean;
+    result[statsRms] = sqrt(var + mean * mean);
+    result[statsStd] = sqrt(var);
+}
+
+static void * allocPvt(void)
+{
+    myStruct *my = (myStruct*) freeListCalloc(myStructFreeList);
+    if (!my) return NULL;
+
+    my->q = statsAll;
+    return (void *) my;
+}
+
+static void freePvt(void *pvt)
+{
+    freeListFree(myStructFreeList, pvt);
+}
+
+static void freeResult(db_field_log *pfl)
+{
+    freeListFree(resultFreeList, pfl->u.r.field);
+}
+
+static db_field_log* filter(void* pvt, dbChannel *chan, db_field_log *pfl)
+{
+    myStruct *my = (myStruct*) pvt;
+    short type = pfl->field_type;
+    statsKernel kernel;
+    statsAcc acc = {0.0, 0.0, 0.0, 0.0, 0.0, 0};
+    double result[statsCount];
+
+    if (type == DBF_MENU || type == DBF_DEVICE)
+        type = DBF_ENUM;
+    if (type < DBF_CHAR || type > DBF_ENUM)
+        return pfl;
+    kernel = EPICS_ARRAY_KERNEL_PICK(kernels)[type];
+
+    if (pfl->type == dbfl_type_val) {
+        kernel(&acc, &pfl->u.v.field, 1);
+    }
+    else if (pfl->dtor || pfl->no_elements == 0) {
+        /* a copy made by an earlier filter */
+        kernel(&acc, pfl->u.r.field, pfl->no_elements);
+        if (pfl->dtor) pfl->dtor(pfl);
+    }
+    else {
+        struct dbCommon *prec = dbChannelRecord(chan);
+        void *pSource = pfl->u.r.field;
+        long nSource = pfl->no_elements;
+        long offset = 0;
+        long nFirst;
+
+        dbScanLock(prec);
+        dbChannelGetArrayInfo(chan, &pSource, &nSource, &offset);
+        /* the elements may wrap around the end of the field */
+        offset %= pfl->no_elements;
+        if (nSource > pfl->no_elements)
+            nSource = pfl->no_elements;
+        nFirst = pfl->no_elements - offset;
+        if (nFirst > nSource)
+            nFirst = nSource;
+        kernel(&acc, (char *) pSource + offset * pfl->field_size, nFirst);
+        kernel(&acc, pSource, nSource - nFirst);
+        dbScanUnlock(prec);
+    }
+    pfl->dtor = NULL;
+
+    statsResult(&acc, result);
+    pfl->field_type = DBF_DOUBLE;
+    pfl->field_size = sizeof(epicsFloat64);
+    if (my->q == statsAll) {
+        epicsFloat64 *pTarget = (epicsFloat64 *) freeListMalloc(resultFreeList);
+        int i;
+
+        pfl->type = dbfl_type_ref;
+        pfl->u.r.pvt = NULL;
+        pfl->u.r.field = pTarget;
+        if (pTarget) {
+            for (i = 0; i < statsCount; i++)
+                pTarget[i] = result[i];
+            pfl->no_elements = statsCount;
+            pfl->dtor = freeResult;
+        }
+        else {
+            pfl->no_elements = 0;
+        }
+    }
+    else {
+        pfl->type = dbfl_type_val;
+        pfl->no_elements = 1;
+        pfl->u.v.field.dbf_double = result[my->q];
+    }
+    return pfl;
+}
+
+/* Registered for the pre-chain, so the reduction is done once per post */
+static void channelRegisterPre(dbChannel *chan, void *pvt,
+    chPostEventFunc **cb_out, void **arg_out, db_field_log *probe)
+{
+    myStruct *my = (myStruct*) pvt;
+    short type = probe->field_type;
+
+    /* numeric data only, menus are read as DBF_ENUM by filter() */
+    if (type == DBF_MENU || type == DBF_DEVICE)
+        type = DBF_ENUM;
+    if (type < DBF_CHAR || type > DBF_ENUM)
+        return;
+
+    probe->field_type = DBF_DOUBLE;
+    probe->field_size = sizeof(epicsFloat64);
+    probe->no_elements = my->q == statsAll ? statsCount : 1;
+    *cb_out = filter;
+    *arg_out = pvt;
+}
+
+static void channel_report(dbChannel *chan, void *pvt, int level,
+    const unsigned short indent)
+{
+    myStruct *my = (myStruct*) pvt;
+    printf("%*sStatistics (stats): q=%s\n", indent, "",
+           chfPluginEnumString(quantityEnum, my->q, "?"));
+}
+
+static chfPluginIf pif = {
+    allocPvt,
+    freePvt,
+
+    NULL, /* parse_error, */
+    NULL, /* parse_ok, */
+
+    NULL, /* channel_open, */
+    channelRegisterPre,
+    NULL, /* channelRegisterPost, */
+    channel_report,
+    NULL /* channel_close */
+};
+
+static void statsShutdown(void* ignore)
+{
+    if (myStructFreeList)
+        freeListCleanup(myStructFreeList);
+    myStructFreeList = NULL;
+    if (resultFreeList)
+        freeListCleanup(resultFreeList);
+    resultFreeList = NULL;
+}
+
+static void statsInitialize(void)
+{
+    if (!myStructFreeList)
+        freeListInitPvt(&myStructFreeList, sizeof(myStruct), 64);
+    if (!resultFreeList)
+        freeListInitPvt(&resultFreeList,
+            statsCount * sizeof(epicsFloat64), 64);
+
+    chfPluginRegister("stats", &pif, opts);
+    epicsAtExit(statsShutdown, NULL);
+}
+
+epicsExportRegistrar(statsInitialize);
@@ -198,6 +198,7 @@ static void syncInitialize(void)
         freeListInitPvt(&myStructFreeList, sizeof(myStruct), 64);
 
     chfPluginRegister("sync", &pif, opts);
+    dbChannelAcceptViews(filter);
     epicsAtExit(syncShutdown, NULL);
 }
 
@@ -95,5 +95,6 @@ static
 void utagInitialize(void)
 {
     chfPluginRegister("utag", &pif, opts);
+    dbChannelAcceptViews(filter);
 }
 epicsExportRegistrar(utagInitialize);
@@ -44,6 +44,7 @@
 #include "cantProceed.h"
 #include "special.h"
 #include "menuYesNo.h"
+#include "epicsSharedArray.h"
 
 #define GEN_SIZE_OFFSET
 #include "aaiRecord.h"
@@ -94,6 +95,14 @@ epicsExportAddress(rset,aaiRSET);
 static void monitor(aaiRecord *);
 static long readValue(aaiRecord *);
 
+/* copy the array to the shared memory region for local readers */
+static void publish(aaiRecord *prec)
+{
+    if (prec->shmp)
+        epicsSharedArrayPublish(prec->shmp, prec->bptr, prec->nord,
+            &prec->time, prec->stat, prec->sevr);
+}
+
 static long init_record(struct dbCommon *pcommon, int pass)
 {
     struct aaiRecord *prec = (struct aaiRecord *)pcommon;
@@ -131,6 +140,13 @@ static long init_record(struct dbCommon *pcommon, int pass)
             prec->bptr = callocMustSucceed(prec->nelm, dbValueSize(prec->ftvl),
                 "aai: buffer calloc failed");
         }
+        if (prec->shm[0]) {
+            prec->shmp = epicsSharedArrayCreate(prec->shm, prec->ftvl,
+                dbValueSize(prec->ftvl), prec->nelm);
+            if (!prec->shmp)
+                errlogPrintf("%s: Can't create shared array \"%s\"\n",
+                    prec->name, prec->shm);
+        }
         return 0;
     }
 
@@ -174,6 +190,7 @@ static long process(struct dbCommon *pcommon)
     recGblGetTimeStampSimm(prec, prec->simm, &prec->siol);
 
     monitor(prec);
+    publish(prec);
     /* process the forward scan link record */
     recGblFwdLink(prec);
 
@@ -235,6 +252,7 @@ static long put_array_info(DBADDR *paddr, long nNew)
 
     if (nord != prec->nord)
         db_post_events(prec, &prec->nord, DBE_VALUE | DBE_LOG);
+    publish(prec);
     return 0;
 }
 
@@ -0,0 +1,322 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* Record Support Routines for Array Calculation records */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "dbDefs.h"
+#include "errlog.h"
+#include "alarm.h"
+#include "cantProceed.h"
+#include "dbAccess.h"
+#include "dbEvent.h"
+#include "dbFldTypes.h"
+#include "dbLink.h"
+#include "errMdef.h"
+#include "recSup.h"
+#include "recGbl.h"
+#include "special.h"
+
+#define GEN_SIZE_OFFSET
+#include "acalcRecord.h"
+#undef  GEN_SIZE_OFFSET
+#include "epicsExport.h"
+
+/* Create RSET - Record Support Entry Table */
+
+#define report NULL
+#define initialize NULL
+static long init_record(struct dbCommon *pcommon, int pass);
+static long process(struct dbCommon *prec);
+static long special(DBADDR *paddr, int after);
+#define get_value NULL
+static long cvt_dbaddr(DBADDR *paddr);
+static long get_array_info(DBADDR *paddr, long *no_elements, long *offset);
+static long put_array_info(DBADDR *paddr, long nNew);
+static long get_units(DBADDR *paddr, char *units);
+static long get_precision(const DBADDR *paddr, long *precision);
+#define get_enum_str NULL
+#define get_enum_strs NULL
+#define put_enum_str NULL
+static long get_graphic_double(DBADDR *paddr, struct dbr_grDouble *pgd);
+static long get_control_double(DBADDR *paddr, struct dbr_ctrlDouble *pcd);
+#define get_alarm_double NULL
+
+rset acalcRSET={
+    RSETNUMBER,
+    report,
+    initialize,
+    init_record,
+    process,
+    special,
+    get_value,
+    cvt_dbaddr,
+    get_array_info,
+    put_array_info,
+    get_units,
+    get_precision,
+    get_enum_str,
+    get_enum_strs,
+    put_enum_str,
+    get_graphic_double,
+    get_control_double,
+    get_alarm_double
+};
+epicsExportAddress(rset, acalcRSET);
+
+static void monitor(acalcRecord *prec, epicsUInt32 nord);
+static long fetch_values(acalcRecord *prec);
+static void alloc_work(acalcRecord *prec);
+
+#define indexof(field) acalcRecord##field
+
+static long init_record(struct dbCommon *pcommon, int pass)
+{
+    struct acalcRecord *prec = (struct acalcRecord *)pcommon;
+    short error_number;
+    int i;
+
+    if (pass == 0) {
+        if (prec->nelm <= 0)
+            prec->nelm = 1;
+        prec->val = callocMustSucceed(prec->nelm, sizeof(double),
+            "acalc: init_record");
+        for (i = 0; i < CALCPERFORM_NARGS; i++) {
+            (&prec->a)[i] = callocMustSucceed(prec->nelm, sizeof(double),
+                "acalc: init_record");
+            (&prec->nea)[i] = 1;
+        }
+        prec->nord = 0;
+        return 0;
+    }
+
+    for (i = 0; i < CALCPERFORM_NARGS; i++) {
+        long n = prec->nelm;
+
+        if (dbLoadLinkArray(&(&prec->inpa)[i], DBF_DOUBLE, (&prec->a)[i],
+                &n) == 0 && n > 0)
+            (&prec->nea)[i] = n;
+    }
+    if (postfix(prec->calc, prec->rpcl, &error_number)) {
+        recGblRecordError(S_db_badField, (void *)prec,
+                          "acalc: init_record: Illegal CALC field");
+        errlogPrintf("%s.CALC: %s in expression \"%s\"\n",
+                     prec->name, calcErrorStr(error_number), prec->calc);
+    }
+    alloc_work(prec);
+    return 0;
+}
+
+static long process(struct dbCommon *pcommon)
+{
+    struct acalcRecord *prec = (struct acalcRecord *)pcommon;
+    epicsUInt32 nord = prec->nord;
+
+    prec->pact = TRUE;
+    if (fetch_values(prec) == 0) {
+        epicsUInt32 n = prec->nelm;
+
+        if (calcArrayPerform((const double * const *) &prec->a, &prec->nea,
+                prec->val, &n, prec->rpcl, prec->work)) {
+            recGblSetSevr(prec, CALC_ALARM, INVALID_ALARM);
+        } else {
+            prec->nord = n;
+            prec->udf = FALSE;
+        }
+    }
+    if (prec->udf)
+        recGblSetSevr(prec, UDF_ALARM, prec->udfs);
+
+    recGblGetTimeStamp(prec);
+    monitor(prec, nord);
+    /* process the forward scan link record */
+    recGblFwdLink(prec);
+    prec->pact = FALSE;
+    return 0;
+}
+
+static long special(DBADDR *paddr, int after)
+{
+    acalcRecord *prec = (acalcRecord *)paddr->precord;
+    short error_number;
+
+    if (!after) return 0;
+    if (paddr->special == SPC_CALC) {
+        long status = 0;
+
+        if (postfix(prec->calc, prec->rpcl, &error_number)) {
+            recGblRecordError(S_db_badField, (void *)prec,
+                              "acalc: Illegal CALC field");
+            errlogPrintf("%s.CALC: %s in expression \"%s\"\n",
+                         prec->name, calcErrorStr(error_number), prec->calc);
+            status = S_db_badField;
+        }
+        alloc_work(prec);
+        return status;
+    }
+    recGblDbaddrError(S_db_badChoice, paddr, "acalc::special - bad special value!");
+    return S_db_badChoice;
+}
+
+static long cvt_dbaddr(DBADDR *paddr)
+{
+    acalcRecord *prec = (acalcRecord *)paddr->precord;
+    int fieldIndex = dbGetFieldIndex(paddr);
+
+    if (fieldIndex == indexof(VAL))
+        paddr->pfield = prec->val;
+    else if (fieldIndex >= indexof(A) && fieldIndex <= indexof(L))
+        paddr->pfield = (&prec->a)[fieldIndex - indexof(A)];
+    else {
+        errlogPrintf("acalcRecord::cvt_dbaddr called for %s.%s\n",
+            prec->name, paddr->pfldDes->name);
+        return 0;
+    }
+    paddr->no_elements = prec->nelm;
+    paddr->field_type = DBF_DOUBLE;
+    paddr->field_size = sizeof(double);
+    paddr->dbr_field_type = DBF_DOUBLE;
+    return 0;
+}
+
+static long get_array_info(DBADDR *paddr, long *no_elements, long *offset)
+{
+    acalcRecord *prec = (acalcRecord *)paddr->precord;
+    int fieldIndex = dbGetFieldIndex(paddr);
+
+    if (fieldIndex >= indexof(A) && fieldIndex <= indexof(L))
+        *no_elements = (&prec->nea)[fieldIndex - indexof(A)];
+    else
+        *no_elements = prec->nord;
+    *offset = 0;
+    return 0;
+}
+
+static long put_array_info(DBADDR *paddr, long nNew)
+{
+    acalcRecord *prec = (acalcRecord *)paddr->precord;
+    int fieldIndex = dbGetFieldIndex(paddr);
+    epicsUInt32 *pcount;
+
+    if (fieldIndex >= indexof(A) && fieldIndex <= indexof(L))
+        pcount = &(&prec->nea)[fieldIndex - indexof(A)];
+    else
+        pcount = &prec->nord;
+
+    *pcount = nNew > prec->nelm ? prec->nelm : nNew;
+    db_post_events(prec, pcount, DBE_VALUE | DBE_LOG);
+    return 0;
+}
+
+static long get_units(DBADDR *paddr, char *units)
+{
+    acalcRecord *prec = (acalcRecord *)paddr->precord;
+
+    switch (dbGetFieldIndex(paddr)) {
+        case indexof(VAL):
+        case indexof(HOPR):
+        case indexof(LOPR):
+            strncpy(units, prec->egu, DB_UNITS_SIZE);
+    }
+    return 0;
+}
+
+static long get_precision(const DBADDR *paddr, long *precision)
+{
+    acalcRecord *prec = (acalcRecord *)paddr->precord;
+    int fieldIndex = dbGetFieldIndex(paddr);
+
+    *precision = prec->prec;
+    if (fieldIndex == indexof(VAL) ||
+        (fieldIndex >= indexof(A) && fieldIndex <= indexof(L)))
+        return 0;
+    recGblGetPrec(paddr, precision);
+    return 0;
+}
+
+static long get_graphic_double(DBADDR *paddr, struct dbr_grDouble *pgd)
+{
+    acalcRecord *prec = (acalcRecord *)paddr->precord;
+
+    switch (dbGetFieldIndex(paddr)) {
+        case indexof(VAL):
+            pgd->upper_disp_limit = prec->hopr;
+            pgd->lower_disp_limit = prec->lopr;
+            break;
+        case indexof(NORD):
+            pgd->upper_disp_limit = prec->nelm;
+            pgd->lower_disp_limit = 0;
+            break;
+        default:
+            recGblGetGraphicDouble(paddr, pgd);
+    }
+    return 0;
+}
+
+static long get_control_double(DBADDR *paddr, struct dbr_ctrlDouble *pcd)
+{
+    acalcRecord *prec = (acalcRecord *)paddr->precord;
+
+    switch (dbGetFieldIndex(paddr)) {
+        case indexof(VAL):
+            pcd->upper_ctrl_limit = prec->hopr;
+            pcd->lower_ctrl_limit = prec->lopr;
+            break;
+        case indexof(NORD):
+            pcd->upper_ctrl_limit = prec->nelm;
+            pcd->lower_ctrl_limit = 0;
+            break;
+        default:
+            recGblGetControlDouble(paddr, pcd);
+    }
+    return 0;
+}
+
+static void monitor(acalcRecord *prec, epicsUInt32 nord)
+{
+    unsigned short monitor_mask = recGblResetAlarms(prec);
+
+    db_post_events(prec, prec->val, monitor_mask | DBE_VALUE | DBE_LOG);
+    if (nord != prec->nord)
+        db_post_events(prec, &prec->nord, monitor_mask | DBE_VALUE | DBE_LOG);
+}
+
+static long fetch_values(acalcRecord *prec)
+{
+    long status = 0;
+    int i;
+
+    for (i = 0; i < CALCPERFORM_NARGS; i++) {
+        struct link *plink = &(&prec->inpa)[i];
+        long nRequest = prec->nelm;
+        long newStatus;
+
+        if (dbLinkIsConstant(plink))
+            continue;
+        newStatus = dbGetLink(plink, DBR_DOUBLE, (&prec->a)[i], 0,
+            &nRequest);
+        if (newStatus == 0)
+            (&prec->nea)[i] = nRequest;
+        else if (status == 0)
+            status = newStatus;
+    }
+    return status;
+}
+
+/* The workspace for RPCL, so that process doesn't allocate one */
+static void alloc_work(acalcRecord *prec)
+{
+    size_t size = calcArrayWorkSize(prec->rpcl);
+
+    free(prec->work);
+    prec->work = size ? mallocMustSucceed(size * sizeof(double),
+        "acalc: alloc_work") : NULL;
+}
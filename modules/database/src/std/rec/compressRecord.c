@@ -21,6 +21,7 @@
 #include <math.h>
 
 #include "dbDefs.h"
+#include "epicsArrayKernels.h"
 #include "epicsPrint.h"
 #include "alarm.h"
 #include "dbStaticLib.h"
@@ -138,15 +139,39 @@ static void put_value(compressRecord *prec, double *psource, int n)
 }
 
 
-/* qsort comparison function (for median calculation) */
-static int compare(const void *arg1, const void *arg2)
+/*
+ * Returns the value which would be at index k if p[0..n-1] were sorted,
+ * reordering p on the way (Wirth's selection, O(n) on average). This
+ * replaces the qsort() previously used for the median.
+ */
+static double select_kth(double *p, epicsInt32 n, epicsInt32 k)
 {
-    double a = *(double *)arg1;
-    double b = *(double *)arg2;
-
-    if      ( a <  b ) return -1;
-    else if ( a == b ) return  0;
-    else               return  1;
+    epicsInt32 l = 0, m = n - 1;
+
+    while (l < m) {
+        double x = p[k];
+        epicsInt32 i = l, j = m;
+
+        do {
+            while (p[i] < x)
+                i++;
+            while (x < p[j])
+                j--;
+            if (i <= j) {
+                double tmp = p[i];
+
+                p[i] = p[j];
+                p[j] = tmp;
+                i++;
+                j--;
+            }
+        } while (i <= j);
+        if (j < k)
+            l = i;
+        if (k < i)
+            m = j;
+    }
+    return p[k];
 }
 
 #define min(a, b) ((a) < (b) ? (a) : (b))
@@ -154,7 +179,6 @@ static int compare(const void *arg1, const void *arg2)
 static int compress_array(compressRecord *prec,
     double *psource, int no_elements)
 {
-    epicsInt32 j;
     epicsInt32 n, nnew;
     epicsInt32 nsam = prec->nsam;
     epicsUInt32 samples_written = 0;
@@ -183,36 +207,20 @@ static int compress_array(compressRecord *prec,
         switch (prec->alg)
         {
         case compressALG_N_to_1_Low_Value:
-            value = *psource++;
-            for (j = 1; j < n; j++, psource++)
-            {
-                if (value > *psource)
-                    value = *psource;
-            }
+            value = epicsArrayMin(psource, n);
             break;
         case compressALG_N_to_1_High_Value:
-            value = *psource++;
-            for (j = 1; j < n; j++, psource++)
-            {
-                if (value < *psource)
-                    value = *psource;
-            }
+            value = epicsArrayMax(psource, n);
             break;
         case compressALG_N_to_1_Average:
-            value = *psource++;
-            for (j = 1; j < n; j++, psource++)
-            {
-                value += *psource;
-            }
-            value = value / n;
+            value = epicsArraySum(psource, n) / n;
             break;
         case compressALG_N_to_1_Median:
-            /* note: sorts source array (OK; it's a work pointer) */
-            qsort(psource, n, sizeof(double), compare);
-            value = psource[n / 2];
-            psource += n;
+            /* note: reorders source array (OK; it's a work pointer) */
+            value = select_kth(psource, n, n / 2);
             break;
         }
+        psource += n;
         nnew -= n;
         put_value(prec, &value, 1);
         samples_written++;
@@ -227,7 +235,6 @@ static int array_average(compressRecord *prec,
     epicsInt32 nnow;
     epicsInt32 nsam=prec->nsam;
     double *psum;
-    double multiplier;
     epicsInt32 inx = prec->inx;
     epicsInt32 nuse, n;
 
@@ -239,8 +246,22 @@ static int array_average(compressRecord *prec,
         nnow=no_elements;
     psum = (double *)prec->sptr;
 
-    /* add in the new waveform */
-    if (inx == 0) {
+    if (prec->n <= 0)
+        prec->n = 1;
+    n = prec->n;
+
+    /* nothing to average */
+    if (n == 1) {
+        put_value(prec, psource, nuse);
+        prec->inx = 0;
+        return 0;
+    }
+
+    /* add in the new waveform, scaling the sums with the last one */
+    if (inx + 1 >= n) {
+        epicsArrayAddScale(psum, psource, nnow, 1.0 / n);
+    }
+    else if (inx == 0) {
         for (i = 0; i < nnow; i++)
             *psum++ = *psource++;
         for (i = nnow; i < nuse; i++)
@@ -252,19 +273,10 @@ static int array_average(compressRecord *prec,
 
     /* do we need to calculate the result */
     inx++;
-    if (prec->n <= 0)
-        prec->n = 1;
-    n = prec->n;
     if (inx < n) {
         prec->inx = inx;
         return 1;
     }
-    if (n > 1) {
-        psum = (double *)prec->sptr;
-        multiplier = 1.0 / n;
-        for (i = 0; i < nuse; i++, psum++)
-            *psum = *psum * multiplier;
-    }
     put_value(prec, prec->sptr, nuse);
     prec->inx = 0;
     return 0;
@@ -36,6 +36,7 @@
 #include "special.h"
 #include "cantProceed.h"
 #include "menuYesNo.h"
+#include "epicsSharedArray.h"
 
 #define GEN_SIZE_OFFSET
 #include "waveformRecord.h"
@@ -84,6 +85,14 @@ epicsExportAddress(rset,waveformRSET);
 
 static void monitor(waveformRecord *);
 static long readValue(waveformRecord *);
+
+/* copy the array to the shared memory region for local readers */
+static void publish(waveformRecord *prec)
+{
+    if (prec->shmp)
+        epicsSharedArrayPublish(prec->shmp, prec->bptr, prec->nord,
+            &prec->time, prec->stat, prec->sevr);
+}
 
 static long init_record(struct dbCommon *pcommon, int pass)
 {
@@ -98,6 +107,13 @@ static long init_record(struct dbCommon *pcommon, int pass)
         prec->bptr = callocMustSucceed(prec->nelm, dbValueSize(prec->ftvl),
             "waveform calloc failed");
         prec->nord = (prec->nelm == 1);
+        if (prec->shm[0]) {
+            prec->shmp = epicsSharedArrayCreate(prec->shm, prec->ftvl,
+                dbValueSize(prec->ftvl), prec->nelm);
+            if (!prec->shmp)
+                errlogPrintf("%s: Can't create shared array \"%s\"\n",
+                    prec->name, prec->shm);
+        }
         return 0;
     }
 
@@ -147,6 +163,7 @@ static long process(struct dbCommon *pcommon)
     if (nord != prec->nord)
         db_post_events(prec, &prec->nord, DBE_VALUE | DBE_LOG);
     monitor(prec);
+    publish(prec);
 
     /* process the forward scan link record */
     recGblFwdLink(prec);
@@ -212,6 +229,7 @@ static long put_array_info(DBADDR *paddr, long nNew)
     {
         db_post_events(prec, &prec->nord, DBE_VALUE | DBE_LOG);
     }
+    publish(prec);
     return 0;
 }
 
@@ -0,0 +1,111 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+#include <string.h>
+
+#include "cantProceed.h"
+#include "dbExtractArray.h"
+#include "epicsTime.h"
+#include "epicsMath.h"
+
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#define NELEM 1000000
+
+static char *input, *output, *expect;
+
+/* the element by element copy that dbExtractArray() replaces */
+static void reference(const char *psrc, char *pdst, short field_size,
+    long nRequest, long no_elements, long offset, long increment)
+{
+    for (; nRequest > 0; nRequest--, pdst += field_size, offset += increment) {
+        offset %= no_elements;
+        memcpy(pdst, psrc + (offset * field_size), field_size);
+    }
+}
+
+/* copies from a buffer of 8MB */
+static void runBench(const char *what, short field_size, long offset,
+    long increment, long nRequest, size_t nrep)
+{
+    long no_elements = NELEM / field_size * 8;
+    double sum = 0, sum2 = 0, mean, t;
+    size_t i;
+
+    reference(input, expect, field_size, nRequest, no_elements, offset,
+        increment);
+    memset(output, 0, nRequest * field_size);
+    dbExtractArray(input, output, field_size, nRequest, no_elements, offset,
+        increment);
+    testOk(memcmp(output, expect, nRequest * field_size) == 0,
+           "%s, %d byte elements, increment %ld: data correct",
+           what, field_size, increment);
+
+    for (i = 0; i < nrep; i++) {
+        epicsTimeStamp start, stop;
+
+        epicsTimeGetCurrent(&start);
+        dbExtractArray(input, output, field_size, nRequest, no_elements,
+            offset, increment);
+        epicsTimeGetCurrent(&stop);
+        t = epicsTimeDiffInSeconds(&stop, &start);
+        sum += t;
+        sum2 += t * t;
+    }
+    mean = sum / nrep;
+    testDiag("%-10s %d byte, incr %3ld: %8.3f ms +- %.3f ms, %7.1f MB/s",
+             what, field_size, increment, mean * 1e3,
+             sqrt(sum2 / nrep - mean * mean) * 1e3,
+             nRequest * field_size / mean / 1e6);
+
+    sum = 0;
+    for (i = 0; i < nrep; i++) {
+        epicsTimeStamp start, stop;
+
+        epicsTimeGetCurrent(&start);
+        reference(input, output, field_size, nRequest, no_elements,
+            offset, increment);
+        epicsTimeGetCurrent(&stop);
+        sum += epicsTimeDiffInSeconds(&stop, &start);
+    }
+    testDiag("%-10s element by element: %8.3f ms", "", sum / nrep * 1e3);
+}
+
+MAIN(benchdbExtractArray)
+{
+    static const short sizes[] = {1, 2, 4, 8};
+    static const long increments[] = {2, 3, 10};
+    size_t i, j;
+
+    testPlan(32);
+
+    input = callocMustSucceed(NELEM, 8, "benchdbExtractArray");
+    output = callocMustSucceed(NELEM, 8, "benchdbExtractArray");
+    expect = callocMustSucceed(NELEM, 8, "benchdbExtractArray");
+    for (i = 0; i < NELEM * 8; i++)
+        input[i] = (char) (i * 7 + i / 251);
+
+    for (i = 0; i < 4; i++) {
+        long no_elements = NELEM / sizes[i] * 8;
+
+        runBench("contiguous", sizes[i], 0, 1, no_elements, 20);
+        runBench("wrapped", sizes[i], no_elements / 3, 1, no_elements, 20);
+        for (j = 0; j < 3; j++) {
+            runBench("strided", sizes[i], 0, increments[j],
+                (no_elements - 1) / increments[j] + 1, 20);
+        }
+        runBench("wrapped", sizes[i], no_elements / 3 + 1, 3,
+            no_elements / 3, 20);
+        /* a few elements per pass, and increments beyond the buffer */
+        runBench("wrapped", sizes[i], 5, no_elements / 4 + 1, 1000, 20);
+        runBench("wrapped", sizes[i], 5, 2 * no_elements + 3, 1000, 20);
+    }
+
+    free(input);
+    free(output);
+    free(expect);
+    return testDone();
+}
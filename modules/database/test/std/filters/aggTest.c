@@ -0,0 +1,248 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <string.h>
+
+#include "alarm.h"
+#include "caeventmask.h"
+#include "dbAccessDefs.h"
+#include "db_field_log.h"
+#include "dbChannel.h"
+#include "dbEvent.h"
+#include "dbLock.h"
+#include "chfPlugin.h"
+#include "errlog.h"
+#include "epicsEvent.h"
+#include "epicsMutex.h"
+#include "epicsThread.h"
+#include "epicsUnitTest.h"
+#include "dbUnitTest.h"
+#include "testMain.h"
+
+#include "xRecord.h"
+
+void filterTest_registerRecordDeviceDriver(struct dbBase *);
+
+static const double period = 0.5;
+
+typedef struct aggMonitor {
+    dbChannel *chan;
+    dbEventSubscription sub;
+    epicsMutexId lock;
+    epicsEventId event;
+    unsigned count;
+    short type;
+    double value;
+    unsigned short sevr;
+} aggMonitor;
+
+static void monitorUpdate(void *user_arg, struct dbChannel *chan,
+    int eventsRemaining, struct db_field_log *pfl)
+{
+    aggMonitor *mon = (aggMonitor *) user_arg;
+
+    epicsMutexMustLock(mon->lock);
+    mon->count++;
+    mon->type = pfl->field_type;
+    mon->sevr = pfl->sevr;
+    switch (pfl->field_type) {
+    case DBF_DOUBLE: mon->value = pfl->u.v.field.dbf_double; break;
+    case DBF_ULONG:  mon->value = pfl->u.v.field.dbf_ulong; break;
+    case DBF_LONG:   mon->value = pfl->u.v.field.dbf_long; break;
+    default:         mon->value = -1.0;
+    }
+    epicsMutexUnlock(mon->lock);
+    epicsEventSignal(mon->event);
+}
+
+static void monitorCreate(dbEventCtx ctx, aggMonitor *mon, const char *name)
+{
+    memset(mon, 0, sizeof(*mon));
+    mon->lock = epicsMutexMustCreate();
+    mon->event = epicsEventMustCreate(epicsEventEmpty);
+    mon->chan = dbChannelCreate(name);
+    if (!mon->chan || dbChannelOpen(mon->chan))
+        testAbort("Can't open channel '%s'", name);
+    mon->sub = db_add_event(ctx, mon->chan, monitorUpdate, mon,
+        DBE_VALUE | DBE_ALARM);
+    if (!mon->sub)
+        testAbort("Can't subscribe to '%s'", name);
+    db_event_enable(mon->sub);
+}
+
+static void monitorDestroy(aggMonitor *mon)
+{
+    db_event_disable(mon->sub);
+    db_cancel_event(mon->sub);
+    dbChannelDelete(mon->chan);
+    epicsEventDestroy(mon->event);
+    epicsMutexDestroy(mon->lock);
+}
+
+static unsigned monitorCount(aggMonitor *mon, double *pvalue, short *ptype)
+{
+    unsigned count;
+
+    epicsMutexMustLock(mon->lock);
+    count = mon->count;
+    mon->count = 0;
+    if (pvalue) *pvalue = mon->value;
+    if (ptype) *ptype = mon->type;
+    epicsMutexUnlock(mon->lock);
+    return count;
+}
+
+/* waits for an update, the timeout is only there to not hang the test */
+static unsigned monitorWait(aggMonitor *mon, double *pvalue, short *ptype)
+{
+    epicsEventWaitWithTimeout(mon->event, period * 20);
+    return monitorCount(mon, pvalue, ptype);
+}
+
+static void post(xRecord *prec, epicsInt32 val, unsigned short sevr)
+{
+    dbScanLock((dbCommon *) prec);
+    prec->val = val;
+    prec->sevr = sevr;
+    prec->stat = sevr ? HIGH_ALARM : NO_ALARM;
+    db_post_events(prec, &prec->val, DBE_VALUE);
+    dbScanUnlock((dbCommon *) prec);
+}
+
+static void testArgs(void)
+{
+    testDiag("Arguments");
+
+    testOk(!dbChannelCreate("x.VAL{agg:{}}"), "period is required");
+    testOk(!dbChannelCreate("x.VAL{agg:{period:0}}"), "period must be > 0");
+    testOk(!dbChannelCreate("x.VAL{agg:{period:1,op:\"median\"}}"),
+           "unknown op is rejected");
+}
+
+static void testOps(dbEventCtx ctx, xRecord *prec)
+{
+    static const char *names[] = {
+        "x.VAL{agg:{period:0.5}}",
+        "x.VAL{agg:{period:0.5,op:\"min\"}}",
+        "x.VAL{agg:{period:0.5,op:\"max\"}}",
+        "x.VAL{agg:{period:0.5,op:\"last\"}}",
+        "x.VAL{agg:{period:0.5,op:\"count\"}}"
+    };
+    static const double expect[] = {5.5, 1., 10., 10., 10.};
+    static const short types[] = {
+        DBF_DOUBLE, DBF_DOUBLE, DBF_DOUBLE, DBF_LONG, DBF_ULONG
+    };
+    aggMonitor mon[5];
+    unsigned i, count;
+    double value;
+    short type;
+
+    testDiag("One update per window");
+
+    for (i = 0; i < NELEMENTS(mon); i++)
+        monitorCreate(ctx, &mon[i], names[i]);
+    testOk(mon[0].chan->final_type == DBF_DOUBLE &&
+           mon[3].chan->final_type == DBF_LONG &&
+           mon[4].chan->final_type == DBF_ULONG, "final types");
+
+    for (i = 1; i <= 10; i++)
+        post(prec, i, i == 3 ? MAJOR_ALARM : NO_ALARM);
+    testOk(monitorCount(&mon[0], NULL, NULL) == 0,
+           "nothing sent during the window");
+
+    for (i = 0; i < NELEMENTS(mon); i++) {
+        count = monitorWait(&mon[i], &value, &type);
+        testOk(count == 1 && value == expect[i] && type == types[i],
+               "%s: %u update, value %g, type %d", names[i], count, value,
+               type);
+    }
+    testOk(mon[0].sevr == MAJOR_ALARM, "highest severity in the window");
+
+    testDiag("Windows follow each other while updates arrive");
+    post(prec, 1, NO_ALARM);
+    post(prec, 3, NO_ALARM);
+    count = monitorWait(&mon[0], &value, NULL);
+    testOk(count == 1 && value == 2.0, "first window, mean %g", value);
+    /* the next window started when the first one was sent */
+    post(prec, 5, NO_ALARM);
+    count = monitorWait(&mon[0], &value, NULL);
+    testOk(count == 1 && value == 5.0, "second window, mean %g", value);
+
+    testOk(epicsEventWaitWithTimeout(mon[0].event, period * 2) ==
+           epicsEventWaitTimeout && monitorCount(&mon[0], NULL, NULL) == 0,
+           "no update when idle");
+
+    for (i = 0; i < NELEMENTS(mon); i++)
+        monitorDestroy(&mon[i]);
+}
+
+static void testOrder(dbEventCtx ctx, xRecord *prec)
+{
+    aggMonitor mon;
+    unsigned count;
+    double value;
+
+    testDiag("Filters before agg only see the updates it collects");
+
+    /* dbnd would drop a summary of the value it has last passed */
+    monitorCreate(ctx, &mon,
+        "x.VAL{dbnd:{d:0.5},agg:{period:0.5,op:\"count\"}}");
+    post(prec, 10, NO_ALARM);
+    post(prec, 11, NO_ALARM);
+    post(prec, 12, NO_ALARM);
+    count = monitorWait(&mon, &value, NULL);
+    testOk(count == 1 && value == 3.0, "%u update, count %g", count, value);
+    monitorDestroy(&mon);
+}
+
+MAIN(aggTest)
+{
+    const chFilterPlugin *plug;
+    char myname[] = "agg";
+    dbEventCtx ctx;
+    xRecord *prec;
+    DBADDR addr;
+
+    testPlan(16);
+
+    testdbPrepare();
+
+    testdbReadDatabase("filterTest.dbd", NULL, NULL);
+
+    filterTest_registerRecordDeviceDriver(pdbbase);
+
+    testdbReadDatabase("xRecord.db", NULL, NULL);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    plug = dbFindFilter(myname, strlen(myname));
+    if (!plug)
+        testAbort("Plugin '%s' not registered", myname);
+    testPass("plugin '%s' registered correctly", myname);
+
+    if (dbNameToAddr("x", &addr))
+        testAbort("No record 'x'");
+    prec = (xRecord *) addr.precord;
+
+    ctx = db_init_events();
+    if (!ctx || db_start_events(ctx, "aggTest", NULL, NULL,
+            epicsThreadPriorityMedium))
+        testAbort("Can't start event task");
+
+    testArgs();
+    testOps(ctx, prec);
+    testOrder(ctx, prec);
+
+    db_close_events(ctx);
+
+    testIocShutdownOk();
+
+    testdbCleanup();
+
+    return testDone();
+}
@@ -148,6 +148,8 @@ static void check(short dbr_type) {
     epicsInt32 ar5_3_3[10] = {15,18};
     epicsInt32 ar5_5_3[10] = {17,10};
     epicsInt32 ar5_9_3[10] = {11,14};
+    epicsInt32 ar2_0_4[10] = {13,17};
+    epicsInt32 ar2_5_4[10] = {18,12};
     epicsInt32 off = 0;
 
     switch (dbr_type) {
@@ -291,6 +293,22 @@ static void check(short dbr_type) {
     TEST5B(3, -8,  6, "left side from-end");
     TEST5B(3,  2, -4, "right side from-end");
     TEST5B(3, -8, -4, "both sides from-end");
+
+    /* Selection from a selection, copied once at the end of the chain */
+
+    testHead("Two %s elements from a selection, increment 2 and 2", typname);
+    createAndOpen(valname, "{arr:{s:1,e:8,i:2},arr:{s:1,i:2}}",
+                  "(1:2:8 then 1:2:-1)", &pch, 2);
+    testOk(pch->final_no_elements == 2,
+           "final no_elements correct (%ld->%ld)", valaddr.no_elements, pch->final_no_elements);
+    TEST1(2, 0, 4, "no offset");
+    TEST1(2, 5, 4, "wrapped");
+    pfl = db_create_read_log(pch);
+    pfl2 = dbChannelRunPostChain(pch, pfl);
+    testOk(pch->view_free_list && pfl2->u.r.pvt == pch->view_free_list,
+           "the copy is in a buffer of the channel");
+    db_delete_field_log(pfl2);
+    dbChannelDelete(pch);
 }
 
 MAIN(arrTest)
@@ -299,7 +317,7 @@ MAIN(arrTest)
     const chFilterPlugin *plug;
     char arr[] = "arr";
 
-    testPlan(1402);
+    testPlan(1447);
 
     /* Prepare the IOC */
 
@@ -0,0 +1,279 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <string.h>
+
+#include "dbAccessDefs.h"
+#include "db_field_log.h"
+#include "dbChannel.h"
+#include "dbEvent.h"
+#include "dbLock.h"
+#include "caeventmask.h"
+#include "chfPlugin.h"
+#include "epicsDeltaCodec.h"
+#include "errlog.h"
+#include "epicsUnitTest.h"
+#include "dbUnitTest.h"
+#include "testMain.h"
+
+#include "arrRecord.h"
+
+void filterTest_registerRecordDeviceDriver(struct dbBase *);
+
+/* each client's copy of the array, client 0 reads, the others subscribe */
+static epicsInt32 copies[11][10];
+static long nCopies[11];
+
+static dbChannel* openChannel(const char *name)
+{
+    dbChannel *pch = dbChannelCreate(name);
+
+    if (!pch || dbChannelOpen(pch))
+        testAbort("Can't open channel '%s'", name);
+    return pch;
+}
+
+static void setOffset(epicsInt32 off)
+{
+    testdbPutFieldOk("x.OFF", DBR_LONG, off);
+}
+
+/*
+ * Sends the array through the post chain as a monitor update for
+ * subscription sub, or a read if sub is 0, applies the message to that
+ * client's copy and returns its size.
+ */
+static size_t updateSub(dbChannel *pch, size_t sub, int *full)
+{
+    db_field_log *pfl;
+    size_t size = 0;
+
+    dbScanLock(dbChannelRecord(pch));
+    pfl = db_create_read_log(pch);
+    dbScanUnlock(dbChannelRecord(pch));
+    if (sub) {
+        pfl->ctx = dbfl_context_event;
+        pfl->mask = DBE_VALUE;
+        pfl->sub_id = sub;
+    }
+    pfl = dbChannelRunPostChain(pch, pfl);
+
+    *full = 0;
+    if (pfl && pfl->type == dbfl_type_ref && pfl->field_type == DBF_UCHAR) {
+        size = pfl->no_elements;
+        *full = epicsDeltaIsFullFrame(pfl->u.r.field, size);
+        nCopies[sub] = epicsDeltaDecode(copies[sub], 10, sizeof(epicsInt32),
+            pfl->u.r.field, size);
+    }
+    if (pfl)
+        db_delete_field_log(pfl);
+    return size;
+}
+
+static size_t update(dbChannel *pch, int event, int *full)
+{
+    return updateSub(pch, event ? 1 : 0, full);
+}
+
+static int subCopyIs(size_t sub, const epicsInt32 *expected, long n)
+{
+    return nCopies[sub] == n &&
+        memcmp(copies[sub], expected, n * sizeof(epicsInt32)) == 0;
+}
+
+static int copyIs(const epicsInt32 *expected, long n)
+{
+    return subCopyIs(1, expected, n);
+}
+
+static void testDelta(void)
+{
+    epicsInt32 buf[10] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    static const epicsInt32 wrapped[10] = {5, 6, 70, 8, 9, 70, 1, 2, 3, 4};
+    static const epicsInt32 four[4] = {11, 12, 13, 14};
+    dbChannel *pch;
+    size_t size;
+    int full, nFull, i;
+
+    testDiag("Changes of a LONG array");
+
+    pch = openChannel("x.VAL{delta:{}}");
+    testOk(ellCount(&pch->pre_chain) == 0 && ellCount(&pch->post_chain) == 1,
+           "delta is in the post chain only");
+    testOk(pch->final_type == DBF_UCHAR && pch->final_no_elements ==
+           (long) epicsDeltaMaxSize(sizeof(epicsInt32), 10),
+           "final type %d, %ld elements", pch->final_type,
+           pch->final_no_elements);
+
+    testdbPutArrFieldOk("x.VAL", DBR_LONG, 10, buf);
+    size = update(pch, 1, &full);
+    testOk(full && copyIs(buf, 10), "first update is a full frame");
+
+    buf[6] = 70;
+    buf[9] = 100;
+    testdbPutArrFieldOk("x.VAL", DBR_LONG, 10, buf);
+    size = update(pch, 1, &full);
+    testOk(!full && size == EPICS_DELTA_HEADER_SIZE +
+           2 * (EPICS_DELTA_RUN_SIZE + sizeof(epicsInt32)) &&
+           copyIs(buf, 10), "two changed elements, %u bytes",
+           (unsigned) size);
+
+    size = update(pch, 1, &full);
+    testOk(size == EPICS_DELTA_HEADER_SIZE && copyIs(buf, 10),
+           "no change, %u bytes", (unsigned) size);
+
+    size = update(pch, 0, &full);
+    testOk(full && subCopyIs(0, buf, 10), "a read is a full frame");
+
+    buf[9] = 70;
+    testdbPutArrFieldOk("x.VAL", DBR_LONG, 10, buf);
+    size = update(pch, 1, &full);
+    testOk(!full && size == EPICS_DELTA_HEADER_SIZE + EPICS_DELTA_RUN_SIZE +
+           sizeof(epicsInt32) && copyIs(buf, 10),
+           "the read did not change the state");
+
+    setOffset(4);
+    size = update(pch, 1, &full);
+    testOk(copyIs(wrapped, 10), "array wrapped around, %u bytes",
+           (unsigned) size);
+    setOffset(0);
+
+    testdbPutArrFieldOk("x.VAL", DBR_LONG, 4, four);
+    size = update(pch, 1, &full);
+    testOk(full && copyIs(four, 4), "new length is a full frame");
+    dbChannelDelete(pch);
+
+    pch = openChannel("x.VAL{delta:{key:2}}");
+    update(pch, 1, &full);
+    testOk1(full);
+    update(pch, 1, &full);
+    testOk(!full, "second update is not a full frame");
+    update(pch, 1, &full);
+    testOk(full && copyIs(four, 4), "third update is a key frame");
+    dbChannelDelete(pch);
+
+    pch = openChannel("x.VAL{delta:{}}");
+    for (i = 0, nFull = 0; i <= 100; i++) {
+        update(pch, 1, &full);
+        nFull += full;
+    }
+    testOk(nFull == 2 && full, "by default the 101st update is a key frame "
+           "(%d full frames)", nFull);
+    dbChannelDelete(pch);
+
+    pch = openChannel("x.VAL{delta:{key:0}}");
+    for (i = 0, nFull = 0; i <= 100; i++) {
+        update(pch, 1, &full);
+        nFull += full;
+    }
+    testOk(nFull == 1, "key 0 sends no key frames (%d full frames)", nFull);
+    dbChannelDelete(pch);
+
+    testOk(!dbChannelCreate("x.VAL{delta:{key:-1}}"),
+           "negative key interval is rejected");
+}
+
+static void testSubscriptions(void)
+{
+    epicsInt32 buf[10] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    dbChannel *pch;
+    size_t size, sub;
+    int full, nFull;
+
+    testDiag("Two subscriptions through the same channel");
+
+    pch = openChannel("x.VAL{delta:{}}");
+    testdbPutArrFieldOk("x.VAL", DBR_LONG, 10, buf);
+    updateSub(pch, 1, &full);
+    testOk(full && subCopyIs(1, buf, 10), "first subscription starts full");
+    updateSub(pch, 2, &full);
+    testOk(full && subCopyIs(2, buf, 10), "second subscription starts full");
+
+    /* only the first subscription sees this one */
+    buf[0] = 50;
+    testdbPutArrFieldOk("x.VAL", DBR_LONG, 10, buf);
+    updateSub(pch, 1, &full);
+    testOk(!full && subCopyIs(1, buf, 10), "first subscription updated");
+
+    buf[5] = 60;
+    testdbPutArrFieldOk("x.VAL", DBR_LONG, 10, buf);
+    size = updateSub(pch, 2, &full);
+    testOk(!full && size == EPICS_DELTA_HEADER_SIZE +
+           2 * (EPICS_DELTA_RUN_SIZE + sizeof(epicsInt32)) &&
+           subCopyIs(2, buf, 10),
+           "second subscription gets both changes, %u bytes", (unsigned) size);
+    size = updateSub(pch, 1, &full);
+    testOk(!full && size == EPICS_DELTA_HEADER_SIZE + EPICS_DELTA_RUN_SIZE +
+           sizeof(epicsInt32) && subCopyIs(1, buf, 10),
+           "first subscription gets one change, %u bytes", (unsigned) size);
+
+    for (sub = 3, nFull = 0; sub <= 10; sub++) {
+        updateSub(pch, sub, &full);
+        nFull += full;
+    }
+    testOk(nFull == 8, "eight more subscriptions start full (%d)", nFull);
+    buf[9] = 90;
+    testdbPutArrFieldOk("x.VAL", DBR_LONG, 10, buf);
+    updateSub(pch, 2, &full);
+    testOk(full && subCopyIs(2, buf, 10),
+           "least recently updated subscription lost its state");
+    updateSub(pch, 10, &full);
+    testOk(!full && subCopyIs(10, buf, 10),
+           "most recently updated subscription kept its state");
+    dbChannelDelete(pch);
+}
+
+static void testOther(void)
+{
+    dbChannel *pch;
+
+    testDiag("Strings and scalars are left alone");
+
+    pch = openChannel("z.VAL{delta:{}}");
+    testOk(ellCount(&pch->post_chain) == 0 && pch->final_type == DBF_STRING,
+           "delta does not register for a string array");
+    dbChannelDelete(pch);
+
+    pch = openChannel("x.OFF{delta:{}}");
+    testOk(ellCount(&pch->post_chain) == 0 && pch->final_type == DBF_ULONG,
+           "delta does not register for a scalar");
+    dbChannelDelete(pch);
+}
+
+MAIN(deltaTest)
+{
+    const chFilterPlugin *plug;
+    char myname[] = "delta";
+
+    testPlan(36);
+
+    testdbPrepare();
+
+    testdbReadDatabase("filterTest.dbd", NULL, NULL);
+
+    filterTest_registerRecordDeviceDriver(pdbbase);
+
+    testdbReadDatabase("deltaTest.db", NULL, NULL);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    plug = dbFindFilter(myname, strlen(myname));
+    if (!plug)
+        testAbort("Plugin '%s' not registered", myname);
+    testPass("plugin '%s' registered correctly", myname);
+
+    testDelta();
+    testSubscriptions();
+    testOther();
+
+    testIocShutdownOk();
+
+    testdbCleanup();
+
+    return testDone();
+}
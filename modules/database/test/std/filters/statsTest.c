@@ -0,0 +1,222 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <string.h>
+#include <math.h>
+
+#include "dbAccessDefs.h"
+#include "db_field_log.h"
+#include "dbChannel.h"
+#include "dbEvent.h"
+#include "dbLock.h"
+#include "chfPlugin.h"
+#include "errlog.h"
+#include "epicsMath.h"
+#include "epicsUnitTest.h"
+#include "dbUnitTest.h"
+#include "testMain.h"
+
+#include "arrRecord.h"
+
+void filterTest_registerRecordDeviceDriver(struct dbBase *);
+
+static int near(double a, double b)
+{
+    return fabs(a - b) <= 1e-6 * (fabs(b) > 1.0 ? fabs(b) : 1.0);
+}
+
+static dbChannel* openChannel(const char *name)
+{
+    dbChannel *pch = dbChannelCreate(name);
+
+    if (!pch || dbChannelOpen(pch))
+        testAbort("Can't open channel '%s'", name);
+    return pch;
+}
+
+static void setOffset(const char *rec, epicsInt32 off)
+{
+    char name[20];
+
+    strcpy(name, rec);
+    strcat(name, ".OFF");
+    testdbPutFieldOk(name, DBR_LONG, off);
+}
+
+/* the statistics of the current array as seen through the channel */
+static void checkStats(dbChannel *pch, const char *what, double min,
+    double max, double mean, double rms, double std)
+{
+    db_field_log *pfl;
+    const double *res;
+
+    dbScanLock(dbChannelRecord(pch));
+    pfl = db_create_read_log(pch);
+    pfl = dbChannelRunPreChain(pch, pfl);
+    dbScanUnlock(dbChannelRecord(pch));
+
+    if (!testOk(pfl && pfl->type == dbfl_type_ref &&
+            pfl->field_type == DBF_DOUBLE && pfl->no_elements == 5 &&
+            dbfl_has_copy(pfl), "%s: 5 doubles in a copy", what)) {
+        testSkip(1, "no result");
+    }
+    else {
+        res = (const double *) pfl->u.r.field;
+        testOk(near(res[0], min) && near(res[1], max) &&
+               near(res[2], mean) && near(res[3], rms) && near(res[4], std),
+               "%s: min %g max %g mean %g rms %g std %g", what,
+               res[0], res[1], res[2], res[3], res[4]);
+    }
+    if (pfl)
+        db_delete_field_log(pfl);
+}
+
+static void testLong(void)
+{
+    static const epicsInt32 ramp[10] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    static const epicsInt32 four[4] = {11, 12, 13, 14};
+    dbChannel *pch;
+    arrRecord *prec;
+
+    testDiag("Statistics of a LONG array");
+
+    pch = openChannel("x.VAL{stats:{}}");
+    testOk(ellCount(&pch->pre_chain) == 1 && ellCount(&pch->post_chain) == 0,
+           "stats is in the pre chain only");
+    testOk(pch->final_type == DBF_DOUBLE && pch->final_no_elements == 5,
+           "final type %d, %ld elements", pch->final_type,
+           pch->final_no_elements);
+
+    testdbPutArrFieldOk("x.VAL", DBR_LONG, 10, ramp);
+    checkStats(pch, "1..10", 1., 10., 5.5, sqrt(38.5), sqrt(8.25));
+    setOffset("x", 4);
+    checkStats(pch, "1..10 wrapped", 1., 10., 5.5, sqrt(38.5), sqrt(8.25));
+
+    /* the buffer now holds 11 12 13 14 5 6 7 8 9 10 */
+    setOffset("x", 0);
+    testdbPutArrFieldOk("x.VAL", DBR_LONG, 4, four);
+    checkStats(pch, "11..14", 11., 14., 12.5, sqrt(157.5), sqrt(1.25));
+    setOffset("x", 8);
+    checkStats(pch, "9..12 wrapped", 9., 12., 10.5, sqrt(111.5), sqrt(1.25));
+
+    prec = (arrRecord *) dbChannelRecord(pch);
+    dbScanLock((dbCommon *) prec);
+    prec->nord = 0;
+    dbScanUnlock((dbCommon *) prec);
+    {
+        db_field_log *pfl;
+        const double *res;
+
+        dbScanLock((dbCommon *) prec);
+        pfl = dbChannelRunPreChain(pch, db_create_read_log(pch));
+        dbScanUnlock((dbCommon *) prec);
+        res = (const double *) pfl->u.r.field;
+        testOk(pfl->no_elements == 5 && isnan(res[0]) && isnan(res[2]) &&
+               isnan(res[4]), "empty array gives NaNs");
+        db_delete_field_log(pfl);
+    }
+    setOffset("x", 0);
+    dbChannelDelete(pch);
+}
+
+static void testDouble(void)
+{
+    epicsFloat64 buf[10];
+    db_field_log *pfl;
+    dbChannel *pch;
+    int i;
+
+    testDiag("Statistics of a DOUBLE array with a large offset");
+
+    for (i = 0; i < 10; i++)
+        buf[i] = 1e9 + 0.1 * (i + 1);
+    testdbPutArrFieldOk("y.VAL", DBR_DOUBLE, 10, buf);
+
+    pch = openChannel("y.VAL{stats:{}}");
+    checkStats(pch, "1e9 + 0.1..1.0", 1e9 + 0.1, 1e9 + 1.0, 1e9 + 0.55,
+        sqrt((1e9 + 0.55) * (1e9 + 0.55) + 0.0825), sqrt(0.0825));
+    dbChannelDelete(pch);
+
+    pch = openChannel("y.VAL{stats:{q:\"std\"}}");
+    testOk(pch->final_type == DBF_DOUBLE && pch->final_no_elements == 1,
+           "q:\"std\" gives a scalar double");
+    dbScanLock(dbChannelRecord(pch));
+    pfl = dbChannelRunPreChain(pch, db_create_read_log(pch));
+    dbScanUnlock(dbChannelRecord(pch));
+    testOk(pfl->type == dbfl_type_val && pfl->no_elements == 1 &&
+           fabs(pfl->u.v.field.dbf_double - sqrt(0.0825)) < 1e-6,
+           "standard deviation %g", pfl->u.v.field.dbf_double);
+    db_delete_field_log(pfl);
+    dbChannelDelete(pch);
+
+    testOk(!dbChannelCreate("y.VAL{stats:{q:\"median\"}}"),
+           "unknown quantity is rejected");
+}
+
+static void testString(void)
+{
+    dbChannel *pch;
+
+    testDiag("Strings are left alone");
+
+    pch = openChannel("z.VAL{stats:{}}");
+    testOk(ellCount(&pch->pre_chain) == 0 && pch->final_type == DBF_STRING,
+           "stats does not register for a string array");
+    dbChannelDelete(pch);
+}
+
+static void testMenu(void)
+{
+    dbChannel *pch;
+
+    testDiag("Menu and device fields are read as enums");
+
+    testdbPutFieldOk("x.PRIO", DBR_LONG, 2);
+    pch = openChannel("x.PRIO{stats:{}}");
+    checkStats(pch, "PRIO", 2.0, 2.0, 2.0, 2.0, 0.0);
+    dbChannelDelete(pch);
+
+    pch = openChannel("x.DTYP{stats:{}}");
+    testOk(ellCount(&pch->pre_chain) == 1 && pch->final_type == DBF_DOUBLE,
+           "stats registers for DTYP");
+    dbChannelDelete(pch);
+}
+
+MAIN(statsTest)
+{
+    const chFilterPlugin *plug;
+    char myname[] = "stats";
+
+    testPlan(29);
+
+    testdbPrepare();
+
+    testdbReadDatabase("filterTest.dbd", NULL, NULL);
+
+    filterTest_registerRecordDeviceDriver(pdbbase);
+
+    testdbReadDatabase("statsTest.db", NULL, NULL);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    plug = dbFindFilter(myname, strlen(myname));
+    if (!plug)
+        testAbort("Plugin '%s' not registered", myname);
+    testPass("plugin '%s' registered correctly", myname);
+
+    testLong();
+    testDouble();
+    testString();
+    testMenu();
+
+    testIocShutdownOk();
+
+    testdbCleanup();
+
+    return testDone();
+}
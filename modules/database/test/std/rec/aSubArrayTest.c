@@ -0,0 +1,222 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <stdlib.h>
+
+#include "dbUnitTest.h"
+#include "testMain.h"
+#include "dbAccess.h"
+#include "dbLock.h"
+#include "errlog.h"
+#include "alarm.h"
+#include "epicsMath.h"
+#include "epicsStdio.h"
+
+#define N 1000
+
+void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+static double a[N], b[N], expect[N], result[N];
+
+static void process(const char *name)
+{
+    char pv[40];
+
+    epicsSnprintf(pv, sizeof(pv), "%s.PROC", name);
+    testdbPutFieldOk(pv, DBF_LONG, 1);
+}
+
+/* VALA of an aSub record as doubles */
+static long getResult(const char *name)
+{
+    char pv[40];
+    DBADDR addr;
+    long nReq = N;
+
+    epicsSnprintf(pv, sizeof(pv), "%s.VALA", name);
+    if (dbNameToAddr(pv, &addr))
+        testAbort("Unknown PV '%s'", pv);
+    dbScanLock(addr.precord);
+    if (dbGet(&addr, DBR_DOUBLE, result, NULL, &nReq, NULL))
+        testAbort("Failed to get '%s'", pv);
+    dbScanUnlock(addr.precord);
+    return nReq;
+}
+
+/* the partial sums may round differently than the reference */
+static void checkResult(const char *name, long n, double tolerance)
+{
+    long nGot = getResult(name);
+    long i, bad = 0;
+
+    for (i = 0; i < n && i < nGot; i++) {
+        if (!(fabs(result[i] - expect[i]) <= tolerance)) {
+            if (bad++ < 5)
+                testDiag("%s[%ld] %g != %g", name, i, result[i], expect[i]);
+        }
+    }
+    testOk(nGot == n && bad == 0, "%s: %ld elements, %ld wrong", name, nGot,
+           bad);
+}
+
+static void testElementwise(void)
+{
+    long i, k;
+    double sum;
+
+    testDiag("Element-wise routines");
+
+    process("scale");
+    for (i = 0; i < 5; i++)
+        expect[i] = (i + 1) * 2.5 - 1.0;
+    checkResult("scale", 5, 0.0);
+
+    /* B is shorter, so is the result */
+    testdbPutArrFieldOk("wfA", DBF_DOUBLE, N, a);
+    testdbPutArrFieldOk("wfB", DBF_DOUBLE, N - 3, b);
+
+    process("add");
+    for (i = 0; i < N - 3; i++)
+        expect[i] = a[i] + b[i];
+    checkResult("add", N - 3, 0.0);
+
+    process("mul");
+    for (i = 0; i < N - 3; i++)
+        expect[i] = a[i] * b[i];
+    checkResult("mul", N - 3, 0.0);
+
+    process("dot");
+    for (i = 0, sum = 0.0; i < N - 3; i++)
+        sum += a[i] * b[i];
+    expect[0] = sum;
+    checkResult("dot", 1, 1e-9 * fabs(sum));
+
+    process("fir");
+    for (i = 0; i < N; i++) {
+        static const double taps[] = {0.5, 0.25, -1.0};
+
+        expect[i] = 0.0;
+        for (k = 0; k < 3 && k <= i; k++)
+            expect[i] += taps[k] * a[i - k];
+    }
+    checkResult("fir", N, 1e-12);
+
+    process("decimate");
+    for (i = 0; i < N / 3; i++)
+        expect[i] = (a[3 * i] + a[3 * i + 1] + a[3 * i + 2]) / 3;
+    checkResult("decimate", N / 3, 1e-12);
+
+    process("cumsum");
+    for (i = 0, sum = 0.0; i < N; i++)
+        expect[i] = sum += a[i];
+    checkResult("cumsum", N, 0.0);
+}
+
+static void testConvert(void)
+{
+    static const float s2f[] = {-3, 0, 7, 32767};
+    static const epicsInt32 d2l[] = {-3, 0, 7, 1000000};
+    long i;
+
+    testDiag("Type conversion");
+
+    process("s2f");
+    testdbGetArrFieldEqual("s2f.VALA", DBF_FLOAT, 4, 4, s2f);
+    process("d2l");
+    testdbGetArrFieldEqual("d2l.VALA", DBF_LONG, 4, 4, d2l);
+
+    /* more than one block of the buffer between two integer types */
+    for (i = 0; i < 600; i++)
+        a[i] = (double) (i % 256);
+    testdbPutArrFieldOk("wfA", DBF_DOUBLE, 600, a);
+    process("u2d");
+    for (i = 0; i < 600; i++)
+        expect[i] = a[i];
+    checkResult("u2d", 600, 0.0);
+    process("u2s");
+    checkResult("u2s", 600, 0.0);
+}
+
+static void testConvertRange(void)
+{
+    /* 2^53 + 1 can not be held by a double */
+    static const epicsInt64 i64[] = {
+        9007199254740993LL, -1, -9223372036854775807LL - 1, 4294967297LL
+    };
+    static const epicsUInt64 i2u[] = {
+        9007199254740993ULL, 18446744073709551615ULL,
+        9223372036854775808ULL, 4294967297ULL
+    };
+    static const epicsInt32 i2l[] = {1, -1, 0, 1};
+    static const epicsUInt8 d2c[] = {0, 255, 0, 0, 255};
+    static const epicsInt16 d2s[] = {-3, 300, -32768, 0, 32767};
+    static const epicsInt64 d2q[] = {
+        -3, 300, -9223372036854775807LL - 1, 0, 9223372036854775807LL
+    };
+    double d[5];
+
+    testDiag("Conversion of large and out of range values");
+
+    testdbPutArrFieldOk("wf64", DBF_INT64, 4, i64);
+    process("i2u");
+    testdbGetArrFieldEqual("i2u.VALA", DBF_UINT64, 4, 4, i2u);
+    process("i2l");
+    testdbGetArrFieldEqual("i2l.VALA", DBF_LONG, 4, 4, i2l);
+
+    /* doubles saturate, a NaN gives 0 */
+    d[0] = -3.5;
+    d[1] = 300.0;
+    d[2] = -1e30;
+    d[3] = epicsNAN;
+    d[4] = 1e30;
+    testdbPutArrFieldOk("wfA", DBF_DOUBLE, 5, d);
+    process("d2c");
+    testdbGetArrFieldEqual("d2c.VALA", DBF_UCHAR, 5, 5, d2c);
+    process("d2s");
+    testdbGetArrFieldEqual("d2s.VALA", DBF_SHORT, 5, 5, d2s);
+    process("d2q");
+    testdbGetArrFieldEqual("d2q.VALA", DBF_INT64, 5, 5, d2q);
+}
+
+static void testErrors(void)
+{
+    testDiag("Inputs of the wrong type");
+
+    process("badtype");
+    testdbGetFieldEqual("badtype.SEVR", DBF_LONG, INVALID_ALARM);
+    testdbGetFieldEqual("badtype.VAL", DBF_LONG, -1);
+}
+
+MAIN(aSubArrayTest)
+{
+    long i;
+
+    testPlan(40);
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("aSubArrayTest.db", NULL, NULL);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    srand(1);
+    for (i = 0; i < N; i++) {
+        a[i] = -1.0 + 2.0 * rand() / RAND_MAX;
+        b[i] = i * 0.125 - 7.0;
+    }
+
+    testElementwise();
+    testConvert();
+    testConvertRange();
+    testErrors();
+
+    testIocShutdownOk();
+    testdbCleanup();
+    return testDone();
+}
@@ -0,0 +1,174 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <stdlib.h>
+
+#include "dbUnitTest.h"
+#include "testMain.h"
+#include "dbAccess.h"
+#include "dbLock.h"
+#include "errlog.h"
+#include "alarm.h"
+#include "epicsMath.h"
+#include "epicsStdio.h"
+
+#define N 1000
+
+void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+static double a[N], b[N], expect[N], result[N];
+
+static void process(const char *name)
+{
+    char pv[40];
+
+    epicsSnprintf(pv, sizeof(pv), "%s.PROC", name);
+    testdbPutFieldOk(pv, DBF_LONG, 1);
+}
+
+/* VAL of an acalc record */
+static long getResult(const char *name)
+{
+    DBADDR addr;
+    long nReq = N;
+
+    if (dbNameToAddr(name, &addr))
+        testAbort("Unknown PV '%s'", name);
+    dbScanLock(addr.precord);
+    if (dbGet(&addr, DBR_DOUBLE, result, NULL, &nReq, NULL))
+        testAbort("Failed to get '%s'", name);
+    dbScanUnlock(addr.precord);
+    return nReq;
+}
+
+static void checkResult(const char *name, long n, double tolerance)
+{
+    long nGot = getResult(name);
+    long i, bad = 0;
+
+    for (i = 0; i < n && i < nGot; i++) {
+        if (!(fabs(result[i] - expect[i]) <= tolerance)) {
+            if (bad++ < 5)
+                testDiag("%s[%ld] %g != %g", name, i, result[i], expect[i]);
+        }
+    }
+    testOk(nGot == n && bad == 0, "%s: %ld elements, %ld wrong", name, nGot,
+           bad);
+}
+
+static void testElements(void)
+{
+    double amax = a[0], amin = a[0], sum = 0.0;
+    long i;
+
+    testDiag("Element by element");
+
+    /* B is shorter, so is the result; C is a single value */
+    testdbPutArrFieldOk("wfA", DBF_DOUBLE, N, a);
+    testdbPutArrFieldOk("wfB", DBF_DOUBLE, N - 3, b);
+    process("lin");
+    for (i = 0; i < N - 3; i++)
+        expect[i] = a[i] * 3 + b[i];
+    checkResult("lin", N - 3, 0.0);
+    testdbGetFieldEqual("lin.NORD", DBF_LONG, N - 3);
+    testdbGetFieldEqual("lin.NEC", DBF_LONG, 1);
+    testdbGetFieldEqual("lin.SEVR", DBF_LONG, NO_ALARM);
+
+    testDiag("Reductions");
+
+    for (i = 0; i < N; i++) {
+        if (a[i] > amax) amax = a[i];
+        if (a[i] < amin) amin = a[i];
+        sum += a[i];
+    }
+    process("norm");
+    for (i = 0; i < N; i++)
+        expect[i] = (a[i] - amin) / (amax - amin);
+    checkResult("norm", N, 1e-15);
+
+    testdbPutFieldOk("lin.CALC", DBF_STRING, "A-AVG(A)");
+    process("lin");
+    for (i = 0; i < N; i++)
+        expect[i] = a[i] - sum / N;
+    checkResult("lin", N, 1e-12);
+    testdbGetFieldEqual("lin.NORD", DBF_LONG, N);
+
+    process("const");
+    for (i = 0; i < 5; i++)
+        expect[i] = (i + 1) * 10 + 15;
+    checkResult("const", 5, 0.0);
+}
+
+static void testInputs(void)
+{
+    static const double in[] = {1, 2, 3, 4};
+    long i;
+
+    testDiag("Inputs written directly");
+
+    /* writing an input processes the record */
+    testdbPutArrFieldOk("direct.A", DBF_DOUBLE, 4, in);
+    testdbGetFieldEqual("direct.NEA", DBF_LONG, 4);
+    for (i = 0; i < 4; i++)
+        expect[i] = in[i];
+    checkResult("direct", 4, 0.0);
+    process("direct");
+    for (i = 0; i < 4; i++)
+        expect[i] = 2 * in[i];
+    checkResult("direct", 4, 0.0);
+}
+
+static void testErrors(void)
+{
+    testDiag("Bad expressions");
+
+    process("bad");
+    testdbGetFieldEqual("bad.SEVR", DBF_LONG, NO_ALARM);
+
+    eltc(0);
+    testdbPutFieldFail(S_db_badField, "bad.CALC", DBF_STRING, "A*");
+    eltc(1);
+    process("bad");
+    testdbGetFieldEqual("bad.SEVR", DBF_LONG, INVALID_ALARM);
+    testdbGetFieldEqual("bad.STAT", DBF_LONG, CALC_ALARM);
+
+    testdbPutFieldOk("bad.CALC", DBF_STRING, "A*2");
+    process("bad");
+    testdbGetFieldEqual("bad.SEVR", DBF_LONG, NO_ALARM);
+    expect[0] = 2;
+    expect[1] = 4;
+    checkResult("bad", 2, 0.0);
+}
+
+MAIN(acalcTest)
+{
+    long i;
+
+    testPlan(30);
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("acalcTest.db", NULL, NULL);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    srand(1);
+    for (i = 0; i < N; i++) {
+        a[i] = -1.0 + 2.0 * rand() / RAND_MAX;
+        b[i] = i * 0.125 - 7.0;
+    }
+
+    testElements();
+    testInputs();
+    testErrors();
+
+    testIocShutdownOk();
+    testdbCleanup();
+    return testDone();
+}
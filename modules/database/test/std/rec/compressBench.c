@@ -0,0 +1,107 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Measures how many input samples per second a compress record reduces
+ * with each of its algorithms, reading a large waveform as a beam
+ * position record would.
+ *
+ *   compressBench [samples [N [iterations]]]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "cantProceed.h"
+#include "dbUnitTest.h"
+#include "dbAccess.h"
+#include "dbLock.h"
+#include "errlog.h"
+#include "epicsStdio.h"
+#include "epicsTime.h"
+
+void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+static void bench(const char *alg, long nelm, long n, int iterations)
+{
+    char macros[120];
+    double *values;
+    DBADDR wfaddr, caddr;
+    epicsTimeStamp start, end;
+    double elapsed;
+    long i;
+    int iter;
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+    epicsSnprintf(macros, sizeof(macros), "ALG=%s,NELM=%ld,NSAM=%ld,N=%ld",
+        alg, nelm, nelm / n > 0 ? nelm / n : 1, n);
+    testdbReadDatabase("compressBench.db", NULL, macros);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    if (dbNameToAddr("wf", &wfaddr) || dbNameToAddr("comp", &caddr))
+        testAbort("records not found");
+
+    /* a noisy ramp, so that the median has some work to do */
+    values = callocMustSucceed(nelm, sizeof(double), "compressBench");
+    srand(1);
+    for (i = 0; i < nelm; i++)
+        values[i] = i * 1e-3 + (double)rand() / RAND_MAX;
+    dbScanLock(wfaddr.precord);
+    dbPut(&wfaddr, DBR_DOUBLE, values, nelm);
+    dbScanUnlock(wfaddr.precord);
+
+    /* the record copies the waveform into its work buffer each time */
+    epicsTimeGetCurrent(&start);
+    for (iter = 0; iter < iterations; iter++) {
+        dbScanLock(caddr.precord);
+        dbProcess(caddr.precord);
+        dbScanUnlock(caddr.precord);
+    }
+    epicsTimeGetCurrent(&end);
+    elapsed = epicsTimeDiffInSeconds(&end, &start);
+
+    testDiag("%-20s %8.1f Msamples/s  (%.3f ms per waveform)", alg,
+        nelm * (double)iterations / elapsed / 1e6,
+        elapsed / iterations * 1e3);
+
+    free(values);
+    testIocShutdownOk();
+    testdbCleanup();
+}
+
+int main(int argc, char *argv[])
+{
+    static const char *algs[] = {
+        "N to 1 Low Value", "N to 1 High Value", "N to 1 Average",
+        "N to 1 Median", "Average", "Circular Buffer"
+    };
+    long nelm = 1000000;
+    long n = 100;
+    int iterations = 50;
+    unsigned i;
+
+    if (argc > 1)
+        nelm = atol(argv[1]);
+    if (argc > 2)
+        n = atol(argv[2]);
+    if (argc > 3)
+        iterations = atoi(argv[3]);
+    if (nelm < 2 || n < 1 || iterations < 1) {
+        fprintf(stderr, "usage: %s [samples [N [iterations]]]\n", argv[0]);
+        return 1;
+    }
+
+    testPlan(0);
+    testDiag("%ld samples, N=%ld, %d iterations", nelm, n, iterations);
+    for (i = 0; i < NELEMENTS(algs); i++)
+        bench(algs[i], nelm, n, iterations);
+    return testDone();
+}
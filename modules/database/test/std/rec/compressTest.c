@@ -14,6 +14,7 @@
 #include "errlog.h"
 #include "dbAccess.h"
 #include "epicsMath.h"
+#include "epicsStdio.h"
 #include "menuYesNo.h"
 
 #include "aiRecord.h"
@@ -694,9 +695,55 @@ testAIAveragePartial(void) {
     testdbCleanup();
 }
 
+static
+void testNto1Bins(void)
+{
+    /* two bins of 7, longer than the reduction kernels' lanes */
+    static const char *algs[] = {
+        "N to 1 Low Value", "N to 1 High Value",
+        "N to 1 Average", "N to 1 Median"
+    };
+    static const double expect[][2] = {
+        {1., -4.}, {9., 10.}, {33. / 7., 20.5 / 7.}, {5., 2.5}
+    };
+    char macros[80];
+    DBADDR wfaddr, caddr;
+    unsigned i;
+
+    for (i = 0; i < NELEMENTS(algs); i++) {
+        testDiag("Test '%s', NSAM=2, N=7", algs[i]);
+
+        testdbPrepare();
+        testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+        recTestIoc_registerRecordDeviceDriver(pdbbase);
+        epicsSnprintf(macros, sizeof(macros),
+            "INP=wf14,ALG=%s,BALG=FIFO Buffer,NSAM=2,N=7", algs[i]);
+        testdbReadDatabase("compressTest.db", NULL, macros);
+
+        eltc(0);
+        testIocInitOk();
+        eltc(1);
+
+        fetchRecordOrDie("wf14", wfaddr);
+        fetchRecordOrDie("comp", caddr);
+
+        writeToWaveform(&wfaddr, 14,
+            5., 3., 9., 1., 7., 2., 6.,
+            -4., 10., 0., 2.5, 10., -1., 3.);
+
+        dbScanLock(caddr.precord);
+        dbProcess(caddr.precord);
+        checkArrD("comp", 2, expect[i][0], expect[i][1], 0., 0.);
+        dbScanUnlock(caddr.precord);
+
+        testIocShutdownOk();
+        testdbCleanup();
+    }
+}
+
 MAIN(compressTest)
 {
-    testPlan(134);
+    testPlan(138);
     testFIFOCirc();
     testLIFOCirc();
     testArrayAverage();
@@ -706,5 +753,6 @@ MAIN(compressTest)
     testNtoMPartial();
     testAIAveragePartial();
     testNto1LowValue();
+    testNto1Bins();
     return testDone();
 }
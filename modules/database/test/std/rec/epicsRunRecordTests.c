@@ -15,6 +15,10 @@
 
 int analogMonitorTest(void);
 int compressTest(void);
+int histogramTest(void);
+int sharedArrayTest(void);
+int aSubArrayTest(void);
+int acalcTest(void);
 int recMiscTest(void);
 int arrayOpTest(void);
 int asTest(void);
@@ -37,6 +41,14 @@ void epicsRunRecordTests(void)
 
     runTest(compressTest);
 
+    runTest(histogramTest);
+
+    runTest(sharedArrayTest);
+
+    runTest(aSubArrayTest);
+
+    runTest(acalcTest);
+
     runTest(recMiscTest);
 
     runTest(arrayOpTest);
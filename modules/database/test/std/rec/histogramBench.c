@@ -0,0 +1,150 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Measures how many samples per second a histogram record bins, when it
+ * is processed once per sample and when it reads a waveform of samples
+ * each time it is processed.
+ *
+ *   histogramBench [samples [bins [iterations]]]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "cantProceed.h"
+#include "dbUnitTest.h"
+#include "dbAccess.h"
+#include "dbLock.h"
+#include "errlog.h"
+#include "epicsStdio.h"
+#include "epicsTime.h"
+
+void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+static double perSample(const double *values, long nsam, int iterations)
+{
+    DBADDR aoaddr, haddr;
+    epicsTimeStamp start, end;
+    long i;
+    int iter;
+
+    if (dbNameToAddr("src", &aoaddr) || dbNameToAddr("hs", &haddr))
+        testAbort("records not found");
+
+    epicsTimeGetCurrent(&start);
+    for (iter = 0; iter < iterations; iter++) {
+        for (i = 0; i < nsam; i++) {
+            dbScanLock(haddr.precord);
+            dbPut(&aoaddr, DBR_DOUBLE, &values[i], 1);
+            dbProcess(haddr.precord);
+            dbScanUnlock(haddr.precord);
+        }
+    }
+    epicsTimeGetCurrent(&end);
+    return nsam * (double)iterations / epicsTimeDiffInSeconds(&end, &start);
+}
+
+static double bulk(const double *values, long nsam, int iterations)
+{
+    DBADDR wfaddr, haddr;
+    epicsTimeStamp start, end;
+    int iter;
+
+    if (dbNameToAddr("wf", &wfaddr) || dbNameToAddr("hb", &haddr))
+        testAbort("records not found");
+
+    dbScanLock(wfaddr.precord);
+    dbPut(&wfaddr, DBR_DOUBLE, values, nsam);
+    dbScanUnlock(wfaddr.precord);
+
+    epicsTimeGetCurrent(&start);
+    for (iter = 0; iter < iterations; iter++) {
+        dbScanLock(haddr.precord);
+        dbProcess(haddr.precord);
+        dbScanUnlock(haddr.precord);
+    }
+    epicsTimeGetCurrent(&end);
+    return nsam * (double)iterations / epicsTimeDiffInSeconds(&end, &start);
+}
+
+static void setEdges(long nbins)
+{
+    double *edge = callocMustSucceed(nbins + 1, sizeof(double),
+        "histogramBench");
+    DBADDR addr;
+    long i;
+
+    /* bins that get narrower towards the upper limit */
+    for (i = 0; i <= nbins; i++)
+        edge[i] = 1.0 - (double)(nbins - i) * (nbins - i) / nbins / nbins;
+    if (dbNameToAddr("hb.EDGE", &addr))
+        testAbort("records not found");
+    dbScanLock(addr.precord);
+    if (dbPut(&addr, DBR_DOUBLE, edge, nbins + 1))
+        testAbort("bin edges rejected");
+    dbScanUnlock(addr.precord);
+    free(edge);
+}
+
+int main(int argc, char *argv[])
+{
+    char macros[80];
+    double *values;
+    long nsam = 100000;
+    long nbins = 100;
+    int iterations = 20;
+    double rate1, rateN;
+    long i;
+
+    if (argc > 1)
+        nsam = atol(argv[1]);
+    if (argc > 2)
+        nbins = atol(argv[2]);
+    if (argc > 3)
+        iterations = atoi(argv[3]);
+    if (nsam < 1 || nbins < 1 || nbins > 65534 || iterations < 1) {
+        fprintf(stderr, "usage: %s [samples [bins [iterations]]]\n",
+            argv[0]);
+        return 1;
+    }
+
+    testPlan(0);
+    testDiag("%ld samples, %ld bins, %d iterations", nsam, nbins,
+        iterations);
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+    epicsSnprintf(macros, sizeof(macros), "NSAM=%ld,NBINS=%ld", nsam, nbins);
+    testdbReadDatabase("histogramBench.db", NULL, macros);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    /* a few percent of the samples are out of range */
+    values = callocMustSucceed(nsam, sizeof(double), "histogramBench");
+    srand(1);
+    for (i = 0; i < nsam; i++)
+        values[i] = -0.02 + 1.04 * rand() / RAND_MAX;
+
+    rate1 = perSample(values, nsam, iterations);
+    testDiag("%-24s %8.2f Msamples/s", "one sample per process",
+        rate1 / 1e6);
+    rateN = bulk(values, nsam, iterations);
+    testDiag("%-24s %8.2f Msamples/s  (x%.0f)", "array, equal bins",
+        rateN / 1e6, rateN / rate1);
+    setEdges(nbins);
+    rateN = bulk(values, nsam, iterations);
+    testDiag("%-24s %8.2f Msamples/s  (x%.0f)", "array, bin edges",
+        rateN / 1e6, rateN / rate1);
+
+    free(values);
+    testIocShutdownOk();
+    testdbCleanup();
+    return testDone();
+}
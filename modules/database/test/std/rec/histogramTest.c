@@ -0,0 +1,217 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <stdlib.h>
+
+#include "dbUnitTest.h"
+#include "testMain.h"
+#include "dbAccess.h"
+#include "dbLock.h"
+#include "errlog.h"
+#include "epicsMath.h"
+
+#include "histogramRecord.h"
+
+#define NBINS 10
+#define NSAMPLES 1000
+
+void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+/* the linear search that the record used to do for each value */
+static void refAdd(epicsUInt32 *bins, double x, double llim, double ulim)
+{
+    double wdth = (ulim - llim) / NBINS;
+    int i;
+
+    if (x < llim || x >= ulim)
+        return;
+    for (i = 1; i <= NBINS; i++)
+        if (x - llim <= (double) i * wdth)
+            break;
+    bins[i - 1]++;
+}
+
+static void refAddEdges(epicsUInt32 *bins, double x, const double *edge)
+{
+    int i;
+
+    if (!(x >= edge[0] && x < edge[NBINS]))
+        return;
+    for (i = 0; i < NBINS - 1; i++)
+        if (x <= edge[i + 1])
+            break;
+    bins[i]++;
+}
+
+static void checkBins(const char *pv, const epicsUInt32 *expect)
+{
+    epicsUInt32 bins[NBINS];
+    long nReq = NBINS;
+    int i, match = 1;
+    DBADDR addr;
+
+    if (dbNameToAddr(pv, &addr))
+        testAbort("Unknown PV '%s'", pv);
+    dbScanLock(addr.precord);
+    if (dbGet(&addr, DBR_ULONG, bins, NULL, &nReq, NULL))
+        testAbort("Failed to get '%s'", pv);
+    dbScanUnlock(addr.precord);
+
+    for (i = 0; i < NBINS; i++) {
+        if (bins[i] != expect[i]) {
+            testDiag("%s[%d] %u != %u", pv, i, bins[i], expect[i]);
+            match = 0;
+        }
+    }
+    testOk(match && nReq == NBINS, "%s counts match", pv);
+}
+
+static void putSamples(const double *values, long n)
+{
+    testdbPutArrFieldOk("wf", DBF_DOUBLE, n, values);
+}
+
+/* values on and next to the bin boundaries, and out of range */
+static const double boundaries[] = {
+    0.0, 1.0, 1.0000001, 0.9999999, 2.0, 3.0, 4.5, 5.0, 6.0, 7.0, 8.0,
+    9.0, 9.9999999, 10.0, 10.5, -0.0000001, -3.0, 0.1, 0.3, 0.7
+};
+
+static void testScalar(void)
+{
+    epicsUInt32 expect[NBINS] = {0};
+    size_t i;
+
+    testDiag("One value per process");
+
+    for (i = 0; i < NELEMENTS(boundaries); i++) {
+        testdbPutFieldOk("hs.SGNL", DBF_DOUBLE, boundaries[i]);
+        refAdd(expect, boundaries[i], 0.0, 10.0);
+    }
+    checkBins("hs", expect);
+}
+
+static void testBulk(double *values)
+{
+    epicsUInt32 expect[NBINS] = {0};
+    long i;
+
+    testDiag("Array of values per process");
+
+    for (i = 0; i < NSAMPLES; i++) {
+        if (i < (long) NELEMENTS(boundaries))
+            values[i] = boundaries[i];
+        else
+            values[i] = -1.0 + 12.0 * rand() / RAND_MAX;
+        refAdd(expect, values[i], 0.0, 10.0);
+    }
+    values[NSAMPLES - 1] = epicsNAN;
+    putSamples(values, NSAMPLES);
+    testdbPutFieldOk("hb.PROC", DBF_LONG, 1);
+    testdbGetFieldEqual("hb.NUSE", DBF_ULONG, NSAMPLES);
+    checkBins("hb", expect);
+
+    /* a shorter array adds only its own values */
+    putSamples(values, 300);
+    for (i = 0; i < 300; i++)
+        refAdd(expect, values[i], 0.0, 10.0);
+    testdbPutFieldOk("hb.PROC", DBF_LONG, 1);
+    testdbGetFieldEqual("hb.NUSE", DBF_ULONG, 300);
+    checkBins("hb", expect);
+
+    /* the same values one at a time give the same histogram */
+    testdbPutFieldOk("hs.CMD", DBF_USHORT, 1);
+    for (i = 0; i < 50; i++)
+        testdbPutFieldOk("hs.SGNL", DBF_DOUBLE, values[i]);
+    for (i = 0; i < NBINS; i++)
+        expect[i] = 0;
+    for (i = 0; i < 50; i++)
+        refAdd(expect, values[i], 0.0, 10.0);
+    checkBins("hs", expect);
+}
+
+static void testEdges(double *values)
+{
+    static const double edge[NBINS + 1] = {
+        -1.0, 0.0, 0.5, 1.0, 2.0, 4.0, 4.5, 5.0, 7.0, 9.0, 10.5
+    };
+    static const double bad[NBINS + 1] = {
+        -1.0, 0.0, 0.5, 1.0, 2.0, 4.0, 4.0, 5.0, 7.0, 9.0, 10.5
+    };
+    epicsUInt32 expect[NBINS] = {0};
+    DBADDR addr;
+    long i, status;
+
+    testDiag("Bin edges");
+
+    testdbPutArrFieldOk("hb.EDGE", DBF_DOUBLE, NBINS + 1, edge);
+    testdbGetFieldEqual("hb.NEDG", DBF_ULONG, NBINS + 1);
+    checkBins("hb", expect);
+
+    for (i = 0; i < NSAMPLES; i++)
+        refAddEdges(expect, values[i], edge);
+    for (i = 0; i < NBINS + 1; i++)
+        refAddEdges(expect, edge[i], edge);
+    putSamples(values, NSAMPLES);
+    testdbPutFieldOk("hb.PROC", DBF_LONG, 1);
+    putSamples(edge, NBINS + 1);
+    testdbPutFieldOk("hb.PROC", DBF_LONG, 1);
+    checkBins("hb", expect);
+
+    testDiag("Edges that are not increasing are rejected");
+    if (dbNameToAddr("hb.EDGE", &addr))
+        testAbort("Unknown PV 'hb.EDGE'");
+    eltc(0);
+    dbScanLock(addr.precord);
+    status = dbPut(&addr, DBR_DOUBLE, bad, NBINS + 1);
+    dbScanUnlock(addr.precord);
+    testOk(status != 0, "dbPut(hb.EDGE) of decreasing edges fails");
+    dbScanLock(addr.precord);
+    status = dbPut(&addr, DBR_DOUBLE, edge, NBINS);
+    dbScanUnlock(addr.precord);
+    testOk(status != 0, "dbPut(hb.EDGE) of NELM edges fails");
+    eltc(1);
+    testdbGetFieldEqual("hb.NEDG", DBF_ULONG, 0);
+
+    /* back to bins of equal width */
+    for (i = 0; i < NBINS; i++)
+        expect[i] = 0;
+    for (i = 0; i < NSAMPLES; i++)
+        refAdd(expect, values[i], 0.0, 10.0);
+    putSamples(values, NSAMPLES);
+    testdbPutFieldOk("hb.PROC", DBF_LONG, 1);
+    checkBins("hb", expect);
+}
+
+MAIN(histogramTest)
+{
+    double *values;
+
+    testPlan(95);
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("histogramTest.db", NULL, NULL);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    values = calloc(NSAMPLES, sizeof(double));
+    if (!values)
+        testAbort("Out of memory");
+    srand(1);
+
+    testScalar();
+    testBulk(values);
+    testEdges(values);
+
+    free(values);
+    testIocShutdownOk();
+    testdbCleanup();
+    return testDone();
+}
@@ -0,0 +1,132 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <string.h>
+
+#include "dbUnitTest.h"
+#include "testMain.h"
+#include "dbAccess.h"
+#include "errlog.h"
+#include "alarm.h"
+#include "epicsSharedArray.h"
+#include "epicsStdio.h"
+#include "epicsTime.h"
+
+void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+static char prefix[40];
+
+static epicsSharedArrayId openShared(const char *suffix)
+{
+    char name[80];
+
+    epicsSnprintf(name, sizeof(name), "%s%s", prefix, suffix);
+    return epicsSharedArrayOpen(name);
+}
+
+static void testWaveform(void)
+{
+    static const double values[] = {1.5, -2.0, 3.25, 1e10};
+    double buf[10];
+    epicsSharedArrayInfo info;
+    epicsSharedArrayId id;
+
+    testDiag("waveform with SHM");
+
+    id = openShared("wf");
+    testOk(id != NULL, "shared array of wf exists");
+    if (!id) {
+        testSkip(10, "no shared array");
+        return;
+    }
+    testOk1(epicsSharedArrayRead(id, buf, 10, &info) == 0);
+    testOk(info.type == DBF_DOUBLE && info.elementSize == sizeof(double) &&
+           info.capacity == 10, "type %u, size %u, capacity %u", info.type,
+           (unsigned) info.elementSize, (unsigned) info.capacity);
+
+    /* a put updates the shared array */
+    testdbPutArrFieldOk("wf", DBF_DOUBLE, 4, values);
+    memset(buf, 0, sizeof(buf));
+    testOk1(epicsSharedArrayRead(id, buf, 10, &info) == 4);
+    testOk1(!memcmp(buf, values, sizeof(values)));
+
+    /* processing publishes the time stamp and alarm too */
+    testdbPutFieldOk("wf.PROC", DBF_LONG, 1);
+    testOk1(epicsSharedArrayRead(id, buf, 10, &info) == 4);
+    testOk1(info.stamp.secPastEpoch != 0);
+    testOk1(info.severity == NO_ALARM);
+
+    /* the record itself is unchanged */
+    testdbGetArrFieldEqual("wf", DBF_DOUBLE, 10, 4, values);
+    testdbGetFieldEqual("wf.NORD", DBF_LONG, 4);
+
+    epicsSharedArrayClose(id);
+}
+
+static void testAai(void)
+{
+    static const epicsInt32 expect[] = {1, 2, 3, 4, 5};
+    epicsInt32 buf[5];
+    epicsSharedArrayInfo info;
+    epicsSharedArrayId id;
+
+    testDiag("aai with SHM");
+
+    id = openShared("aai");
+    testOk(id != NULL, "shared array of aai exists");
+    if (!id) {
+        testSkip(3, "no shared array");
+        return;
+    }
+    testdbPutFieldOk("aai.PROC", DBF_LONG, 1);
+    testOk1(epicsSharedArrayRead(id, buf, 5, &info) == 5);
+    testOk1(info.type == DBF_LONG && !memcmp(buf, expect, sizeof(expect)));
+    epicsSharedArrayClose(id);
+}
+
+MAIN(sharedArrayTest)
+{
+    static const epicsInt16 values[] = {1, 2, 3};
+    char macros[60];
+    epicsTimeStamp now;
+    epicsSharedArrayId id;
+
+    testPlan(18);
+
+    epicsTimeGetCurrent(&now);
+    /* SHM has room for 40 characters */
+    epicsSnprintf(prefix, sizeof(prefix), "shmTest.%x.",
+        (unsigned) (now.secPastEpoch * 1000003u ^ now.nsec));
+    id = epicsSharedArrayCreate(prefix, 0, 1, 1);
+    if (!id) {
+        testSkip(18, "shared memory not supported");
+        return testDone();
+    }
+    epicsSharedArrayClose(id);
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+    epicsSnprintf(macros, sizeof(macros), "P=%s", prefix);
+    testdbReadDatabase("sharedArrayTest.db", NULL, macros);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    testWaveform();
+    testAai();
+
+    testDiag("a record without its shared array still works");
+    testdbPutArrFieldOk("wfbad", DBF_SHORT, 3, values);
+    testdbGetArrFieldEqual("wfbad", DBF_SHORT, 4, 3, values);
+
+    testIocShutdownOk();
+
+    /* the names of the shared arrays are removed by epicsExit() */
+    testdbCleanup();
+    return testDone();
+}
@@ -0,0 +1,818 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* calcArrayPerform.c */
+
+/*
+ * Evaluates a postfix expression element by element over arrays. The
+ * elements are taken in blocks, and each instruction is run over a whole
+ * block before the next, so that the arithmetic loops can use the vector
+ * instructions of the CPU.
+ *
+ * A conditional evaluates both of its branches and selects between them
+ * for each element. postfix() only places assignments at the end of a
+ * sub-expression, never inside a branch.
+ *
+ * The array reductions need their argument for all of the elements before
+ * the rest of the expression can use them. Since a reduction only depends
+ * on instructions before it, each one gets a pass over the elements that
+ * runs the expression up to that reduction, and a final pass evaluates the
+ * whole expression. A reduction's pass covers the elements of the inputs
+ * that its argument reads, which may be more than the number of results,
+ * so inputs are read as NaN past their end.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "dbDefs.h"
+#include "epicsArrayKernels.h"
+#include "epicsMath.h"
+#include "epicsTypes.h"
+#include "errlog.h"
+#include "postfix.h"
+#include "postfixPvt.h"
+
+#ifndef PI
+#define PI 3.14159265358979323
+#endif
+
+/* elements evaluated at a time */
+#define CALC_BLOCK 256
+
+#define LANES EPICS_ARRAY_KERNEL_LANES
+
+/* Same conversions as in calcPerform() */
+#define d2i(x) ((x)<0?(epicsInt32)(x):(epicsInt32)(epicsUInt32)(x))
+#define d2ui(x) ((x)<0?(epicsUInt32)(epicsInt32)(x):(epicsUInt32)(x))
+
+/*
+ * Kernels for the operators that the compiler can turn into vector
+ * instructions. SUM and AVG use epicsArraySum(), which may differ from a
+ * sequential sum in the last bits.
+ */
+#define CALC_KERNELS(suffix, attr) \
+/* y = y op x */ \
+attr static void binary##suffix(int op, double *y, const double *x, int n) \
+{ \
+    int i; \
+\
+    switch (op) { \
+    case ADD: \
+        for (i = 0; i < n; i++) y[i] += x[i]; \
+        break; \
+    case SUB: \
+        for (i = 0; i < n; i++) y[i] -= x[i]; \
+        break; \
+    case MULT: \
+        for (i = 0; i < n; i++) y[i] *= x[i]; \
+        break; \
+    case DIV: \
+        for (i = 0; i < n; i++) y[i] /= x[i]; \
+        break; \
+    case MAX: \
+        for (i = 0; i < n; i++) \
+            y[i] = (y[i] < x[i] || isnan(x[i])) ? x[i] : y[i]; \
+        break; \
+    case MIN: \
+        for (i = 0; i < n; i++) \
+            y[i] = (y[i] > x[i] || isnan(x[i])) ? x[i] : y[i]; \
+        break; \
+    case REL_OR: \
+        for (i = 0; i < n; i++) \
+            y[i] = (y[i] != 0.0 || x[i] != 0.0) ? 1.0 : 0.0; \
+        break; \
+    case REL_AND: \
+        for (i = 0; i < n; i++) \
+            y[i] = (y[i] != 0.0 && x[i] != 0.0) ? 1.0 : 0.0; \
+        break; \
+    case NOT_EQ: \
+        for (i = 0; i < n; i++) y[i] = y[i] != x[i] ? 1.0 : 0.0; \
+        break; \
+    case LESS_THAN: \
+        for (i = 0; i < n; i++) y[i] = y[i] < x[i] ? 1.0 : 0.0; \
+        break; \
+    case LESS_OR_EQ: \
+        for (i = 0; i < n; i++) y[i] = y[i] <= x[i] ? 1.0 : 0.0; \
+        break; \
+    case EQUAL: \
+        for (i = 0; i < n; i++) y[i] = y[i] == x[i] ? 1.0 : 0.0; \
+        break; \
+    case GR_OR_EQ: \
+        for (i = 0; i < n; i++) y[i] = y[i] >= x[i] ? 1.0 : 0.0; \
+        break; \
+    case GR_THAN: \
+        for (i = 0; i < n; i++) y[i] = y[i] > x[i] ? 1.0 : 0.0; \
+        break; \
+    } \
+} \
+\
+/* y = op y, returns 0 if op is not one of these */ \
+attr static int unary##suffix(int op, double *y, int n) \
+{ \
+    int i; \
+\
+    switch (op) { \
+    case UNARY_NEG: \
+        for (i = 0; i < n; i++) y[i] = -y[i]; \
+        break; \
+    case ABS_VAL: \
+        for (i = 0; i < n; i++) y[i] = fabs(y[i]); \
+        break; \
+    case SQU_RT: \
+        for (i = 0; i < n; i++) y[i] = sqrt(y[i]); \
+        break; \
+    case CEIL: \
+        for (i = 0; i < n; i++) y[i] = ceil(y[i]); \
+        break; \
+    case FLOOR: \
+        for (i = 0; i < n; i++) y[i] = floor(y[i]); \
+        break; \
+    case REL_NOT: \
+        for (i = 0; i < n; i++) y[i] = y[i] == 0.0 ? 1.0 : 0.0; \
+        break; \
+    default: \
+        return 0; \
+    } \
+    return 1; \
+} \
+\
+/* c = c ? x : y */ \
+attr static void select##suffix(double *c, const double *x, \
+    const double *y, int n) \
+{ \
+    int i; \
+\
+    for (i = 0; i < n; i++) \
+        c[i] = c[i] != 0.0 ? x[i] : y[i]; \
+} \
+\
+/* the largest or smallest element, or a NaN if there is one */ \
+attr static double extreme##suffix(int op, double acc, const double *x, \
+    int n) \
+{ \
+    double lane[LANES]; \
+    int i, k; \
+\
+    for (k = 0; k < LANES; k++) \
+        lane[k] = acc; \
+    if (op == ARRAY_MAX) { \
+        for (i = 0; i + LANES <= n; i += LANES) \
+            for (k = 0; k < LANES; k++) \
+                lane[k] = (lane[k] < x[i + k] || isnan(x[i + k])) ? \
+                    x[i + k] : lane[k]; \
+    } \
+    else { \
+        for (i = 0; i + LANES <= n; i += LANES) \
+            for (k = 0; k < LANES; k++) \
+                lane[k] = (lane[k] > x[i + k] || isnan(x[i + k])) ? \
+                    x[i + k] : lane[k]; \
+    } \
+    binary##suffix(op == ARRAY_MAX ? MAX : MIN, lane, x + i, n - i); \
+    for (k = 1; k < LANES; k++) \
+        binary##suffix(op == ARRAY_MAX ? MAX : MIN, lane, lane + k, 1); \
+    return lane[0]; \
+}
+
+EPICS_ARRAY_KERNEL_VARIANTS(CALC_KERNELS)
+
+typedef struct calcArrayEval {
+    const char *pinst;
+    const double * const *pparg;
+    const epicsUInt32 *pcount;
+    double *presult;
+    epicsUInt32 nVal;       /* capacity of presult */
+    double *stack;          /* CALC_BLOCK elements per entry */
+    double *local;          /* assigned variables, CALC_BLOCK elements each */
+    double *reduced;        /* values of the reductions known so far */
+    double acc;             /* reduction being computed */
+    /* the kernels for this CPU */
+    void (*binary)(int op, double *y, const double *x, int n);
+    int (*unary)(int op, double *y, int n);
+    void (*select)(double *c, const double *x, const double *y, int n);
+    double (*extreme)(int op, double acc, const double *x, int n);
+} calcArrayEval;
+
+static void fill(double *y, double value, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+        y[i] = value;
+}
+
+/* m elements of an input of count elements from first on, NaN past its end */
+static void fetch(double *y, const double *x, epicsUInt32 count,
+    epicsUInt32 first, int m)
+{
+    int nHave = count <= first ? 0 :
+        count - first < (epicsUInt32) m ? (int) (count - first) : m;
+
+    memcpy(y, x + first, nHave * sizeof(double));
+    fill(y + nHave, epicsNAN, m - nHave);
+}
+
+/* Runs the expression over m elements from first on. If stopAt is not
+ * negative, stops at that reduction and adds its argument to pe->acc.
+ */
+static long evalBlock(calcArrayEval *pe, epicsUInt32 first, int m,
+    int stopAt)
+{
+    const char *pinst = pe->pinst;
+    double *ptop = NULL;
+    unsigned long stored = 0;
+    int reduction = 0;
+    epicsInt32 itop;
+    double top;
+    int op, nargs, i, j;
+
+/* the entry below the top of the stack */
+#define NEXT (ptop - CALC_BLOCK)
+#define PUSH (ptop = ptop ? ptop + CALC_BLOCK : pe->stack)
+#define POP (ptop -= CALC_BLOCK)
+
+    while ((op = *pinst++) != END_EXPRESSION) {
+        switch (op) {
+
+        case LITERAL_DOUBLE:
+            memcpy(&top, pinst, sizeof(double));
+            pinst += sizeof(double);
+            fill(PUSH, top, m);
+            break;
+
+        case LITERAL_INT:
+            memcpy(&itop, pinst, sizeof(epicsInt32));
+            pinst += sizeof(epicsInt32);
+            fill(PUSH, itop, m);
+            break;
+
+        case FETCH_VAL:
+            fetch(PUSH, pe->presult, pe->nVal, first, m);
+            break;
+
+        case FETCH_A:
+        case FETCH_B:
+        case FETCH_C:
+        case FETCH_D:
+        case FETCH_E:
+        case FETCH_F:
+        case FETCH_G:
+        case FETCH_H:
+        case FETCH_I:
+        case FETCH_J:
+        case FETCH_K:
+        case FETCH_L:
+            j = op - FETCH_A;
+            PUSH;
+            if (stored & (1ul << j))
+                memcpy(ptop, pe->local + j * CALC_BLOCK, m * sizeof(double));
+            else if (pe->pcount[j] == 1)
+                fill(ptop, pe->pparg[j][0], m);
+            else
+                fetch(ptop, pe->pparg[j], pe->pcount[j], first, m);
+            break;
+
+        case STORE_A:
+        case STORE_B:
+        case STORE_C:
+        case STORE_D:
+        case STORE_E:
+        case STORE_F:
+        case STORE_G:
+        case STORE_H:
+        case STORE_I:
+        case STORE_J:
+        case STORE_K:
+        case STORE_L:
+            j = op - STORE_A;
+            memcpy(pe->local + j * CALC_BLOCK, ptop, m * sizeof(double));
+            stored |= 1ul << j;
+            POP;
+            break;
+
+        case CONST_PI:
+            fill(PUSH, PI, m);
+            break;
+
+        case CONST_D2R:
+            fill(PUSH, PI/180., m);
+            break;
+
+        case CONST_R2D:
+            fill(PUSH, 180./PI, m);
+            break;
+
+        case RANDOM:
+            PUSH;
+            for (i = 0; i < m; i++)
+                ptop[i] = epicsCalcRandomPvt();
+            break;
+
+        case ADD:
+        case SUB:
+        case MULT:
+        case DIV:
+        case REL_OR:
+        case REL_AND:
+        case NOT_EQ:
+        case LESS_THAN:
+        case LESS_OR_EQ:
+        case EQUAL:
+        case GR_OR_EQ:
+        case GR_THAN:
+            pe->binary(op, NEXT, ptop, m);
+            POP;
+            break;
+
+        case MAX:
+        case MIN:
+            nargs = *pinst++;
+            while (--nargs) {
+                pe->binary(op, NEXT, ptop, m);
+                POP;
+            }
+            break;
+
+        case MODULO:
+            for (i = 0; i < m; i++) {
+                itop = (epicsInt32) ptop[i];
+                if (itop)
+                    NEXT[i] = (epicsInt32) NEXT[i] % itop;
+                else
+                    NEXT[i] = epicsNAN;
+            }
+            POP;
+            break;
+
+        case POWER:
+            for (i = 0; i < m; i++)
+                NEXT[i] = pow(NEXT[i], ptop[i]);
+            POP;
+            break;
+
+        case ATAN2:
+            for (i = 0; i < m; i++)
+                NEXT[i] = atan2(ptop[i], NEXT[i]);
+            POP;
+            break;
+
+        case FMOD:
+            for (i = 0; i < m; i++)
+                NEXT[i] = fmod(NEXT[i], ptop[i]);
+            POP;
+            break;
+
+        case BIT_OR:
+            for (i = 0; i < m; i++)
+                NEXT[i] = (double)(d2i(NEXT[i]) | d2i(ptop[i]));
+            POP;
+            break;
+
+        case BIT_AND:
+            for (i = 0; i < m; i++)
+                NEXT[i] = (double)(d2i(NEXT[i]) & d2i(ptop[i]));
+            POP;
+            break;
+
+        case BIT_EXCL_OR:
+            for (i = 0; i < m; i++)
+                NEXT[i] = (double)(d2i(NEXT[i]) ^ d2i(ptop[i]));
+            POP;
+            break;
+
+        case RIGHT_SHIFT_ARITH:
+            for (i = 0; i < m; i++)
+                NEXT[i] = (double)(d2i(NEXT[i]) >> (d2i(ptop[i]) & 31));
+            POP;
+            break;
+
+        case LEFT_SHIFT_ARITH:
+            for (i = 0; i < m; i++)
+                NEXT[i] = (double)(d2i(NEXT[i]) << (d2i(ptop[i]) & 31));
+            POP;
+            break;
+
+        case RIGHT_SHIFT_LOGIC:
+            for (i = 0; i < m; i++)
+                NEXT[i] = (double)(d2ui(NEXT[i]) >> (d2ui(ptop[i]) & 31u));
+            POP;
+            break;
+
+        case FINITE:
+        case ISNAN:
+            nargs = *pinst++;
+            for (i = 0; i < m; i++) {
+                int test = op == FINITE ? finite(ptop[i]) : isnan(ptop[i]);
+
+                for (j = 1; j < nargs; j++) {
+                    double x = ptop[i - j * CALC_BLOCK];
+
+                    if (op == FINITE)
+                        test = test && finite(x);
+                    else
+                        test = test || isnan(x);
+                }
+                ptop[i - (nargs - 1) * CALC_BLOCK] = test;
+            }
+            ptop -= (nargs - 1) * CALC_BLOCK;
+            break;
+
+        case ISINF:
+            for (i = 0; i < m; i++)
+                ptop[i] = isinf(ptop[i]);
+            break;
+
+        case NINT:
+            for (i = 0; i < m; i++) {
+                top = ptop[i];
+                ptop[i] = (epicsInt32) (top >= 0 ? top + 0.5 : top - 0.5);
+            }
+            break;
+
+        case BIT_NOT:
+            for (i = 0; i < m; i++)
+                ptop[i] = (double)~d2i(ptop[i]);
+            break;
+
+        case EXP:
+        case LOG_10:
+        case LOG_E:
+        case ACOS:
+        case ASIN:
+        case ATAN:
+        case COS:
+        case COSH:
+        case SIN:
+        case SINH:
+        case TAN:
+        case TANH:
+            {
+                double (*func)(double);
+
+                switch (op) {
+                case EXP:    func = exp;   break;
+                case LOG_10: func = log10; break;
+                case LOG_E:  func = log;   break;
+                case ACOS:   func = acos;  break;
+                case ASIN:   func = asin;  break;
+                case ATAN:   func = atan;  break;
+                case COS:    func = cos;   break;
+                case COSH:   func = cosh;  break;
+                case SIN:    func = sin;   break;
+                case SINH:   func = sinh;  break;
+                case TAN:    func = tan;   break;
+                default:     func = tanh;  break;
+                }
+                for (i = 0; i < m; i++)
+                    ptop[i] = func(ptop[i]);
+            }
+            break;
+
+        /* The condition stays on the stack under the two branches */
+        case COND_IF:
+        case COND_ELSE:
+            break;
+
+        case COND_END:
+            pe->select(ptop - 2 * CALC_BLOCK, NEXT, ptop, m);
+            ptop -= 2 * CALC_BLOCK;
+            break;
+
+        case ARRAY_SUM:
+        case ARRAY_MAX:
+        case ARRAY_MIN:
+        case ARRAY_AVG:
+            if (reduction == stopAt) {
+                if (op == ARRAY_SUM || op == ARRAY_AVG)
+                    pe->acc += epicsArraySum(ptop, m);
+                else
+                    pe->acc = pe->extreme(op, pe->acc, ptop, m);
+                return 0;
+            }
+            fill(ptop, pe->reduced[reduction++], m);
+            break;
+
+        default:
+            if (!pe->unary(op, ptop, m)) {
+                errlogPrintf("calcArrayPerform: Bad Opcode %d at %p\n",
+                    op, pinst-1);
+                return -1;
+            }
+        }
+    }
+
+    memcpy(pe->presult + first, ptop, m * sizeof(double));
+    return 0;
+
+#undef NEXT
+#undef PUSH
+#undef POP
+}
+
+/* Runs the expression over n elements, see evalBlock() */
+static long evalAll(calcArrayEval *pe, epicsUInt32 n, int stopAt)
+{
+    epicsUInt32 first;
+
+    for (first = 0; first < n; first += CALC_BLOCK) {
+        epicsUInt32 m = n - first;
+
+        if (evalBlock(pe, first, m < CALC_BLOCK ? m : CALC_BLOCK, stopAt))
+            return -1;
+    }
+    return 0;
+}
+
+/* VAL in the bitmaps of inputs read, after A-L */
+#define VAL_INPUT (1ul << CALCPERFORM_NARGS)
+
+/* Finds the stack depth and the number of reductions of an expression.
+ * If which is not negative, also finds the opcode of that reduction and
+ * the inputs that its argument reads. Returns -1 if it can't be evaluated
+ * by selecting between the branches of its conditionals.
+ */
+static int scanExpr(const char *pinst, int *pdepth, int *pnReduce,
+    int which, int *pop, unsigned long *pinputs)
+{
+    int condDepth[CALCPERFORM_STACK];
+    unsigned long inputs[CALCPERFORM_STACK];    /* read by each entry */
+    unsigned long assigned[CALCPERFORM_NARGS];  /* read by each variable */
+    unsigned long stored = 0;
+    int depth = 0, maxDepth = 0, nCond = 0, nReduce = 0;
+    int op, j;
+
+    while ((op = *pinst++) != END_EXPRESSION) {
+        /* entries taken from and put on the stack */
+        int nPop = 0, nPush = 1;
+        int reduced = 0;
+        unsigned long read = 0;
+
+        switch (op) {
+
+        case LITERAL_DOUBLE:
+            pinst += sizeof(double);
+            break;
+
+        case LITERAL_INT:
+            pinst += sizeof(epicsInt32);
+            break;
+
+        case FETCH_VAL:
+            read = VAL_INPUT;
+            break;
+
+        case FETCH_A:
+        case FETCH_B:
+        case FETCH_C:
+        case FETCH_D:
+        case FETCH_E:
+        case FETCH_F:
+        case FETCH_G:
+        case FETCH_H:
+        case FETCH_I:
+        case FETCH_J:
+        case FETCH_K:
+        case FETCH_L:
+            j = op - FETCH_A;
+            read = (stored & (1ul << j)) ? assigned[j] : 1ul << j;
+            break;
+
+        case CONST_PI:
+        case CONST_D2R:
+        case CONST_R2D:
+        case RANDOM:
+            break;
+
+        case STORE_A:
+        case STORE_B:
+        case STORE_C:
+        case STORE_D:
+        case STORE_E:
+        case STORE_F:
+        case STORE_G:
+        case STORE_H:
+        case STORE_I:
+        case STORE_J:
+        case STORE_K:
+        case STORE_L:
+            if (nCond || !depth)
+                return -1;
+            j = op - STORE_A;
+            assigned[j] = inputs[depth - 1];
+            stored |= 1ul << j;
+            nPop = 1;
+            nPush = 0;
+            break;
+
+        case MAX:
+        case MIN:
+        case FINITE:
+        case ISNAN:
+            nPop = *pinst++;
+            break;
+
+        case ADD:
+        case SUB:
+        case MULT:
+        case DIV:
+        case MODULO:
+        case POWER:
+        case ATAN2:
+        case FMOD:
+        case REL_OR:
+        case REL_AND:
+        case BIT_OR:
+        case BIT_AND:
+        case BIT_EXCL_OR:
+        case RIGHT_SHIFT_ARITH:
+        case LEFT_SHIFT_ARITH:
+        case RIGHT_SHIFT_LOGIC:
+        case NOT_EQ:
+        case LESS_THAN:
+        case LESS_OR_EQ:
+        case EQUAL:
+        case GR_OR_EQ:
+        case GR_THAN:
+            nPop = 2;
+            break;
+
+        /* Each branch must leave one value above the condition */
+        case COND_IF:
+            if (nCond == NELEMENTS(condDepth))
+                return -1;
+            condDepth[nCond++] = depth;
+            nPush = 0;
+            break;
+
+        case COND_ELSE:
+            if (!nCond || depth != condDepth[nCond - 1] + 1)
+                return -1;
+            nPush = 0;
+            break;
+
+        /* the condition and the two branches give one value */
+        case COND_END:
+            if (!nCond || depth != condDepth[--nCond] + 2)
+                return -1;
+            nPop = 3;
+            break;
+
+        /* the result is the same for every element */
+        case ARRAY_SUM:
+        case ARRAY_MAX:
+        case ARRAY_MIN:
+        case ARRAY_AVG:
+            if (!depth)
+                return -1;
+            if (nReduce++ == which) {
+                *pop = op;
+                *pinputs = inputs[depth - 1];
+            }
+            nPop = 1;
+            reduced = 1;
+            break;
+
+        default:
+            if (op < UNARY_NEG || op >= NOT_GENERATED)
+                return -1;
+            nPop = 1;
+            break;
+        }
+        if (nPop > depth)
+            return -1;
+        for (j = 1; j <= nPop && !reduced; j++)
+            read |= inputs[depth - j];
+        depth += nPush - nPop;
+        if (nPush) {
+            if (depth > CALCPERFORM_STACK)
+                return -1;
+            inputs[depth - 1] = read;
+        }
+        if (depth > maxDepth)
+            maxDepth = depth;
+    }
+    if (depth != 1 || nCond)
+        return -1;
+    *pdepth = maxDepth;
+    *pnReduce = nReduce;
+    return 0;
+}
+
+/* The number of elements of the inputs read, the smallest one that isn't
+ * a single value, or 1 if all of them are. VAL has nVal elements.
+ */
+static epicsUInt32 inputCount(unsigned long inputs, const epicsUInt32 *pcount,
+    epicsUInt32 nVal)
+{
+    epicsUInt32 n = 0;
+    int haveArray = 0;
+    int j;
+
+    for (j = 0; j <= CALCPERFORM_NARGS; j++) {
+        epicsUInt32 count;
+
+        if (!(inputs & (1ul << j)))
+            continue;
+        count = j < CALCPERFORM_NARGS ? pcount[j] : nVal;
+        if (count == 1)
+            continue;
+        if (!haveArray || count < n)
+            n = count;
+        haveArray = 1;
+    }
+    return haveArray ? n : 1;
+}
+
+/* doubles needed for the stack, the assigned variables and the reductions */
+static size_t workSize(int depth, int nReduce, unsigned long stores)
+{
+    return (depth + (stores ? CALCPERFORM_NARGS : 0)) * CALC_BLOCK + nReduce;
+}
+
+LIBCOM_API size_t
+    calcArrayWorkSize(const char *pinst)
+{
+    unsigned long stores;
+    int depth, nReduce;
+
+    if (scanExpr(pinst, &depth, &nReduce, -1, NULL, NULL))
+        return 0;
+    calcArgUsage(pinst, NULL, &stores);
+    return workSize(depth, nReduce, stores);
+}
+
+LIBCOM_API long
+    calcArrayPerform(const double * const *pparg, const epicsUInt32 *pcount,
+        double *presult, epicsUInt32 *pnresult, const char *pinst,
+        double *pwork)
+{
+    calcArrayEval eval;
+    unsigned long inputs, stores;
+    int depth, nReduce, status, r, j;
+    epicsUInt32 n;
+    double *palloc = NULL;
+
+    if (scanExpr(pinst, &depth, &nReduce, -1, NULL, NULL))
+        return -1;
+
+    /* the arrays that are read give the number of elements */
+    calcArgUsage(pinst, &inputs, &stores);
+    for (j = 0; j < CALCPERFORM_NARGS; j++) {
+        if ((inputs & (1ul << j)) && !pparg[j])
+            return -1;
+    }
+    n = inputCount(inputs, pcount, *pnresult);
+    if (n > *pnresult)
+        n = *pnresult;
+
+    if (!pwork) {
+        pwork = palloc = malloc(workSize(depth, nReduce, stores) *
+            sizeof(double));
+        if (!pwork)
+            return -1;
+    }
+    eval.pinst = pinst;
+    eval.pparg = pparg;
+    eval.pcount = pcount;
+    eval.presult = presult;
+    eval.nVal = *pnresult;
+    eval.stack = pwork;
+    eval.local = pwork + depth * CALC_BLOCK;
+    eval.reduced = eval.local + (stores ? CALCPERFORM_NARGS * CALC_BLOCK : 0);
+    eval.binary = EPICS_ARRAY_KERNEL_PICK(binary);
+    eval.unary = EPICS_ARRAY_KERNEL_PICK(unary);
+    eval.select = EPICS_ARRAY_KERNEL_PICK(select);
+    eval.extreme = EPICS_ARRAY_KERNEL_PICK(extreme);
+    status = 0;
+    for (r = 0; r < nReduce && !status; r++) {
+        unsigned long rinputs;
+        epicsUInt32 nr;
+        int op;
+
+        /* the reduction takes all of the elements of its argument */
+        scanExpr(pinst, &depth, &nReduce, r, &op, &rinputs);
+        nr = inputCount(rinputs, pcount, *pnresult);
+
+        if (op == ARRAY_MAX)
+            eval.acc = -epicsINF;
+        else if (op == ARRAY_MIN)
+            eval.acc = epicsINF;
+        else
+            eval.acc = 0.0;
+        status = evalAll(&eval, nr, r);
+        if (op == ARRAY_AVG)
+            eval.acc /= nr;
+        else if (op != ARRAY_SUM && nr == 0)
+            eval.acc = epicsNAN;
+        eval.reduced[r] = eval.acc;
+    }
+    if (!status)
+        status = evalAll(&eval, n, -1);
+    free(palloc);
+    if (status)
+        return -1;
+    *pnresult = n;
+    return 0;
+}
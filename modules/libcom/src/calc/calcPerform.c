@@ -26,7 +26,6 @@
 #include "postfixPvt.h"
 
 
-static double calcRandom(void);
 static int cond_search(const char **ppinst, int match);
 
 #ifndef PI
@@ -275,7 +274,7 @@ LIBCOM_API long
             break;
 
         case RANDOM:
-            *++ptop = calcRandom();
+            *++ptop = epicsCalcRandomPvt();
             break;
 
         case REL_OR:
@@ -390,6 +389,13 @@ LIBCOM_API long
         case COND_END:
             break;
 
+        /* A single value is an array of one element */
+        case ARRAY_SUM:
+        case ARRAY_MAX:
+        case ARRAY_MIN:
+        case ARRAY_AVG:
+            break;
+
         default:
             errlogPrintf("calcPerform: Bad Opcode %d at %p\n", op, pinst-1);
             return -1;
@@ -479,7 +485,7 @@ static unsigned short seed = 0xa3bf;
 static unsigned short multy = 191 * 8 + 5;  /* 191 % 8 == 5 */
 static unsigned short addy = 0x3141;
 
-static double calcRandom(void)
+double epicsCalcRandomPvt(void)
 {
     seed = (seed * multy) + addy;
 
@@ -89,9 +89,12 @@ static const ELEMENT operands[] = {
 {"A",           0, 0,   1,      OPERAND,        FETCH_A},
 {"ABS",         7, 8,   0,      UNARY_OPERATOR, ABS_VAL},
 {"ACOS",        7, 8,   0,      UNARY_OPERATOR, ACOS},
+{"AMAX",        7, 8,   0,      UNARY_OPERATOR, ARRAY_MAX},
+{"AMIN",        7, 8,   0,      UNARY_OPERATOR, ARRAY_MIN},
 {"ASIN",        7, 8,   0,      UNARY_OPERATOR, ASIN},
 {"ATAN",        7, 8,   0,      UNARY_OPERATOR, ATAN},
 {"ATAN2",       7, 8,   -1,     UNARY_OPERATOR, ATAN2},
+{"AVG",         7, 8,   0,      UNARY_OPERATOR, ARRAY_AVG},
 {"B",           0, 0,   1,      OPERAND,        FETCH_B},
 {"C",           0, 0,   1,      OPERAND,        FETCH_C},
 {"CEIL",        7, 8,   0,      UNARY_OPERATOR, CEIL},
@@ -129,6 +132,7 @@ static const ELEMENT operands[] = {
 {"SINH",        7, 8,   0,      UNARY_OPERATOR, SINH},
 {"SQR",         7, 8,   0,      UNARY_OPERATOR, SQU_RT},
 {"SQRT",        7, 8,   0,      UNARY_OPERATOR, SQU_RT},
+{"SUM",         7, 8,   0,      UNARY_OPERATOR, ARRAY_SUM},
 {"TAN",         7, 8,   0,      UNARY_OPERATOR, TAN},
 {"TANH",        7, 8,   0,      UNARY_OPERATOR, TANH},
 {"VAL",         0, 0,   1,      OPERAND,        FETCH_VAL},
@@ -579,6 +583,7 @@ LIBCOM_API void
     /* Numeric */
         "CEIL",
         "FLOOR",
+        "FMOD",
         "FINITE",
         "ISINF",
         "ISNAN",
@@ -607,6 +612,11 @@ LIBCOM_API void
         "COND_IF",
         "COND_ELSE",
         "COND_END",
+    /* Array reductions */
+        "ARRAY_SUM",
+        "ARRAY_MAX",
+        "ARRAY_MIN",
+        "ARRAY_AVG",
     /* Misc */
         "NOT_GENERATED"
     };
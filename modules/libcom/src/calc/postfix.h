@@ -20,7 +20,10 @@
 #ifndef INCpostfixh
 #define INCpostfixh
 
+#include <stddef.h>
+
 #include "libComAPI.h"
+#include "epicsTypes.h"
 
 /** \brief Number of input arguments to a calc expression (A-L) */
 #define CALCPERFORM_NARGS 12
@@ -297,6 +300,23 @@ extern "C" {
  *      - Example:
  *        - a < 360 ? a+1 : 0
  *
+ * -# ***Array Reductions***
+ *  These functions reduce an array to a single value, and are meant for
+ *  expressions evaluated by calcArrayPerform(). There the result is used
+ *  for every element. When calcPerform() evaluates a single value they
+ *  return their argument.
+ *
+ *    - Sum of the elements: sum(a)
+ *    - Largest element: amax(a)
+ *    - Smallest element: amin(a)
+ *    - Mean of the elements: avg(a)
+ *
+ *  amax() and amin() return a NaN if any element is a NaN, like max() and
+ *  min().
+ *      - Example:
+ *        - (a - avg(a)) / (amax(a) - amin(a))
+ *  \since UNRELEASED
+ *
  * -# ***Parentheses***
  * Sub-expressions can be placed within parentheses to override operator presence rules.
  * Parentheses can be nested to any depth, but the intermediate value stack used by
@@ -321,6 +341,61 @@ LIBCOM_API long
 LIBCOM_API long
     calcPerform(double *parg, double *presult, const char *ppostfix);
 
+/** \brief Run the calculation engine over arrays
+ *
+ * Evaluates the postfix expression for each element of the input arrays,
+ * giving an array of results. Element \c i of the result is calculated
+ * from element \c i of each argument, as calcPerform() would do, while
+ * the array reductions sum(), amax(), amin() and avg() use all of the
+ * elements of their argument.
+ *
+ * An argument with one element is used for every element of the result.
+ * The number of results is the smallest number of elements of the other
+ * arguments that the expression reads, or 1 if it reads none of them, and
+ * at most the capacity of \p presult. VAL refers to the element of
+ * \p presult at the same index.
+ *
+ * A reduction works the same way over the arguments read by its own
+ * argument, with VAL having the capacity of \p presult elements, whatever
+ * the number of results. So sum(A) adds up all of the elements of A even
+ * if B is shorter in sum(A)+B or if \p presult has room for one value.
+ *
+ * Unlike calcPerform(), the conditional operator evaluates both of its
+ * branches and selects one of the results for each element, so rndm
+ * advances for both.
+ *
+ * \param pparg Pointer to an array of CALCPERFORM_NARGS pointers to the
+ * arrays of values of the arguments A-L. Arguments that are not used by the
+ * expression may be NULL. The arrays are not modified by assignments.
+ * \param pcount Pointer to the numbers of elements of the arguments.
+ * \param presult The array of results.
+ * \param pnresult On entry the capacity of \p presult, on success
+ * replaced by the number of results.
+ * \param ppostfix The postfix expression created by postfix().
+ * \param pwork A workspace of calcArrayWorkSize() doubles for this
+ * expression, or NULL to allocate one for this call only.
+ * \return Status value 0 for OK, or non-zero if an error is discovered
+ * during the evaluation process.
+ * \since UNRELEASED
+ */
+LIBCOM_API long
+    calcArrayPerform(const double * const *pparg, const epicsUInt32 *pcount,
+        double *presult, epicsUInt32 *pnresult, const char *ppostfix,
+        double *pwork);
+
+/** \brief The workspace that calcArrayPerform() needs for an expression
+ *
+ * Code that evaluates the same expression many times can allocate the
+ * workspace once and pass it to each call of calcArrayPerform().
+ *
+ * \param ppostfix The postfix expression created by postfix().
+ * \return The number of doubles needed, or 0 if calcArrayPerform() can't
+ * evaluate the expression.
+ * \since UNRELEASED
+ */
+LIBCOM_API size_t
+    calcArrayWorkSize(const char *ppostfix);
+
 /** \brief Find the inputs and outputs of an expression
  *
  * Software using the calc subsystem may need to know what expression
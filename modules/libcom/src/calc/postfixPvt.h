@@ -100,8 +100,16 @@ typedef enum {
     COND_IF,
     COND_ELSE,
     COND_END,
+    /* Array reductions */
+    ARRAY_SUM,
+    ARRAY_MAX,
+    ARRAY_MIN,
+    ARRAY_AVG,
     /* Misc */
     NOT_GENERATED
 } rpn_opcode;
 
+/* Shared by calcPerform() and calcArrayPerform(), internal to libCom */
+double epicsCalcRandomPvt(void);
+
 #endif /* INCpostfixPvth */
@@ -50,6 +50,10 @@ LIBCOM_API extern const ENV_PARAM EPICS_CA_AUTO_ADDR_LIST;
 LIBCOM_API extern const ENV_PARAM EPICS_CA_REPEATER_PORT;
 LIBCOM_API extern const ENV_PARAM EPICS_CA_SERVER_PORT;
 LIBCOM_API extern const ENV_PARAM EPICS_CA_MAX_ARRAY_BYTES;
+LIBCOM_API extern const ENV_PARAM EPICS_CA_TCP_RECV_THREADS;
+LIBCOM_API extern const ENV_PARAM EPICS_CA_CALLBACK_THREADS;
+LIBCOM_API extern const ENV_PARAM EPICS_CA_NAME_CACHE;
+LIBCOM_API extern const ENV_PARAM EPICS_CA_NAME_CACHE_TTL;
 LIBCOM_API extern const ENV_PARAM EPICS_CA_AUTO_ARRAY_BYTES;
 LIBCOM_API extern const ENV_PARAM EPICS_CA_MAX_SEARCH_PERIOD;
 LIBCOM_API extern const ENV_PARAM EPICS_CA_NAME_SERVERS;
@@ -67,12 +71,18 @@ LIBCOM_API extern const ENV_PARAM EPICS_BUILD_OS_CLASS;
 LIBCOM_API extern const ENV_PARAM EPICS_BUILD_TARGET_ARCH;
 LIBCOM_API extern const ENV_PARAM EPICS_TZ;
 LIBCOM_API extern const ENV_PARAM EPICS_TS_NTP_INET;
+LIBCOM_API extern const ENV_PARAM EPICS_IP_TO_ASCII_THREADS;
+LIBCOM_API extern const ENV_PARAM EPICS_IP_TO_ASCII_CACHE_TTL;
+LIBCOM_API extern const ENV_PARAM EPICS_IP_TO_ASCII_NEG_CACHE_TTL;
 LIBCOM_API extern const ENV_PARAM EPICS_IOC_IGNORE_SERVERS;
 LIBCOM_API extern const ENV_PARAM EPICS_IOC_LOG_PORT;
 LIBCOM_API extern const ENV_PARAM EPICS_IOC_LOG_INET;
 LIBCOM_API extern const ENV_PARAM EPICS_IOC_LOG_FILE_LIMIT;
 LIBCOM_API extern const ENV_PARAM EPICS_IOC_LOG_FILE_NAME;
 LIBCOM_API extern const ENV_PARAM EPICS_IOC_LOG_FILE_COMMAND;
+LIBCOM_API extern const ENV_PARAM EPICS_IOC_LOG_FILE_ROTATE;
+LIBCOM_API extern const ENV_PARAM EPICS_IOC_LOG_QUEUE_SIZE;
+LIBCOM_API extern const ENV_PARAM EPICS_IOC_LOG_FRAMED;
 LIBCOM_API extern const ENV_PARAM IOCSH_PS1;
 LIBCOM_API extern const ENV_PARAM IOCSH_HISTSIZE;
 LIBCOM_API extern const ENV_PARAM IOCSH_HISTEDIT_DISABLE;
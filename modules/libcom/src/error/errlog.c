@@ -38,6 +38,7 @@
 #include "errlog.h"
 #include "epicsStdio.h"
 #include "epicsExit.h"
+#include "epicsTime.h"
 #include "osiUnistd.h"
 
 
@@ -56,11 +57,22 @@
 /* should this message be echoed to the console? */
 #define ERL_LOCALECHO   0x20
 
+/* Repeat suppression.  Call sites are identified by their format string,
+ * tracked in a small open addressed table.
+ */
+#define SUPPRESS_TABLE_SIZE 64
+#define SUPPRESS_PROBE 8
+#define SUPPRESS_SAMPLE 48
+/* class of messages logged without a severity */
+#define SUPPRESS_NOSEVR (errlogFatal+1)
+#define SUPPRESS_NCLASS (errlogFatal+2)
+
 /*Declare storage for errVerbose */
 int errVerbose = 0;
 
 static void errlogExitHandler(void *);
 static void errlogThread(void);
+static void errlogSequence(void);
 
 typedef struct listenerNode{
     ELLNODE node;
@@ -75,6 +87,28 @@ typedef struct {
     size_t pos;
 } buffer_t;
 
+typedef struct {
+    const char *format; /* key, NULL when slot is unused */
+    int cls;
+    epicsUInt64 windowStart; /* epicsMonotonicGet() ns */
+    unsigned count; /* messages in current window */
+    unsigned nSuppressed; /* of which were suppressed */
+    epicsUInt64 since; /* start of the period nSuppressed covers */
+    size_t totalSeen;
+    size_t totalSuppressed;
+    /* start of format, which may not outlive its library */
+    char sample[SUPPRESS_SAMPLE];
+} suppressEntry;
+
+/* Per-thread scratch space where messages are formatted before
+ * msgQueueLock is taken, so that only the copy into the shared
+ * buffer is serialized.
+ */
+typedef struct {
+    int busy;
+    char msg[1]; /* actually pvt.maxMsgSize */
+} fmtbuf_t;
+
 static struct {
     /* const after errlogInit() */
     size_t maxMsgSize;
@@ -91,6 +125,9 @@ static struct {
     epicsEventId waitForSeq;
     epicsMutexId msgQueueLock;
 
+    /* fmtbuf_t of each thread which has logged */
+    epicsThreadPrivateId fmtBuf;
+
     /* guarded by msgQueueLock */
     int          atExit;
     int          sevToLog;
@@ -102,6 +139,19 @@ static struct {
     epicsUInt32 flushSeq;
     size_t nFlushers;
     size_t nLost;
+    /* running totals for errlogGetCounts() */
+    size_t totalLogged;
+    size_t totalLost;
+
+    /* guards the remaining members */
+    epicsMutexId suppressLock;
+    /* burst==0 disables suppression for the class */
+    unsigned suppressBurst[SUPPRESS_NCLASS];
+    epicsUInt64 suppressWindow[SUPPRESS_NCLASS]; /* ns */
+    int suppressEnabled; /* any suppressBurst!=0, read unlocked */
+    size_t totalSuppressed;
+    size_t suppressEvicted;
+    suppressEntry suppress[SUPPRESS_TABLE_SIZE];
 
     /* 'log' and 'print' combine to form a double buffer. */
     buffer_t *log;
@@ -111,13 +161,25 @@ static struct {
     buffer_t bufs[2];
 } pvt;
 
+static
+void fmtbufFree(void *raw)
+{
+    epicsThreadPrivateSet(pvt.fmtBuf, NULL);
+    free(raw);
+}
+
 /* Returns an pointer to pvt.maxMsgSize bytes, or NULL if ring buffer is full.
  * When !NULL, caller _must_ later msgbufCommit()
+ *
+ * Normally this is the calling thread's fmtbuf_t and no lock is held.
+ * If that can't be used, formatting happens directly in the shared
+ * buffer with msgQueueLock held, as only one buffer per thread is kept.
  */
 static
 char* msgbufAlloc(void)
 {
     char *ret = NULL;
+    fmtbuf_t *fmt;
 
     if (epicsInterruptIsInterruptContext()) {
         epicsInterruptContextMessage
@@ -126,6 +188,23 @@ char* msgbufAlloc(void)
     }
 
     errlogInit(0);
+
+    fmt = epicsThreadPrivateGet(pvt.fmtBuf);
+    if(!fmt) {
+        fmt = malloc(offsetof(fmtbuf_t, msg) + pvt.maxMsgSize);
+        if(fmt) {
+            fmt->busy = 0;
+            epicsThreadPrivateSet(pvt.fmtBuf, fmt);
+            if(epicsAtThreadExit(fmtbufFree, fmt))
+                fmtbufFree(fmt); /* we would leak it */
+            fmt = epicsThreadPrivateGet(pvt.fmtBuf);
+        }
+    }
+    if(fmt && !fmt->busy) {
+        fmt->busy = 1;
+        return fmt->msg;
+    }
+
     epicsMutexMustLock(pvt.msgQueueLock); /* matched in msgbufCommit() */
     if(pvt.bufSize - pvt.log->pos >= 1+pvt.maxMsgSize) {
         /* there is enough space for the worst cast */
@@ -136,40 +215,67 @@ char* msgbufAlloc(void)
 
     if(!ret) {
         pvt.nLost++;
+        pvt.totalLost++;
         epicsMutexUnlock(pvt.msgQueueLock);
     }
     return ret;
 }
 
+/* Queue a message formatted into the pointer returned by msgbufAlloc().
+ * Returns the number of characters queued, or 0 if the message was lost.
+ */
 static
-size_t msgbufCommit(size_t nchar, int localEcho)
+size_t msgbufCommit(char *buf, size_t nchar, int localEcho)
 {
     int isOkToBlock = epicsThreadIsOkToBlock();
-    int wasEmpty = pvt.log->pos==0;
-    int atExit = pvt.atExit;
-    char *start = pvt.log->base + pvt.log->pos;
+    fmtbuf_t *fmt = epicsThreadPrivateGet(pvt.fmtBuf);
+    int formatted = fmt && buf == fmt->msg;
+    int wasEmpty;
+    int atExit;
+    char *start = buf - 1u;
 
     /* nchar returned by snprintf() is >= maxMsgSize when truncated */
     if(nchar >= pvt.maxMsgSize) {
         const char *trunc = "<<TRUNCATED>>\n";
         nchar = pvt.maxMsgSize - 1u;
 
-        strcpy(start + 1u + nchar - strlen(trunc), trunc);
-        /* assert(strlen(start+1u)==nchar); */
+        strcpy(buf + nchar - strlen(trunc), trunc);
+        /* assert(strlen(buf)==nchar); */
+    }
+
+    buf[nchar] = '\0';
+
+    if(formatted) {
+        /* only the copy happens under the lock */
+        epicsMutexMustLock(pvt.msgQueueLock); /* matched below */
+
+        if(!pvt.atExit) {
+            if(pvt.bufSize - pvt.log->pos < 1u + nchar + 1u) {
+                pvt.nLost++;
+                pvt.totalLost++;
+                epicsMutexUnlock(pvt.msgQueueLock);
+                fmt->busy = 0;
+                return 0;
+            }
+            start = pvt.log->base + pvt.log->pos;
+            memcpy(start + 1u, buf, nchar + 1u);
+        }
     }
 
-    start[1u + nchar] = '\0';
+    wasEmpty = pvt.log->pos==0;
+    atExit = pvt.atExit;
 
     if(localEcho && isOkToBlock && atExit) {
         /* errlogThread is not running, so we print directly
          * and then abandon the buffer.
          */
-        fprintf(pvt.console, "%s", start);
+        fprintf(pvt.console, "%s", buf);
 
     } else if(!atExit) {
         start[0u] = ERL_STATE_READY | (localEcho ? ERL_LOCALECHO : 0);
 
         pvt.log->pos += 1u + nchar + 1u;
+        pvt.totalLogged++;
 
     } else {
         /* listeners will not see messages logged during errlog shutdown */
@@ -177,15 +283,181 @@ size_t msgbufCommit(size_t nchar, int localEcho)
 
     epicsMutexUnlock(pvt.msgQueueLock); /* matched in msgbufAlloc() */
 
+    if(formatted)
+        fmt->busy = 0;
+
     if(wasEmpty && !atExit)
         epicsEventMustTrigger(pvt.waitForWork);
 
-    if(localEcho && isOkToBlock && !atExit)
-        errlogFlush();
+    if(localEcho && isOkToBlock && !atExit) {
+        /* as errlogFlush(), without reporting suppressed repeats early */
+        errlogSequence();
+        errlogSequence();
+    }
 
     return nchar;
 }
 
+/* Log a summary of suppressed repeats over the time covered. */
+static
+void suppressReport(const char *sample, unsigned nSuppressed, epicsUInt64 covered)
+{
+    char *buf = msgbufAlloc();
+
+    if(buf) {
+        int nchar = epicsSnprintf(buf, pvt.maxMsgSize,
+            "errlog: %u repeats in %.3g sec suppressed of \"%s\"\n",
+            nSuppressed, covered * 1e-9, sample);
+        msgbufCommit(buf, nchar, pvt.toConsole);
+    }
+}
+
+/* Report suppressed repeats which are still pending, one at a time so
+ * suppressLock isn't held while logging.  Unless 'all' is set only those
+ * whose window has ended are reported, and their window is restarted.
+ * With 'all' the window is left running.
+ */
+static
+void suppressFlush(int all)
+{
+    while(pvt.suppressEnabled) {
+        epicsUInt64 now = epicsMonotonicGet();
+        suppressEntry report;
+        unsigned i;
+
+        report.nSuppressed = 0u;
+        epicsMutexMustLock(pvt.suppressLock);
+        for(i=0; i<SUPPRESS_TABLE_SIZE; i++) {
+            suppressEntry *entry = &pvt.suppress[i];
+            int expired;
+
+            if(!entry->format || !entry->nSuppressed)
+                continue;
+            expired = now - entry->windowStart >= pvt.suppressWindow[entry->cls];
+            if(!all && !expired)
+                continue;
+            report = *entry;
+            entry->nSuppressed = 0u;
+            entry->since = now;
+            if(expired) {
+                entry->windowStart = now;
+                entry->count = 0u;
+            }
+            break;
+        }
+        epicsMutexUnlock(pvt.suppressLock);
+
+        if(!report.nSuppressed)
+            break;
+        suppressReport(report.sample, report.nSuppressed, now - report.since);
+    }
+}
+
+/* How long errlogThread may sleep before suppressFlush() is due */
+static
+double suppressDelay(void)
+{
+    epicsUInt64 delay = 0u;
+    int cls;
+
+    epicsMutexMustLock(pvt.suppressLock);
+    for(cls=0; cls<SUPPRESS_NCLASS; cls++) {
+        if(pvt.suppressBurst[cls] && (!delay || pvt.suppressWindow[cls] < delay))
+            delay = pvt.suppressWindow[cls];
+    }
+    epicsMutexUnlock(pvt.suppressLock);
+    /* not too often for very short windows */
+    return delay < 10000000u ? 0.01 : delay * 1e-9;
+}
+
+/* Returns true if this message is a repeat which should be dropped */
+static
+int suppressCheck(const char *format, int cls)
+{
+    epicsUInt64 now, window;
+    unsigned hash, i, burst;
+    suppressEntry *entry = NULL;
+    suppressEntry report;
+    int drop;
+
+    if(epicsInterruptIsInterruptContext())
+        return 0; /* msgbufAlloc() complains */
+    errlogInit(0);
+    if(!pvt.suppressEnabled)
+        return 0;
+    /* Can't tell the callers of a generic format apart */
+    if(!format || format[0]=='\0' || !strcmp(format, "%s") || !strcmp(format, "%s\n"))
+        return 0;
+
+    report.nSuppressed = 0u;
+    now = epicsMonotonicGet();
+    hash = (unsigned)((size_t)format >> 3) * 31u + (unsigned)cls;
+
+    epicsMutexMustLock(pvt.suppressLock);
+
+    burst = pvt.suppressBurst[cls];
+    window = pvt.suppressWindow[cls];
+    if(!burst) {
+        epicsMutexUnlock(pvt.suppressLock);
+        return 0;
+    }
+
+    for(i=0; i<SUPPRESS_PROBE; i++) {
+        suppressEntry *slot = &pvt.suppress[(hash + i) % SUPPRESS_TABLE_SIZE];
+
+        if(slot->format==format && slot->cls==cls) {
+            entry = slot;
+            break;
+
+        } else if(!slot->format) {
+            if(!entry || entry->format)
+                entry = slot;
+
+        } else if(!entry || (entry->format && slot->windowStart < entry->windowStart)) {
+            /* oldest so far */
+            entry = slot;
+        }
+    }
+
+    if(entry->format!=format || entry->cls!=cls) {
+        if(entry->format) {
+            /* evict */
+            report = *entry;
+            pvt.suppressEvicted++;
+        }
+        memset(entry, 0, sizeof(*entry));
+        entry->format = format;
+        entry->cls = cls;
+        entry->windowStart = now;
+        entry->since = now;
+        strncpy(entry->sample, format, sizeof(entry->sample)-1u);
+        entry->sample[strcspn(entry->sample, "\n")] = '\0';
+
+    } else if(now - entry->windowStart >= window) {
+        /* window expired, report and start a new one */
+        report = *entry;
+        entry->windowStart = now;
+        entry->since = now;
+        entry->count = 0u;
+        entry->nSuppressed = 0u;
+    }
+
+    entry->totalSeen++;
+    drop = ++entry->count > burst;
+    if(drop) {
+        entry->nSuppressed++;
+        entry->totalSuppressed++;
+        pvt.totalSuppressed++;
+    }
+
+    epicsMutexUnlock(pvt.suppressLock);
+
+    if(report.nSuppressed)
+        suppressReport(report.sample, report.nSuppressed, now - report.since);
+
+    return drop;
+}
+
 static
 void errlogSequence(void)
 {
@@ -325,11 +597,16 @@ int errlogPrintf(const char *pFormat, ...)
 int errlogVprintf(const char *pFormat,va_list pvar)
 {
     int nchar = 0;
-    char *buf = msgbufAlloc();
+    char *buf;
+
+    if(suppressCheck(pFormat, SUPPRESS_NOSEVR))
+        return 0;
+
+    buf = msgbufAlloc();
 
     if(buf) {
         nchar = epicsVsnprintf(buf, pvt.maxMsgSize, pFormat, pvar);
-        nchar = msgbufCommit(nchar, pvt.toConsole);
+        nchar = msgbufCommit(buf, nchar, pvt.toConsole);
     }
     return nchar;
 }
@@ -353,11 +630,16 @@ int errlogPrintfNoConsole(const char *pFormat, ...)
 int errlogVprintfNoConsole(const char *pFormat, va_list pvar)
 {
     int nchar = 0;
-    char *buf = msgbufAlloc();
+    char *buf;
+
+    if(suppressCheck(pFormat, SUPPRESS_NOSEVR))
+        return 0;
+
+    buf = msgbufAlloc();
 
     if(buf) {
         nchar = epicsVsnprintf(buf, pvt.maxMsgSize, pFormat, pvar);
-        nchar = msgbufCommit(nchar, 0);
+        nchar = msgbufCommit(buf, nchar, 0);
     }
     return nchar;
 }
@@ -376,13 +658,18 @@ int errlogSevPrintf(errlogSevEnum severity, const char *pFormat, ...)
 int errlogSevVprintf(errlogSevEnum severity, const char *pFormat, va_list pvar)
 {
     int nchar = 0;
-    char *buf = msgbufAlloc();
+    char *buf;
+
+    if(severity <= errlogFatal && suppressCheck(pFormat, severity))
+        return 0;
+
+    buf = msgbufAlloc();
 
     if(buf) {
         nchar = sprintf(buf, "sevr=%s ", errlogGetSevEnumString(severity));
         if(nchar < pvt.maxMsgSize)
             nchar += epicsVsnprintf(buf + nchar, pvt.maxMsgSize - nchar, pFormat, pvar);
-        nchar = msgbufCommit(nchar, pvt.toConsole);
+        nchar = msgbufCommit(buf, nchar, pvt.toConsole);
     }
     return nchar;
 }
@@ -414,6 +701,79 @@ errlogSevEnum errlogGetSevToLog(void)
     return ret;
 }
 
+int errlogSetSuppress(int severity, double window, unsigned burst)
+{
+    int cls, enabled = 0;
+
+    errlogInit(0);
+    if(severity < errlogSevAll || severity > (int)errlogFatal || window < 0.0)
+        return -1;
+
+    epicsMutexMustLock(pvt.suppressLock);
+    for(cls=0; cls<SUPPRESS_NCLASS; cls++) {
+        if(severity==errlogSevAll || severity==cls
+                || (severity==errlogSevNone && cls==SUPPRESS_NOSEVR)) {
+            pvt.suppressBurst[cls] = burst;
+            pvt.suppressWindow[cls] = (epicsUInt64)(window * 1e9);
+        }
+        enabled |= pvt.suppressBurst[cls]!=0u;
+    }
+    if(!enabled) {
+        /* forget history */
+        memset(pvt.suppress, 0, sizeof(pvt.suppress));
+    }
+    pvt.suppressEnabled = enabled;
+    epicsMutexUnlock(pvt.suppressLock);
+    return 0;
+}
+
+void errlogSuppressShow(int level)
+{
+    static const char * const clsName[SUPPRESS_NCLASS] = {
+        "info", "minor", "major", "fatal", "none"
+    };
+    int cls;
+    unsigned i;
+
+    errlogInit(0);
+    epicsMutexMustLock(pvt.suppressLock);
+
+    printf("errlog repeat suppression %s, %zu messages suppressed, %zu evictions\n",
+           pvt.suppressEnabled ? "enabled" : "disabled",
+           pvt.totalSuppressed, pvt.suppressEvicted);
+    for(cls=0; cls<SUPPRESS_NCLASS; cls++) {
+        if(pvt.suppressBurst[cls])
+            printf("  sevr=%-5s  %u per %.3f sec\n", clsName[cls],
+                   pvt.suppressBurst[cls], pvt.suppressWindow[cls] * 1e-9);
+    }
+
+    if(level > 0) {
+        printf("  sevr   seen       suppressed  pending  format\n");
+        for(i=0; i<SUPPRESS_TABLE_SIZE; i++) {
+            const suppressEntry *entry = &pvt.suppress[i];
+
+            if(!entry->format || (level < 2 && !entry->totalSuppressed))
+                continue;
+            printf("  %-5s  %-9zu  %-10zu  %-7u  \"%s\"\n", clsName[entry->cls],
+                   entry->totalSeen, entry->totalSuppressed,
+                   entry->nSuppressed, entry->sample);
+        }
+    }
+
+    epicsMutexUnlock(pvt.suppressLock);
+}
+
+void errlogGetCounts(size_t *pnLogged, size_t *pnLost)
+{
+    errlogInit(0);
+    epicsMutexMustLock(pvt.msgQueueLock);
+    if(pnLogged)
+        *pnLogged = pvt.totalLogged;
+    if(pnLost)
+        *pnLost = pvt.totalLost;
+    epicsMutexUnlock(pvt.msgQueueLock);
+}
+
 void errlogAddListener(errlogListener listener, void *pPrivate)
 {
     listenerNode *plistenerNode;
@@ -489,7 +849,12 @@ void errPrintf(long status, const char *pFileName, int lineno,
 {
     va_list pvar;
     int     nchar = 0;
-    char *buf = msgbufAlloc();
+    char *buf;
+
+    if(suppressCheck(pformat, SUPPRESS_NOSEVR))
+        return;
+
+    buf = msgbufAlloc();
 
     va_start(pvar, pformat);
 
@@ -504,7 +869,7 @@ void errPrintf(long status, const char *pFileName, int lineno,
                               name, status ? " " : "", pFileName, lineno);
         if(nchar < pvt.maxMsgSize)
             nchar += epicsVsnprintf(buf + nchar, pvt.maxMsgSize - nchar, pformat, pvar);
-        msgbufCommit(nchar, pvt.toConsole);
+        msgbufCommit(buf, nchar, pvt.toConsole);
     }
 
     va_end(pvar);
@@ -520,6 +885,8 @@ void errPrintf(long status, const char *pFileName, int lineno,
 static void errlogExitHandler(void *raw)
 {
     epicsThreadId tid = raw;
+    /* queued for errlogThread, which empties the buffer before it stops */
+    suppressFlush(1);
     epicsMutexMustLock(pvt.msgQueueLock);
     pvt.atExit = 1;
     epicsMutexUnlock(pvt.msgQueueLock);
@@ -557,6 +924,8 @@ static void errlogInitPvt(void *arg)
     pvt.listenerLock = epicsMutexCreate();
     pvt.msgQueueLock = epicsMutexCreate();
     pvt.waitForSeq = epicsEventCreate(epicsEventEmpty);
+    pvt.fmtBuf = epicsThreadPrivateCreate();
+    pvt.suppressLock = epicsMutexCreate();
     pvt.log = &pvt.bufs[0];
     pvt.print = &pvt.bufs[1];
     pvt.log->base = calloc(1, pvt.bufSize);
@@ -568,6 +937,8 @@ static void errlogInitPvt(void *arg)
             && pvt.listenerLock
             && pvt.msgQueueLock
             && pvt.waitForSeq
+            && pvt.fmtBuf
+            && pvt.suppressLock
             && pvt.log->base
             && pvt.print->base
             ) {
@@ -617,6 +988,7 @@ void errlogFlush(void)
      * logged message have been seen/sent.
      */
     errlogInit(0);
+    suppressFlush(1);
     errlogSequence();
     errlogSequence();
 }
@@ -635,7 +1007,13 @@ static void errlogThread(void)
             epicsMutexUnlock(pvt.msgQueueLock);
             if(wakeFlusher)
                 epicsEventMustTrigger(pvt.waitForSeq);
-            epicsEventMustWait(pvt.waitForWork);
+            if(pvt.suppressEnabled) {
+                /* report repeats which stopped before their window ended */
+                (void)epicsEventWaitWithTimeout(pvt.waitForWork, suppressDelay());
+                suppressFlush(0);
+            } else {
+                epicsEventMustWait(pvt.waitForWork);
+            }
             epicsMutexMustLock(pvt.msgQueueLock);
 
         } else {
@@ -166,6 +166,58 @@ LIBCOM_API void errlogSetSevToLog(errlogSevEnum severity);
  */
 LIBCOM_API errlogSevEnum errlogGetSevToLog(void);
 
+/** Pseudo-severity for ::errlogSetSuppress meaning messages logged without a severity */
+#define errlogSevNone (-1)
+/** Pseudo-severity for ::errlogSetSuppress meaning all messages */
+#define errlogSevAll (-2)
+
+/**
+ * Configure suppression of repeated messages.
+ *
+ * Repeats are recognized by the format string passed to the logging routine,
+ * so each call site is counted separately. After \p burst messages from one
+ * call site within \p window seconds, further messages from that site are
+ * discarded until the window ends. A line giving the number of repeats that
+ * were suppressed is logged when the window ends, and by errlogFlush() and
+ * at exit for a window that hasn't ended yet.
+ * Messages logged with a generic format of just \c "%s" can't be told apart
+ * and are never suppressed.
+ *
+ * Suppression is disabled by default.
+ *
+ * \param severity One of ::errlogSevEnum to configure messages logged with
+ *        that severity, ::errlogSevNone for messages logged without one,
+ *        or ::errlogSevAll for all messages.
+ * \param window Length of the counting window in seconds
+ * \param burst Messages allowed per window, 0 disables suppression
+ * \return 0, or -1 if an argument is invalid
+ *
+ * \since UNRELEASED
+ */
+LIBCOM_API int errlogSetSuppress(int severity, double window, unsigned burst);
+
+/**
+ * Print repeat suppression settings and statistics.
+ *
+ * \param level 0 for totals, 1 adds each call site with suppressed messages,
+ *        2 adds all call sites being tracked.
+ *
+ * \since UNRELEASED
+ */
+LIBCOM_API void errlogSuppressShow(int level);
+
+/**
+ * Fetch running totals of messages queued for the errlog task, and of
+ * messages discarded because the buffer was full when they were logged.
+ * Lost messages are also reported on the console as they are detected.
+ *
+ * \param pnLogged Receives the number of messages queued, may be NULL
+ * \param pnLost Receives the number of messages lost, may be NULL
+ *
+ * \since UNRELEASED
+ */
+LIBCOM_API void errlogGetCounts(size_t *pnLogged, size_t *pnLost);
+
 /**
  * Any code can receive errlog message. This function will add a listener callback.
  *
@@ -220,7 +272,8 @@ LIBCOM_API int errlogInit(int bufsize);
  */
 LIBCOM_API int errlogInit2(int bufsize, int maxMsgSize);
 
-/** Wakes up the errlog task and then waits until all messages are flushed from the queue. */
+/** Wakes up the errlog task and then waits until all messages are flushed from the queue.
+ * Any pending count of suppressed repeats is logged first, see errlogSetSuppress(). */
 LIBCOM_API void errlogFlush(void);
 
 /**
@@ -10,7 +10,9 @@
 \*************************************************************************/
 
 #include <stdlib.h>
+#include <string.h>
 
+#include "dbDefs.h"
 #include "iocsh.h"
 #include "asLib.h"
 #include "epicsStdioRedirect.h"
@@ -286,6 +288,59 @@ static void errlogInit2CallFunc(const iocshArgBuf *args)
     errlogInit2(args[0].ival, args[1].ival);
 }
 
+/* errlogSuppress */
+static const iocshArg errlogSuppressArg0 = { "window",iocshArgDouble};
+static const iocshArg errlogSuppressArg1 = { "burst",iocshArgInt};
+static const iocshArg errlogSuppressArg2 = { "severity",iocshArgString};
+static const iocshArg * const errlogSuppressArgs[] =
+    {&errlogSuppressArg0, &errlogSuppressArg1, &errlogSuppressArg2};
+static const iocshFuncDef errlogSuppressFuncDef = {
+    "errlogSuppress", 3, errlogSuppressArgs,
+    "Limit repeats of the same error log message\n"
+    "  window   - counting period in seconds\n"
+    "  burst    - messages from one call site allowed per window, 0 to disable\n"
+    "  severity - info, minor, major, fatal, none (no severity) or all (default)\n"
+    "Example: errlogSuppress 10 5\n"
+};
+static void errlogSuppressCallFunc(const iocshArgBuf *args)
+{
+    static const char * const names[] = {"info", "minor", "major", "fatal"};
+    const char *sevr = args[2].sval;
+    int severity = errlogSevAll;
+
+    if (sevr && *sevr && strcmp(sevr, "all")) {
+        if (!strcmp(sevr, "none")) {
+            severity = errlogSevNone;
+        } else {
+            for (severity = 0; severity < (int)NELEMENTS(names); severity++)
+                if (!strcmp(sevr, names[severity]))
+                    break;
+            if (severity == (int)NELEMENTS(names)) {
+                fprintf(stderr, "errlogSuppress: unknown severity '%s'\n", sevr);
+                iocshSetError(1);
+                return;
+            }
+        }
+    }
+    if (args[1].ival < 0 || errlogSetSuppress(severity, args[0].dval, args[1].ival)) {
+        fprintf(stderr, "errlogSuppress: invalid arguments\n");
+        iocshSetError(1);
+    }
+}
+
+/* errlogSuppressShow */
+static const iocshArg errlogSuppressShowArg0 = { "level",iocshArgInt};
+static const iocshArg * const errlogSuppressShowArgs[] = {&errlogSuppressShowArg0};
+static const iocshFuncDef errlogSuppressShowFuncDef = {
+    "errlogSuppressShow", 1, errlogSuppressShowArgs,
+    "Show error log repeat suppression settings and statistics\n"
+    "  level - 0 totals, 1 call sites with suppressed messages, 2 all call sites\n"
+};
+static void errlogSuppressShowCallFunc(const iocshArgBuf *args)
+{
+    errlogSuppressShow(args[0].ival);
+}
+
 /* errlog */
 IOCSH_STATIC_FUNC void errlog(const char *message)
 {
@@ -499,6 +554,8 @@ void epicsStdCall libComRegister(void)
     iocshRegister(&errlogInitFuncDef,errlogInitCallFunc);
     iocshRegister(&errlogInit2FuncDef,errlogInit2CallFunc);
     iocshRegister(&errlogFuncDef, errlogCallFunc);
+    iocshRegister(&errlogSuppressFuncDef, errlogSuppressCallFunc);
+    iocshRegister(&errlogSuppressShowFuncDef, errlogSuppressShowCallFunc);
     iocshRegister(&iocLogPrefixFuncDef, iocLogPrefixCallFunc);
 
     iocshRegister(&epicsThreadShowAllFuncDef,epicsThreadShowAllCallFunc);
@@ -27,26 +27,53 @@
 #ifdef UNIX
 #include    <unistd.h>
 #include    <signal.h>
+#include    <sys/resource.h>
+#endif
+
+#ifdef __linux__
+#include    <sys/epoll.h>
+#define     USE_EPOLL
 #endif
 
 #include    "dbDefs.h"
 #include    "epicsAssert.h"
+#include    "epicsEvent.h"
+#include    "epicsMutex.h"
+#include    "epicsThread.h"
 #include    "fdmgr.h"
 #include    "envDefs.h"
 #include    "osiSock.h"
 #include    "epicsStdio.h"
+#include    "logClient.h"
+#include    "logDeframe.h"
 
 static unsigned short ioc_log_port;
 static long ioc_log_file_limit;
+static long ioc_log_file_rotate;
 static char ioc_log_file_name[512];
 static char ioc_log_file_command[256];
 
 
+/*
+ * Lines are queued in memory and written to the file in large blocks
+ * by a separate thread, so a slow disk doesn't stall the event loop.
+ */
+#define WRITE_BUF_SIZE      (1024u * 1024u)
+#define WRITE_BEHIND_DELAY  0.2 /* sec */
+#define MAX_EVENTS          256
+
+struct ioHandler {
+    void (*pfunc)(void *pParam);
+    void *pParam;
+};
+
 struct iocLogClient {
     SOCKET insock;
     struct ioc_log_server *pserver;
+    struct ioHandler reader;
     size_t nChar;
-    char recvbuf[1024];
+    logDeframeState deframe;
+    char recvbuf[4096];
     char name[32];
     char ascii_time[32];
 };
@@ -55,9 +82,25 @@ struct ioc_log_server {
     char outfile[256];
     long filePos;
     FILE *poutfile;
+#ifdef USE_EPOLL
+    int epfd;
+#else
     void *pfdctx;
+#endif
     SOCKET sock;
     long max_file_size;
+    long rotate;
+    struct ioHandler acceptor;
+#ifdef UNIX
+    struct ioHandler sighup;
+#endif
+    epicsMutexId fileLock;      /* held while using poutfile */
+    epicsMutexId bufLock;       /* protects pending and nPending */
+    epicsEventId wakeWriter;
+    epicsEventId bufDrained;
+    char *pending;              /* lines waiting for the writer */
+    size_t nPending;
+    char *writing;              /* lines being written */
 };
 
 #define IOCLS_ERROR (-1)
@@ -72,6 +115,18 @@ static void handleLogFileError(void);
 static void envFailureNotify(const ENV_PARAM *pparam);
 static void freeLogClient(struct iocLogClient *pclient);
 static void writeMessagesToLog (struct iocLogClient *pclient);
+static void queueLogLine (struct iocLogClient *pclient,
+    const char *pText, size_t nchar);
+static int startLogWriter (struct ioc_log_server *pserver);
+static void logWriter (void *pParam);
+static void writeToLogFile (struct ioc_log_server *pserver,
+    const char *pBuf, size_t nBuf);
+static int addReadHandler (struct ioc_log_server *pserver, SOCKET fd,
+    struct ioHandler *pHandler);
+static int clearReadHandler (struct ioc_log_server *pserver, SOCKET fd);
+static void pendEvents (struct ioc_log_server *pserver, double timeout);
+static void deframedText (void *pParam, const char *pText, size_t nText,
+    int endOfMessage);
 
 #ifdef UNIX
 static int setupSIGHUP(struct ioc_log_server *);
@@ -91,7 +146,6 @@ static int sighupPipe[2];
 int main(void)
 {
     struct sockaddr_in serverAddr;  /* server's address */
-    struct timeval timeout;
     int status;
     struct ioc_log_server *pserver;
 
@@ -111,13 +165,32 @@ int main(void)
         return IOCLS_ERROR;
     }
 
+#ifdef USE_EPOLL
+    pserver->epfd = epoll_create(MAX_EVENTS);
+    if (pserver->epfd < 0) {
+#else
     pserver->pfdctx = (void *) fdmgr_init();
     if (!pserver->pfdctx) {
+#endif
         fprintf(stderr, "iocLogServer: %s\n", strerror(errno));
         free(pserver);
         return IOCLS_ERROR;
     }
 
+#   ifdef UNIX
+    {
+        /*
+         * a central log server may have thousands of clients
+         */
+        struct rlimit lim;
+
+        if (getrlimit(RLIMIT_NOFILE, &lim) == 0 && lim.rlim_cur < lim.rlim_max) {
+            lim.rlim_cur = lim.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &lim);
+        }
+    }
+#   endif
+
     /*
      * Open the socket. Use ARPA Internet address format and stream
      * sockets. Format described in <sys/socket.h>.
@@ -154,7 +227,7 @@ int main(void)
     }
 
     /* listen and accept new connections */
-    status = listen(pserver->sock, 10);
+    status = listen(pserver->sock, SOMAXCONN);
     if (status < 0) {
         char sockErrBuf[64];
         epicsSocketConvertErrnoToString ( sockErrBuf, sizeof ( sockErrBuf ) );
@@ -197,12 +270,17 @@ int main(void)
         return IOCLS_ERROR;
     }
 
-    status = fdmgr_add_callback(
-            pserver->pfdctx,
-            pserver->sock,
-            fdi_read,
-            acceptNewClient,
-            pserver);
+    status = startLogWriter(pserver);
+    if (status < 0) {
+        fprintf(stderr,
+            "iocLogServer: failed to start log file writer\n");
+        free(pserver);
+        return IOCLS_ERROR;
+    }
+
+    pserver->acceptor.pfunc = acceptNewClient;
+    pserver->acceptor.pParam = pserver;
+    status = addReadHandler(pserver, pserver->sock, &pserver->acceptor);
     if (status < 0) {
         fprintf(stderr,
             "iocLogServer: failed to add read callback\n");
@@ -212,10 +290,240 @@ int main(void)
 
 
     while (TRUE) {
-        timeout.tv_sec = 60; /* 1 min */
-        timeout.tv_usec = 0;
-        fdmgr_pend_event(pserver->pfdctx, &timeout);
-        fflush(pserver->poutfile);
+        pendEvents(pserver, 60.0); /* 1 min */
+    }
+}
+
+#ifdef USE_EPOLL
+/*
+ * addReadHandler()
+ */
+static int addReadHandler (struct ioc_log_server *pserver, SOCKET fd,
+    struct ioHandler *pHandler)
+{
+    struct epoll_event ev;
+
+    memset (&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = pHandler;
+    return epoll_ctl (pserver->epfd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+/*
+ * clearReadHandler()
+ */
+static int clearReadHandler (struct ioc_log_server *pserver, SOCKET fd)
+{
+    struct epoll_event ev; /* ignored, but must be non-NULL before 2.6.9 */
+
+    memset (&ev, 0, sizeof(ev));
+    return epoll_ctl (pserver->epfd, EPOLL_CTL_DEL, fd, &ev);
+}
+
+/*
+ * pendEvents()
+ *
+ * A handler may only free its own client, which can't appear again
+ * later in the same batch of events.
+ */
+static void pendEvents (struct ioc_log_server *pserver, double timeout)
+{
+    struct epoll_event events[MAX_EVENTS];
+    int i, n;
+
+    n = epoll_wait (pserver->epfd, events, MAX_EVENTS, (int) (timeout * 1000));
+    if (n < 0 && errno != EINTR) {
+        fprintf (stderr, "iocLogServer: epoll_wait error %s\n",
+            strerror(errno));
+        epicsThreadSleep (1.0);
+    }
+    for (i = 0; i < n; i++) {
+        struct ioHandler *pHandler = (struct ioHandler *) events[i].data.ptr;
+        (*pHandler->pfunc) (pHandler->pParam);
+    }
+}
+#else
+static int addReadHandler (struct ioc_log_server *pserver, SOCKET fd,
+    struct ioHandler *pHandler)
+{
+    return fdmgr_add_callback (pserver->pfdctx, fd, fdi_read,
+        pHandler->pfunc, pHandler->pParam);
+}
+
+static int clearReadHandler (struct ioc_log_server *pserver, SOCKET fd)
+{
+    return fdmgr_clear_callback (pserver->pfdctx, fd, fdi_read);
+}
+
+static void pendEvents (struct ioc_log_server *pserver, double timeout)
+{
+    struct timeval tmo;
+
+    tmo.tv_sec = (long) timeout;
+    tmo.tv_usec = (long) ((timeout - tmo.tv_sec) * 1e6);
+    fdmgr_pend_event (pserver->pfdctx, &tmo);
+}
+#endif
+
+/*
+ * startLogWriter()
+ */
+static int startLogWriter (struct ioc_log_server *pserver)
+{
+    pserver->fileLock = epicsMutexCreate ();
+    pserver->bufLock = epicsMutexCreate ();
+    pserver->wakeWriter = epicsEventCreate (epicsEventEmpty);
+    pserver->bufDrained = epicsEventCreate (epicsEventEmpty);
+    pserver->pending = malloc (WRITE_BUF_SIZE);
+    pserver->writing = malloc (WRITE_BUF_SIZE);
+    pserver->nPending = 0u;
+    if (!pserver->fileLock || !pserver->bufLock || !pserver->wakeWriter ||
+        !pserver->bufDrained || !pserver->pending || !pserver->writing) {
+        return IOCLS_ERROR;
+    }
+    if (!epicsThreadCreate ("logWriter", epicsThreadPriorityMedium,
+            epicsThreadGetStackSize (epicsThreadStackSmall),
+            logWriter, pserver)) {
+        return IOCLS_ERROR;
+    }
+    return IOCLS_OK;
+}
+
+/*
+ * logWriter()
+ *
+ * Swap the pending and writing buffers and write out the lines.
+ */
+static void logWriter (void *pParam)
+{
+    struct ioc_log_server *pserver = (struct ioc_log_server *) pParam;
+
+    while (TRUE) {
+        char *pBuf;
+        size_t nBuf;
+
+        epicsEventWaitWithTimeout (pserver->wakeWriter, WRITE_BEHIND_DELAY);
+
+        epicsMutexMustLock (pserver->bufLock);
+        pBuf = pserver->pending;
+        nBuf = pserver->nPending;
+        pserver->pending = pserver->writing;
+        pserver->nPending = 0u;
+        pserver->writing = pBuf;
+        epicsMutexUnlock (pserver->bufLock);
+
+        epicsEventSignal (pserver->bufDrained);
+
+        if (nBuf) {
+            epicsMutexMustLock (pserver->fileLock);
+            writeToLogFile (pserver, pBuf, nBuf);
+            if (fflush (pserver->poutfile) == EOF) {
+                handleLogFileError ();
+            }
+            epicsMutexUnlock (pserver->fileLock);
+        }
+    }
+}
+
+/*
+ * rotateLogFile()
+ *
+ * Rename name to name.1, name.1 to name.2 etc. keeping
+ * ioc_log_file_rotate old files, and start a new empty log.
+ */
+static void rotateLogFile (struct ioc_log_server *pserver)
+{
+    char from[sizeof(pserver->outfile) + 24];
+    char to[sizeof(pserver->outfile) + 24];
+    long i;
+
+    fclose (pserver->poutfile);
+    for (i = pserver->rotate - 1; i > 0; i--) {
+        sprintf (from, "%s.%ld", pserver->outfile, i);
+        sprintf (to, "%s.%ld", pserver->outfile, i + 1);
+        rename (from, to); /* may not exist yet */
+    }
+    sprintf (to, "%s.1", pserver->outfile);
+    if (rename (pserver->outfile, to) != 0) {
+        fprintf (stderr, "iocLogServer: unable to rename `%s' because `%s'\n",
+            pserver->outfile, strerror(errno));
+    }
+    pserver->poutfile = fopen (pserver->outfile, "w");
+    if (!pserver->poutfile) {
+        pserver->poutfile = stderr;
+        handleLogFileError ();
+    }
+    pserver->filePos = 0;
+}
+
+/*
+ * writeToLogFile()
+ *
+ * Write whole lines, wrapping to the start of the file or rotating
+ * it when the size limit would be reached.
+ */
+static void writeToLogFile (struct ioc_log_server *pserver,
+    const char *pBuf, size_t nBuf)
+{
+    while (nBuf > 0u) {
+        size_t chunk = nBuf;
+
+        if (pserver->max_file_size && pserver->poutfile != stderr &&
+                pserver->filePos + (long) nBuf >= pserver->max_file_size) {
+            size_t room = 0u;
+            size_t i;
+
+            /* the longest run of lines which ends before the limit */
+            if (pserver->max_file_size > pserver->filePos) {
+                room = (size_t) (pserver->max_file_size - pserver->filePos);
+            }
+            chunk = 0u;
+            for (i = 0u; i + 1u < room && i < nBuf; i++) {
+                if (pBuf[i] == '\n') {
+                    chunk = i + 1u;
+                }
+            }
+
+            if (chunk == 0u && pserver->filePos == 0) {
+                /* a line longer than the limit */
+                const char *pEnd = memchr (pBuf, '\n', nBuf);
+                chunk = pEnd ? (size_t) (pEnd - pBuf) + 1u : nBuf;
+            }
+            else if (chunk == 0u) {
+                if (pserver->rotate > 0) {
+                    rotateLogFile (pserver);
+                    continue;
+                }
+                if (pserver->max_file_size >= pserver->filePos) {
+                    long nPadChar;
+                    /*
+                     * this gets rid of leftover junk at the end of the file
+                     */
+                    nPadChar = pserver->max_file_size - pserver->filePos;
+                    while (nPadChar--) {
+                        if (putc (' ', pserver->poutfile) == EOF) {
+                            handleLogFileError();
+                        }
+                    }
+                }
+
+#               ifdef DEBUG
+                    fprintf ( stderr,
+                        "ioc log server: resetting the file pointer\n" );
+#               endif
+                fflush ( pserver->poutfile );
+                rewind ( pserver->poutfile );
+                pserver->filePos = ftell ( pserver->poutfile );
+                continue;
+            }
+        }
+
+        if (fwrite (pBuf, 1, chunk, pserver->poutfile) != chunk) {
+            handleLogFileError();
+        }
+        pserver->filePos += (long) chunk;
+        pBuf += chunk;
+        nBuf -= chunk;
     }
 }
 
@@ -361,13 +669,15 @@ static int openLogFile (struct ioc_log_server *pserver)
 
     pserver->poutfile = fopen(ioc_log_file_name, "r+");
     if (pserver->poutfile) {
-        fclose (pserver->poutfile);
-        pserver->poutfile = NULL;
-        ret = truncateFile (ioc_log_file_name, ioc_log_file_limit);
-        if (ret==TF_ERROR) {
-            return IOCLS_ERROR;
+        if (ioc_log_file_rotate <= 0) {
+            fclose (pserver->poutfile);
+            pserver->poutfile = NULL;
+            ret = truncateFile (ioc_log_file_name, ioc_log_file_limit);
+            if (ret==TF_ERROR) {
+                return IOCLS_ERROR;
+            }
+            pserver->poutfile = fopen(ioc_log_file_name, "r+");
         }
-        pserver->poutfile = fopen(ioc_log_file_name, "r+");
     }
     else {
         pserver->poutfile = fopen(ioc_log_file_name, "w");
@@ -379,6 +689,20 @@ static int openLogFile (struct ioc_log_server *pserver)
     }
     strcpy (pserver->outfile, ioc_log_file_name);
     pserver->max_file_size = ioc_log_file_limit;
+    pserver->rotate = ioc_log_file_rotate;
+
+    if (pserver->rotate > 0) {
+        /*
+         * append, the writer rotates the file when it's full
+         */
+        if (fseek (pserver->poutfile, 0L, SEEK_END) != 0) {
+            fclose (pserver->poutfile);
+            pserver->poutfile = stderr;
+            return IOCLS_ERROR;
+        }
+        pserver->filePos = ftell (pserver->poutfile);
+        return IOCLS_OK;
+    }
 
     return seekLatestLine (pserver);
 }
@@ -459,6 +783,7 @@ static void acceptNewClient ( void *pParam )
 
     pclient->pserver = pserver;
     pclient->nChar = 0u;
+    logDeframeInit (&pclient->deframe);
 
     ipAddrToA (&addr, pclient->name, sizeof(pclient->name));
 
@@ -505,16 +830,13 @@ static void acceptNewClient ( void *pParam )
         return;
     }
 
-    status = fdmgr_add_callback(
-            pserver->pfdctx,
-            pclient->insock,
-            fdi_read,
-            readFromClient,
-            pclient);
+    pclient->reader.pfunc = readFromClient;
+    pclient->reader.pParam = pclient;
+    status = addReadHandler (pserver, pclient->insock, &pclient->reader);
     if (status<0) {
         epicsSocketDestroy ( pclient->insock );
         free(pclient);
-        fprintf(stderr, "%s:%d client fdmgr_add_callback() failed\n",
+        fprintf(stderr, "%s:%d client addReadHandler() failed\n",
             __FILE__, __LINE__);
         return;
     }
@@ -534,11 +856,22 @@ static void readFromClient(void *pParam)
     int                 recvLength;
     int                 size;
 
+    char                raw[sizeof(pclient->recvbuf)];
+    char                *pRecv;
+
     logTime(pclient);
 
-    size = (int) (sizeof(pclient->recvbuf) - pclient->nChar);
+    /* framed streams are received aside and unpacked into recvbuf */
+    if (pclient->deframe.framed) {
+        pRecv = raw;
+        size = (int) sizeof(raw);
+    }
+    else {
+        pRecv = &pclient->recvbuf[pclient->nChar];
+        size = (int) (sizeof(pclient->recvbuf) - pclient->nChar);
+    }
     recvLength = recv(pclient->insock,
-              &pclient->recvbuf[pclient->nChar],
+              pRecv,
               size,
               0);
     if (recvLength <= 0) {
@@ -567,24 +900,66 @@ static void readFromClient(void *pParam)
         return;
     }
 
-    pclient->nChar += (size_t) recvLength;
+    if (pclient->deframe.framed) {
+        logDeframe (&pclient->deframe, raw, (size_t) recvLength,
+            deframedText, pclient);
+    }
+    else {
+        pclient->nChar += (size_t) recvLength;
+    }
 
     writeMessagesToLog (pclient);
 }
 
+/*
+ * deframedText()
+ *
+ * Copy text unpacked by logDeframe() into recvbuf, writing out lines
+ * as it fills, and end each framed message with a carrage return.
+ */
+static void deframedText (void *pParam, const char *pText, size_t nText,
+    int endOfMessage)
+{
+    struct iocLogClient *pclient = (struct iocLogClient *) pParam;
+
+    while (nText > 0u) {
+        size_t n = sizeof(pclient->recvbuf) - pclient->nChar;
+
+        /* a full buffer is forced out with an artificial carrage return */
+        if (n == 0u) {
+            writeMessagesToLog (pclient);
+            continue;
+        }
+        if (n > nText) {
+            n = nText;
+        }
+        memcpy (&pclient->recvbuf[pclient->nChar], pText, n);
+        pclient->nChar += n;
+        pText += n;
+        nText -= n;
+    }
+
+    if (endOfMessage) {
+        if (pclient->nChar >= sizeof(pclient->recvbuf)) {
+            writeMessagesToLog (pclient);
+        }
+        if (pclient->nChar > 0u &&
+                pclient->recvbuf[pclient->nChar - 1u] != '\n') {
+            pclient->recvbuf[pclient->nChar++] = '\n';
+        }
+    }
+}
+
 /*
  * writeMessagesToLog()
  */
 static void writeMessagesToLog (struct iocLogClient *pclient)
 {
-    int status;
     size_t lineIndex = 0;
 
     while (TRUE) {
         size_t nchar;
-        size_t nTotChar;
         size_t crIndex;
-        int ntci;
 
         if ( lineIndex >= pclient->nChar ) {
             pclient->nChar = 0u;
@@ -622,63 +997,62 @@ static void writeMessagesToLog (struct iocLogClient *pclient)
             }
         }
 
-        /*
-         * reset the file pointer if we hit the end of the file
-         */
-        nTotChar = strlen(pclient->name) +
-                strlen(pclient->ascii_time) + nchar + 3u;
-        assert (nTotChar <= INT_MAX);
-        ntci = (int) nTotChar;
-        if ( pclient->pserver->max_file_size && pclient->pserver->filePos+ntci >= pclient->pserver->max_file_size ) {
-            if ( pclient->pserver->max_file_size >= pclient->pserver->filePos ) {
-                unsigned nPadChar;
-                /*
-                 * this gets rid of leftover junk at the end of the file
-                 */
-                nPadChar = pclient->pserver->max_file_size - pclient->pserver->filePos;
-                while (nPadChar--) {
-                    status = putc ( ' ', pclient->pserver->poutfile );
-                    if ( status == EOF ) {
-                        handleLogFileError();
-                    }
-                }
-            }
-
-#           ifdef DEBUG
-                fprintf ( stderr,
-                    "ioc log server: resetting the file pointer\n" );
-#           endif
-            fflush ( pclient->pserver->poutfile );
-            rewind ( pclient->pserver->poutfile );
-            pclient->pserver->filePos = ftell ( pclient->pserver->poutfile );
-        }
-
-        /*
-         * NOTE: !! change format string here then must
-         * change nTotChar calc above !!
-         */
-        assert (nchar<INT_MAX);
-        status = fprintf(
-            pclient->pserver->poutfile,
-            "%s %s %.*s\n",
-            pclient->name,
-            pclient->ascii_time,
-            (int) nchar,
-            &pclient->recvbuf[lineIndex]);
-        if (status<0) {
-            handleLogFileError();
-        }
-        else {
-            if (status != ntci) {
-                fprintf(stderr, "iocLogServer: didnt calculate number of characters correctly?\n");
-            }
-            pclient->pserver->filePos += status;
-        }
+        queueLogLine (pclient, &pclient->recvbuf[lineIndex], nchar);
         lineIndex += nchar+1u;
     }
 }
 
 
+/*
+ * queueLogLine()
+ *
+ * Queue one line for the writer thread, waiting for it if the
+ * buffer is full.
+ */
+static void queueLogLine (struct iocLogClient *pclient,
+    const char *pText, size_t nchar)
+{
+    struct ioc_log_server *pserver = pclient->pserver;
+    size_t nName = strlen (pclient->name);
+    size_t nTime = strlen (pclient->ascii_time);
+    size_t nTotChar = nName + nTime + nchar + 3u;
+    int wakeWriter;
+    char *p;
+
+    assert (nTotChar <= WRITE_BUF_SIZE);
+
+    epicsMutexMustLock (pserver->bufLock);
+    while (pserver->nPending + nTotChar > WRITE_BUF_SIZE) {
+        epicsMutexUnlock (pserver->bufLock);
+        epicsEventSignal (pserver->wakeWriter);
+        epicsEventMustWait (pserver->bufDrained);
+        epicsMutexMustLock (pserver->bufLock);
+    }
+
+    /*
+     * format is "<name> <time> <message>\n"
+     */
+    p = &pserver->pending[pserver->nPending];
+    memcpy (p, pclient->name, nName);
+    p += nName;
+    *p++ = ' ';
+    memcpy (p, pclient->ascii_time, nTime);
+    p += nTime;
+    *p++ = ' ';
+    memcpy (p, pText, nchar);
+    p += nchar;
+    *p = '\n';
+    pserver->nPending += nTotChar;
+    wakeWriter = pserver->nPending >= WRITE_BUF_SIZE / 2u;
+
+    epicsMutexUnlock (pserver->bufLock);
+
+    if (wakeWriter) {
+        epicsEventSignal (pserver->wakeWriter);
+    }
+}
+
+
 /*
  * freeLogClient ()
  */
@@ -699,12 +1073,9 @@ static void freeLogClient(struct iocLogClient     *pclient)
         writeMessagesToLog (pclient);
     }
 
-    status = fdmgr_clear_callback(
-               pclient->pserver->pfdctx,
-               pclient->insock,
-               fdi_read);
+    status = clearReadHandler (pclient->pserver, pclient->insock);
     if (status!=IOCLS_OK) {
-        fprintf(stderr, "%s:%d fdmgr_clear_callback() failed\n",
+        fprintf(stderr, "%s:%d clearReadHandler() failed\n",
             __FILE__, __LINE__);
     }
 
@@ -774,6 +1145,13 @@ static int getConfig(void)
         ioc_log_file_limit = 10000;
     }
 
+    status = envGetLongConfigParam(
+            &EPICS_IOC_LOG_FILE_ROTATE,
+            &ioc_log_file_rotate);
+    if(status<0 || ioc_log_file_rotate < 0){
+        ioc_log_file_rotate = 0;
+    }
+
     pstring = envGetConfigParam(
             &EPICS_IOC_LOG_FILE_NAME,
             sizeof ioc_log_file_name,
@@ -843,12 +1221,9 @@ static int setupSIGHUP(struct ioc_log_server *pserver)
                 return IOCLS_ERROR;
         }
 
-    status = fdmgr_add_callback(
-            pserver->pfdctx,
-            sighupPipe[0],
-            fdi_read,
-            serviceSighupRequest,
-            pserver);
+    pserver->sighup.pfunc = serviceSighupRequest;
+    pserver->sighup.pParam = pserver;
+    status = addReadHandler(pserver, sighupPipe[0], &pserver->sighup);
     if(status<0){
         fprintf(stderr,
             "iocLogServer: failed to add SIGHUP callback\n");
@@ -906,6 +1281,7 @@ static void serviceSighupRequest(void *pParam)
     /*
      * Try (re)opening the file.
      */
+    epicsMutexMustLock (pserver->fileLock);
     status = openLogFile(pserver);
     if(status<0){
         fprintf(stderr,
@@ -920,6 +1296,7 @@ static void serviceSighupRequest(void *pParam)
                 "File access problems to `%s' because `%s'\n",
                 ioc_log_file_name,
                 strerror(errno));
+            epicsMutexUnlock (pserver->fileLock);
             return;
         }
         else {
@@ -933,6 +1310,7 @@ static void serviceSighupRequest(void *pParam)
             "iocLogServer: opened new log file %s\n",
             ioc_log_file_name);
     }
+    epicsMutexUnlock (pserver->fileLock);
 }
 
 
@@ -32,33 +32,51 @@
 #include "epicsAssert.h"
 #include "epicsExit.h"
 #include "epicsSignal.h"
+#include "envDefs.h"
 #include "epicsExport.h"
 
 #include "logClient.h"
 
+#if defined(__unix__) || defined(__APPLE__)
+#   include <sys/uio.h>
+#   define USE_WRITEV
+#endif
+
 int logClientDebug = 0;
 epicsExportAddress (int, logClientDebug);
 
 typedef struct {
-    char                msgBuf[0x4000];
+    char                *msgBuf;        /* ring of queued bytes */
+    size_t              msgBufSize;
+    size_t              head;           /* index of oldest queued byte */
+    size_t              nQueued;        /* bytes queued, including backlog */
+    size_t              maxQueued;      /* high water mark of nQueued */
+    size_t              frameRemaining; /* bytes of the frame at head */
+    epicsUInt64         nEnqueued;      /* total bytes queued */
+    epicsUInt64         nDequeued;      /* total bytes handed to TCP */
+    unsigned            nMessages;      /* messages queued */
+    unsigned            nDropped;       /* messages dropped when full */
+    unsigned            nDropNotice;    /* drops not yet reported to server */
     struct sockaddr_in  addr;
     char                name[64];
     epicsMutexId        mutex;
     SOCKET              sock;
     epicsThreadId       restartThreadId;
     epicsEventId        stateChangeNotify;
-    epicsEventId        shutdownNotify;
+    epicsEventId        sendNotify;
+    epicsEventId        flushNotify;
     unsigned            connectCount;
-    unsigned            nextMsgIndex;
     unsigned            backlog;
     unsigned            connected;
     unsigned            shutdown;
     unsigned            shutdownConfirm;
+    unsigned            framed;
     int                 connFailStatus;
 } logClient;
 
 static const double      LOG_RESTART_DELAY = 5.0; /* sec */
 static const double      LOG_SERVER_SHUTDOWN_TIMEOUT = 30.0; /* sec */
+static const size_t      LOG_MIN_QUEUE_SIZE = 0x4000; /* bytes */
 
 /*
  * If set using iocLogPrefix() this string is prepended to all log messages:
@@ -95,6 +113,8 @@ static void logClientClose ( logClient *pClient )
      */
     epicsMutexUnlock (pClient->mutex);
 
+    epicsEventSignal ( pClient->flushNotify );
+
     if (logClientDebug)
         fprintf (stderr, "done\n");
 }
@@ -114,7 +134,7 @@ static void logClientDestroy (logClientId id)
     epicsMutexMustLock ( pClient->mutex );
     pClient->shutdown = 1u;
     epicsMutexUnlock ( pClient->mutex );
-    epicsEventSignal ( pClient->shutdownNotify );
+    epicsEventSignal ( pClient->sendNotify );
 
     /* unblock log client thread blocking in send() or connect() */
     interruptInfo =
@@ -160,48 +180,105 @@ static void logClientDestroy (logClientId id)
 
     epicsMutexDestroy ( pClient->mutex );
     epicsEventDestroy ( pClient->stateChangeNotify );
-    epicsEventDestroy ( pClient->shutdownNotify );
+    epicsEventDestroy ( pClient->sendNotify );
+    epicsEventDestroy ( pClient->flushNotify );
 
+    free ( pClient->msgBuf );
     free ( pClient );
 }
 
 /*
+ * Copy bytes into the ring at the tail.
  * This method requires the pClient->mutex be owned already.
  */
-static void sendMessageChunk(logClient * pClient, const char * message) {
-    unsigned strSize;
+static void queueBytes ( logClient * pClient, const void * pData, size_t len )
+{
+    size_t tail = ( pClient->head + pClient->nQueued ) % pClient->msgBufSize;
+    size_t first = pClient->msgBufSize - tail;
+
+    if ( first > len ) first = len;
+    memcpy ( & pClient->msgBuf[tail], pData, first );
+    memcpy ( pClient->msgBuf, ( const char * ) pData + first, len - first );
+    pClient->nQueued += len;
+    pClient->nEnqueued += len;
+}
 
-    strSize = strlen ( message );
-    while ( strSize ) {
-        unsigned msgBufBytesLeft =
-            sizeof ( pClient->msgBuf ) - pClient->nextMsgIndex;
+/*
+ * Queue one message, which is dropped if the ring can't hold all of it.
+ * This method requires the pClient->mutex be owned already.
+ */
+static int queueMessage ( logClient * pClient,
+    const char * prefix, const char * message )
+{
+    size_t prefixLen = prefix ? strlen ( prefix ) : 0u;
+    size_t msgLen = strlen ( message );
+    size_t len = prefixLen + msgLen;
+    size_t total = len + ( pClient->framed ? 4u : 0u );
+
+    if ( total > pClient->msgBufSize - pClient->nQueued ) {
+        return -1;
+    }
+    if ( pClient->framed ) {
+        unsigned char hdr[4];
+        hdr[0] = ( unsigned char ) ( len >> 24 );
+        hdr[1] = ( unsigned char ) ( len >> 16 );
+        hdr[2] = ( unsigned char ) ( len >> 8 );
+        hdr[3] = ( unsigned char ) len;
+        queueBytes ( pClient, hdr, sizeof ( hdr ) );
+    }
+    queueBytes ( pClient, prefix, prefixLen );
+    queueBytes ( pClient, message, msgLen );
+    if ( pClient->nQueued > pClient->maxQueued ) {
+        pClient->maxQueued = pClient->nQueued;
+    }
+    pClient->nMessages++;
+    return 0;
+}
 
-        if ( msgBufBytesLeft < strSize && pClient->nextMsgIndex != 0u && pClient->connected)
-        {
-            /* buffer is full, thus flush it */
-            logClientFlush ( pClient );
-            msgBufBytesLeft = sizeof ( pClient->msgBuf ) - pClient->nextMsgIndex;
-        }
-        if ( msgBufBytesLeft == 0u ) {
-            fprintf ( stderr, "log client: messages to \"%s\" are lost\n",
-                pClient->name );
-            break;
+/*
+ * Release bytes at the head of the ring, keeping track of how much of
+ * the frame that head now points into is still to come.
+ * This method requires the pClient->mutex be owned already.
+ */
+static void dequeueBytes ( logClient * pClient, size_t len )
+{
+    while ( len > 0u ) {
+        size_t step = len;
+
+        if ( pClient->framed ) {
+            if ( pClient->frameRemaining == 0u ) {
+                unsigned char hdr[4];
+                size_t i;
+                for ( i = 0u; i < sizeof ( hdr ); i++ ) {
+                    hdr[i] = ( unsigned char ) pClient->msgBuf[
+                        ( pClient->head + i ) % pClient->msgBufSize];
+                }
+                pClient->frameRemaining = sizeof ( hdr ) +
+                    ( ( size_t ) hdr[0] << 24 | ( size_t ) hdr[1] << 16 |
+                      ( size_t ) hdr[2] << 8 | hdr[3] );
+            }
+            if ( step > pClient->frameRemaining ) {
+                step = pClient->frameRemaining;
+            }
+            pClient->frameRemaining -= step;
         }
-        if ( msgBufBytesLeft > strSize) msgBufBytesLeft = strSize;
-        memcpy ( & pClient->msgBuf[pClient->nextMsgIndex],
-            message, msgBufBytesLeft );
-        pClient->nextMsgIndex += msgBufBytesLeft;
-        strSize -= msgBufBytesLeft;
-        message += msgBufBytesLeft;
+        pClient->head = ( pClient->head + step ) % pClient->msgBufSize;
+        pClient->nQueued -= step;
+        pClient->nDequeued += step;
+        len -= step;
     }
 }
 
 /*
  * logClientSend ()
+ *
+ * Never blocks on the network; the message is queued for the
+ * logRestart thread, or dropped if the queue is full.
  */
 void epicsStdCall logClientSend ( logClientId id, const char * message )
 {
     logClient * pClient = ( logClient * ) id;
+    int wasEmpty;
 
     if ( ! pClient || ! message ) {
         return;
@@ -209,37 +286,87 @@ void epicsStdCall logClientSend ( logClientId id, const char * message )
 
     epicsMutexMustLock ( pClient->mutex );
 
-    if (logClientPrefix) {
-        sendMessageChunk(pClient, logClientPrefix);
+    wasEmpty = pClient->nQueued == 0u;
+
+    if ( pClient->nDropNotice ) {
+        char notice[64];
+        sprintf ( notice, "log client: %u messages dropped, queue full\n",
+            pClient->nDropNotice );
+        if ( queueMessage ( pClient, logClientPrefix, notice ) == 0 ) {
+            pClient->nDropNotice = 0u;
+        }
+    }
+    if ( pClient->nDropNotice ||
+            queueMessage ( pClient, logClientPrefix, message ) ) {
+        pClient->nDropped++;
+        pClient->nDropNotice++;
     }
-    sendMessageChunk(pClient, message);
 
     epicsMutexUnlock (pClient->mutex);
-}
 
+    if ( wasEmpty ) {
+        epicsEventSignal ( pClient->sendNotify );
+    }
+}
 
-void epicsStdCall logClientFlush ( logClientId id )
+/*
+ * Send everything queued to the server.  Only called by the logRestart
+ * thread, which does not hold the mutex while in send() so that
+ * logClientSend() never waits for the network.
+ */
+static void logClientSendQueued ( logClient * pClient )
 {
-    unsigned nSent;
     int status = 0;
 
-    logClient * pClient = ( logClient * ) id;
+    epicsMutexMustLock ( pClient->mutex );
 
-    if ( ! pClient || ! pClient->connected ) {
-        return;
-    }
+    while ( pClient->connected && pClient->nQueued > pClient->backlog ) {
+        size_t start = ( pClient->head + pClient->backlog ) % pClient->msgBufSize;
+        size_t len = pClient->nQueued - pClient->backlog;
+        size_t first = pClient->msgBufSize - start;
+        SOCKET sock = pClient->sock;
+        size_t nSent;
+        int backlog;
 
-    epicsMutexMustLock ( pClient->mutex );
+        if ( first > len ) first = len;
 
-    nSent = pClient->backlog;
-    while ( nSent < pClient->nextMsgIndex && pClient->connected ) {
-        status = send ( pClient->sock, pClient->msgBuf + nSent,
-            pClient->nextMsgIndex - nSent, 0 );
-        if ( status < 0 ) break;
-        nSent += status;
+        /* the sent region is only modified by this thread */
+        epicsMutexUnlock ( pClient->mutex );
+#ifdef USE_WRITEV
+        {
+            struct iovec iov[2];
+            iov[0].iov_base = & pClient->msgBuf[start];
+            iov[0].iov_len = first;
+            iov[1].iov_base = pClient->msgBuf;
+            iov[1].iov_len = len - first;
+            status = writev ( sock, iov, len > first ? 2 : 1 );
+        }
+#else
+        status = send ( sock, & pClient->msgBuf[start], (int) first, 0 );
+#endif
+        epicsMutexMustLock ( pClient->mutex );
+
+        if ( status < 0 ) {
+            if ( SOCKERRNO == SOCK_EINTR && ! pClient->shutdown ) {
+                status = 0;
+                continue;
+            }
+            break;
+        }
+        nSent = pClient->backlog + ( size_t ) status;
+
+        backlog = pClient->connected ? epicsSocketUnsentCount ( sock ) : -1;
+        if ( backlog >= 0 && ( size_t ) backlog <= nSent ) {
+            pClient->backlog = backlog;
+            nSent -= backlog;
+        }
+        else {
+            pClient->backlog = 0u;
+        }
+        dequeueBytes ( pClient, nSent );
     }
 
-    if ( pClient->backlog > 0 && status >= 0 ) {
+    if ( pClient->connected && pClient->backlog > 0 && status >= 0 ) {
         /* On Linux send 0 bytes can detect EPIPE */
         /* NOOP on Windows, fails on vxWorks */
         errno = 0;
@@ -247,7 +374,7 @@ void epicsStdCall logClientFlush ( logClientId id )
         if (!(errno == SOCK_ECONNRESET || errno == SOCK_EPIPE)) status = 0;
     }
 
-    if ( status < 0 ) {
+    if ( status < 0 && pClient->connected ) {
         if ( ! pClient->shutdown ) {
             char sockErrBuf[128];
             epicsSocketConvertErrnoToString(sockErrBuf, sizeof(sockErrBuf));
@@ -255,19 +382,48 @@ void epicsStdCall logClientFlush ( logClientId id )
                 " because \"%s\"\n", pClient->name, sockErrBuf);
         }
         pClient->backlog = 0;
+        if ( pClient->framed && pClient->frameRemaining ) {
+            /* the server never saw the end of this frame, so it
+             * can't be resent on the next connection */
+            dequeueBytes ( pClient, pClient->frameRemaining );
+            pClient->nDropped++;
+        }
+        epicsMutexUnlock ( pClient->mutex );
         logClientClose ( pClient );
+        return;
     }
-    else if ( nSent > 0 && pClient->nextMsgIndex > 0 ) {
-        int backlog = epicsSocketUnsentCount ( pClient->sock );
-        if (backlog >= 0) {
-            pClient->backlog = backlog;
-            nSent -= backlog;
-        }
-        pClient->nextMsgIndex -= nSent;
-        if ( nSent > 0 && pClient->nextMsgIndex > 0 ) {
-            memmove ( pClient->msgBuf, & pClient->msgBuf[nSent],
-                pClient->nextMsgIndex );
-        }
+    epicsMutexUnlock ( pClient->mutex );
+
+    epicsEventSignal ( pClient->flushNotify );
+}
+
+/*
+ * logClientFlush ()
+ *
+ * Wait until everything queued so far has been handed to TCP, or the
+ * connection is lost.
+ */
+void epicsStdCall logClientFlush ( logClientId id )
+{
+    logClient * pClient = ( logClient * ) id;
+    epicsUInt64 target;
+    double waited = 0.0;
+    static const double interval = 0.1;
+
+    if ( ! pClient || ! pClient->connected ) {
+        return;
+    }
+
+    epicsMutexMustLock ( pClient->mutex );
+    target = pClient->nEnqueued;
+    while ( pClient->connected && ! pClient->shutdown &&
+            pClient->nDequeued + pClient->backlog < target &&
+            waited < LOG_RESTART_DELAY ) {
+        epicsMutexUnlock ( pClient->mutex );
+        epicsEventSignal ( pClient->sendNotify );
+        epicsEventWaitWithTimeout ( pClient->flushNotify, interval );
+        waited += interval;
+        epicsMutexMustLock ( pClient->mutex );
     }
     epicsMutexUnlock ( pClient->mutex );
 }
@@ -414,6 +570,16 @@ static void logClientConnect (logClient *pClient)
 
     epicsMutexUnlock ( pClient->mutex );
 
+    if ( pClient->framed ) {
+        /* announce the framing; only this thread sends on the socket */
+        status = send ( pClient->sock, LOG_CLIENT_FRAME_MAGIC,
+            LOG_CLIENT_FRAME_MAGIC_SIZE, 0 );
+        if ( status != LOG_CLIENT_FRAME_MAGIC_SIZE ) {
+            logClientClose ( pClient );
+            return;
+        }
+    }
+
     epicsEventSignal ( pClient->stateChangeNotify );
 
     fprintf(stderr, "log client: connected to log server at '%s'\n",
@@ -426,6 +592,10 @@ static void logClientConnect (logClient *pClient)
 static void logClientRestart ( logClientId id )
 {
     logClient *pClient = (logClient *)id;
+    epicsTimeStamp lastAttempt, now;
+
+    lastAttempt.secPastEpoch = 0u;
+    lastAttempt.nsec = 0u;
 
     /* SMP safe state inspection */
     epicsMutexMustLock ( pClient->mutex );
@@ -436,10 +606,18 @@ static void logClientRestart ( logClientId id )
 
         epicsMutexUnlock ( pClient->mutex );
 
-        if ( ! isConn ) logClientConnect ( pClient );
-        logClientFlush ( pClient );
+        if ( ! isConn ) {
+            /* a queued message wakes us, but don't retry any faster */
+            epicsTimeGetCurrent ( & now );
+            if ( epicsTimeDiffInSeconds ( & now, & lastAttempt ) >=
+                    LOG_RESTART_DELAY ) {
+                lastAttempt = now;
+                logClientConnect ( pClient );
+            }
+        }
+        logClientSendQueued ( pClient );
 
-        epicsEventWaitWithTimeout ( pClient->shutdownNotify, LOG_RESTART_DELAY);
+        epicsEventWaitWithTimeout ( pClient->sendNotify, LOG_RESTART_DELAY );
 
         epicsMutexMustLock ( pClient->mutex );
     }
@@ -456,6 +634,8 @@ logClientId epicsStdCall logClientCreate (
     struct in_addr server_addr, unsigned short server_port)
 {
     logClient *pClient;
+    long queueSize = 0;
+    int framed = 0;
 
     pClient = calloc (1, sizeof (*pClient));
     if (pClient==NULL) {
@@ -467,8 +647,22 @@ logClientId epicsStdCall logClientCreate (
     pClient->addr.sin_port = htons(server_port);
     ipAddrToDottedIP (&pClient->addr, pClient->name, sizeof(pClient->name));
 
+    if ( envGetLongConfigParam ( &EPICS_IOC_LOG_QUEUE_SIZE, &queueSize ) ||
+            queueSize < (long) LOG_MIN_QUEUE_SIZE ) {
+        queueSize = (long) LOG_MIN_QUEUE_SIZE;
+    }
+    pClient->msgBufSize = (size_t) queueSize;
+    pClient->msgBuf = malloc ( pClient->msgBufSize );
+    if ( ! pClient->msgBuf ) {
+        free ( pClient );
+        return NULL;
+    }
+    envGetBoolConfigParam ( &EPICS_IOC_LOG_FRAMED, &framed );
+    pClient->framed = framed ? 1u : 0u;
+
     pClient->mutex = epicsMutexCreate ();
     if ( ! pClient->mutex ) {
+        free ( pClient->msgBuf );
         free ( pClient );
         return NULL;
     }
@@ -479,21 +673,12 @@ logClientId epicsStdCall logClientCreate (
     pClient->shutdown = 0;
     pClient->shutdownConfirm = 0;
 
-    epicsAtExit (logClientDestroy, (void*) pClient);
-
     pClient->stateChangeNotify = epicsEventCreate (epicsEventEmpty);
-    if ( ! pClient->stateChangeNotify ) {
-        epicsMutexDestroy ( pClient->mutex );
-        free ( pClient );
-        return NULL;
-    }
-
-    pClient->shutdownNotify = epicsEventCreate (epicsEventEmpty);
-    if ( ! pClient->shutdownNotify ) {
-        epicsMutexDestroy ( pClient->mutex );
-        epicsEventDestroy ( pClient->stateChangeNotify );
-        free ( pClient );
-        return NULL;
+    pClient->sendNotify = epicsEventCreate (epicsEventEmpty);
+    pClient->flushNotify = epicsEventCreate (epicsEventEmpty);
+    if ( ! pClient->stateChangeNotify || ! pClient->sendNotify ||
+            ! pClient->flushNotify ) {
+        goto fail;
     }
 
     pClient->restartThreadId = epicsThreadCreate (
@@ -501,15 +686,25 @@ logClientId epicsStdCall logClientCreate (
         epicsThreadGetStackSize(epicsThreadStackSmall),
         logClientRestart, pClient );
     if ( pClient->restartThreadId == NULL ) {
-        epicsMutexDestroy ( pClient->mutex );
-        epicsEventDestroy ( pClient->stateChangeNotify );
-        epicsEventDestroy ( pClient->shutdownNotify );
-        free (pClient);
         fprintf(stderr, "log client: unable to start reconnection thread\n");
-        return NULL;
+        goto fail;
     }
 
+    epicsAtExit (logClientDestroy, (void*) pClient);
+
     return (void *) pClient;
+
+fail:
+    epicsMutexDestroy ( pClient->mutex );
+    if ( pClient->stateChangeNotify )
+        epicsEventDestroy ( pClient->stateChangeNotify );
+    if ( pClient->sendNotify )
+        epicsEventDestroy ( pClient->sendNotify );
+    if ( pClient->flushNotify )
+        epicsEventDestroy ( pClient->flushNotify );
+    free ( pClient->msgBuf );
+    free ( pClient );
+    return NULL;
 }
 
 /*
@@ -532,16 +727,33 @@ void epicsStdCall logClientShow (logClientId id, unsigned level)
     }
 
     if (level>0) {
-        printf ("log client: sock %s, connect cycles = %u\n",
+        printf ("log client: sock %s, connect cycles = %u%s\n",
             pClient->sock==INVALID_SOCKET?"INVALID":"OK",
-            pClient->connectCount);
+            pClient->connectCount,
+            pClient->framed ? ", framed" : "");
+        epicsMutexMustLock ( pClient->mutex );
+        printf ("log client: %u messages queued, %u dropped,"
+            " %llu bytes sent\n",
+            pClient->nMessages, pClient->nDropped,
+            (unsigned long long) pClient->nDequeued);
+        printf ("log client: queue %lu of %lu bytes used, high water %lu\n",
+            (unsigned long) pClient->nQueued,
+            (unsigned long) pClient->msgBufSize,
+            (unsigned long) pClient->maxQueued);
+        epicsMutexUnlock ( pClient->mutex );
     }
     if (level>1) {
-        printf ("log client: %u bytes in buffer\n", pClient->nextMsgIndex);
-        if (pClient->nextMsgIndex)
+        size_t first;
+
+        epicsMutexMustLock ( pClient->mutex );
+        first = pClient->msgBufSize - pClient->head;
+        if ( first > pClient->nQueued ) first = pClient->nQueued;
+        if ( pClient->nQueued && ! pClient->framed )
             printf("-------------------------\n"
-                "%.*s-------------------------\n",
-                (int)(pClient->nextMsgIndex), pClient->msgBuf);
+                "%.*s%.*s-------------------------\n",
+                (int) first, & pClient->msgBuf[pClient->head],
+                (int) ( pClient->nQueued - first ), pClient->msgBuf);
+        epicsMutexUnlock ( pClient->mutex );
     }
 }
 
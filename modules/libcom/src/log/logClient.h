@@ -35,6 +35,16 @@
 extern "C" {
 #endif
 
+/** \brief First bytes sent on a connection by a log client which frames
+ * its messages.  The leading nul can't occur in a plain text log stream.
+ * \since UNRELEASED
+ */
+#define LOG_CLIENT_FRAME_MAGIC "\0EPICSLF"
+/** \brief Length of ::LOG_CLIENT_FRAME_MAGIC
+ * \since UNRELEASED
+ */
+#define LOG_CLIENT_FRAME_MAGIC_SIZE 8
+
 /** \brief Abstract type that represents handle to the log client
  */
 typedef void *logClientId;
@@ -44,8 +54,12 @@ typedef void *logClientId;
  * Starts a background thread to connect to server and returns immediately. 
  * If a connection cannot be established, an error message is 
  * printed on the console, but the log client will keep trying to connect in 
- * the background. This thread will also periodically (every 5 seconds) flush 
- * pending messages out to the server. 
+ * the background (every 5 seconds). This thread also sends queued messages
+ * out to the server.
+ *
+ * The queue size is set by EPICS_IOC_LOG_QUEUE_SIZE. If EPICS_IOC_LOG_FRAMED
+ * is YES each connection starts with ::LOG_CLIENT_FRAME_MAGIC and every
+ * message is preceded by its length as a 4 byte big-endian integer.
  *
  * \param server_addr log server IP address
  * \param server_port log server port
@@ -57,10 +71,11 @@ LIBCOM_API logClientId epicsStdCall logClientCreate (
 
 /** \brief Log message
  *
- * Logs message to log server.  Messages are not immediately sent to the log 
- * server. Instead they are sent periodically (every 5 seconds), when the cache 
- * overflows, or when logClientFlush() is called. If messages can't sent, an error 
- * message will be printed to stderr
+ * Queues message for the log server and wakes the background thread to
+ * send it.  This never waits for the network; if the queue can't hold the
+ * whole message it is dropped and counted, and the server is told how many
+ * messages were lost once there is room again.  If messages can't be sent,
+ * an error message will be printed to stderr
  *
  * \param id log client handle
  * \param message log message
@@ -79,7 +94,8 @@ LIBCOM_API void epicsStdCall logClientShow (logClientId id, unsigned level);
 
 /** \brief Flushes all outstanding messages
  * 
- * Immediately sends all outstanding messages to the server
+ * Waits (for up to 5 seconds) until all messages queued before the call
+ * have been handed to the network, or the connection is lost.
  *
  * \param id log client handle
  */
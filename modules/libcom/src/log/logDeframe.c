@@ -0,0 +1,74 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* logDeframe.c */
+
+#include "logClient.h"
+#include "logDeframe.h"
+
+void logDeframeInit (logDeframeState *pState)
+{
+    pState->framed = -1;
+    pState->magicSeen = 0u;
+    pState->hdrSeen = 0u;
+    pState->frameLeft = 0u;
+}
+
+void logDeframe (logDeframeState *pState, const char *pRaw, size_t nRaw,
+    logDeframeOutput pOutput, void *pPvt)
+{
+    static const char magic[] = LOG_CLIENT_FRAME_MAGIC;
+    size_t i = 0u;
+
+    while (i < nRaw && pState->framed < 0) {
+        if (pRaw[i] != magic[pState->magicSeen]) {
+            /* plain text, including whatever matched so far */
+            pState->framed = 0;
+            if (pState->magicSeen) {
+                (*pOutput) (pPvt, magic, pState->magicSeen, 0);
+            }
+            break;
+        }
+        i++;
+        if (++pState->magicSeen == LOG_CLIENT_FRAME_MAGIC_SIZE) {
+            pState->framed = 1;
+        }
+    }
+
+    if (pState->framed == 0) {
+        if (i < nRaw) {
+            (*pOutput) (pPvt, &pRaw[i], nRaw - i, 0);
+        }
+        return;
+    }
+
+    while (i < nRaw) {
+        size_t n;
+
+        if (pState->hdrSeen < sizeof(pState->hdr)) {
+            pState->hdr[pState->hdrSeen++] = (unsigned char) pRaw[i++];
+            if (pState->hdrSeen == sizeof(pState->hdr)) {
+                pState->frameLeft = (size_t) pState->hdr[0] << 24 |
+                    (size_t) pState->hdr[1] << 16 |
+                    (size_t) pState->hdr[2] << 8 | pState->hdr[3];
+                if (pState->frameLeft == 0u) {
+                    pState->hdrSeen = 0u;
+                }
+            }
+            continue;
+        }
+
+        n = nRaw - i;
+        if (n > pState->frameLeft) {
+            n = pState->frameLeft;
+        }
+        pState->frameLeft -= n;
+        (*pOutput) (pPvt, &pRaw[i], n, pState->frameLeft == 0u);
+        i += n;
+        if (pState->frameLeft == 0u) {
+            pState->hdrSeen = 0u;
+        }
+    }
+}
@@ -0,0 +1,51 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* logDeframe.h */
+
+/*
+ * Unpack the stream from a log client, which is either plain text or
+ * starts with LOG_CLIENT_FRAME_MAGIC and has length prefixed messages.
+ * Built into iocLogServer and its test, not part of libCom.
+ */
+
+#ifndef INC_logDeframe_H
+#define INC_logDeframe_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct logDeframeState {
+    int framed;             /* -1 until the stream's first bytes are seen */
+    size_t magicSeen;
+    unsigned char hdr[4];
+    size_t hdrSeen;
+    size_t frameLeft;
+} logDeframeState;
+
+/*
+ * Receives the text of the stream. endOfMessage is set after the last
+ * part of a framed message, which may not end with a carrage return.
+ */
+typedef void (*logDeframeOutput) (void *pPvt, const char *pText,
+    size_t nText, int endOfMessage);
+
+void logDeframeInit (logDeframeState *pState);
+
+/*
+ * Passes all of the nRaw bytes on to pOutput, whatever the way the
+ * stream is split into reads.
+ */
+void logDeframe (logDeframeState *pState, const char *pRaw, size_t nRaw,
+    logDeframeOutput pOutput, void *pPvt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_logDeframe_H */
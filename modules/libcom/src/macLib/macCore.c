@@ -12,7 +12,10 @@
  *
  * The implementation is fairly unsophisticated and linked lists are
  * used to store macro values. Typically there will will be only a
- * small number of macros and performance won't be a problem. Special
+ * small number of macros and performance won't be a problem; once the
+ * list grows beyond MAC_HASH_THRESHOLD entries a hash index of the
+ * names is added, with newer entries ahead of older ones so scoping
+ * still works. Special
  * measures are taken to avoid unnecessary expansion of macros whose
  * definitions reference other macros. Whenever a macro is created,
  * modified or deleted, a "dirty" flag is set; this causes a full
@@ -29,6 +32,7 @@
 #include "dbDefs.h"
 #include "errlog.h"
 #include "dbmf.h"
+#include "epicsString.h"
 #include "macLib.h"
 
 
@@ -48,8 +52,49 @@ typedef struct mac_entry {
     int         visited;        /* ever been visited? */
     int         special;        /* special (internal) entry? */
     int         level;          /* scoping level */
+    unsigned    hash;           /* hash of name */
+    struct mac_entry *chain;    /* next entry in same hash bucket */
 } MAC_ENTRY;
 
+/*
+ * Hash index of (non-special) macro entries; each bucket chain holds the
+ * newest entry first
+ */
+typedef struct mac_hash {
+    unsigned    mask;           /* number of buckets - 1 */
+    unsigned    count;          /* number of entries indexed */
+    MAC_ENTRY   **buckets;      /* bucket chains */
+} MAC_HASH;
+
+/*
+ * Context allocated by macCreateHandle(); the public MAC_HANDLE comes first
+ * so its layout is unchanged, the rest is private to this file
+ */
+typedef struct mac_context {
+    MAC_HANDLE  handle;         /* public part, must be first */
+    MAC_HASH    *hash;          /* name index, NULL until the list grows */
+} MAC_CONTEXT;
+
+#define HASH_INDEX( handle ) ( ( ( MAC_CONTEXT * ) ( handle ) )->hash )
+
+/*
+ * Token of a pre-parsed template
+ */
+typedef struct mac_token {
+    int         type;           /* TOKEN_TEXT, TOKEN_NAME or TOKEN_REF */
+    const char  *text;          /* start of token in template source */
+    size_t      length;         /* length of token in template source */
+    const char  *name;          /* TOKEN_NAME: macro name */
+    unsigned    hash;           /* TOKEN_NAME: hash of name */
+} MAC_TOKEN;
+
+struct mac_template {
+    char        *source;        /* copy of the source string */
+    char        *names;         /* storage for TOKEN_NAME names */
+    int         ntokens;        /* number of tokens */
+    MAC_TOKEN   *tokens;        /* token array */
+};
+
 
 /*** Local function prototypes ***/
 
@@ -63,6 +108,11 @@ static MAC_ENTRY *previous( MAC_ENTRY  *entry );
 
 static MAC_ENTRY *create( MAC_HANDLE *handle, const char *name, int special );
 static MAC_ENTRY *lookup( MAC_HANDLE *handle, const char *name, int special );
+static MAC_ENTRY *lookupHash( MAC_HANDLE *handle, const char *name,
+                              int special, unsigned hash );
+static void       hashAdd   ( MAC_HANDLE *handle, MAC_ENTRY *entry );
+static void       hashRemove( MAC_HANDLE *handle, MAC_ENTRY *entry );
+static void       hashBuild ( MAC_HANDLE *handle, unsigned nBuckets );
 static char      *rawval( MAC_HANDLE *handle, MAC_ENTRY *entry, const char *value );
 static void       delete( MAC_HANDLE *handle, MAC_ENTRY *entry );
 static long       expand( MAC_HANDLE *handle );
@@ -72,6 +122,9 @@ static void       trans ( MAC_HANDLE *handle, MAC_ENTRY *entry, int level,
 static void       refer ( MAC_HANDLE *handle, MAC_ENTRY *entry, int level,
                           const char **rawval, char **value, char *valend );
 
+static const char *skipTrans( const char *rawval, const char *term );
+static const char *skipRefer( const char *rawval );
+
 static void cpy2val( const char *src, char **value, const char *valend );
 static char *Strdup( const char *string );
 
@@ -89,6 +142,18 @@ static char *Strdup( const char *string );
 #define FLAG_SUPPRESS_WARNINGS  0x1
 #define FLAG_USE_ENVIRONMENT    0x80
 
+/*
+ * Number of entries above which a hash index is maintained
+ */
+#define MAC_HASH_THRESHOLD 16
+
+/*
+ * Template token types
+ */
+#define TOKEN_TEXT  0           /* literal text, copied verbatim */
+#define TOKEN_NAME  1           /* reference to a plain macro name */
+#define TOKEN_REF   2           /* any other macro reference */
+
 
 /*** Library routines ***/
 
@@ -113,7 +178,7 @@ epicsStdCall macCreateHandle(
     *pHandle = NULL;
 
     /* allocate macro substitution context */
-    handle = ( MAC_HANDLE * ) dbmfMalloc( sizeof( MAC_HANDLE ) );
+    handle = ( MAC_HANDLE * ) dbmfMalloc( sizeof( MAC_CONTEXT ) );
     if ( handle == NULL ) {
         errlogPrintf( "macCreateHandle: failed to allocate context\n" );
         return -1;
@@ -125,6 +190,7 @@ epicsStdCall macCreateHandle(
     handle->level = 0;
     handle->debug = 0;
     handle->flags = 0;
+    HASH_INDEX( handle ) = NULL;
     ellInit( &handle->list );
 
     /* use environment variables if so specified */
@@ -135,7 +201,7 @@ epicsStdCall macCreateHandle(
         /* if supplied, load macro definitions */
         for ( ; pairs && pairs[0]; pairs += 2 ) {
             if ( macPutValue( handle, pairs[0], pairs[1] ) < 0 ) {
-                dbmfFree( handle );
+                macDeleteHandle( handle );
                 return -1;
             }
         }
@@ -226,6 +292,231 @@ epicsStdCall macExpandString(
     return length;
 }
 
+/*
+ * Pre-parse a string into a template of literal text and macro references.
+ * The scan mirrors trans() at level 0 so that expanding the template gives
+ * exactly what macExpandString() would give for the same string
+ */
+MAC_TEMPLATE *                  /* NULL on allocation failure */
+epicsStdCall macCompileTemplate(
+    const char  *src )          /* source string */
+{
+    MAC_TEMPLATE *tmpl;
+    MAC_TOKEN *token;
+    const char *r, *text;
+    char *n;
+    char quote = 0;
+    int maxtokens = 8;
+    size_t length = strlen( src );
+
+    tmpl = calloc( 1, sizeof( MAC_TEMPLATE ) );
+    if ( tmpl == NULL ) goto fail;
+    tmpl->source = malloc( length + 1 );
+    tmpl->names  = malloc( length + 1 );
+    tmpl->tokens = malloc( maxtokens * sizeof( MAC_TOKEN ) );
+    if ( !tmpl->source || !tmpl->names || !tmpl->tokens ) goto fail;
+    strcpy( tmpl->source, src );
+
+    n = tmpl->names;
+    for ( r = text = tmpl->source; ; ) {
+        const char *end = NULL;
+        int macRef;
+
+        if ( *r != '\0' ) {
+            /* track quotes, as trans() does */
+            if ( quote ) {
+                if ( *r == quote ) quote = 0;
+            }
+            else if ( *r == '"' || *r == '\'' ) {
+                quote = *r;
+            }
+
+            /* macros are not expanded in single quotes */
+            macRef = ( *r == '$' &&
+                       *( r + 1 ) != '\0' &&
+                       strchr( "({", *( r + 1 ) ) != NULL &&
+                       quote != '\'' );
+
+            if ( !macRef ) {
+                /* escaped characters are literal */
+                if ( *r == '\\' && *( r + 1 ) != '\0' ) r++;
+                r++;
+                continue;
+            }
+
+            /* reference is from r to end inclusive */
+            end = skipRefer( r );
+        }
+
+        /* need room for a text token and a reference token */
+        if ( tmpl->ntokens + 2 > maxtokens ) {
+            MAC_TOKEN *tokens;
+
+            maxtokens *= 2;
+            tokens = realloc( tmpl->tokens, maxtokens * sizeof( MAC_TOKEN ) );
+            if ( tokens == NULL ) goto fail;
+            tmpl->tokens = tokens;
+        }
+
+        if ( r > text ) {
+            token = &tmpl->tokens[tmpl->ntokens++];
+            token->type   = TOKEN_TEXT;
+            token->text   = text;
+            token->length = r - text;
+            token->name   = NULL;
+            token->hash   = 0;
+        }
+
+        if ( end == NULL )
+            break;
+
+        token = &tmpl->tokens[tmpl->ntokens++];
+        token->type   = TOKEN_REF;
+        token->text   = r;
+        token->length = end - r + 1;
+        token->name   = NULL;
+        token->hash   = 0;
+
+        /* is this a reference to a plain name, with at most a default
+           value that itself contains no references? */
+        {
+            char close = ( *( r + 1 ) == '(' ) ? ')' : '}';
+            size_t len = strcspn( r + 2, "=,)}$\"'\\" );
+            const char *p = r + 2 + len;
+
+            if ( *p == '=' )
+                p += 1 + strcspn( p + 1, ",)}$" );
+            if ( p == end && *p == close && len <= MAC_SIZE ) {
+                memcpy( n, r + 2, len );
+                n[len] = '\0';
+                token->type = TOKEN_NAME;
+                token->name = n;
+                token->hash = epicsStrHash( n, 0 );
+                n += len + 1;
+            }
+        }
+
+        r = text = end + 1;
+    }
+
+    return tmpl;
+
+fail:
+    errlogPrintf( "macCompileTemplate: failed to allocate template\n" );
+    macDeleteTemplate( tmpl );
+    return NULL;
+}
+
+/*
+ * Expand a template returned by macCompileTemplate(). Literal text is
+ * copied and plain references are looked up by their pre-computed hash;
+ * anything else is handed to refer() just as trans() would
+ */
+long                            /* strlen(dest), <0 if any macros are */
+                                /* undefined */
+epicsStdCall macExpandTemplate(
+    MAC_HANDLE  *handle,        /* opaque handle */
+
+    const MAC_TEMPLATE *tmpl,   /* template from macCompileTemplate() */
+
+    char        *dest,          /* destination string */
+
+    long        capacity )      /* capacity of destination buffer (dest) */
+{
+    MAC_ENTRY entry;
+    char *d, *valend;
+    long length;
+    int i;
+
+    /* check handle */
+    if ( handle == NULL || handle->magic != MAC_MAGIC ) {
+        errlogPrintf( "macExpandTemplate: NULL or invalid handle\n" );
+        return -1;
+    }
+    if ( tmpl == NULL ) {
+        errlogPrintf( "macExpandTemplate: NULL template\n" );
+        return -1;
+    }
+
+    /* debug output */
+    if ( handle->debug & 1 )
+        printf( "macExpandTemplate( %s, capacity = %ld )\n",
+                tmpl->source, capacity );
+
+    /* Check size */
+    if (capacity <= 1)
+        return -1;
+
+    /* expand raw values if necessary */
+    if ( expand( handle ) < 0 )
+        errlogPrintf( "macExpandTemplate: failed to expand raw values\n" );
+
+    /* fill in necessary fields in fake macro entry structure */
+    entry.name  = tmpl->source;
+    entry.type  = "string";
+    entry.error = FALSE;
+
+    d  = dest;
+    *d = '\0';
+    valend = dest + capacity - 1;
+
+    for ( i = 0; i < tmpl->ntokens; i++ ) {
+        const MAC_TOKEN *token = &tmpl->tokens[i];
+        const char *r;
+
+        if ( token->type == TOKEN_TEXT ) {
+            size_t n = valend - d;
+
+            if ( n > token->length ) n = token->length;
+            memcpy( d, token->text, n );
+            d += n;
+            *d = '\0';
+            continue;
+        }
+
+        if ( token->type == TOKEN_NAME && !handle->dirty ) {
+            MAC_ENTRY *refentry = lookupHash( handle, token->name, FALSE,
+                                              token->hash );
+
+            /* lookup() may have created an environment entry */
+            if ( refentry && !refentry->visited && !handle->dirty ) {
+                cpy2val( refentry->value, &d, valend );
+                entry.error = entry.error || refentry->error;
+                continue;
+            }
+        }
+
+        /* undefined, defaulted or complex reference */
+        r = token->text;
+        refer( handle, &entry, 0, &r, &d, valend );
+    }
+
+    /* return +/- #chars copied depending on successful expansion */
+    length = d - dest;
+    length = ( entry.error ) ? -length : length;
+
+    /* debug output */
+    if ( handle->debug & 1 )
+        printf( "macExpandTemplate() -> %ld\n", length );
+
+    return length;
+}
+
+/*
+ * Free a template
+ */
+void
+epicsStdCall macDeleteTemplate(
+    MAC_TEMPLATE *tmpl )        /* template to delete */
+{
+    if ( tmpl == NULL )
+        return;
+    free( tmpl->source );
+    free( tmpl->names );
+    free( tmpl->tokens );
+    free( tmpl );
+}
+
 /*
  * Define the value of a macro. A NULL value deletes the macro if it
  * already existed
@@ -379,6 +670,12 @@ epicsStdCall macDeleteHandle(
         delete( handle, entry );
     }
 
+    /* free hash index */
+    if ( HASH_INDEX( handle ) != NULL ) {
+        free( HASH_INDEX( handle )->buckets );
+        free( HASH_INDEX( handle ) );
+    }
+
     /* clear magic field and free context structure */
     handle->magic = 0;
     dbmfFree( handle );
@@ -560,8 +857,17 @@ static MAC_ENTRY *create( MAC_HANDLE *handle, const char *name, int special )
             entry->visited = FALSE;
             entry->special = special;
             entry->level   = handle->level;
+            entry->hash    = epicsStrHash( name, 0 );
+            entry->chain   = NULL;
 
             ellAdd( list, ( ELLNODE * ) entry );
+
+            if ( !special ) {
+                if ( HASH_INDEX( handle ) != NULL )
+                    hashAdd( handle, entry );
+                else if ( ellCount( list ) > MAC_HASH_THRESHOLD )
+                    hashBuild( handle, 2 * MAC_HASH_THRESHOLD );
+            }
         }
     }
 
@@ -573,18 +879,38 @@ static MAC_ENTRY *create( MAC_HANDLE *handle, const char *name, int special )
  */
 static MAC_ENTRY *lookup( MAC_HANDLE *handle, const char *name, int special )
 {
+    return lookupHash( handle, name, special, epicsStrHash( name, 0 ) );
+}
+
+/*
+ * Look up macro entry as above, given the hash of its name
+ */
+static MAC_ENTRY *lookupHash( MAC_HANDLE *handle, const char *name,
+                              int special, unsigned hash )
+{
+    MAC_HASH *index = HASH_INDEX( handle );
     MAC_ENTRY *entry;
 
     if ( handle->debug & 2 )
         printf( "lookup-> level = %d, name = %s, special = %d\n",
                 handle->level, name, special );
 
-    /* search backwards so scoping works */
-    for ( entry = last( handle ); entry != NULL; entry = previous( entry ) ) {
-        if ( entry->special != special )
-            continue;
-        if ( strcmp( name, entry->name ) == 0 )
-            break;
+    if ( !special && index != NULL ) {
+        /* bucket chains hold newer entries first so scoping works */
+        entry = index->buckets[hash & index->mask];
+        for ( ; entry != NULL; entry = entry->chain ) {
+            if ( entry->hash == hash && strcmp( name, entry->name ) == 0 )
+                break;
+        }
+    }
+    else {
+        /* search backwards so scoping works */
+        for ( entry = last( handle ); entry != NULL; entry = previous( entry ) ) {
+            if ( entry->special != special )
+                continue;
+            if ( strcmp( name, entry->name ) == 0 )
+                break;
+        }
     }
     if ( (special == FALSE) && (entry == NULL) &&
          (handle->flags & FLAG_USE_ENVIRONMENT) ) {
@@ -629,6 +955,8 @@ static void delete( MAC_HANDLE *handle, MAC_ENTRY *entry )
     ELLLIST *list = &handle->list;
 
     ellDelete( list, ( ELLNODE * ) entry );
+    if ( !entry->special && HASH_INDEX( handle ) != NULL )
+        hashRemove( handle, entry );
 
     dbmfFree( entry->name );
     if ( entry->rawval != NULL )
@@ -640,6 +968,86 @@ static void delete( MAC_HANDLE *handle, MAC_ENTRY *entry )
     handle->dirty = TRUE;
 }
 
+/*
+ * Add an entry to the hash index as the newest of its name, doubling the
+ * number of buckets when the chains get long
+ */
+static void hashAdd( MAC_HANDLE *handle, MAC_ENTRY *entry )
+{
+    MAC_HASH *hash = HASH_INDEX( handle );
+    MAC_ENTRY **bucket;
+
+    if ( hash->count >= 2 * ( hash->mask + 1 ) ) {
+        /* rebuild from the list, which includes this entry */
+        hashBuild( handle, 2 * ( hash->mask + 1 ) );
+        return;
+    }
+
+    bucket = &hash->buckets[entry->hash & hash->mask];
+    entry->chain = *bucket;
+    *bucket = entry;
+    hash->count++;
+}
+
+/*
+ * Remove an entry from the hash index
+ */
+static void hashRemove( MAC_HANDLE *handle, MAC_ENTRY *entry )
+{
+    MAC_HASH *hash = HASH_INDEX( handle );
+    MAC_ENTRY **pprev = &hash->buckets[entry->hash & hash->mask];
+
+    for ( ; *pprev != NULL; pprev = &( *pprev )->chain ) {
+        if ( *pprev == entry ) {
+            *pprev = entry->chain;
+            entry->chain = NULL;
+            hash->count--;
+            return;
+        }
+    }
+}
+
+/*
+ * (Re-)build the hash index from the list with nBuckets buckets (a power
+ * of 2). On allocation failure any existing index is kept, or lookups
+ * continue to search the list
+ */
+static void hashBuild( MAC_HANDLE *handle, unsigned nBuckets )
+{
+    MAC_HASH *hash = HASH_INDEX( handle );
+    MAC_ENTRY **buckets = calloc( nBuckets, sizeof( MAC_ENTRY * ) );
+    MAC_ENTRY *entry;
+
+    if ( buckets == NULL )
+        return;
+    if ( hash == NULL ) {
+        hash = malloc( sizeof( MAC_HASH ) );
+        if ( hash == NULL ) {
+            free( buckets );
+            return;
+        }
+        HASH_INDEX( handle ) = hash;
+    }
+    else {
+        free( hash->buckets );
+    }
+    hash->buckets = buckets;
+    hash->mask = nBuckets - 1;
+    hash->count = 0;
+
+    /* the list is oldest first, so newer entries end up ahead */
+    for ( entry = first( handle ); entry != NULL; entry = next( entry ) ) {
+        MAC_ENTRY **bucket;
+
+        if ( entry->special )
+            continue;
+        bucket = &buckets[entry->hash & hash->mask];
+        entry->chain = *bucket;
+        *bucket = entry;
+        hash->count++;
+    }
+}
+
 /*
  * Expand macro definitions (expensive but done very infrequently)
  */
@@ -925,6 +1333,58 @@ cleanup:
     *value = v;
 }
 
+/*
+ * Find the end of raw text that trans() would scan, without translating
+ * it. Returns a pointer to the terminator (or last character)
+ */
+static const char *skipTrans( const char *r, const char *term )
+{
+    char quote = 0;
+
+    for ( ; strchr( term, *r ) == NULL; r++ ) {
+        if ( quote ) {
+            if ( *r == quote ) quote = 0;
+        }
+        else if ( *r == '"' || *r == '\'' ) {
+            quote = *r;
+        }
+
+        if ( *r == '$' && *( r + 1 ) != '\0' &&
+             strchr( "({", *( r + 1 ) ) != NULL && quote != '\'' )
+            r = skipRefer( r );
+        else if ( *r == '\\' && *( r + 1 ) != '\0' )
+            r++;
+    }
+
+    return ( *r == '\0' ) ? r - 1 : r;
+}
+
+/*
+ * Find the last character of the macro reference starting at r, as
+ * consumed by refer()
+ */
+static const char *skipRefer( const char *r )
+{
+    const char *macEnd;
+
+    r++;
+    macEnd = ( *r == '(' ) ? "=,)" : "=,}";
+    r++;
+
+    r = skipTrans( r, macEnd );
+    if ( *r == '=' )
+        r = skipTrans( r + 1, macEnd + 1 );
+
+    /* a trailing ',' at the end of the string would never terminate */
+    while ( *r == ',' && *( r + 1 ) != '\0' ) {
+        r = skipTrans( r + 1, macEnd );
+        if ( *r == '=' )
+            r = skipTrans( r + 1, macEnd + 1 );
+    }
+
+    return r;
+}
+
 /*
  * Copy a string, honoring the 'end of destination string' pointer
  * Returns with **value pointing to the '\0' terminator
@@ -49,6 +49,12 @@ typedef struct {
     int         flags;          /**< \brief operating mode flags */
 } MAC_HANDLE;
 
+/** \brief Pre-parsed macro substitution template, see macCompileTemplate().
+ *
+ * The structure is private to macLib.
+ */
+typedef struct mac_template MAC_TEMPLATE;
+
 /** \name Core Library
  *  The core library provides a minimal set of basic operations.
  *  @{
@@ -194,6 +200,53 @@ LIBCOM_API long
 epicsStdCall macPopScope(
     MAC_HANDLE  *handle         /**< opaque handle */
 );
+/**
+ * \brief Pre-parse a string which may contain macro references.
+ * \return Opaque template, or NULL on allocation failure.
+ *
+ * The string is split once into runs of literal text and macro references.
+ * References to a plain macro name (no nested references, scoped macros,
+ * quotes or escapes in the name) are stored with a pre-computed hash of the
+ * name so they can be resolved without re-parsing. The template is
+ * independent of any handle and may be expanded with macExpandTemplate()
+ * against any number of handles, which is much cheaper than repeating
+ * macExpandString() on the same text for each set of substitutions.
+ * The \c src string is copied and need not be kept by the caller.
+ */
+LIBCOM_API MAC_TEMPLATE *
+epicsStdCall macCompileTemplate(
+    const char  *src            /**< source string */
+);
+
+/**
+ * \brief Expand a pre-parsed template.
+ * \return Returns the length of the expanded string, <0 if any macro are
+ * undefined
+ *
+ * The result, return value and any warnings are identical to those from
+ * calling macExpandString() on the string the template was compiled from.
+ */
+LIBCOM_API long
+epicsStdCall macExpandTemplate(
+    MAC_HANDLE  *handle,        /**< opaque handle */
+
+    const MAC_TEMPLATE *tmpl,   /**< template from macCompileTemplate() */
+
+    char        *dest,          /**< destination string */
+
+    long        capacity        /**< capacity of destination buffer (dest) */
+);
+
+/**
+ * \brief Free a template returned by macCompileTemplate().
+ *
+ * A NULL \c tmpl is ignored.
+ */
+LIBCOM_API void
+epicsStdCall macDeleteTemplate(
+    MAC_TEMPLATE *tmpl          /**< template to delete */
+);
+
 /**
  * \brief Reports details of current definitions
  * \return 0 = OK; <0 = ERROR
@@ -0,0 +1,237 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* epicsArrayKernels.c */
+
+#include <string.h>
+
+#include "epicsThread.h"
+#include "epicsTypes.h"
+#include "epicsArrayKernels.h"
+
+#define LANES EPICS_ARRAY_KERNEL_LANES
+
+#define ARRAY_KERNELS(suffix, attr) \
+attr static double sum##suffix(const double *x, size_t n) \
+{ \
+    double lane[LANES] = {0.0}; \
+    size_t i, k; \
+\
+    for (i = 0; i + LANES <= n; i += LANES) \
+        for (k = 0; k < LANES; k++) \
+            lane[k] += x[i + k]; \
+    for (; i < n; i++) \
+        lane[0] += x[i]; \
+    return (lane[0] + lane[1]) + (lane[2] + lane[3]); \
+} \
+\
+attr static double dot##suffix(const double *a, const double *b, size_t n) \
+{ \
+    double lane[LANES] = {0.0}; \
+    size_t i, k; \
+\
+    for (i = 0; i + LANES <= n; i += LANES) \
+        for (k = 0; k < LANES; k++) \
+            lane[k] += a[i + k] * b[i + k]; \
+    for (; i < n; i++) \
+        lane[0] += a[i] * b[i]; \
+    return (lane[0] + lane[1]) + (lane[2] + lane[3]); \
+} \
+\
+/* a NaN never replaces a lane, so only one in x[0] is returned */ \
+attr static double min##suffix(const double *x, size_t n) \
+{ \
+    double lane[LANES]; \
+    double value; \
+    size_t i, k; \
+\
+    for (k = 0; k < LANES; k++) \
+        lane[k] = x[0]; \
+    for (i = 1; i + LANES <= n; i += LANES) \
+        for (k = 0; k < LANES; k++) \
+            lane[k] = x[i + k] < lane[k] ? x[i + k] : lane[k]; \
+    for (; i < n; i++) \
+        lane[0] = x[i] < lane[0] ? x[i] : lane[0]; \
+    value = lane[0]; \
+    for (k = 1; k < LANES; k++) \
+        value = lane[k] < value ? lane[k] : value; \
+    return value; \
+} \
+\
+attr static double max##suffix(const double *x, size_t n) \
+{ \
+    double lane[LANES]; \
+    double value; \
+    size_t i, k; \
+\
+    for (k = 0; k < LANES; k++) \
+        lane[k] = x[0]; \
+    for (i = 1; i + LANES <= n; i += LANES) \
+        for (k = 0; k < LANES; k++) \
+            lane[k] = x[i + k] > lane[k] ? x[i + k] : lane[k]; \
+    for (; i < n; i++) \
+        lane[0] = x[i] > lane[0] ? x[i] : lane[0]; \
+    value = lane[0]; \
+    for (k = 1; k < LANES; k++) \
+        value = lane[k] > value ? lane[k] : value; \
+    return value; \
+} \
+\
+attr static void scale_offset##suffix(double *y, const double *a, \
+    size_t n, double scale, double offset) \
+{ \
+    size_t i; \
+\
+    for (i = 0; i < n; i++) \
+        y[i] = a[i] * scale + offset; \
+} \
+\
+attr static void add##suffix(double *y, const double *a, const double *b, \
+    size_t n) \
+{ \
+    size_t i; \
+\
+    for (i = 0; i < n; i++) \
+        y[i] = a[i] + b[i]; \
+} \
+\
+attr static void mul##suffix(double *y, const double *a, const double *b, \
+    size_t n) \
+{ \
+    size_t i; \
+\
+    for (i = 0; i < n; i++) \
+        y[i] = a[i] * b[i]; \
+} \
+\
+attr static void axpy##suffix(double *y, const double *a, size_t n, \
+    double k) \
+{ \
+    size_t i; \
+\
+    for (i = 0; i < n; i++) \
+        y[i] += k * a[i]; \
+} \
+\
+attr static void add_scale##suffix(double *y, const double *a, size_t n, \
+    double scale) \
+{ \
+    size_t i; \
+\
+    for (i = 0; i < n; i++) \
+        y[i] = (y[i] + a[i]) * scale; \
+} \
+\
+STRIDE_KERNEL(epicsUInt8, suffix, attr) \
+STRIDE_KERNEL(epicsUInt16, suffix, attr) \
+STRIDE_KERNEL(epicsUInt32, suffix, attr) \
+STRIDE_KERNEL(epicsUInt64, suffix, attr) \
+\
+/* indexed by log2 of the element size */ \
+static const strideKernel stride##suffix[4] = { \
+    stride_epicsUInt8##suffix, stride_epicsUInt16##suffix, \
+    stride_epicsUInt32##suffix, stride_epicsUInt64##suffix \
+};
+
+typedef void (*strideKernel)(void *pto, const void *pfrom, size_t n,
+    size_t increment);
+
+/* AVX2 can gather the elements */
+#define STRIDE_KERNEL(type, suffix, attr) \
+attr static void stride_##type##suffix(void *pto, const void *pfrom, \
+    size_t n, size_t increment) \
+{ \
+    type *pdst = (type *) pto; \
+    const type *psrc = (const type *) pfrom; \
+    size_t i; \
+\
+    for (i = 0; i < n; i++) \
+        pdst[i] = psrc[i * increment]; \
+}
+
+EPICS_ARRAY_KERNEL_VARIANTS(ARRAY_KERNELS)
+
+static epicsThreadOnceId avx2Once = EPICS_THREAD_ONCE_INIT;
+static int useAvx2;
+
+static void checkAvx2(void *unused)
+{
+#ifdef EPICS_ARRAY_KERNELS_AVX2
+    __builtin_cpu_init();
+    useAvx2 = __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+int epicsArrayKernelsAvx2(void)
+{
+    epicsThreadOnce(&avx2Once, checkAvx2, NULL);
+    return useAvx2;
+}
+
+double epicsArraySum(const double *x, size_t n)
+{
+    return EPICS_ARRAY_KERNEL_PICK(sum)(x, n);
+}
+
+double epicsArrayDot(const double *a, const double *b, size_t n)
+{
+    return EPICS_ARRAY_KERNEL_PICK(dot)(a, b, n);
+}
+
+double epicsArrayMin(const double *x, size_t n)
+{
+    return EPICS_ARRAY_KERNEL_PICK(min)(x, n);
+}
+
+double epicsArrayMax(const double *x, size_t n)
+{
+    return EPICS_ARRAY_KERNEL_PICK(max)(x, n);
+}
+
+void epicsArrayScaleOffset(double *y, const double *a, size_t n,
+    double scale, double offset)
+{
+    EPICS_ARRAY_KERNEL_PICK(scale_offset)(y, a, n, scale, offset);
+}
+
+void epicsArrayAdd(double *y, const double *a, const double *b, size_t n)
+{
+    EPICS_ARRAY_KERNEL_PICK(add)(y, a, b, n);
+}
+
+void epicsArrayMul(double *y, const double *a, const double *b, size_t n)
+{
+    EPICS_ARRAY_KERNEL_PICK(mul)(y, a, b, n);
+}
+
+void epicsArrayAxpy(double *y, const double *a, size_t n, double k)
+{
+    EPICS_ARRAY_KERNEL_PICK(axpy)(y, a, n, k);
+}
+
+void epicsArrayAddScale(double *y, const double *a, size_t n, double scale)
+{
+    EPICS_ARRAY_KERNEL_PICK(add_scale)(y, a, n, scale);
+}
+
+void epicsArrayStride(void *pto, const void *pfrom, size_t elemSize,
+    size_t n, size_t increment)
+{
+    char *pdst = (char *) pto;
+    const char *psrc = (const char *) pfrom;
+    size_t i;
+
+    for (i = 0; i < 4; i++) {
+        if (elemSize == (size_t) 1 << i)
+            break;
+    }
+    /* the typed kernels need aligned elements */
+    if (i < 4 && ((size_t) pfrom | (size_t) pto) % elemSize == 0) {
+        EPICS_ARRAY_KERNEL_PICK(stride)[i](pto, pfrom, n, increment);
+        return;
+    }
+    for (i = 0; i < n; i++, pdst += elemSize, psrc += increment * elemSize)
+        memcpy(pdst, psrc, elemSize);
+}
@@ -0,0 +1,131 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/**
+ * \file epicsArrayKernels.h
+ *
+ * \brief Loops over arrays, built for the CPU they run on
+ *
+ * The routines here are compiled generically and, on x86-64 with GCC or
+ * clang, a second time for AVX2. The AVX2 versions are used if the CPU
+ * has AVX2, which is checked once.
+ *
+ * The reductions keep ::EPICS_ARRAY_KERNEL_LANES partial results so that
+ * the compiler can use vector instructions, so their results may differ
+ * from those of a sequential loop in the last bits.
+ *
+ * Code with kernels of its own writes them as a macro taking a name
+ * suffix and a function attribute, expands that macro with
+ * EPICS_ARRAY_KERNEL_VARIANTS() and calls the version that
+ * EPICS_ARRAY_KERNEL_PICK() returns:
+ * \code
+   #define MY_KERNELS(suffix, attr) \
+   attr static void twice##suffix(double *y, size_t n) \
+   { \
+       size_t i; \
+       for (i = 0; i < n; i++) y[i] *= 2.0; \
+   }
+   EPICS_ARRAY_KERNEL_VARIANTS(MY_KERNELS)
+   ...
+   EPICS_ARRAY_KERNEL_PICK(twice)(y, n);
+   \endcode
+ */
+
+#ifndef INC_epicsArrayKernels_H
+#define INC_epicsArrayKernels_H
+
+#include <stddef.h>
+
+#include "libComAPI.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \brief Number of partial results kept by the reductions */
+#define EPICS_ARRAY_KERNEL_LANES 4
+
+#if defined(__x86_64__) && \
+    (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+/** \brief Defined where kernels are also built for AVX2 */
+#define EPICS_ARRAY_KERNELS_AVX2
+
+/** \brief Expands KERNELS(suffix, attr) for each version of the kernels
+ *
+ * The suffix is \c _generic, or \c _avx2 with an attribute that has the
+ * compiler generate AVX2 instructions.
+ */
+#define EPICS_ARRAY_KERNEL_VARIANTS(KERNELS) \
+    KERNELS(_generic, ) \
+    KERNELS(_avx2, __attribute__((target("avx2"))))
+
+/** \brief The version of a kernel, or of a table of them, for this CPU */
+#define EPICS_ARRAY_KERNEL_PICK(name) \
+    (epicsArrayKernelsAvx2() ? name##_avx2 : name##_generic)
+#else
+#define EPICS_ARRAY_KERNEL_VARIANTS(KERNELS) \
+    KERNELS(_generic, )
+#define EPICS_ARRAY_KERNEL_PICK(name) (name##_generic)
+#endif
+
+/** \brief Whether the AVX2 versions of the kernels are used
+ *
+ * \return non-zero if they were built and the CPU has AVX2
+ */
+LIBCOM_API int epicsArrayKernelsAvx2(void);
+
+/** \brief The sum of x[0..n-1] */
+LIBCOM_API double epicsArraySum(const double *x, size_t n);
+
+/** \brief The sum of a[i] * b[i] */
+LIBCOM_API double epicsArrayDot(const double *a,
+    const double *b, size_t n);
+
+/** \brief The smallest of x[0..n-1], with n at least 1
+ *
+ * A NaN in x[0] is returned, NaNs in the other elements are ignored.
+ */
+LIBCOM_API double epicsArrayMin(const double *x, size_t n);
+
+/** \brief The largest of x[0..n-1], with n at least 1
+ *
+ * A NaN in x[0] is returned, NaNs in the other elements are ignored.
+ */
+LIBCOM_API double epicsArrayMax(const double *x, size_t n);
+
+/** \brief y[i] = a[i] * scale + offset */
+LIBCOM_API void epicsArrayScaleOffset(double *y,
+    const double *a, size_t n, double scale, double offset);
+
+/** \brief y[i] = a[i] + b[i] */
+LIBCOM_API void epicsArrayAdd(double *y, const double *a,
+    const double *b, size_t n);
+
+/** \brief y[i] = a[i] * b[i] */
+LIBCOM_API void epicsArrayMul(double *y, const double *a,
+    const double *b, size_t n);
+
+/** \brief y[i] += k * a[i] */
+LIBCOM_API void epicsArrayAxpy(double *y, const double *a,
+    size_t n, double k);
+
+/** \brief y[i] = (y[i] + a[i]) * scale */
+LIBCOM_API void epicsArrayAddScale(double *y, const double *a,
+    size_t n, double scale);
+
+/** \brief Copies every increment'th element
+ *
+ * Copies n elements of elemSize bytes, pfrom[0], pfrom[increment] and so
+ * on, to pto[0..n-1]. The arrays must not overlap.
+ */
+LIBCOM_API void epicsArrayStride(void *pto, const void *pfrom,
+    size_t elemSize, size_t n, size_t increment);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_epicsArrayKernels_H */
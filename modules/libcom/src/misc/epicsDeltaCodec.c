@@ -0,0 +1,203 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <string.h>
+
+#include "epicsEndian.h"
+#include "epicsTypes.h"
+#include "epicsDeltaCodec.h"
+
+#define VERSION 1
+
+static void putUInt32(epicsUInt8 *p, epicsUInt32 v)
+{
+    p[0] = (epicsUInt8) (v >> 24);
+    p[1] = (epicsUInt8) (v >> 16);
+    p[2] = (epicsUInt8) (v >> 8);
+    p[3] = (epicsUInt8) v;
+}
+
+static epicsUInt32 getUInt32(const epicsUInt8 *p)
+{
+    return ((epicsUInt32) p[0] << 24) | ((epicsUInt32) p[1] << 16) |
+        ((epicsUInt32) p[2] << 8) | p[3];
+}
+
+/* copies n elements between host and network byte order */
+static void copyElements(epicsUInt8 *pdst, const epicsUInt8 *psrc,
+    size_t n, size_t elemSize)
+{
+#if EPICS_BYTE_ORDER == EPICS_ENDIAN_LITTLE
+    size_t i, k;
+
+    if (elemSize > 1) {
+        for (i = 0; i < n; i++, pdst += elemSize, psrc += elemSize)
+            for (k = 0; k < elemSize; k++)
+                pdst[k] = psrc[elemSize - 1 - k];
+        return;
+    }
+#endif
+    memcpy(pdst, psrc, n * elemSize);
+}
+
+/*
+ * nextDiff returns the first index from i on at which the arrays differ,
+ * nextSame the first at which they are equal, or n.
+ */
+#define SCAN_FUNCTIONS(type) \
+static size_t nextDiff_##type(const void *pa, const void *pb, \
+    size_t i, size_t n) \
+{ \
+    const type *a = (const type *) pa, *b = (const type *) pb; \
+\
+    while (i < n && a[i] == b[i]) \
+        i++; \
+    return i; \
+} \
+\
+static size_t nextSame_##type(const void *pa, const void *pb, \
+    size_t i, size_t n) \
+{ \
+    const type *a = (const type *) pa, *b = (const type *) pb; \
+\
+    while (i < n && a[i] != b[i]) \
+        i++; \
+    return i; \
+}
+
+SCAN_FUNCTIONS(epicsUInt8)
+SCAN_FUNCTIONS(epicsUInt16)
+SCAN_FUNCTIONS(epicsUInt32)
+SCAN_FUNCTIONS(epicsUInt64)
+
+typedef size_t (*scanFunc)(const void *pa, const void *pb,
+    size_t i, size_t n);
+
+size_t epicsDeltaMaxSize(size_t elemSize, size_t nElements)
+{
+    return EPICS_DELTA_HEADER_SIZE + EPICS_DELTA_RUN_SIZE +
+        elemSize * nElements;
+}
+
+static epicsUInt8 * putRun(epicsUInt8 *p, const epicsUInt8 *pcur,
+    size_t start, size_t end, size_t elemSize)
+{
+    putUInt32(p, (epicsUInt32) start);
+    putUInt32(p + 4, (epicsUInt32) (end - start));
+    p += EPICS_DELTA_RUN_SIZE;
+    copyElements(p, pcur + start * elemSize, end - start, elemSize);
+    return p + (end - start) * elemSize;
+}
+
+size_t epicsDeltaEncode(void *pmsg, const void *pprev, size_t nPrev,
+    const void *pcur, size_t nCur, size_t elemSize)
+{
+    epicsUInt8 *pstart = (epicsUInt8 *) pmsg;
+    epicsUInt8 *p = pstart + EPICS_DELTA_HEADER_SIZE;
+    const epicsUInt8 *pc = (const epicsUInt8 *) pcur;
+    epicsUInt32 nRuns = 0;
+    scanFunc nextDiff, nextSame;
+
+    switch (elemSize) {
+    case 1: nextDiff = nextDiff_epicsUInt8;  nextSame = nextSame_epicsUInt8;
+        break;
+    case 2: nextDiff = nextDiff_epicsUInt16; nextSame = nextSame_epicsUInt16;
+        break;
+    case 4: nextDiff = nextDiff_epicsUInt32; nextSame = nextSame_epicsUInt32;
+        break;
+    case 8: nextDiff = nextDiff_epicsUInt64; nextSame = nextSame_epicsUInt64;
+        break;
+    default:
+        return 0;
+    }
+
+    pstart[0] = 'D';
+    pstart[1] = 'L';
+    pstart[2] = VERSION;
+    pstart[3] = (epicsUInt8) elemSize;
+    putUInt32(pstart + 4, (epicsUInt32) nCur);
+
+    if (!pprev || nPrev != nCur) {
+        if (nCur > 0) {
+            p = putRun(p, pc, 0, nCur, elemSize);
+            nRuns = 1;
+        }
+    }
+    else {
+        /* a gap this short costs less than the header of a new run */
+        size_t maxGap = EPICS_DELTA_RUN_SIZE / elemSize;
+        size_t i = nextDiff(pprev, pcur, 0, nCur);
+
+        while (i < nCur) {
+            size_t start = i;
+            size_t end = nextSame(pprev, pcur, i, nCur);
+
+            while (end < nCur) {
+                i = nextDiff(pprev, pcur, end, nCur);
+                if (i >= nCur || i - end > maxGap)
+                    break;
+                end = nextSame(pprev, pcur, i, nCur);
+            }
+            p = putRun(p, pc, start, end, elemSize);
+            nRuns++;
+            if (end >= nCur)
+                break;
+        }
+    }
+    putUInt32(pstart + 8, nRuns);
+    return p - pstart;
+}
+
+long epicsDeltaDecode(void *parray, size_t maxElements, size_t elemSize,
+    const void *pmsg, size_t msgSize)
+{
+    const epicsUInt8 *p = (const epicsUInt8 *) pmsg;
+    const epicsUInt8 *pend = p + msgSize;
+    epicsUInt8 *pa = (epicsUInt8 *) parray;
+    epicsUInt32 nElements, nRuns, i;
+
+    if (msgSize < EPICS_DELTA_HEADER_SIZE || p[0] != 'D' || p[1] != 'L' ||
+            p[2] != VERSION || p[3] != elemSize)
+        return -1;
+    nElements = getUInt32(p + 4);
+    nRuns = getUInt32(p + 8);
+    if (nElements > maxElements)
+        return -1;
+    p += EPICS_DELTA_HEADER_SIZE;
+
+    for (i = 0; i < nRuns; i++) {
+        epicsUInt32 start, count;
+
+        if ((size_t) (pend - p) < EPICS_DELTA_RUN_SIZE)
+            return -1;
+        start = getUInt32(p);
+        count = getUInt32(p + 4);
+        p += EPICS_DELTA_RUN_SIZE;
+        if (start > nElements || count > nElements - start ||
+                (size_t) (pend - p) / elemSize < count)
+            return -1;
+        copyElements(pa + start * elemSize, p, count, elemSize);
+        p += count * elemSize;
+    }
+    return (long) nElements;
+}
+
+int epicsDeltaIsFullFrame(const void *pmsg, size_t msgSize)
+{
+    const epicsUInt8 *p = (const epicsUInt8 *) pmsg;
+    epicsUInt32 nElements, nRuns;
+
+    if (msgSize < EPICS_DELTA_HEADER_SIZE)
+        return 0;
+    nElements = getUInt32(p + 4);
+    nRuns = getUInt32(p + 8);
+    if (nElements == 0)
+        return nRuns == 0;
+    return nRuns == 1 &&
+        msgSize >= EPICS_DELTA_HEADER_SIZE + EPICS_DELTA_RUN_SIZE &&
+        getUInt32(p + EPICS_DELTA_HEADER_SIZE) == 0 &&
+        getUInt32(p + EPICS_DELTA_HEADER_SIZE + 4) == nElements;
+}
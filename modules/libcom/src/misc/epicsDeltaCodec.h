@@ -0,0 +1,101 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/**
+ * \file epicsDeltaCodec.h
+ *
+ * \brief Encoding of the changes between two versions of an array
+ *
+ * These routines are used by the \c delta channel filter, which sends
+ * only the ranges of an array that changed since the previous update.
+ * Clients apply each message to their copy of the array with
+ * epicsDeltaDecode().
+ *
+ * A message is a byte string. All integers in it are unsigned and in
+ * network byte order, as are the array elements.
+ *
+ * \verbatim
+   offset  size
+   0       2     'D' 'L'
+   2       1     format version, 1
+   3       1     element size in bytes, 1, 2, 4 or 8
+   4       4     number of elements in the array
+   8       4     number of runs that follow
+   12            runs: 4 bytes start index, 4 bytes element count,
+                 then the new values of those elements
+   \endverbatim
+ *
+ * A message that replaces the whole array is a full frame; it has one
+ * run covering all of the elements, or none for an empty array.
+ */
+
+#ifndef INC_epicsDeltaCodec_H
+#define INC_epicsDeltaCodec_H
+
+#include <stddef.h>
+
+#include "libComAPI.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \brief Size of the message header in bytes */
+#define EPICS_DELTA_HEADER_SIZE 12
+/** \brief Size of the header of each run in bytes */
+#define EPICS_DELTA_RUN_SIZE 8
+
+/** \brief Largest message for an array
+ *
+ * \param elemSize size of an element in bytes
+ * \param nElements number of elements
+ * \return the size of a full frame, which no message for an array of
+ *         this size exceeds.
+ */
+LIBCOM_API size_t epicsDeltaMaxSize(size_t elemSize, size_t nElements);
+
+/** \brief Encodes the changes of an array
+ *
+ * Ranges of unchanged elements that are shorter than a run header are
+ * included in the run around them.
+ *
+ * \param pmsg buffer of at least epicsDeltaMaxSize() bytes
+ * \param pprev the previous array, or NULL for a full frame
+ * \param nPrev the number of elements of the previous array; if it
+ *        differs from \p nCur a full frame is written
+ * \param pcur the new array
+ * \param nCur the number of elements of the new array
+ * \param elemSize size of an element in bytes, 1, 2, 4 or 8
+ * \return the size of the message in bytes, 0 if \p elemSize is invalid
+ */
+LIBCOM_API size_t epicsDeltaEncode(void *pmsg, const void *pprev,
+    size_t nPrev, const void *pcur, size_t nCur, size_t elemSize);
+
+/** \brief Applies a message to an array
+ *
+ * \param parray the array, holding the result of the previous message
+ * \param maxElements the capacity of \p parray in elements
+ * \param elemSize size of an element in bytes, must match the message
+ * \param pmsg the message
+ * \param msgSize the number of bytes available at \p pmsg; trailing
+ *        bytes after the last run are ignored
+ * \return the number of elements in the array, or -1 if the message is
+ *         malformed, has another element size, or does not fit.
+ */
+LIBCOM_API long epicsDeltaDecode(void *parray, size_t maxElements,
+    size_t elemSize, const void *pmsg, size_t msgSize);
+
+/** \brief Whether a message is a full frame
+ *
+ * \return non-zero if the message replaces all of the array.
+ */
+LIBCOM_API int epicsDeltaIsFullFrame(const void *pmsg, size_t msgSize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_epicsDeltaCodec_H */
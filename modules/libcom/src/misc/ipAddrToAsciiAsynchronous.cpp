@@ -14,6 +14,7 @@
  */
 
 #include <string>
+#include <map>
 #include <climits>
 #include <stdexcept>
 #include <cstdio>
@@ -28,6 +29,9 @@
 #include "epicsEvent.h"
 #include "epicsGuard.h"
 #include "epicsExit.h"
+#include "epicsTime.h"
+#include "epicsStdio.h"
+#include "envDefs.h"
 #include "tsDLList.h"
 #include "tsFreeList.h"
 #include "errlog.h"
@@ -51,6 +55,9 @@ public:
     osiSockAddr addr;
     ipAddrToAsciiEnginePrivate & engine;
     ipAddrToAsciiCallBack * pCB;
+    // the worker thread doing the lookup or the callback, if any
+    struct ipAddrToAsciiWorker * pWorker;
+    epicsUInt64 queuedAt;
     bool pending;
     void ipAddrToAscii ( const osiSockAddr &, ipAddrToAsciiCallBack & );
     void release ();
@@ -77,12 +84,43 @@ static void ipAddrToAsciiEngineGlobalMutexConstruct ( void * );
 }
 
 namespace {
-struct ipAddrToAsciiGlobal : public epicsThreadRunable {
-    ipAddrToAsciiGlobal();
-    virtual ~ipAddrToAsciiGlobal() {}
+struct ipAddrToAsciiGlobal;
+}
+
+// one of the threads that look up host names, all of which
+// take transactions from the same queue
+struct ipAddrToAsciiWorker : public epicsThreadRunable {
+    ipAddrToAsciiWorker ( ipAddrToAsciiGlobal &, const char * pName );
+    virtual ~ipAddrToAsciiWorker() {}
 
     virtual void run ();
 
+    ipAddrToAsciiGlobal & global;
+    epicsThread thread;
+    // pCurrent may be changed by any thread (worker or other)
+    ipAddrToAsciiTransactionPrivate * pCurrent;
+    // pActive may only be changed by the worker
+    ipAddrToAsciiTransactionPrivate * pActive;
+    bool callbackInProgress;
+};
+
+namespace {
+// a host name, or an empty name if the lookup failed
+struct nameCacheEntry {
+    std::string name;
+    epicsUInt64 expires;
+};
+
+struct ipAddrToAsciiGlobal {
+    ipAddrToAsciiGlobal();
+    ~ipAddrToAsciiGlobal();
+
+    void hostName ( epicsGuard < epicsMutex > &,
+        const osiSockAddr &, char * pBuf, unsigned bufSize );
+    const nameCacheEntry * cacheFind ( epicsUInt32 ip, epicsUInt64 now );
+    void cacheAdd ( epicsUInt32 ip, const char * pName, epicsUInt64 now );
+    bool callbackActiveFor ( const ipAddrToAsciiEnginePrivate & ) const;
+
     tsFreeList
         < ipAddrToAsciiTransactionPrivate, 0x80 >
             transactionFreeList;
@@ -90,19 +128,31 @@ struct ipAddrToAsciiGlobal : public epicsThreadRunable {
     mutable epicsMutex mutex;
     epicsEvent laborEvent;
     epicsEvent destructorBlockEvent;
-    epicsThread thread;
-    // pCurrent may be changed by any thread (worker or other)
-    ipAddrToAsciiTransactionPrivate * pCurrent;
-    // pActive may only be changed by the worker
-    ipAddrToAsciiTransactionPrivate * pActive;
+    std::map < epicsUInt32, nameCacheEntry > cache;
+    ipAddrToAsciiWorker ** ppWorkers;
+    unsigned nWorkers;
     unsigned cancelPendingCount;
+    ipAddrToAsciiEngine::resolver_t pResolver;
+    epicsUInt64 timeToLive; // ns
+    epicsUInt64 negativeTimeToLive; // ns
+    // statistics
+    unsigned long nRequests;
+    unsigned long nStarted;
+    unsigned long nOverflow;
+    unsigned long nHits;
+    unsigned long nNegativeHits;
+    unsigned long nLookups;
+    unsigned long nFailures;
+    unsigned maxQueued;
+    epicsUInt64 waitTotal, waitMax; // ns
+    epicsUInt64 lookupTotal, lookupMax; // ns
     bool exitFlag;
-    bool callbackInProgress;
 };
 }
 
 // - this class executes the synchronous DNS query
-// - it creates one thread
+// - the queries of all engines share the threads and host name
+//   cache of one ipAddrToAsciiGlobal
 class ipAddrToAsciiEnginePrivate :
     public ipAddrToAsciiEngine {
 public:
@@ -125,6 +175,11 @@ private:
 ipAddrToAsciiGlobal * ipAddrToAsciiEnginePrivate :: pEngine = 0;
 static epicsThreadOnceId ipAddrToAsciiEngineGlobalMutexOnceFlag = EPICS_THREAD_ONCE_INIT;
 
+// queue limit for each thread, past which requests complete early
+static const unsigned maxQueuedPerWorker = 16u;
+static const unsigned maxWorkers = 64u;
+static const size_t maxCacheEntries = 1024u;
+
 // the users are not required to supply a show routine
 // for there transaction callback class
 void ipAddrToAsciiCallBack::show ( unsigned /* level */ ) const {}
@@ -143,43 +198,251 @@ static void ipAddrToAsciiEngineGlobalMutexConstruct ( void * )
     }
 }
 
+static ipAddrToAsciiGlobal & ipAddrToAsciiGlobalInstance ()
+{
+    epicsThreadOnce (
+        & ipAddrToAsciiEngineGlobalMutexOnceFlag,
+        ipAddrToAsciiEngineGlobalMutexConstruct, 0 );
+    if(!ipAddrToAsciiEnginePrivate::pEngine)
+        throw std::runtime_error("ipAddrToAsciiEngine::allocate fails");
+    return *ipAddrToAsciiEnginePrivate::pEngine;
+}
+
 void ipAddrToAsciiEngine::cleanup()
 {
     {
         epicsGuard<epicsMutex> G(ipAddrToAsciiEnginePrivate::pEngine->mutex);
         ipAddrToAsciiEnginePrivate::pEngine->exitFlag = true;
     }
+    // each worker passes the signal on when it exits
     ipAddrToAsciiEnginePrivate::pEngine->laborEvent.signal();
-    ipAddrToAsciiEnginePrivate::pEngine->thread.exitWait();
     delete ipAddrToAsciiEnginePrivate::pEngine;
     ipAddrToAsciiEnginePrivate::pEngine = 0;
 }
 
 // for now its probably sufficent to allocate one
-// DNS transaction thread for all codes sharing
+// pool of DNS transaction threads for all codes sharing
 // the same process that need DNS services but we
 // leave our options open for the future
 ipAddrToAsciiEngine & ipAddrToAsciiEngine::allocate ()
 {
-    epicsThreadOnce (
-        & ipAddrToAsciiEngineGlobalMutexOnceFlag,
-        ipAddrToAsciiEngineGlobalMutexConstruct, 0 );
-    if(!ipAddrToAsciiEnginePrivate::pEngine)
-        throw std::runtime_error("ipAddrToAsciiEngine::allocate fails");
+    ipAddrToAsciiGlobalInstance ();
     return * new ipAddrToAsciiEnginePrivate();
 }
 
+void ipAddrToAsciiEngine::setResolver ( resolver_t pResolver )
+{
+    ipAddrToAsciiGlobal & global ( ipAddrToAsciiGlobalInstance () );
+    epicsGuard < epicsMutex > guard ( global.mutex );
+    global.pResolver = pResolver ? pResolver : ipAddrToHostName;
+}
+
+void ipAddrToAsciiEngine::flushCache ()
+{
+    ipAddrToAsciiGlobal & global ( ipAddrToAsciiGlobalInstance () );
+    epicsGuard < epicsMutex > guard ( global.mutex );
+    global.cache.clear ();
+}
+
+static epicsUInt64 timeToLiveParam ( const ENV_PARAM & param, double dflt )
+{
+    double timeToLive = dflt;
+    int status = envGetDoubleConfigParam ( &param, &timeToLive );
+    if ( status || timeToLive < 0.0 ) {
+        timeToLive = dflt;
+        errlogPrintf ( "EPICS \"%s\" must be zero or a positive number of seconds\n",
+            param.name );
+        errlogPrintf ( "Defaulting \"%s\" = %f\n", param.name, timeToLive );
+    }
+    return static_cast < epicsUInt64 > ( timeToLive * 1e9 );
+}
+
 ipAddrToAsciiGlobal::ipAddrToAsciiGlobal () :
     mutex(__FILE__, __LINE__),
-    thread ( *this, "ipToAsciiProxy",
+    ppWorkers ( 0 ), nWorkers ( 1u ), cancelPendingCount ( 0u ),
+    pResolver ( ipAddrToHostName ),
+    timeToLive ( timeToLiveParam ( EPICS_IP_TO_ASCII_CACHE_TTL, 300.0 ) ),
+    negativeTimeToLive ( timeToLiveParam ( EPICS_IP_TO_ASCII_NEG_CACHE_TTL, 30.0 ) ),
+    nRequests ( 0u ), nStarted ( 0u ), nOverflow ( 0u ), nHits ( 0u ), nNegativeHits ( 0u ),
+    nLookups ( 0u ), nFailures ( 0u ), maxQueued ( 0u ),
+    waitTotal ( 0u ), waitMax ( 0u ), lookupTotal ( 0u ), lookupMax ( 0u ),
+    exitFlag ( false )
+{
+    long nThreads = 1;
+    int status = envGetLongConfigParam ( &EPICS_IP_TO_ASCII_THREADS, &nThreads );
+    if ( status || nThreads < 1 || nThreads > long ( maxWorkers ) ) {
+        errlogPrintf ( "EPICS \"%s\" must be between 1 and %u\n",
+            EPICS_IP_TO_ASCII_THREADS.name, maxWorkers );
+        nThreads = 1;
+    }
+    this->nWorkers = static_cast < unsigned > ( nThreads );
+    this->ppWorkers = new ipAddrToAsciiWorker * [ this->nWorkers ];
+    unsigned i = 0u;
+    try {
+        for ( ; i < this->nWorkers; i++ ) {
+            char name[32];
+            if ( i == 0u ) {
+                strcpy ( name, "ipToAsciiProxy" );
+            }
+            else {
+                epicsSnprintf ( name, sizeof ( name ), "ipToAsciiProxy%u", i );
+            }
+            this->ppWorkers[i] = new ipAddrToAsciiWorker ( *this, name );
+        }
+    }
+    catch ( ... ) {
+        while ( i-- > 0u ) {
+            delete this->ppWorkers[i];
+        }
+        delete [] this->ppWorkers;
+        throw;
+    }
+    for ( i = 0u; i < this->nWorkers; i++ ) {
+        this->ppWorkers[i]->thread.start (); // start the thread
+    }
+}
+
+// the workers must have been asked to exit
+ipAddrToAsciiGlobal::~ipAddrToAsciiGlobal ()
+{
+    for ( unsigned i = 0u; i < this->nWorkers; i++ ) {
+        this->ppWorkers[i]->thread.exitWait ();
+        delete this->ppWorkers[i];
+    }
+    delete [] this->ppWorkers;
+}
+
+ipAddrToAsciiWorker::ipAddrToAsciiWorker (
+        ipAddrToAsciiGlobal & globalIn, const char * pName ) :
+    global ( globalIn ),
+    thread ( *this, pName,
         epicsThreadGetStackSize(epicsThreadStackBig),
         epicsThreadPriorityLow ),
-    pCurrent ( 0 ), pActive ( 0 ), cancelPendingCount ( 0u ), exitFlag ( false ),
-    callbackInProgress ( false )
+    pCurrent ( 0 ), pActive ( 0 ), callbackInProgress ( false )
 {
-    this->thread.start (); // start the thread
 }
 
+// called with the lock applied, returns 0 if the address
+// is not in the cache or its entry has expired
+const nameCacheEntry * ipAddrToAsciiGlobal::cacheFind (
+    epicsUInt32 ip, epicsUInt64 now )
+{
+    std::map < epicsUInt32, nameCacheEntry > :: iterator it =
+        this->cache.find ( ip );
+    if ( it == this->cache.end () ) {
+        return 0;
+    }
+    if ( now >= it->second.expires ) {
+        this->cache.erase ( it );
+        return 0;
+    }
+    return & it->second;
+}
+
+// called with the lock applied, an empty name records a failed lookup
+void ipAddrToAsciiGlobal::cacheAdd (
+    epicsUInt32 ip, const char * pName, epicsUInt64 now )
+{
+    epicsUInt64 ttl = *pName ? this->timeToLive : this->negativeTimeToLive;
+    if ( ttl == 0u ) {
+        return;
+    }
+    if ( this->cache.size () >= maxCacheEntries &&
+            this->cache.find ( ip ) == this->cache.end () ) {
+        // make room by removing the expired entries, or
+        // failing that the one that would expire first
+        std::map < epicsUInt32, nameCacheEntry > :: iterator it =
+            this->cache.begin ();
+        while ( it != this->cache.end () ) {
+            if ( now >= it->second.expires ) {
+                this->cache.erase ( it++ );
+            }
+            else {
+                ++it;
+            }
+        }
+        if ( this->cache.size () >= maxCacheEntries ) {
+            std::map < epicsUInt32, nameCacheEntry > :: iterator oldest =
+                this->cache.begin ();
+            for ( it = oldest; it != this->cache.end (); ++it ) {
+                if ( it->second.expires < oldest->second.expires ) {
+                    oldest = it;
+                }
+            }
+            this->cache.erase ( oldest );
+        }
+    }
+    nameCacheEntry & entry = this->cache[ip];
+    entry.name = pName;
+    entry.expires = now + ttl;
+}
+
+//
+// Called by a worker with the lock applied. The lock is released
+// while waiting for the name server.
+//
+void ipAddrToAsciiGlobal::hostName ( epicsGuard < epicsMutex > & guard,
+    const osiSockAddr & addr, char * pBuf, unsigned bufSize )
+{
+    if ( this->exitFlag || addr.sa.sa_family != AF_INET ) {
+        sockAddrToDottedIP ( & addr.sa, pBuf, bufSize );
+        return;
+    }
+    epicsUInt32 ip = addr.ia.sin_addr.s_addr;
+    unsigned short port = ntohs ( addr.ia.sin_port );
+    epicsUInt64 start = epicsMonotonicGet ();
+    const nameCacheEntry * pEntry = this->cacheFind ( ip, start );
+    if ( pEntry ) {
+        if ( pEntry->name.size () ) {
+            this->nHits++;
+            epicsSnprintf ( pBuf, bufSize, "%s:%hu", pEntry->name.c_str (), port );
+        }
+        else {
+            this->nNegativeHits++;
+            sockAddrToDottedIP ( & addr.sa, pBuf, bufSize );
+        }
+        return;
+    }
+
+    ipAddrToAsciiEngine::resolver_t pResolverNow = this->pResolver;
+    unsigned len;
+    {
+        epicsGuardRelease < epicsMutex > unguard ( guard );
+        // depending on DNS configuration, this could take a very long time
+        // so we release the lock
+        len = ( *pResolverNow ) ( & addr.ia.sin_addr, pBuf, bufSize );
+    }
+    epicsUInt64 done = epicsMonotonicGet ();
+    this->nLookups++;
+    this->lookupTotal += done - start;
+    if ( done - start > this->lookupMax ) {
+        this->lookupMax = done - start;
+    }
+    if ( len ) {
+        std::string name ( pBuf, len );
+        this->cacheAdd ( ip, name.c_str (), done );
+        epicsSnprintf ( pBuf, bufSize, "%s:%hu", name.c_str (), port );
+    }
+    else {
+        this->nFailures++;
+        this->cacheAdd ( ip, "", done );
+        sockAddrToDottedIP ( & addr.sa, pBuf, bufSize );
+    }
+}
+
+// called with the lock applied
+bool ipAddrToAsciiGlobal::callbackActiveFor (
+    const ipAddrToAsciiEnginePrivate & eng ) const
+{
+    for ( unsigned i = 0u; i < this->nWorkers; i++ ) {
+        const ipAddrToAsciiWorker & worker = *this->ppWorkers[i];
+        if ( worker.pActive && &eng == &worker.pActive->engine &&
+                ! worker.thread.isCurrentThread () ) {
+            return true;
+        }
+    }
+    return false;
+}
 
 void ipAddrToAsciiEnginePrivate::release ()
 {
@@ -205,16 +468,19 @@ void ipAddrToAsciiEnginePrivate::release ()
                 }
             }
 
-            // cancel transaction in lookup or callback
-            if (pEngine->pCurrent && this==&pEngine->pCurrent->engine) {
-                pEngine->pCurrent->pending = false;
-                pEngine->pCurrent = 0;
+            // cancel transactions in lookup or callback
+            for (unsigned i = 0u; i < pEngine->nWorkers; i++) {
+                ipAddrToAsciiWorker *worker = pEngine->ppWorkers[i];
+                if (worker->pCurrent && this==&worker->pCurrent->engine) {
+                    worker->pCurrent->pending = false;
+                    worker->pCurrent->pWorker = 0;
+                    worker->pCurrent = 0;
+                }
             }
 
-            // wait for completion of in-progress callback
+            // wait for completion of in-progress callbacks
             pEngine->cancelPendingCount++;
-            while(pEngine->pActive && this==&pEngine->pActive->engine
-                  && ! pEngine->thread.isCurrentThread()) {
+            while(pEngine->callbackActiveFor(*this)) {
                 epicsGuardRelease < epicsMutex > unguard ( guard );
                 pEngine->destructorBlockEvent.wait();
             }
@@ -231,14 +497,36 @@ void ipAddrToAsciiEnginePrivate::release ()
     }
 }
 
+static double meanMilliSec ( epicsUInt64 total, unsigned long count )
+{
+    return count ? total / 1e6 / count : 0.0;
+}
+
 void ipAddrToAsciiEnginePrivate::show ( unsigned level ) const
 {
     epicsGuard < epicsMutex > guard ( this->pEngine->mutex );
+    const ipAddrToAsciiGlobal & global = *this->pEngine;
     printf ( "ipAddrToAsciiEngine at %p with %u requests pending\n",
-        static_cast <const void *> (this), this->pEngine->labor.count () );
+        static_cast <const void *> (this), global.labor.count () );
+    printf ( "\t%u lookup threads, %lu requests, at most %u queued, "
+        "%lu completed early with a full queue\n",
+        global.nWorkers, global.nRequests, global.maxQueued,
+        global.nOverflow );
+    printf ( "\t%lu lookups, %lu failed, %.3f ms mean, %.3f ms max; "
+        "queue wait %.3f ms mean, %.3f ms max\n",
+        global.nLookups, global.nFailures,
+        meanMilliSec ( global.lookupTotal, global.nLookups ),
+        global.lookupMax / 1e6,
+        meanMilliSec ( global.waitTotal, global.nStarted ),
+        global.waitMax / 1e6 );
+    printf ( "\thost name cache: %u entries, %lu hits, %lu negative hits, "
+        "time to live %.0f s, negative %.0f s\n",
+        static_cast < unsigned > ( global.cache.size () ),
+        global.nHits, global.nNegativeHits,
+        global.timeToLive / 1e9, global.negativeTimeToLive / 1e9 );
     if ( level > 0u ) {
-        tsDLIter < ipAddrToAsciiTransactionPrivate >
-            pItem = this->pEngine->labor.firstIter ();
+        tsDLIterConst < ipAddrToAsciiTransactionPrivate >
+            pItem = global.labor.firstIter ();
         while ( pItem.valid () ) {
             pItem->show ( level - 1u );
             pItem++;
@@ -246,10 +534,10 @@ void ipAddrToAsciiEnginePrivate::show ( unsigned level ) const
     }
     if ( level > 1u ) {
         printf ( "mutex:\n" );
-        this->pEngine->mutex.show ( level - 2u );
+        global.mutex.show ( level - 2u );
         printf ( "laborEvent:\n" );
-        this->pEngine->laborEvent.show ( level - 2u );
-        printf ( "exitFlag  boolean = %u\n", this->pEngine->exitFlag );
+        global.laborEvent.show ( level - 2u );
+        printf ( "exitFlag  boolean = %u\n", global.exitFlag );
         printf ( "exit event:\n" );
     }
 }
@@ -295,71 +583,76 @@ ipAddrToAsciiTransaction & ipAddrToAsciiEnginePrivate::createTransaction ()
     return * ret;
 }
 
-void ipAddrToAsciiGlobal::run ()
+void ipAddrToAsciiWorker::run ()
 {
     std::vector<char> nameTmp(1024);
 
-    epicsGuard < epicsMutex > guard ( this->mutex );
-    while ( ! this->exitFlag ) {
-        {
-            epicsGuardRelease < epicsMutex > unguard ( guard );
-            this->laborEvent.wait ();
-        }
-        while ( true ) {
-            ipAddrToAsciiTransactionPrivate * pItem = this->labor.get ();
-            if ( ! pItem ) {
+    epicsGuard < epicsMutex > guard ( global.mutex );
+    while ( true ) {
+        ipAddrToAsciiTransactionPrivate * pItem = global.labor.get ();
+        if ( ! pItem ) {
+            if ( global.exitFlag ) {
                 break;
             }
-            osiSockAddr addr = pItem->addr;
-            this->pCurrent = pItem;
+            epicsGuardRelease < epicsMutex > unguard ( guard );
+            global.laborEvent.wait ();
+            continue;
+        }
+        if ( global.labor.count () ) {
+            // more work for the other threads
+            global.laborEvent.signal ();
+        }
+        osiSockAddr addr = pItem->addr;
+        epicsUInt64 wait = epicsMonotonicGet () - pItem->queuedAt;
+        global.nStarted++;
+        global.waitTotal += wait;
+        if ( wait > global.waitMax ) {
+            global.waitMax = wait;
+        }
+        pItem->pWorker = this;
+        this->pCurrent = pItem;
 
-            if ( this->exitFlag )
-            {
-                sockAddrToDottedIP ( & addr.sa, &nameTmp[0], nameTmp.size() );
-            }
-            else {
-                epicsGuardRelease < epicsMutex > unguard ( guard );
-                // depending on DNS configuration, this could take a very long time
-                // so we release the lock
-                sockAddrToA ( &addr.sa, &nameTmp[0], nameTmp.size() );
-            }
+        global.hostName ( guard, addr, &nameTmp[0], nameTmp.size() );
 
-            // the ipAddrToAsciiTransactionPrivate destructor is allowed to
-            // set pCurrent to nill and avoid blocking on a slow DNS
-            // operation
-            if ( ! this->pCurrent ) {
-                continue;
-            }
+        // the ipAddrToAsciiTransactionPrivate destructor is allowed to
+        // set pCurrent to nill and avoid blocking on a slow DNS
+        // operation
+        if ( ! this->pCurrent ) {
+            continue;
+        }
 
-            // fix for lp:1580623
-            // a destructing cac sets pCurrent to NULL, so
-            // make local copy to avoid race when releasing the guard
-            ipAddrToAsciiTransactionPrivate *pCur = pActive = pCurrent;
-            this->callbackInProgress = true;
+        // fix for lp:1580623
+        // a destructing cac sets pCurrent to NULL, so
+        // make local copy to avoid race when releasing the guard
+        ipAddrToAsciiTransactionPrivate *pCur = pActive = pCurrent;
+        this->callbackInProgress = true;
 
-            {
-                epicsGuardRelease < epicsMutex > unguard ( guard );
-                // don't call callback with lock applied
-                pCur->pCB->transactionComplete ( &nameTmp[0] );
-            }
+        {
+            epicsGuardRelease < epicsMutex > unguard ( guard );
+            // don't call callback with lock applied
+            pCur->pCB->transactionComplete ( &nameTmp[0] );
+        }
 
-            this->callbackInProgress = false;
-            pActive = 0;
+        this->callbackInProgress = false;
+        pActive = 0;
 
-            if ( this->pCurrent ) {
-                this->pCurrent->pending = false;
-                this->pCurrent = 0;
-            }
-            if ( this->cancelPendingCount  ) {
-                this->destructorBlockEvent.signal ();
-            }
+        if ( this->pCurrent ) {
+            this->pCurrent->pending = false;
+            this->pCurrent->pWorker = 0;
+            this->pCurrent = 0;
+        }
+        if ( global.cancelPendingCount  ) {
+            global.destructorBlockEvent.signal ();
         }
     }
+    // wake the next worker
+    global.laborEvent.signal ();
 }
 
 ipAddrToAsciiTransactionPrivate::ipAddrToAsciiTransactionPrivate
     ( ipAddrToAsciiEnginePrivate & engineIn ) :
-    engine ( engineIn ), pCB ( 0 ), pending ( false )
+    engine ( engineIn ), pCB ( 0 ), pWorker ( 0 ), queuedAt ( 0u ),
+    pending ( false )
 {
     memset ( & this->addr, '\0', sizeof ( this->addr ) );
     this->addr.sa.sa_family = AF_UNSPEC;
@@ -378,9 +671,10 @@ ipAddrToAsciiTransactionPrivate::~ipAddrToAsciiTransactionPrivate ()
     {
         epicsGuard < epicsMutex > guard ( pGlobal->mutex );
         while ( this->pending ) {
-            if ( pGlobal->pCurrent == this &&
-                    pGlobal->callbackInProgress &&
-                    ! pGlobal->thread.isCurrentThread() ) {
+            ipAddrToAsciiWorker * pWorkerNow = this->pWorker;
+            if ( pWorkerNow &&
+                    pWorkerNow->callbackInProgress &&
+                    ! pWorkerNow->thread.isCurrentThread() ) {
                 // cancel from another thread while callback in progress
                 // waits for callback to complete
                 assert ( pGlobal->cancelPendingCount < UINT_MAX );
@@ -399,9 +693,10 @@ ipAddrToAsciiTransactionPrivate::~ipAddrToAsciiTransactionPrivate ()
                 }
             }
             else {
-                if ( pGlobal->pCurrent == this ) {
+                if ( pWorkerNow ) {
                     // cancel from callback, or while lookup in progress
-                    pGlobal->pCurrent = 0;
+                    pWorkerNow->pCurrent = 0;
+                    this->pWorker = 0;
                 }
                 else {
                     // cancel before lookup starts
@@ -431,15 +726,32 @@ void ipAddrToAsciiTransactionPrivate::ipAddrToAscii (
             errlogPrintf("Warning: ipAddrToAscii on transaction with release()'d ipAddrToAsciiEngine");
             success = false;
 
-        } else if ( !this->pending && pGlobal->labor.count () < 16u ) {
+        } else if ( !this->pending && pGlobal->labor.count () <
+                maxQueuedPerWorker * pGlobal->nWorkers ) {
             // put some reasonable limit on queue expansion
             this->addr = addrIn;
             this->pCB = & cbIn;
             this->pending = true;
-            pGlobal->labor.add ( *this );
+            this->queuedAt = epicsMonotonicGet ();
+            // names already in the cache need not wait behind lookups
+            if ( addrIn.sa.sa_family == AF_INET &&
+                    pGlobal->cacheFind ( addrIn.ia.sin_addr.s_addr,
+                        this->queuedAt ) ) {
+                pGlobal->labor.push ( *this );
+            }
+            else {
+                pGlobal->labor.add ( *this );
+            }
+            pGlobal->nRequests++;
+            if ( pGlobal->labor.count () > pGlobal->maxQueued ) {
+                pGlobal->maxQueued = pGlobal->labor.count ();
+            }
             success = true;
         }
         else {
+            if ( ! this->engine.released && ! this->pending ) {
+                pGlobal->nOverflow++;
+            }
             success = false;
         }
     }
@@ -164,6 +164,15 @@ protected:
 public:
 #ifdef EPICS_PRIVATE_API
     static void cleanup();
+
+    /// Signature of ipAddrToHostName(), which is used by default
+    typedef unsigned ( epicsStdCall * resolver_t ) (
+        const struct in_addr *, char *, unsigned );
+    /// Replace the host name lookup function, or restore the default
+    /// when passed zero.  Intended for tests.
+    static void setResolver ( resolver_t );
+    /// Discard all cached host names and failed lookups
+    static void flushCache ();
 #endif
 };
 
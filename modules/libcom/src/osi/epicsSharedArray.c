@@ -0,0 +1,286 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ellLib.h"
+#include "epicsAtomic.h"
+#include "epicsExit.h"
+#include "epicsMutex.h"
+#include "epicsThread.h"
+#include "errlog.h"
+#include "epicsSharedArray.h"
+#include "epicsSharedArrayPvt.h"
+
+#define MAGIC "EPSA"
+#define VERSION 1
+#define FLAG_CLOSED 1u
+
+/* the layout documented in epicsSharedArray.h */
+typedef struct sharedHeader {
+    epicsUInt32 magic;
+    epicsUInt32 version;
+    epicsUInt32 dataOffset;
+    epicsUInt32 type;
+    epicsUInt32 elementSize;
+    epicsUInt32 flags;
+    epicsUInt64 capacity;
+    int sequence;
+    epicsUInt32 reserved;
+    epicsUInt64 count;
+    epicsUInt32 secPastEpoch;
+    epicsUInt32 nsec;
+    epicsUInt16 status;
+    epicsUInt16 severity;
+} sharedHeader;
+
+struct epicsSharedArray {
+    ELLNODE node;           /* in writers, if this is the writer */
+    sharedHeader *header;
+    char *data;
+    size_t size;
+    /* as validated by epicsSharedArrayOpen(), the header is writable */
+    unsigned type;
+    size_t elementSize;
+    size_t capacity;
+    void *pvt;
+    int writer;
+    char name[1];
+};
+
+/* tries of epicsSharedArrayRead() before it gives up */
+#define READ_TRIES 100
+
+static epicsThreadOnceId onceId = EPICS_THREAD_ONCE_INIT;
+static epicsMutexId writersLock;
+static ELLLIST writers = ELLLIST_INIT;
+
+/* the names of the arrays still open go away with the process */
+static void sharedArrayExit(void *arg)
+{
+    ELLNODE *node;
+
+    epicsMutexMustLock(writersLock);
+    for (node = ellFirst(&writers); node; node = ellNext(node)) {
+        epicsSharedArrayId id = (epicsSharedArrayId) node;
+
+        id->header->flags |= FLAG_CLOSED;
+        osdSharedMemRemove(id->name, id->pvt);
+    }
+    epicsMutexUnlock(writersLock);
+}
+
+static void sharedArrayOnce(void *arg)
+{
+    writersLock = epicsMutexMustCreate();
+    epicsAtExit(sharedArrayExit, NULL);
+}
+
+static epicsSharedArrayId newId(const char *name)
+{
+    size_t len = strlen(name);
+    epicsSharedArrayId id = calloc(1, sizeof(*id) + len);
+
+    if (id)
+        memcpy(id->name, name, len + 1);
+    return id;
+}
+
+epicsSharedArrayId epicsSharedArrayCreate(const char *name, unsigned type,
+    size_t elementSize, size_t capacity)
+{
+    epicsSharedArrayId id;
+    sharedHeader *header;
+
+    if (!name || !*name || elementSize == 0 || elementSize > 0xffffffffu ||
+            capacity > ((size_t) -1 - EPICS_SHARED_ARRAY_HEADER_SIZE) /
+                elementSize)
+        return NULL;
+
+    epicsThreadOnce(&onceId, sharedArrayOnce, NULL);
+    id = newId(name);
+    if (!id)
+        return NULL;
+    id->size = EPICS_SHARED_ARRAY_HEADER_SIZE + capacity * elementSize;
+    header = osdSharedMemCreate(name, id->size, &id->pvt);
+    if (!header) {
+        free(id);
+        return NULL;
+    }
+    id->header = header;
+    id->data = (char *) header + EPICS_SHARED_ARRAY_HEADER_SIZE;
+    id->writer = 1;
+    id->type = type;
+    id->elementSize = elementSize;
+    id->capacity = capacity;
+
+    header->version = VERSION;
+    header->dataOffset = EPICS_SHARED_ARRAY_HEADER_SIZE;
+    header->type = type;
+    header->elementSize = (epicsUInt32) elementSize;
+    header->capacity = capacity;
+    /* readers check the magic last */
+    epicsAtomicWriteMemoryBarrier();
+    memcpy(&header->magic, MAGIC, 4);
+
+    epicsMutexMustLock(writersLock);
+    ellAdd(&writers, &id->node);
+    epicsMutexUnlock(writersLock);
+    return id;
+}
+
+epicsSharedArrayId epicsSharedArrayOpen(const char *name)
+{
+    epicsSharedArrayId id;
+    sharedHeader header;
+
+    if (!name || !*name)
+        return NULL;
+    id = newId(name);
+    if (!id)
+        return NULL;
+    id->header = osdSharedMemOpen(name, &id->size, &id->pvt);
+    if (!id->header) {
+        free(id);
+        return NULL;
+    }
+    /* the magic is written last */
+    if (id->size < EPICS_SHARED_ARRAY_HEADER_SIZE ||
+            memcmp(&id->header->magic, MAGIC, 4) != 0) {
+        osdSharedMemUnmap(id->header, id->size, id->pvt);
+        free(id);
+        return NULL;
+    }
+    epicsAtomicReadMemoryBarrier();
+    /* the header can be written to, so check and keep one copy of it */
+    memcpy(&header, id->header, sizeof(header));
+    if (header.version != VERSION ||
+            header.dataOffset != EPICS_SHARED_ARRAY_HEADER_SIZE ||
+            header.elementSize == 0 ||
+            header.capacity > (id->size - EPICS_SHARED_ARRAY_HEADER_SIZE) /
+                header.elementSize) {
+        osdSharedMemUnmap(id->header, id->size, id->pvt);
+        free(id);
+        return NULL;
+    }
+    id->data = (char *) id->header + EPICS_SHARED_ARRAY_HEADER_SIZE;
+    id->type = header.type;
+    id->elementSize = header.elementSize;
+    id->capacity = (size_t) header.capacity;
+    return id;
+}
+
+void epicsSharedArrayClose(epicsSharedArrayId id)
+{
+    if (!id)
+        return;
+    if (id->writer) {
+        epicsMutexMustLock(writersLock);
+        ellDelete(&writers, &id->node);
+        epicsMutexUnlock(writersLock);
+        id->header->flags |= FLAG_CLOSED;
+        osdSharedMemRemove(id->name, id->pvt);
+    }
+    osdSharedMemUnmap(id->header, id->size, id->pvt);
+    free(id);
+}
+
+void * epicsSharedArrayWriteBegin(epicsSharedArrayId id)
+{
+    /* an atomic increment is a full barrier */
+    epicsAtomicIncrIntT(&id->header->sequence);
+    return id->data;
+}
+
+void epicsSharedArrayWriteEnd(epicsSharedArrayId id, size_t count,
+    const epicsTimeStamp *stamp, epicsUInt16 status, epicsUInt16 severity)
+{
+    sharedHeader *header = id->header;
+
+    if (count > id->capacity)
+        count = id->capacity;
+    header->count = count;
+    header->secPastEpoch = stamp ? stamp->secPastEpoch : 0;
+    header->nsec = stamp ? stamp->nsec : 0;
+    header->status = status;
+    header->severity = severity;
+    epicsAtomicWriteMemoryBarrier();
+    epicsAtomicIncrIntT(&header->sequence);
+}
+
+void epicsSharedArrayPublish(epicsSharedArrayId id, const void *pdata,
+    size_t count, const epicsTimeStamp *stamp, epicsUInt16 status,
+    epicsUInt16 severity)
+{
+    void *pdest = epicsSharedArrayWriteBegin(id);
+
+    if (count > id->capacity)
+        count = id->capacity;
+    memcpy(pdest, pdata, count * id->elementSize);
+    epicsSharedArrayWriteEnd(id, count, stamp, status, severity);
+}
+
+const void * epicsSharedArrayReadBegin(epicsSharedArrayId id,
+    epicsSharedArrayInfo *pinfo)
+{
+    const sharedHeader *header = id->header;
+    epicsUInt32 sequence;
+
+    sequence = (epicsUInt32) epicsAtomicGetIntT(&header->sequence);
+    epicsAtomicReadMemoryBarrier();
+    if ((sequence & 1) || (header->flags & FLAG_CLOSED))
+        return NULL;
+
+    pinfo->type = id->type;
+    pinfo->elementSize = id->elementSize;
+    pinfo->capacity = id->capacity;
+    pinfo->count = (size_t) header->count;
+    pinfo->generation = sequence >> 1;
+    pinfo->stamp.secPastEpoch = header->secPastEpoch;
+    pinfo->stamp.nsec = header->nsec;
+    pinfo->status = header->status;
+    pinfo->severity = header->severity;
+    /* a torn count must not take a reader out of the region */
+    if (pinfo->count > pinfo->capacity)
+        pinfo->count = pinfo->capacity;
+    return id->data;
+}
+
+int epicsSharedArrayReadValidate(epicsSharedArrayId id,
+    const epicsSharedArrayInfo *pinfo)
+{
+    epicsAtomicReadMemoryBarrier();
+    return (epicsUInt32) epicsAtomicGetIntT(&id->header->sequence) ==
+        pinfo->generation << 1;
+}
+
+long epicsSharedArrayRead(epicsSharedArrayId id, void *pbuf,
+    size_t maxCount, epicsSharedArrayInfo *pinfo)
+{
+    epicsSharedArrayInfo info;
+    int i;
+
+    for (i = 0; i < READ_TRIES; i++) {
+        const void *pdata = epicsSharedArrayReadBegin(id, &info);
+        size_t count;
+
+        if (!pdata) {
+            if (id->header->flags & FLAG_CLOSED)
+                return -1;
+            epicsThreadSleep(0.0);
+            continue;
+        }
+        count = info.count < maxCount ? info.count : maxCount;
+        memcpy(pbuf, pdata, count * info.elementSize);
+        if (epicsSharedArrayReadValidate(id, &info)) {
+            if (pinfo)
+                *pinfo = info;
+            return (long) count;
+        }
+    }
+    return -1;
+}
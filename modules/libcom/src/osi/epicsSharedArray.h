@@ -0,0 +1,177 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/**
+ * \file epicsSharedArray.h
+ *
+ * \brief Arrays published in named shared memory
+ *
+ * A writer, usually an array record, creates a named shared memory
+ * region and copies each new version of its array into it. Other
+ * processes on the same host open the region by name and read consistent
+ * snapshots of the array directly from memory, without Channel Access.
+ *
+ * The region starts with a header of EPICS_SHARED_ARRAY_HEADER_SIZE bytes
+ * followed by the elements. All values are in host byte order.
+ *
+ * \verbatim
+   offset  size
+   0       4     magic, 'E' 'P' 'S' 'A'
+   4       4     format version, 1
+   8       4     offset of the first element, 64
+   12      4     element type, chosen by the writer; array records use
+                 the DBF_ type code of FTVL
+   16      4     element size in bytes
+   20      4     flags, bit 0 is set when the writer has closed the array
+   24      8     capacity in elements
+   32      4     sequence number, odd while the writer changes the array
+   36      4     reserved
+   40      8     number of elements in the array
+   48      4     time stamp, seconds past the EPICS epoch
+   52      4     time stamp, nanoseconds
+   56      2     alarm status
+   58      2     alarm severity
+   \endverbatim
+ *
+ * The sequence number makes the header and the elements a sequence lock:
+ * a reader notes the number, copies what it needs, and then checks that
+ * the number is even and has not changed. Otherwise the copy may be torn
+ * and must be retried. Half of the sequence number is the generation of
+ * the array, which readers can poll to detect updates.
+ *
+ * This is supported on POSIX systems and Windows. Elsewhere
+ * epicsSharedArrayCreate() and epicsSharedArrayOpen() return NULL.
+ */
+
+#ifndef INC_epicsSharedArray_H
+#define INC_epicsSharedArray_H
+
+#include <stddef.h>
+
+#include "libComAPI.h"
+#include "epicsTime.h"
+#include "epicsTypes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \brief Size of the header before the first element */
+#define EPICS_SHARED_ARRAY_HEADER_SIZE 64
+
+/** \brief Handle of a shared array */
+typedef struct epicsSharedArray *epicsSharedArrayId;
+
+/** \brief Description of a snapshot */
+typedef struct epicsSharedArrayInfo {
+    unsigned type;          /**< \brief Element type set by the writer */
+    size_t elementSize;     /**< \brief Element size in bytes */
+    size_t capacity;        /**< \brief Maximum number of elements */
+    size_t count;           /**< \brief Number of elements in the array */
+    epicsUInt32 generation; /**< \brief Number of updates, modulo 2^31 */
+    epicsTimeStamp stamp;   /**< \brief Time stamp of the update */
+    epicsUInt16 status;     /**< \brief Alarm status of the update */
+    epicsUInt16 severity;   /**< \brief Alarm severity of the update */
+} epicsSharedArrayInfo;
+
+/** \brief Creates a shared array for writing
+ *
+ * A region of the same name left behind by a process that exited is
+ * replaced. Readers that still have it open see it as closed. The name
+ * is removed from the system when the array is closed or the process
+ * calls epicsExit().
+ *
+ * \param name name of the region; a '/' is prepended on POSIX systems if
+ *        it has none
+ * \param type element type stored in the header for readers
+ * \param elementSize size of an element in bytes
+ * \param capacity maximum number of elements
+ * \return the handle, or NULL if the region could not be created.
+ */
+LIBCOM_API epicsSharedArrayId epicsSharedArrayCreate(const char *name,
+    unsigned type, size_t elementSize, size_t capacity);
+
+/** \brief Opens an existing shared array for reading
+ *
+ * \return the handle, or NULL if there is no valid region of that name.
+ */
+LIBCOM_API epicsSharedArrayId epicsSharedArrayOpen(const char *name);
+
+/** \brief Closes a shared array
+ *
+ * If the array was created by this handle it is marked closed for its
+ * readers and its name is removed.
+ */
+LIBCOM_API void epicsSharedArrayClose(epicsSharedArrayId id);
+
+/** \brief Starts an update of the array
+ *
+ * Readers retry until epicsSharedArrayWriteEnd() is called, so the update
+ * should be short. Only the creator of the array may write to it, and
+ * from one thread at a time.
+ *
+ * \return the first element, where up to the capacity may be written.
+ */
+LIBCOM_API void * epicsSharedArrayWriteBegin(epicsSharedArrayId id);
+
+/** \brief Ends an update started by epicsSharedArrayWriteBegin()
+ *
+ * \param count number of elements now in the array, at most the capacity
+ * \param stamp time stamp of the update, or NULL for none
+ * \param status alarm status of the update
+ * \param severity alarm severity of the update
+ */
+LIBCOM_API void epicsSharedArrayWriteEnd(epicsSharedArrayId id,
+    size_t count, const epicsTimeStamp *stamp, epicsUInt16 status,
+    epicsUInt16 severity);
+
+/** \brief Copies an array into the shared array as one update
+ *
+ * \param count number of elements at \p pdata; more than the capacity
+ *        are ignored
+ */
+LIBCOM_API void epicsSharedArrayPublish(epicsSharedArrayId id,
+    const void *pdata, size_t count, const epicsTimeStamp *stamp,
+    epicsUInt16 status, epicsUInt16 severity);
+
+/** \brief Copies a consistent snapshot of the array
+ *
+ * Retries for a short while if the writer is busy.
+ *
+ * \param pbuf buffer for the elements
+ * \param maxCount capacity of \p pbuf in elements
+ * \param pinfo if not NULL, receives the description of the snapshot
+ * \return the number of elements copied, or -1 if the array is closed or
+ *         no consistent snapshot could be read.
+ */
+LIBCOM_API long epicsSharedArrayRead(epicsSharedArrayId id, void *pbuf,
+    size_t maxCount, epicsSharedArrayInfo *pinfo);
+
+/** \brief Starts reading the array in place, without copying it
+ *
+ * The elements may change while they are used. The result is only valid
+ * if epicsSharedArrayReadValidate() succeeds for \p pinfo afterwards.
+ *
+ * \param pinfo receives the description of the array
+ * \return the first element, or NULL if the array is closed or the
+ *         writer is busy.
+ */
+LIBCOM_API const void * epicsSharedArrayReadBegin(epicsSharedArrayId id,
+    epicsSharedArrayInfo *pinfo);
+
+/** \brief Checks that reading in place saw a consistent array
+ *
+ * \return non-zero if the array did not change since the call to
+ *         epicsSharedArrayReadBegin() that filled \p pinfo.
+ */
+LIBCOM_API int epicsSharedArrayReadValidate(epicsSharedArrayId id,
+    const epicsSharedArrayInfo *pinfo);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_epicsSharedArray_H */
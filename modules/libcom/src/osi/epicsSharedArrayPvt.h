@@ -0,0 +1,41 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* Operating system interface of epicsSharedArray.c, in osdSharedMem.c */
+
+#ifndef INC_epicsSharedArrayPvt_H
+#define INC_epicsSharedArrayPvt_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Creates a zeroed region of size bytes mapped for writing, replacing
+ * one of the same name. Returns its address or NULL. *ppvt receives
+ * what the other calls need.
+ */
+void * osdSharedMemCreate(const char *name, size_t size, void **ppvt);
+
+/* Maps an existing region for reading. Returns its address or NULL,
+ * with its size in *psize.
+ */
+void * osdSharedMemOpen(const char *name, size_t *psize, void **ppvt);
+
+/* Removes the name of a region made by osdSharedMemCreate(); the
+ * mappings stay valid.
+ */
+void osdSharedMemRemove(const char *name, void *pvt);
+
+/* Unmaps a region and releases pvt */
+void osdSharedMemUnmap(void *addr, size_t size, void *pvt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_epicsSharedArrayPvt_H */
@@ -0,0 +1,80 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* osi/os/WIN32/osdSharedMem.c */
+
+/*
+ * A named file mapping backed by the paging file. Windows removes it
+ * when the last handle to it is closed, so there is no name to remove.
+ */
+
+#define VC_EXTRALEAN
+#define STRICT
+#include <windows.h>
+
+#include "errlog.h"
+#include "epicsSharedArrayPvt.h"
+
+void * osdSharedMemCreate(const char *name, size_t size, void **ppvt)
+{
+    unsigned long long size64 = size;
+    HANDLE map;
+    void *addr;
+
+    *ppvt = NULL;
+    map = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+        (DWORD) (size64 >> 32), (DWORD) size64, name);
+    if (!map) {
+        errlogPrintf("osdSharedMemCreate: CreateFileMapping(\"%s\") "
+            "failed: %lu\n", name, (unsigned long) GetLastError());
+        return NULL;
+    }
+    if (GetLastError() == ERROR_ALREADY_EXISTS) {
+        errlogPrintf("osdSharedMemCreate: \"%s\" is in use\n", name);
+        CloseHandle(map);
+        return NULL;
+    }
+    addr = MapViewOfFile(map, FILE_MAP_WRITE, 0, 0, size);
+    if (!addr) {
+        CloseHandle(map);
+        return NULL;
+    }
+    /* pages of a new mapping are zero */
+    *ppvt = map;
+    return addr;
+}
+
+void * osdSharedMemOpen(const char *name, size_t *psize, void **ppvt)
+{
+    MEMORY_BASIC_INFORMATION info;
+    HANDLE map;
+    void *addr;
+
+    *ppvt = NULL;
+    map = OpenFileMappingA(FILE_MAP_READ, FALSE, name);
+    if (!map)
+        return NULL;
+    addr = MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+    if (!addr || !VirtualQuery(addr, &info, sizeof(info))) {
+        if (addr)
+            UnmapViewOfFile(addr);
+        CloseHandle(map);
+        return NULL;
+    }
+    *psize = info.RegionSize;
+    *ppvt = map;
+    return addr;
+}
+
+void osdSharedMemRemove(const char *name, void *pvt)
+{
+}
+
+void osdSharedMemUnmap(void *addr, size_t size, void *pvt)
+{
+    UnmapViewOfFile(addr);
+    if (pvt)
+        CloseHandle((HANDLE) pvt);
+}
@@ -0,0 +1,32 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* osi/os/default/osdSharedMem.c */
+
+/* Named shared memory is not supported on this target */
+
+#include "errlog.h"
+#include "epicsSharedArrayPvt.h"
+
+void * osdSharedMemCreate(const char *name, size_t size, void **ppvt)
+{
+    errlogPrintf("osdSharedMemCreate: not supported on this target\n");
+    *ppvt = NULL;
+    return NULL;
+}
+
+void * osdSharedMemOpen(const char *name, size_t *psize, void **ppvt)
+{
+    *ppvt = NULL;
+    return NULL;
+}
+
+void osdSharedMemRemove(const char *name, void *pvt)
+{
+}
+
+void osdSharedMemUnmap(void *addr, size_t size, void *pvt)
+{
+}
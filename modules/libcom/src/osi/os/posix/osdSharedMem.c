@@ -0,0 +1,102 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* osi/os/posix/osdSharedMem.c */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "epicsStdio.h"
+#include "errlog.h"
+#include "epicsSharedArrayPvt.h"
+
+/* shm_open() wants a name with one leading '/' */
+static int shmName(char *buf, size_t size, const char *name)
+{
+    int n = epicsSnprintf(buf, size, "%s%s", name[0] == '/' ? "" : "/",
+        name);
+
+    return n > 0 && (size_t) n < size ? 0 : -1;
+}
+
+void * osdSharedMemCreate(const char *name, size_t size, void **ppvt)
+{
+    char path[256];
+    void *addr;
+    int fd;
+
+    *ppvt = NULL;
+    if (shmName(path, sizeof(path), name))
+        return NULL;
+
+    /* readers of a region left behind keep their old mapping */
+    shm_unlink(path);
+    fd = shm_open(path, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        errlogPrintf("osdSharedMemCreate: shm_open(\"%s\") failed: %s\n",
+            path, strerror(errno));
+        return NULL;
+    }
+    if (ftruncate(fd, (off_t) size) != 0) {
+        errlogPrintf("osdSharedMemCreate: ftruncate(\"%s\", %lu) failed: "
+            "%s\n", path, (unsigned long) size, strerror(errno));
+        close(fd);
+        shm_unlink(path);
+        return NULL;
+    }
+    addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        errlogPrintf("osdSharedMemCreate: mmap(\"%s\") failed: %s\n",
+            path, strerror(errno));
+        shm_unlink(path);
+        return NULL;
+    }
+    return addr;
+}
+
+void * osdSharedMemOpen(const char *name, size_t *psize, void **ppvt)
+{
+    char path[256];
+    struct stat st;
+    void *addr;
+    int fd;
+
+    *ppvt = NULL;
+    if (shmName(path, sizeof(path), name))
+        return NULL;
+
+    fd = shm_open(path, O_RDONLY, 0);
+    if (fd < 0)
+        return NULL;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return NULL;
+    }
+    addr = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+        return NULL;
+    *psize = (size_t) st.st_size;
+    return addr;
+}
+
+void osdSharedMemRemove(const char *name, void *pvt)
+{
+    char path[256];
+
+    if (!shmName(path, sizeof(path), name))
+        shm_unlink(path);
+}
+
+void osdSharedMemUnmap(void *addr, size_t size, void *pvt)
+{
+    munmap(addr, size);
+}
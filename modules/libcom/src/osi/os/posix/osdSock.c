@@ -167,11 +167,30 @@ LIBCOM_API void epicsStdCall epicsSocketDestroy ( SOCKET s )
 /*
  * ipAddrToHostName
  * On many systems, gethostbyaddr must be protected by a
- * mutex since the routine is not thread-safe.
+ * mutex since the routine is not thread-safe. Where getnameinfo
+ * is available it is used instead, so that several threads can
+ * wait for the name server at the same time.
  */
 LIBCOM_API unsigned epicsStdCall ipAddrToHostName 
             (const struct in_addr *pAddr, char *pBuf, unsigned bufSize)
 {
+#if !defined(__rtems__)
+    struct sockaddr_in addr;
+
+    if (bufSize<1) {
+        return 0;
+    }
+
+    memset (&addr, 0, sizeof (addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr = *pAddr;
+    if (getnameinfo ((struct sockaddr *) &addr, sizeof (addr),
+            pBuf, bufSize, NULL, 0, NI_NAMEREQD) != 0) {
+        return 0;
+    }
+    pBuf[bufSize-1] = '\0';
+    return strlen (pBuf);
+#else
     struct hostent *ent;
     int ret = 0;
 
@@ -188,6 +207,7 @@ LIBCOM_API unsigned epicsStdCall ipAddrToHostName
     }
     unlockInfo ();
     return ret;
+#endif
 }
 
 /*
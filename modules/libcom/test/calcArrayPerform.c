@@ -0,0 +1,110 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/*
+ * Measure calcArrayPerform() against calling calcPerform() once for each
+ * element, which is what a calc record per channel amounts to.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cantProceed.h"
+#include "dbDefs.h"
+#include "epicsMath.h"
+#include "epicsTime.h"
+#include "postfix.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#define NELEM 100000
+#define NREP 20
+
+static double *a, *b, *result;
+
+static void measure(const char *expr, epicsUInt32 n)
+{
+    const double *args[CALCPERFORM_NARGS] = {0};
+    epicsUInt32 counts[CALCPERFORM_NARGS] = {0};
+    char rpn[INFIX_TO_POSTFIX_SIZE(100)];
+    double c = 0.5, scalarTime = 0, arrayTime = 0;
+    epicsTimeStamp start, stop;
+    epicsUInt32 nResult = n;
+    double *work;
+    short err;
+    int rep;
+
+    args[0] = a;
+    args[1] = b;
+    args[2] = &c;
+    counts[0] = counts[1] = n;
+    counts[2] = 1;
+
+    if (postfix(expr, rpn, &err))
+        testAbort("postfix: %s in expression '%s'", calcErrorStr(err), expr);
+    work = malloc(calcArrayWorkSize(rpn) * sizeof(double));
+    if (!work)
+        testAbort("no memory for the workspace of '%s'", expr);
+    testOk(calcArrayPerform(args, counts, result, &nResult, rpn, work) == 0 &&
+           nResult == n, "%s, %u elements", expr, n);
+
+    for (rep = 0; rep < NREP; rep++) {
+        epicsUInt32 i;
+
+        epicsTimeGetCurrent(&start);
+        for (i = 0; i < n; i++) {
+            double arg[CALCPERFORM_NARGS] = {0};
+
+            arg[0] = a[i];
+            arg[1] = b[i];
+            arg[2] = c;
+            calcPerform(arg, &result[i], rpn);
+        }
+        epicsTimeGetCurrent(&stop);
+        scalarTime += epicsTimeDiffInSeconds(&stop, &start);
+
+        nResult = n;
+        epicsTimeGetCurrent(&start);
+        calcArrayPerform(args, counts, result, &nResult, rpn, work);
+        epicsTimeGetCurrent(&stop);
+        arrayTime += epicsTimeDiffInSeconds(&stop, &start);
+    }
+    testDiag("%-32s calcPerform %7.1f ns/element, calcArrayPerform "
+             "%6.2f ns/element", expr, scalarTime / NREP / n * 1e9,
+             arrayTime / NREP / n * 1e9);
+    free(work);
+}
+
+MAIN(calcArrayPerform)
+{
+    static const char *exprs[] = {
+        "A*C+B",
+        "A>B?A:B",
+        "SQRT(A*A+B*B)",
+        "(A-AMIN(A))/(AMAX(A)-AMIN(A))",
+        "SIN(A)*C",
+    };
+    int i;
+
+    testPlan(2 * NELEMENTS(exprs));
+
+    a = callocMustSucceed(NELEM, sizeof(double), "calcArrayPerform");
+    b = callocMustSucceed(NELEM, sizeof(double), "calcArrayPerform");
+    result = callocMustSucceed(NELEM, sizeof(double), "calcArrayPerform");
+    for (i = 0; i < NELEM; i++) {
+        a[i] = sin(i * 0.001);
+        b[i] = i % 97 - 48.0;
+    }
+
+    for (i = 0; i < NELEMENTS(exprs); i++) {
+        measure(exprs[i], 1000);
+        measure(exprs[i], NELEM);
+    }
+
+    free(a);
+    free(b);
+    free(result);
+    return testDone();
+}
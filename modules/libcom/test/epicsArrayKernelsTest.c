@@ -0,0 +1,141 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <math.h>
+#include <string.h>
+
+#include "dbDefs.h"
+#include "epicsMath.h"
+#include "epicsTypes.h"
+#include "epicsArrayKernels.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+/* not a multiple of the lanes, so the tails are used */
+#define N 103
+
+static double a[N], b[N], y[N];
+
+static void testReductions(void)
+{
+    double sum = 0.0, dot = 0.0, lo, hi;
+    double s, d;
+    int i;
+
+    testDiag("Reductions");
+
+    for (i = 0; i < N; i++) {
+        a[i] = i % 7 - 3.25;
+        b[i] = i * 0.5;
+        sum += a[i];
+        dot += a[i] * b[i];
+    }
+    s = epicsArraySum(a, N);
+    d = epicsArrayDot(a, b, N);
+    testOk(s == sum, "sum %g, expected %g", s, sum);
+    testOk(d == dot, "dot %g, expected %g", d, dot);
+    testOk1(epicsArraySum(a, 0) == 0.0);
+
+    lo = epicsArrayMin(a, N);
+    hi = epicsArrayMax(b, N);
+    testOk(lo == -3.25, "min %g", lo);
+    testOk(hi == (N - 1) * 0.5, "max %g", hi);
+    lo = epicsArrayMin(a, 1);
+    testOk(lo == a[0], "min of one element %g", lo);
+
+    a[N - 2] = epicsNAN;
+    lo = epicsArrayMin(a, N);
+    hi = epicsArrayMax(a, N);
+    testOk(lo == -3.25 && hi == 2.75, "a NaN after the first element is "
+        "ignored, min %g max %g", lo, hi);
+    a[0] = epicsNAN;
+    lo = epicsArrayMin(a, N);
+    hi = epicsArrayMax(a, N);
+    testOk(isnan(lo) && isnan(hi), "a NaN in the first element is "
+        "returned, min %g max %g", lo, hi);
+}
+
+static void testElementWise(void)
+{
+    int i, nBad;
+
+    testDiag("Element-wise");
+
+    for (i = 0; i < N; i++) {
+        a[i] = i - 50.0;
+        b[i] = i * 0.25;
+    }
+
+    epicsArrayScaleOffset(y, a, N, 2.0, 1.0);
+    for (nBad = 0, i = 0; i < N; i++)
+        nBad += y[i] != a[i] * 2.0 + 1.0;
+    testOk(nBad == 0, "scale and offset, %d wrong", nBad);
+
+    epicsArrayAdd(y, a, b, N);
+    for (nBad = 0, i = 0; i < N; i++)
+        nBad += y[i] != a[i] + b[i];
+    testOk(nBad == 0, "add, %d wrong", nBad);
+
+    epicsArrayMul(y, a, b, N);
+    for (nBad = 0, i = 0; i < N; i++)
+        nBad += y[i] != a[i] * b[i];
+    testOk(nBad == 0, "mul, %d wrong", nBad);
+
+    memcpy(y, b, sizeof(y));
+    epicsArrayAxpy(y, a, N, 3.0);
+    for (nBad = 0, i = 0; i < N; i++)
+        nBad += y[i] != b[i] + 3.0 * a[i];
+    testOk(nBad == 0, "axpy, %d wrong", nBad);
+
+    memcpy(y, b, sizeof(y));
+    epicsArrayAddScale(y, a, N, 0.5);
+    for (nBad = 0, i = 0; i < N; i++)
+        nBad += y[i] != (b[i] + a[i]) * 0.5;
+    testOk(nBad == 0, "add and scale, %d wrong", nBad);
+}
+
+static void testStride(void)
+{
+    static const size_t sizes[] = {1, 2, 4, 8, 3};
+    /* 8 bytes more, to misalign the source */
+    epicsUInt64 from[3 * N + 1];
+    epicsUInt64 to[N];
+    unsigned i;
+
+    testDiag("Strided copies");
+
+    for (i = 0; i < sizeof(from); i++)
+        ((epicsUInt8 *) from)[i] = (epicsUInt8) (i * 37 + 1);
+
+    for (i = 0; i < NELEMENTS(sizes) * 2; i++) {
+        size_t size = sizes[i / 2];
+        const char *psrc = (const char *) from + (i % 2);
+        size_t k;
+        int nBad = 0;
+
+        memset(to, 0, sizeof(to));
+        epicsArrayStride(to, psrc, size, N / 3, 3);
+        for (k = 0; k < N / 3; k++)
+            nBad += memcmp((char *) to + k * size, psrc + 3 * k * size,
+                size) != 0;
+        testOk(nBad == 0, "%u byte elements, %s, %d wrong",
+            (unsigned) size, i % 2 ? "misaligned" : "aligned", nBad);
+    }
+}
+
+MAIN(epicsArrayKernelsTest)
+{
+    testPlan(23);
+
+    testDiag("The AVX2 kernels are %sused",
+        epicsArrayKernelsAvx2() ? "" : "not ");
+
+    testReductions();
+    testElementWise();
+    testStride();
+
+    return testDone();
+}
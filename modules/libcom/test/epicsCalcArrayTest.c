@@ -0,0 +1,323 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "dbDefs.h"
+#include "epicsUnitTest.h"
+#include "epicsMath.h"
+#include "epicsTypes.h"
+#include "postfix.h"
+#include "testMain.h"
+
+/* not a multiple of the block size of calcArrayPerform() */
+#define N 1000
+
+static double a[N], b[N], c = 0.75, d[N];
+static double val[N], result[N], expect[N];
+static const double *args[CALCPERFORM_NARGS];
+static epicsUInt32 counts[CALCPERFORM_NARGS];
+
+static char * compile(const char *expr)
+{
+    char *rpn = malloc(INFIX_TO_POSTFIX_SIZE(strlen(expr) + 1));
+    short err;
+
+    if (!rpn)
+        testAbort("postfix: %s no memory", expr);
+    if (postfix(expr, rpn, &err)) {
+        testDiag("postfix: %s in expression '%s'", calcErrorStr(err), expr);
+        free(rpn);
+        return NULL;
+    }
+    return rpn;
+}
+
+static int same(double x, double y)
+{
+    return x == y || (isnan(x) && isnan(y));
+}
+
+/* A, B and D are arrays, C is a single value */
+static void setArgs(epicsUInt32 na, epicsUInt32 nb, epicsUInt32 nd)
+{
+    memset((void *) args, 0, sizeof(args));
+    args[0] = a;
+    args[1] = b;
+    args[2] = &c;
+    args[3] = d;
+    counts[0] = na;
+    counts[1] = nb;
+    counts[2] = 1;
+    counts[3] = nd;
+}
+
+/* compares with calcPerform() for each element */
+static void testElements(const char *expr)
+{
+    char *rpn = compile(expr);
+    epicsUInt32 i, n = N;
+    long bad = 0;
+
+    if (!rpn) {
+        testFail("%s: doesn't compile", expr);
+        return;
+    }
+    for (i = 0; i < N; i++) {
+        double arg[CALCPERFORM_NARGS] = {0.0};
+
+        arg[0] = a[i];
+        arg[1] = b[i];
+        arg[2] = c;
+        arg[3] = d[i];
+        expect[i] = val[i];
+        if (calcPerform(arg, &expect[i], rpn))
+            testAbort("calcPerform failed for '%s'", expr);
+    }
+    memcpy(result, val, sizeof(result));
+    if (calcArrayPerform(args, counts, result, &n, rpn, NULL)) {
+        testFail("%s: calcArrayPerform failed", expr);
+        free(rpn);
+        return;
+    }
+    for (i = 0; i < n; i++) {
+        if (!same(result[i], expect[i]) && bad++ < 3)
+            testDiag("%s: [%u] %.17g != %.17g", expr, i, result[i],
+                     expect[i]);
+    }
+    testOk(n == N && bad == 0, "%s: %u elements, %ld differ", expr, n, bad);
+    free(rpn);
+}
+
+/* evaluates expr, returns the number of results or -1 on error */
+static long evaluate(const char *expr, epicsUInt32 capacity)
+{
+    char *rpn = compile(expr);
+    epicsUInt32 n = capacity;
+    long status;
+
+    if (!rpn)
+        return -1;
+    status = calcArrayPerform(args, counts, result, &n, rpn, NULL);
+    free(rpn);
+    return status ? -1 : (long) n;
+}
+
+static double refSum(const double *x, int n)
+{
+    double sum = 0.0;
+    int i;
+
+    for (i = 0; i < n; i++)
+        sum += x[i];
+    return sum;
+}
+
+/* the same value for all of the nExpect elements */
+static void testReduce(const char *expr, long nExpect, double expected)
+{
+    long n = evaluate(expr, N);
+    double tolerance = 1e-12 * (fabs(expected) + 1.0);
+
+    testOk(n == nExpect && (same(result[0], expected) ||
+           fabs(result[0] - expected) <= tolerance) &&
+           same(result[n - 1], result[0]),
+           "%s = %.17g (expected %.17g)", expr, result[0], expected);
+}
+
+static void testOperators(void)
+{
+    static const char *exprs[] = {
+        "A+B*C", "A-B/C", "-A", "ABS(A)", "SQRT(ABS(B))",
+        "ABS(A)**B+B^2", "A*10%3", "FMOD(A,0.3)", "MAX(A,B,C)",
+        "MIN(A,B,0)", "A<B", "A<=B", "A=B", "A#B", "A>=0", "A>B",
+        "A&&B>0", "A||B<0", "!(A>0)", "CEIL(A)+FLOOR(B)", "NINT(A*100)",
+        "EXP(A)+LN(ABS(B))+LOG(ABS(A))", "SIN(A)+COS(B)+TAN(C)",
+        "ASIN(A/2)+ACOS(B/2)+ATAN(A)", "ATAN2(A,B)",
+        "SINH(A)+COSH(B)+TANH(C)", "(A*1000 AND 0xff) | (B*1000 XOR 3)",
+        "~(A*100)", "(A*100)<<2 + (B*100)>>1 + (A*-100)>>>3",
+        "ISINF(A/0)+ISNAN(A,D)+2*FINITE(A,B,D)", "A>0?B:C",
+        "A>0?(B>0?1:2):(B>0?3:4)", "B:=A*2;B+1", "D2R*A+R2D*B+PI",
+        "VAL+A", "MAX(A,D)", "MIN(D,A)", "D>0?A:D", "A>0?B:=1:0;B",
+    };
+    size_t i;
+
+    testDiag("Element by element, as calcPerform()");
+    setArgs(N, N, N);
+    for (i = 0; i < NELEMENTS(exprs); i++)
+        testElements(exprs[i]);
+}
+
+static void testReductions(void)
+{
+    double sum = refSum(a, N), amax = a[0], amin = a[0];
+    double scale;
+    long i, n, bad;
+
+    testDiag("Array reductions");
+    setArgs(N, N, N);
+    for (i = 1; i < N; i++) {
+        if (a[i] > amax) amax = a[i];
+        if (a[i] < amin) amin = a[i];
+    }
+
+    testReduce("SUM(A)", N, sum);
+    testReduce("AVG(A)", N, sum / N);
+    testReduce("AMAX(A)", N, amax);
+    testReduce("AMIN(A)", N, amin);
+    testReduce("AMAX(D)", N, epicsNAN);
+    testReduce("AMIN(-D)", N, epicsNAN);
+    testReduce("SUM(C)", 1, c);
+    testReduce("SUM(C+0*B)", N, c * N);
+    testReduce("SUM(B=B)", N, N);
+    for (i = 0, n = 0; i < N; i++)
+        n += a[i] > 0;
+    testReduce("SUM(A>0)", N, n);
+
+    /* the element by element ones need the reductions of all elements */
+    n = evaluate("(A-AMIN(A))/(AMAX(A)-AMIN(A))", N);
+    scale = amax - amin;
+    for (i = 0, bad = 0; i < n; i++)
+        bad += !same(result[i], (a[i] - amin) / scale);
+    testOk(n == N && bad == 0, "normalized: %ld elements, %ld differ",
+           n, bad);
+
+    n = evaluate("A-AVG(A)", N);
+    for (i = 0, bad = 0; i < n; i++)
+        bad += fabs(result[i] - (a[i] - sum / N)) > 1e-12;
+    testOk(n == N && bad == 0, "A-AVG(A): %ld elements, %ld differ", n, bad);
+
+    /* a reduction of an expression with a reduction */
+    n = evaluate("SQRT(AVG((A-AVG(A))^2))", N);
+    {
+        double var = 0.0;
+
+        for (i = 0; i < N; i++)
+            var += (a[i] - sum / N) * (a[i] - sum / N);
+        testOk(n == N && fabs(result[0] - sqrt(var / N)) < 1e-12,
+               "standard deviation %.17g", result[0]);
+    }
+    n = evaluate("B:=SUM(A);A/B", N);
+    for (i = 0, bad = 0; i < n; i++)
+        bad += fabs(result[i] - a[i] / sum) > 1e-12 * fabs(a[i] / sum);
+    testOk(n == N && bad == 0, "B:=SUM(A);A/B: %ld elements, %ld differ",
+           n, bad);
+    n = evaluate("A>0?B:=SUM(A):0;B", N);
+    for (i = 0, bad = 0; i < n; i++)
+        bad += fabs(result[i] - (a[i] > 0 ? sum : 0.0)) > 1e-12;
+    testOk(n == N && bad == 0,
+           "conditional reduction: %ld elements, %ld differ", n, bad);
+}
+
+static void testCounts(void)
+{
+    long n;
+
+    testDiag("Number of results");
+
+    setArgs(N, 600, N);
+    n = evaluate("A+B", N);
+    testOk(n == 600, "shortest input: %ld", n);
+    n = evaluate("SUM(A)+0*B", N);
+    testOk(n == 600 && fabs(result[599] - refSum(a, N)) < 1e-12,
+           "reductions over all of their argument: %ld, %g", n, result[599]);
+    n = evaluate("B+SUM(A)", N);
+    testOk(n == 600 && fabs(result[599] - b[599] - refSum(a, N)) < 1e-12,
+           "a shorter input before the reduction: %ld, %g", n, result[599]);
+    n = evaluate("A+B", 100);
+    testOk(n == 100, "capacity: %ld", n);
+    n = evaluate("SUM(A)", 1);
+    testOk(n == 1 && fabs(result[0] - refSum(a, N)) < 1e-12,
+           "reductions don't depend on the capacity: %ld, %g", n, result[0]);
+    n = evaluate("A", N);
+    testOk(n == N, "unused input doesn't count: %ld", n);
+    n = evaluate("C*2+1", N);
+    testOk(n == 1 && result[0] == c * 2 + 1, "scalar only: %ld, %g",
+           n, result[0]);
+    n = evaluate("B:=A;B", N);
+    testOk(n == N, "assigned before use: %ld", n);
+
+    setArgs(0, N, N);
+    n = evaluate("A+B", N);
+    testOk(n == 0, "empty input: %ld", n);
+
+    setArgs(N, N, N);
+    args[4] = NULL;
+    counts[4] = 1;
+    n = evaluate("A+E", N);
+    testOk(n == -1, "missing input");
+    args[1] = NULL;
+    n = evaluate("A+B*0", N);
+    testOk(n == -1, "missing array input");
+}
+
+/* a workspace from calcArrayWorkSize() can be used for many calls */
+static void testWorkspace(void)
+{
+    static const char *expr = "D:=A-AVG(A);B*D+SUM(D*D)";
+    char *rpn = compile(expr);
+    double *work;
+    size_t size;
+    epicsUInt32 i, n;
+    long bad = 0;
+    int rep;
+
+    testDiag("Caller's workspace");
+    setArgs(N, N, N);
+    if (!rpn)
+        testAbort("%s: doesn't compile", expr);
+    size = calcArrayWorkSize(rpn);
+    testOk(size > 0, "%s needs %u doubles", expr, (unsigned) size);
+    work = malloc(size * sizeof(double));
+    if (!work)
+        testAbort("no memory for the workspace");
+
+    n = N;
+    if (calcArrayPerform(args, counts, expect, &n, rpn, NULL))
+        testAbort("%s: calcArrayPerform failed", expr);
+    for (rep = 0; rep < 2; rep++) {
+        n = N;
+        if (calcArrayPerform(args, counts, result, &n, rpn, work)) {
+            bad = -1;
+            break;
+        }
+        for (i = 0; i < n; i++)
+            bad += !same(result[i], expect[i]);
+    }
+    testOk(n == N && bad == 0, "same results in the workspace, %ld differ",
+           bad);
+    free(work);
+    free(rpn);
+}
+
+MAIN(epicsCalcArrayTest)
+{
+    int i;
+
+    testPlan(67);
+
+    srand(17);
+    for (i = 0; i < N; i++) {
+        a[i] = -2.0 + 4.0 * rand() / RAND_MAX;
+        b[i] = -2.0 + 4.0 * rand() / RAND_MAX;
+        d[i] = a[i] * 3;
+        val[i] = i * 0.5;
+    }
+    a[10] = 0.0;
+    b[11] = 0.0;
+    b[12] = a[12];
+    d[20] = epicsNAN;
+    d[300] = epicsINF;
+    d[301] = -epicsINF;
+
+    testOperators();
+    testReductions();
+    testCounts();
+    testWorkspace();
+
+    return testDone();
+}
@@ -298,7 +298,7 @@ MAIN(epicsCalcTest)
     const double a=1.0, b=2.0, c=3.0, d=4.0, e=5.0, f=6.0,
                  g=7.0, h=8.0, i=9.0, j=10.0, k=11.0, l=12.0;
 
-    testPlan(637);
+    testPlan(643);
 
     /* LITERAL_OPERAND elements */
     testExpr(0);
@@ -376,6 +376,14 @@ MAIN(epicsCalcTest)
     testExpr(fmod(-1.5, -1.0));
     testExpr(fmod(1.5, 0.0));
 
+    /* The array reductions of a single value */
+    testCalc("sum(a)", a);
+    testCalc("amax(b)", b);
+    testCalc("amin(-c)", -c);
+    testCalc("avg(d)+1", d+1);
+    testCalc("sum(NaN)", NaN);
+    testCalc("asin(1)-amin(2)", asin(1.)-2);
+
     testExpr(finite(0.));
     testExpr(finite(Inf));
     testExpr(finite(-Inf));
@@ -0,0 +1,125 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "epicsTypes.h"
+#include "epicsDeltaCodec.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#define N 1000
+
+static epicsUInt8 msg[EPICS_DELTA_HEADER_SIZE + EPICS_DELTA_RUN_SIZE + 8 * N];
+
+static void testFormat(void)
+{
+    static const epicsUInt8 expect[] = {
+        'D', 'L', 1, 2, 0, 0, 0, 4, 0, 0, 0, 1,
+        0, 0, 0, 1, 0, 0, 0, 2, 0x12, 0x34, 0x56, 0x78
+    };
+    epicsUInt16 prev[4] = {1, 2, 3, 4};
+    epicsUInt16 cur[4] = {1, 0x1234, 0x5678, 4};
+    epicsUInt16 out[4] = {0, 0, 0, 0};
+    size_t size;
+
+    testDiag("Message format");
+
+    size = epicsDeltaEncode(msg, prev, 4, cur, 4, sizeof(epicsUInt16));
+    testOk(size == sizeof(expect) && !memcmp(msg, expect, size),
+           "one run of two elements, %u bytes", (unsigned) size);
+    testOk1(!epicsDeltaIsFullFrame(msg, size));
+
+    memcpy(out, prev, sizeof(out));
+    testOk1(epicsDeltaDecode(out, 4, sizeof(epicsUInt16), msg, size) == 4);
+    testOk1(!memcmp(out, cur, sizeof(cur)));
+
+    size = epicsDeltaEncode(msg, cur, 4, cur, 4, sizeof(epicsUInt16));
+    testOk(size == EPICS_DELTA_HEADER_SIZE, "no changes, no runs");
+    testOk1(epicsDeltaDecode(out, 4, sizeof(epicsUInt16), msg, size) == 4);
+
+    size = epicsDeltaEncode(msg, NULL, 0, cur, 4, sizeof(epicsUInt16));
+    testOk(size == epicsDeltaMaxSize(sizeof(epicsUInt16), 4) &&
+           epicsDeltaIsFullFrame(msg, size), "full frame");
+    memset(out, 0, sizeof(out));
+    testOk1(epicsDeltaDecode(out, 4, sizeof(epicsUInt16), msg, size) == 4);
+    testOk1(!memcmp(out, cur, sizeof(cur)));
+
+    size = epicsDeltaEncode(msg, prev, 3, cur, 4, sizeof(epicsUInt16));
+    testOk(epicsDeltaIsFullFrame(msg, size), "length change gives a full frame");
+
+    testOk(epicsDeltaEncode(msg, prev, 4, cur, 4, 3) == 0,
+           "invalid element size");
+}
+
+static void testMalformed(void)
+{
+    epicsUInt32 prev[4] = {1, 2, 3, 4};
+    epicsUInt32 cur[4] = {1, 2, 5, 4};
+    epicsUInt32 out[4];
+    size_t size;
+
+    testDiag("Malformed messages are rejected");
+
+    size = epicsDeltaEncode(msg, prev, 4, cur, 4, sizeof(epicsUInt32));
+    testOk1(epicsDeltaDecode(out, 4, sizeof(epicsUInt16), msg, size) == -1);
+    testOk1(epicsDeltaDecode(out, 3, sizeof(epicsUInt32), msg, size) == -1);
+    testOk1(epicsDeltaDecode(out, 4, sizeof(epicsUInt32), msg, size - 1) == -1);
+    testOk1(epicsDeltaDecode(out, 4, sizeof(epicsUInt32), msg, 11) == -1);
+    msg[EPICS_DELTA_HEADER_SIZE + 3] = 4; /* run start */
+    testOk1(epicsDeltaDecode(out, 4, sizeof(epicsUInt32), msg, size) == -1);
+    msg[0] = 'X';
+    testOk1(epicsDeltaDecode(out, 4, sizeof(epicsUInt32), msg, size) == -1);
+}
+
+/* random sparse changes, checked by decoding */
+#define ROUND_TRIP(type) \
+static void roundTrip_##type(void) \
+{ \
+    static type prev[N], cur[N], out[N]; \
+    size_t size, total = 0, maxSize = epicsDeltaMaxSize(sizeof(type), N); \
+    int i, j, ok = 1, fits = 1; \
+\
+    for (i = 0; i < N; i++) \
+        prev[i] = out[i] = (type) rand(); \
+    for (j = 0; j < 200; j++) { \
+        int nChanges = rand() % (j < 100 ? 20 : N); \
+        memcpy(cur, prev, sizeof(cur)); \
+        for (i = 0; i < nChanges; i++) \
+            cur[rand() % N] = (type) rand(); \
+        size = epicsDeltaEncode(msg, prev, N, cur, N, sizeof(type)); \
+        fits &= size <= maxSize; \
+        total += size; \
+        ok &= epicsDeltaDecode(out, N, sizeof(type), msg, size) == N && \
+            !memcmp(out, cur, sizeof(cur)); \
+        memcpy(prev, cur, sizeof(prev)); \
+    } \
+    testOk(ok, #type ": 200 messages decoded, %u bytes", (unsigned) total); \
+    testOk(fits, #type ": no message larger than a full frame"); \
+}
+
+ROUND_TRIP(epicsUInt8)
+ROUND_TRIP(epicsInt16)
+ROUND_TRIP(epicsInt32)
+ROUND_TRIP(epicsFloat64)
+
+MAIN(epicsDeltaCodecTest)
+{
+    testPlan(25);
+
+    testFormat();
+    testMalformed();
+
+    testDiag("Round trips");
+    srand(42);
+    roundTrip_epicsUInt8();
+    roundTrip_epicsInt16();
+    roundTrip_epicsInt32();
+    roundTrip_epicsFloat64();
+
+    return testDone();
+}
@@ -198,6 +198,68 @@ void testANSIStrip(void)
 #undef testEscape
 }
 
+static unsigned nRepeats;
+static unsigned nSummaries;
+static unsigned nSevRepeats;
+static unsigned lastSuppressed;
+static double lastCovered;
+
+static void repeatListener(void *pPrivate, const char *message)
+{
+    if (strncmp(message, "repeat ", 7) == 0)
+        nRepeats++;
+    else if (strncmp(message, "sevr=minor repeat ", 18) == 0)
+        nSevRepeats++;
+    else if (strstr(message, "suppressed of \"repeat %d\"") &&
+             sscanf(message, "errlog: %u repeats in %lg sec", &lastSuppressed,
+                    &lastCovered) == 2)
+        nSummaries++;
+}
+
+static void testSuppression(void)
+{
+    int i;
+
+    testDiag("Check repeat suppression");
+
+    errlogAddListener(repeatListener, NULL);
+    testOk1(errlogSetSuppress(errlogSevNone, 0.2, 3) == 0);
+    testOk1(errlogSetSuppress(errlogFatal + 1, 0.2, 3) == -1);
+
+    for (i = 0; i < 10; i++)
+        errlogPrintfNoConsole("repeat %d\n", i);
+    /* generic format, not suppressed */
+    for (i = 0; i < 10; i++)
+        errlogPrintfNoConsole("%s", "generic\n");
+
+    /* the storm has stopped, the summary comes when the window ends */
+    for (i = 0; i < 250 && !nSummaries; i++)
+        epicsThreadSleep(0.02);
+    errlogFlush();
+    testOk(nRepeats == 3 && nSummaries == 1 && lastSuppressed == 7,
+        "%u of 10 repeats logged, %u summaries of %u", nRepeats, nSummaries,
+        lastSuppressed);
+    testOk(lastCovered >= 0.2, "Summary covers %g sec", lastCovered);
+
+    /* errlogFlush() reports a window which hasn't ended */
+    for (i = 0; i < 5; i++)
+        errlogPrintfNoConsole("repeat %d\n", i);
+    errlogFlush();
+    testOk(nRepeats == 6 && nSummaries == 2 && lastSuppressed == 2,
+        "Flushed %u repeats logged, %u summaries of %u", nRepeats, nSummaries,
+        lastSuppressed);
+    testOk(lastCovered < 0.2, "Summary covers %g sec", lastCovered);
+
+    /* other classes are unaffected */
+    for (i = 0; i < 10; i++)
+        errlogSevPrintf(errlogMinor, "repeat %d\n", i);
+    errlogFlush();
+    testEqInt(nSevRepeats, 10);
+
+    errlogSetSuppress(errlogSevAll, 0.0, 0);
+    errlogRemoveListeners(repeatListener, NULL);
+}
+
 static void testErrorMessageMatches(long status, const char *expected)
 {
     const char *msg = errSymMsg(status);
@@ -252,7 +314,7 @@ MAIN(epicsErrlogTest)
     char msg[256];
     clientPvt pvt, pvt2;
 
-    testPlan(54);
+    testPlan(63);
 
     testANSIStrip();
 
@@ -455,10 +517,37 @@ MAIN(epicsErrlogTest)
     /* Expect N+1 messages +- 1 depending on impl */
     testOk(pvt.count >= N && pvt.count<=N+2, "Logged %u messages, expected %zu", pvt.count, N+1);
 
+    testDiag("Check message counters");
+    {
+        size_t nLogged0, nLost0, nLogged, nLost;
+
+        errlogGetCounts(&nLogged0, &nLost0);
+        errlogPrintfNoConsole("counted");
+        errlogFlush();
+        epicsEventMustWait(pvt.done);
+        errlogGetCounts(&nLogged, &nLost);
+        testOk(nLogged == nLogged0 + 1 && nLost == nLost0,
+            "Logged %zu (expect %zu), lost %zu (expect %zu)",
+            nLogged, nLogged0 + 1, nLost, nLost0);
+
+        pvt.jam = 1;
+        for (i = 0; i < LOGBUFSIZE && nLost == nLost0; i++) {
+            errlogPrintfNoConsole("%s", msg);
+            errlogGetCounts(NULL, &nLost);
+        }
+        testOk(nLost == nLost0 + 1, "Lost %zu messages after filling buffer",
+            nLost - nLost0);
+        epicsEventSignal(pvt.jammer);
+        errlogFlush();
+        epicsEventMustWait(pvt.done);
+    }
+
     /* Clean up */
     testOk(1 == errlogRemoveListeners(&logClient, &pvt),
         "Removed 1 listener");
 
+    testSuppression();
+
     osiSockAttach();
     testLogPrefix();
     osiSockRelease();
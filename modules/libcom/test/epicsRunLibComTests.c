@@ -22,9 +22,11 @@ int blockingSockTest(void);
 int epicsAlgorithm(void);
 int epicsAtomicTest(void);
 int epicsCalcTest(void);
+int epicsCalcArrayTest(void);
 int epicsEllTest(void);
 int epicsEnvTest(void);
 int epicsErrlogTest(void);
+int logDeframeTest(void);
 int epicsEventTest(void);
 int epicsExitTest(void);
 int epicsMathTest(void);
@@ -37,6 +39,9 @@ int epicsStackTraceTest(void);
 int epicsStdioTest(void);
 int epicsStdlibTest(void);
 int epicsStringTest(void);
+int epicsArrayKernelsTest(void);
+int epicsDeltaCodecTest(void);
+int epicsSharedArrayTest(void);
 int epicsThreadHooksTest(void);
 int epicsThreadOnceTest(void);
 int epicsThreadPoolTest(void);
@@ -81,9 +86,11 @@ void epicsRunLibComTests(void)
     runTest(epicsAlgorithm);
     runTest(epicsAtomicTest);
     runTest(epicsCalcTest);
+    runTest(epicsCalcArrayTest);
     runTest(epicsEllTest);
     runTest(epicsEnvTest);
     runTest(epicsErrlogTest);
+    runTest(logDeframeTest);
     runTest(epicsEventTest);
     runTest(epicsInlineTest);
     runTest(epicsMathTest);
@@ -96,6 +103,9 @@ void epicsRunLibComTests(void)
     runTest(epicsStdioTest);
     runTest(epicsStdlibTest);
     runTest(epicsStringTest);
+    runTest(epicsArrayKernelsTest);
+    runTest(epicsDeltaCodecTest);
+    runTest(epicsSharedArrayTest);
     runTest(epicsThreadHooksTest);
     runTest(epicsThreadOnceTest);
     runTest(epicsThreadPoolTest);
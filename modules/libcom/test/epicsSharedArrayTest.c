@@ -0,0 +1,203 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "epicsEvent.h"
+#include "epicsSharedArray.h"
+#include "epicsStdio.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
+#include "epicsTypes.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#define N 4096
+#define UPDATES 20000
+
+static char name[64];
+
+static void testWriteRead(void)
+{
+    epicsSharedArrayId wr, rd;
+    epicsSharedArrayInfo info;
+    epicsTimeStamp stamp = {1000, 500};
+    epicsUInt32 *pdata;
+    double in[10], out[10];
+    const double *pview;
+    char *pheader;
+    epicsUInt32 bigSize = 4096;
+    epicsUInt64 bigCount = 1000000;
+    long n;
+    int i;
+
+    testDiag("Writing and reading");
+
+    wr = epicsSharedArrayCreate(name, 6, sizeof(double), 10);
+    testOk(wr != NULL, "created %s", name);
+
+    rd = epicsSharedArrayOpen(name);
+    testOk1(rd != NULL);
+    testOk1(epicsSharedArrayRead(rd, out, 10, &info) == 0);
+    testOk(info.type == 6 && info.elementSize == sizeof(double) &&
+           info.capacity == 10 && info.generation == 0,
+           "header describes the array");
+
+    for (i = 0; i < 10; i++)
+        in[i] = i * 1.5;
+    epicsSharedArrayPublish(wr, in, 7, &stamp, 3, 2);
+    memset(out, 0, sizeof(out));
+    testOk1(epicsSharedArrayRead(rd, out, 10, &info) == 7);
+    testOk1(!memcmp(out, in, 7 * sizeof(double)));
+    testOk(info.generation == 1 && info.count == 7, "generation %u, count %u",
+           (unsigned) info.generation, (unsigned) info.count);
+    testOk1(info.stamp.secPastEpoch == 1000 && info.stamp.nsec == 500);
+    testOk1(info.status == 3 && info.severity == 2);
+
+    /* more than the capacity is cut, less than the buffer is cut */
+    epicsSharedArrayPublish(wr, in, 12, NULL, 0, 0);
+    testOk1(epicsSharedArrayRead(rd, out, 4, &info) == 4);
+    testOk1(info.count == 10 && info.generation == 2);
+
+    testDiag("Reading in place");
+    pview = epicsSharedArrayReadBegin(rd, &info);
+    testOk1(pview && pview[9] == in[9]);
+    testOk1(epicsSharedArrayReadValidate(rd, &info));
+    pview = epicsSharedArrayReadBegin(rd, &info);
+    epicsSharedArrayPublish(wr, in, 2, NULL, 0, 0);
+    testOk(!epicsSharedArrayReadValidate(rd, &info),
+           "an update invalidates the read");
+
+    pdata = epicsSharedArrayWriteBegin(wr);
+    testOk(epicsSharedArrayReadBegin(rd, &info) == NULL,
+           "no read while the writer is busy");
+    testOk1(epicsSharedArrayRead(rd, out, 10, NULL) == -1);
+    epicsSharedArrayWriteEnd(wr, 1, NULL, 0, 0);
+    testOk1(epicsSharedArrayRead(rd, out, 10, NULL) == 1);
+
+    testDiag("Changes to the layout in the header are ignored");
+    pheader = (char *) pdata - EPICS_SHARED_ARRAY_HEADER_SIZE;
+    memcpy(pheader + 16, &bigSize, sizeof(bigSize));
+    memcpy(pheader + 24, &bigCount, sizeof(bigCount));
+    memcpy(pheader + 40, &bigCount, sizeof(bigCount));
+    n = epicsSharedArrayRead(rd, out, 10, &info);
+    testOk(n == 10 && info.elementSize == sizeof(double) &&
+           info.capacity == 10, "read %ld elements of %u bytes, capacity %u",
+           n, (unsigned) info.elementSize, (unsigned) info.capacity);
+
+    epicsSharedArrayClose(wr);
+    testOk(epicsSharedArrayRead(rd, out, 10, NULL) == -1,
+           "closed by the writer");
+    epicsSharedArrayClose(rd);
+    testOk(epicsSharedArrayOpen(name) == NULL, "name removed");
+}
+
+typedef struct writerArgs {
+    epicsSharedArrayId id;
+    epicsEventId done;
+} writerArgs;
+
+/* every update fills the array with its own number */
+static void writer(void *arg)
+{
+    writerArgs *pargs = (writerArgs *) arg;
+    epicsUInt32 i, k;
+
+    for (i = 1; i <= UPDATES; i++) {
+        epicsUInt32 *pdata = epicsSharedArrayWriteBegin(pargs->id);
+
+        for (k = 0; k < N; k++) {
+            pdata[k] = i;
+            /* let the reader in during some of the updates */
+            if (k == N / 2 && i % 64 == 0)
+                epicsThreadSleep(1e-4);
+        }
+        epicsSharedArrayWriteEnd(pargs->id, N - i % 2, NULL, 0, 0);
+        if (i % 64 == 32)
+            epicsThreadSleep(1e-4);
+    }
+    epicsEventMustTrigger(pargs->done);
+}
+
+static void testConcurrent(void)
+{
+    epicsUInt32 *buf = calloc(N, sizeof(epicsUInt32));
+    epicsSharedArrayInfo info;
+    writerArgs args;
+    epicsSharedArrayId rd;
+    unsigned long nRead = 0, nTorn = 0, nFail = 0;
+    epicsUInt32 last = 0;
+    int running = 1, backwards = 0;
+
+    testDiag("Reading while the array is written");
+
+    args.id = epicsSharedArrayCreate(name, 0, sizeof(epicsUInt32), N);
+    rd = epicsSharedArrayOpen(name);
+    args.done = epicsEventMustCreate(epicsEventEmpty);
+    if (!args.id || !rd || !buf)
+        testAbort("setup failed");
+
+    epicsThreadMustCreate("sharedWriter", epicsThreadPriorityMedium,
+        epicsThreadGetStackSize(epicsThreadStackSmall), writer, &args);
+
+    while (running) {
+        long n;
+        long k;
+
+        running = epicsEventTryWait(args.done) != epicsEventOK;
+        n = epicsSharedArrayRead(rd, buf, N, &info);
+        if (n < 0) {
+            nFail++;
+            continue;
+        }
+        nRead++;
+        if (info.generation < last)
+            backwards = 1;
+        last = info.generation;
+        for (k = 0; k < n; k++)
+            if (buf[k] != info.generation)
+                break;
+        if (k < n || n != (long) (N - info.generation % 2))
+            nTorn++;
+        epicsThreadSleep(0.0);
+    }
+    testDiag("%lu snapshots, %lu reads gave up", nRead, nFail);
+    testOk(nRead > 0 && nTorn == 0, "%lu of %lu snapshots torn", nTorn,
+           nRead);
+    testOk1(!backwards);
+    testOk(last == UPDATES, "last generation %u", (unsigned) last);
+
+    epicsSharedArrayClose(rd);
+    epicsSharedArrayClose(args.id);
+    epicsEventDestroy(args.done);
+    free(buf);
+}
+
+MAIN(epicsSharedArrayTest)
+{
+    epicsTimeStamp now;
+    epicsSharedArrayId id;
+
+    testPlan(24);
+
+    epicsTimeGetCurrent(&now);
+    epicsSnprintf(name, sizeof(name), "epicsSharedArrayTest.%u.%u",
+        (unsigned) now.secPastEpoch, (unsigned) now.nsec);
+
+    id = epicsSharedArrayCreate(name, 0, 1, 1);
+    if (!id) {
+        testSkip(23, "shared memory not supported");
+        return testDone();
+    }
+    epicsSharedArrayClose(id);
+
+    testOk1(epicsSharedArrayOpen("epicsSharedArrayTest.none") == NULL);
+    testWriteRead();
+    testConcurrent();
+
+    return testDone();
+}
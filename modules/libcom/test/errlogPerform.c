@@ -0,0 +1,107 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/*
+ * Measure errlog throughput when several threads log at once, as happens
+ * during an error storm.  Messages are formatted outside of the errlog
+ * buffer lock, so the rate should not collapse as threads are added.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "epicsEvent.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
+#include "errlog.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#define NMESSAGES 20000
+#define MAXTHREADS 16
+
+typedef struct {
+    epicsEventId go;
+    epicsEventId done;
+    int id;
+} floodPvt;
+
+static unsigned received;
+
+static void countListener(void *pvt, const char *message)
+{
+    received++;
+}
+
+static void flood(void *raw)
+{
+    floodPvt *pvt = raw;
+    int i;
+
+    epicsEventMustWait(pvt->go);
+    for (i = 0; i < NMESSAGES; i++) {
+        errlogPrintfNoConsole("flood: thread %d message %d value %g status %s\n",
+            pvt->id, i, i * 0.5, "Disconnected");
+    }
+    epicsEventMustTrigger(pvt->done);
+}
+
+static void measure(int nThreads)
+{
+    floodPvt pvt[MAXTHREADS];
+    epicsTimeStamp start, end;
+    size_t nLogged0, nLost0, nLogged, nLost;
+    double delay;
+    int i;
+
+    for (i = 0; i < nThreads; i++) {
+        pvt[i].go = epicsEventMustCreate(epicsEventEmpty);
+        pvt[i].done = epicsEventMustCreate(epicsEventEmpty);
+        pvt[i].id = i;
+        epicsThreadMustCreate("flood", epicsThreadPriorityMedium,
+            epicsThreadGetStackSize(epicsThreadStackSmall), flood, &pvt[i]);
+    }
+
+    errlogFlush();
+    received = 0;
+    errlogGetCounts(&nLogged0, &nLost0);
+
+    epicsTimeGetCurrent(&start);
+    for (i = 0; i < nThreads; i++)
+        epicsEventMustTrigger(pvt[i].go);
+    for (i = 0; i < nThreads; i++)
+        epicsEventMustWait(pvt[i].done);
+    epicsTimeGetCurrent(&end);
+    errlogFlush();
+
+    errlogGetCounts(&nLogged, &nLost);
+    delay = epicsTimeDiffInSeconds(&end, &start);
+
+    testDiag("%2d threads: %8.0f messages/sec, %zu queued, %zu lost, %u seen",
+        nThreads, nThreads * NMESSAGES / delay,
+        nLogged - nLogged0, nLost - nLost0, received);
+
+    for (i = 0; i < nThreads; i++) {
+        epicsEventDestroy(pvt[i].go);
+        epicsEventDestroy(pvt[i].done);
+    }
+}
+
+MAIN(errlogPerform)
+{
+    int nThreads;
+
+    testPlan(0);
+
+    errlogInit2(1 << 20, 256);
+    errlogAddListener(countListener, NULL);
+
+    for (nThreads = 1; nThreads <= MAXTHREADS; nThreads *= 2)
+        measure(nThreads);
+
+    errlogRemoveListeners(countListener, NULL);
+
+    return testDone();
+}
@@ -0,0 +1,115 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/*
+ * Load test for iocLogServer.  Opens many connections to the server as
+ * if from that many IOCs, then sends messages on each of them in turn
+ * and reports the rate achieved.
+ *
+ * usage: iocLogLoadClient <host> [port [connections [messages [length]]]]
+ *
+ * The server may need a larger open file limit (ulimit -n) for
+ * thousands of connections.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "osiSock.h"
+#include "epicsTime.h"
+
+int main (int argc, char **argv)
+{
+    struct sockaddr_in addr;
+    unsigned port = 7004u;
+    unsigned nConn = 1000u;
+    unsigned nMsg = 100u;
+    unsigned msgLen = 80u;
+    SOCKET *socks;
+    char *msg;
+    epicsTimeStamp start, connected, done;
+    double connTime, sendTime;
+    unsigned i, j, nOpen = 0u;
+    unsigned long nSent = 0u;
+
+    if (argc < 2) {
+        fprintf (stderr, "usage: %s <host> [port [connections [messages "
+            "[length]]]]\n", argv[0]);
+        return 1;
+    }
+    if (argc > 2) port = (unsigned) atoi (argv[2]);
+    if (argc > 3) nConn = (unsigned) atoi (argv[3]);
+    if (argc > 4) nMsg = (unsigned) atoi (argv[4]);
+    if (argc > 5) msgLen = (unsigned) atoi (argv[5]);
+    if (msgLen < 32u) msgLen = 32u;
+
+    osiSockAttach ();
+
+    if (aToIPAddr (argv[1], (unsigned short) port, &addr) < 0) {
+        fprintf (stderr, "%s: unknown host '%s'\n", argv[0], argv[1]);
+        return 1;
+    }
+
+    socks = calloc (nConn, sizeof (*socks));
+    msg = malloc (msgLen + 1u);
+    if (!socks || !msg) {
+        fprintf (stderr, "%s: out of memory\n", argv[0]);
+        return 1;
+    }
+
+    epicsTimeGetCurrent (&start);
+    for (i = 0u; i < nConn; i++) {
+        socks[i] = epicsSocketCreate (AF_INET, SOCK_STREAM, 0);
+        if (socks[i] == INVALID_SOCKET ||
+            connect (socks[i], (struct sockaddr *) &addr, sizeof (addr)) < 0) {
+            char sockErrBuf[64];
+            epicsSocketConvertErrnoToString (sockErrBuf, sizeof (sockErrBuf));
+            fprintf (stderr, "%s: connection %u failed: %s\n",
+                argv[0], i, sockErrBuf);
+            if (socks[i] != INVALID_SOCKET)
+                epicsSocketDestroy (socks[i]);
+            break;
+        }
+    }
+    nOpen = i;
+    epicsTimeGetCurrent (&connected);
+
+    /* send round-robin so every connection is active at once */
+    for (j = 0u; j < nMsg && nOpen; j++) {
+        for (i = 0u; i < nOpen; i++) {
+            int n = sprintf (msg, "load client %u message %u ", i, j);
+            memset (&msg[n], 'x', msgLen - 1u - n);
+            msg[msgLen - 1u] = '\n';
+            if (send (socks[i], msg, (int) msgLen, 0) != (int) msgLen) {
+                fprintf (stderr, "%s: send on connection %u failed\n",
+                    argv[0], i);
+                nMsg = j;
+                break;
+            }
+            nSent++;
+        }
+    }
+    epicsTimeGetCurrent (&done);
+
+    for (i = 0u; i < nOpen; i++) {
+        epicsSocketDestroy (socks[i]);
+    }
+
+    connTime = epicsTimeDiffInSeconds (&connected, &start);
+    sendTime = epicsTimeDiffInSeconds (&done, &connected);
+    printf ("%u connections opened in %.3f sec\n", nOpen, connTime);
+    printf ("%lu messages of %u bytes sent in %.3f sec\n",
+        nSent, msgLen, sendTime);
+    if (sendTime > 0.0) {
+        printf ("%.0f messages/sec, %.2f Mbytes/sec\n", nSent / sendTime,
+            nSent * (double) msgLen / sendTime / 1e6);
+    }
+
+    free (msg);
+    free (socks);
+    osiSockRelease ();
+    return nOpen == nConn ? 0 : 1;
+}
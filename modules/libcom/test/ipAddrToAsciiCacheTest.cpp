@@ -0,0 +1,259 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Checks the host name cache and the lookup threads of the
+ * ipAddrToAsciiEngine with a stub in place of the name server.
+ */
+
+#include <string>
+
+#include <stdio.h>
+#include <string.h>
+
+#define EPICS_PRIVATE_API
+
+#include "epicsMutex.h"
+#include "epicsGuard.h"
+#include "epicsThread.h"
+#include "epicsEvent.h"
+#include "epicsTime.h"
+#include "epicsStdio.h"
+#include "envDefs.h"
+#include "ipAddrToAsciiAsynchronous.h"
+
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+namespace {
+
+typedef epicsGuard<epicsMutex> Guard;
+
+const unsigned nThreads = 4u;
+const double timeToLive = 1.0;
+
+// the stub knows the names of 10.0.0.1 to 10.0.0.199
+epicsMutex stubMutex;
+unsigned stubCalls[256];
+unsigned stubActive;
+unsigned stubMaxActive;
+double stubDelay;
+
+unsigned epicsStdCall stubResolver(const struct in_addr *pAddr,
+                                   char *pBuf, unsigned bufSize)
+{
+    unsigned host = ntohl(pAddr->s_addr) & 0xffu;
+    double delay;
+    {
+        Guard G(stubMutex);
+        stubCalls[host]++;
+        if(++stubActive > stubMaxActive)
+            stubMaxActive = stubActive;
+        delay = stubDelay;
+    }
+    if(delay > 0.0)
+        epicsThreadSleep(delay);
+    {
+        Guard G(stubMutex);
+        stubActive--;
+    }
+    if(host == 0u || host >= 200u)
+        return 0u;
+    int len = epicsSnprintf(pBuf, bufSize, "host-%u.test", host);
+    return len > 0 && unsigned(len) < bufSize ? unsigned(len) : 0u;
+}
+
+unsigned callsFor(unsigned host)
+{
+    Guard G(stubMutex);
+    return stubCalls[host];
+}
+
+void setDelay(double delay)
+{
+    Guard G(stubMutex);
+    stubDelay = delay;
+    stubMaxActive = 0u;
+}
+
+epicsMutex orderMutex;
+unsigned completionCount;
+
+struct CB : public ipAddrToAsciiCallBack
+{
+    epicsEvent complete;
+    std::string name;
+    unsigned order;
+    CB() : order(0u) {}
+    virtual ~CB() {}
+    virtual void transactionComplete ( const char * pHostName )
+    {
+        name = pHostName;
+        {
+            Guard G(orderMutex);
+            order = ++completionCount;
+        }
+        complete.signal();
+    }
+};
+
+osiSockAddr address(unsigned host, unsigned short port)
+{
+    osiSockAddr addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.ia.sin_family = AF_INET;
+    addr.ia.sin_addr.s_addr = htonl(0x0a000000u | host);
+    addr.ia.sin_port = htons(port);
+    return addr;
+}
+
+std::string lookup(ipAddrToAsciiEngine& engine, unsigned host,
+                   unsigned short port = 5064)
+{
+    ipAddrToAsciiTransaction& trn(engine.createTransaction());
+    CB cb;
+    trn.ipAddrToAscii(address(host, port), cb);
+    if(!cb.complete.wait(5.0))
+        testDiag("lookup of host %u timed out", host);
+    trn.release();
+    return cb.name;
+}
+
+void testPositive(ipAddrToAsciiEngine& engine)
+{
+    testDiag("Host names are cached");
+
+    testOk1(lookup(engine, 1u) == "host-1.test:5064");
+    testOk1(callsFor(1u) == 1u);
+    testOk1(lookup(engine, 1u, 5065) == "host-1.test:5065");
+    testOk(callsFor(1u) == 1u, "second lookup answered from the cache");
+}
+
+void testNegative(ipAddrToAsciiEngine& engine)
+{
+    testDiag("Failed lookups are cached");
+
+    testOk1(lookup(engine, 200u) == "10.0.0.200:5064");
+    testOk1(callsFor(200u) == 1u);
+    testOk1(lookup(engine, 200u) == "10.0.0.200:5064");
+    testOk(callsFor(200u) == 1u, "failure answered from the cache");
+}
+
+void testExpiry(ipAddrToAsciiEngine& engine)
+{
+    testDiag("Entries expire");
+
+    epicsThreadSleep(timeToLive + 0.2);
+    testOk1(lookup(engine, 1u) == "host-1.test:5064");
+    testOk(callsFor(1u) == 2u, "host name looked up again");
+    testOk1(lookup(engine, 200u) == "10.0.0.200:5064");
+    testOk(callsFor(200u) == 2u, "failed lookup tried again");
+
+    ipAddrToAsciiEngine::flushCache();
+    testOk1(lookup(engine, 1u) == "host-1.test:5064");
+    testOk(callsFor(1u) == 3u, "host name looked up after flushCache()");
+}
+
+void testParallel(ipAddrToAsciiEngine& engine)
+{
+    testDiag("Slow lookups run in parallel");
+
+    const double delay = 0.5;
+    setDelay(delay);
+
+    ipAddrToAsciiTransaction* trn[nThreads];
+    CB cb[nThreads];
+    epicsTime start(epicsTime::getCurrent());
+    for(unsigned i = 0u; i < nThreads; i++) {
+        trn[i] = &engine.createTransaction();
+        trn[i]->ipAddrToAscii(address(10u + i, 5064), cb[i]);
+    }
+    bool ok = true;
+    for(unsigned i = 0u; i < nThreads; i++) {
+        ok &= cb[i].complete.wait(5.0);
+        trn[i]->release();
+    }
+    double elapsed = epicsTime::getCurrent() - start;
+    testOk1(ok);
+    testOk(elapsed < delay * nThreads - delay / 2.0,
+           "%u lookups of %.1f s took %.2f s", nThreads, delay, elapsed);
+    {
+        Guard G(stubMutex);
+        testOk(stubMaxActive > 1u, "%u lookups at the same time",
+               stubMaxActive);
+    }
+    setDelay(0.0);
+}
+
+void testHitJumpsQueue(ipAddrToAsciiEngine& engine)
+{
+    testDiag("Cached names do not wait behind lookups");
+
+    testOk1(lookup(engine, 2u) == "host-2.test:5064");
+
+    const unsigned nSlow = nThreads + 2u;
+    setDelay(0.5);
+
+    ipAddrToAsciiTransaction* trn[nSlow];
+    CB cb[nSlow];
+    for(unsigned i = 0u; i < nSlow; i++) {
+        trn[i] = &engine.createTransaction();
+        trn[i]->ipAddrToAscii(address(20u + i, 5064), cb[i]);
+    }
+    // let the workers take the first lookups
+    epicsThreadSleep(0.1);
+
+    ipAddrToAsciiTransaction& hitTrn(engine.createTransaction());
+    CB hit;
+    hitTrn.ipAddrToAscii(address(2u, 5064), hit);
+
+    bool ok = hit.complete.wait(5.0);
+    for(unsigned i = 0u; i < nSlow; i++) {
+        ok &= cb[i].complete.wait(5.0);
+        trn[i]->release();
+    }
+    hitTrn.release();
+    testOk1(ok);
+    testOk1(hit.name == "host-2.test:5064");
+    testOk(hit.order < cb[nThreads].order && hit.order < cb[nThreads + 1u].order,
+           "cached name (completion %u) came before queued lookups (%u, %u)",
+           hit.order, cb[nThreads].order, cb[nThreads + 1u].order);
+    setDelay(0.0);
+}
+
+} // namespace
+
+MAIN(ipAddrToAsciiCacheTest)
+{
+    testPlan(21);
+
+    // the lookup threads and cache are created by the first allocate()
+    char value[32];
+    epicsSnprintf(value, sizeof(value), "%u", nThreads);
+    epicsEnvSet("EPICS_IP_TO_ASCII_THREADS", value);
+    epicsSnprintf(value, sizeof(value), "%g", timeToLive);
+    epicsEnvSet("EPICS_IP_TO_ASCII_CACHE_TTL", value);
+    epicsEnvSet("EPICS_IP_TO_ASCII_NEG_CACHE_TTL", value);
+
+    ipAddrToAsciiEngine::setResolver(stubResolver);
+    ipAddrToAsciiEngine& engine(ipAddrToAsciiEngine::allocate());
+
+    testPositive(engine);
+    testNegative(engine);
+    testExpiry(engine);
+    testParallel(engine);
+    testHitJumpsQueue(engine);
+
+    engine.show(0u);
+    engine.release();
+    ipAddrToAsciiEngine::setResolver(0);
+
+#ifdef __linux__
+    ipAddrToAsciiEngine::cleanup();
+#endif
+
+    return testDone();
+}
@@ -0,0 +1,170 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/*
+ * Tests of the iocLogServer stream unpacking, with the stream split
+ * into reads at different places.
+ */
+
+#include <string.h>
+
+#include "logClient.h"
+#include "logDeframe.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#define STREAM_SIZE 12000
+
+static char stream[STREAM_SIZE];
+static size_t nStream;
+/* the text passed on, with '|' after each framed message */
+static char output[STREAM_SIZE];
+static size_t nOutput;
+
+static void collect(void *pPvt, const char *pText, size_t nText,
+    int endOfMessage)
+{
+    if (nOutput + nText + 1u > sizeof(output))
+        testAbort("output overflow");
+    memcpy(&output[nOutput], pText, nText);
+    nOutput += nText;
+    if (endOfMessage)
+        output[nOutput++] = '|';
+}
+
+static void put(const void *pData, size_t n)
+{
+    memcpy(&stream[nStream], pData, n);
+    nStream += n;
+}
+
+static void putFrame(const char *pText)
+{
+    size_t n = strlen(pText);
+    unsigned char hdr[4];
+
+    hdr[0] = (unsigned char) (n >> 24);
+    hdr[1] = (unsigned char) (n >> 16);
+    hdr[2] = (unsigned char) (n >> 8);
+    hdr[3] = (unsigned char) n;
+    put(hdr, sizeof(hdr));
+    put(pText, n);
+}
+
+/* unpack the stream in reads of at most 'size' after the first 'first' */
+static int unpack(size_t first, size_t size, const char *pExpect,
+    size_t nExpect)
+{
+    logDeframeState state;
+    size_t i = 0u;
+
+    logDeframeInit(&state);
+    nOutput = 0u;
+    if (first) {
+        logDeframe(&state, stream, first, collect, NULL);
+        i = first;
+    }
+    while (i < nStream) {
+        size_t n = nStream - i < size ? nStream - i : size;
+
+        logDeframe(&state, &stream[i], n, collect, NULL);
+        i += n;
+    }
+    return nOutput == nExpect && memcmp(output, pExpect, nExpect) == 0;
+}
+
+static void testPlain(void)
+{
+    static const char text[] = "first line\nsecond line\n";
+    size_t size, bad = 0u;
+
+    testDiag("Plain text");
+    nStream = 0u;
+    put(text, strlen(text));
+    for (size = 1u; size <= nStream; size++)
+        bad += !unpack(0u, size, text, strlen(text));
+    testOk(bad == 0u, "plain text passed on, %u of %u splits wrong",
+        (unsigned) bad, (unsigned) nStream);
+}
+
+static void testPartialMagic(void)
+{
+    size_t n;
+    int ok;
+
+    testDiag("Plain text which starts like the magic");
+
+    /* a partial match followed by a read longer than the server buffer */
+    nStream = 0u;
+    put(LOG_CLIENT_FRAME_MAGIC, 4u);
+    for (n = 0u; n < 5000u; n++)
+        stream[nStream++] = (char) ('a' + n % 26);
+    stream[nStream++] = '\n';
+    ok = unpack(4u, STREAM_SIZE, stream, nStream);
+    testOk(ok, "partial match then %u bytes in one read: %u passed on",
+        (unsigned) (nStream - 4u), (unsigned) nOutput);
+    ok = unpack(2u, 3u, stream, nStream);
+    testOk(ok, "partial match split across reads: %u passed on",
+        (unsigned) nOutput);
+    ok = unpack(0u, STREAM_SIZE, stream, nStream);
+    testOk(ok, "partial match in the same read: %u passed on",
+        (unsigned) nOutput);
+}
+
+static void testFramed(void)
+{
+    static const char expect[] = "one\n|two|three\nfour\n|";
+    size_t first, size, bad = 0u, nSplits = 0u;
+
+    testDiag("Framed messages");
+
+    nStream = 0u;
+    put(LOG_CLIENT_FRAME_MAGIC, LOG_CLIENT_FRAME_MAGIC_SIZE);
+    putFrame("one\n");
+    putFrame("");
+    putFrame("two");
+    putFrame("three\nfour\n");
+
+    testOk1(unpack(0u, STREAM_SIZE, expect, strlen(expect)));
+
+    /* frames split across reads after a partial match of the magic */
+    for (first = 1u; first < LOG_CLIENT_FRAME_MAGIC_SIZE; first++) {
+        for (size = 1u; size <= nStream; size++) {
+            bad += !unpack(first, size, expect, strlen(expect));
+            nSplits++;
+        }
+    }
+    testOk(bad == 0u, "%u of %u splits wrong", (unsigned) bad,
+        (unsigned) nSplits);
+}
+
+static void testLongFrame(void)
+{
+    static char text[6000];
+    size_t n;
+    int ok;
+
+    testDiag("Frame longer than the server buffer");
+
+    for (n = 0u; n < sizeof(text) - 1u; n++)
+        text[n] = (char) ('A' + n % 26);
+    nStream = 0u;
+    put(LOG_CLIENT_FRAME_MAGIC, LOG_CLIENT_FRAME_MAGIC_SIZE);
+    putFrame(text);
+    text[sizeof(text) - 1u] = '|';
+    ok = unpack(3u, 4096u, text, sizeof(text));
+    testOk(ok, "%u of %u bytes passed on", (unsigned) nOutput,
+        (unsigned) sizeof(text));
+}
+
+MAIN(logDeframeTest)
+{
+    testPlan(7);
+    testPlain();
+    testPartialMagic();
+    testFramed();
+    testLongFrame();
+    return testDone();
+}
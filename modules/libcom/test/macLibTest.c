@@ -40,6 +40,64 @@ static void check(const char *str, const char *expect)
         testDiag("Return status was %ld, expected %ld",
                  status, expect_error ? -expect_len : expect_len);
     }
+
+    /* a compiled template must give the same result */
+    {
+        MAC_TEMPLATE *tmpl = macCompileTemplate(str);
+        char toutput[MAC_SIZE] = {'\0'};
+        long tstatus = macExpandTemplate(h, tmpl, toutput, MAC_SIZE);
+
+        testOk(tstatus == status && !strcmp(toutput, output),
+               "template %s => %s", str, toutput);
+        if (tstatus != status)
+            testDiag("Template status was %ld, expected %ld", tstatus, status);
+        macDeleteTemplate(tmpl);
+    }
+}
+
+static void hashcheck(void)
+{
+    MAC_HANDLE *hh;
+    MAC_TEMPLATE *tmpl;
+    char name[20], value[20], output[MAC_SIZE];
+    int i, bad;
+
+    if (macCreateHandle(&hh, NULL))
+        testAbort("macCreateHandle() failed");
+
+    /* enough macros to use the hash index */
+    for (i = 0; i < 1000; i++) {
+        sprintf(name, "M%d", i);
+        sprintf(value, "v%d", i);
+        macPutValue(hh, name, value);
+    }
+    tmpl = macCompileTemplate("$(M0):$(M999):$(M500=x)");
+
+    bad = 0;
+    for (i = 0; i < 1000; i++) {
+        sprintf(name, "M%d", i);
+        sprintf(value, "v%d", i);
+        if (macGetValue(hh, name, output, sizeof(output)) < 0 ||
+            strcmp(output, value))
+            bad++;
+    }
+    testOk(bad == 0, "1000 macros found, %d bad", bad);
+
+    macExpandTemplate(hh, tmpl, output, sizeof(output));
+    testOk(!strcmp(output, "v0:v999:v500"), "hashed template => %s", output);
+
+    macPushScope(hh);
+    macPutValue(hh, "M999", "scoped");
+    macPutValue(hh, "M500", NULL);
+    macExpandTemplate(hh, tmpl, output, sizeof(output));
+    testOk(!strcmp(output, "v0:scoped:x"), "scoped template => %s", output);
+
+    macPopScope(hh);
+    macExpandTemplate(hh, tmpl, output, sizeof(output));
+    testOk(!strcmp(output, "v0:v999:x"), "popped template => %s", output);
+
+    macDeleteTemplate(tmpl);
+    macDeleteHandle(hh);
 }
 
 static void ovcheck(void)
@@ -66,7 +124,7 @@ static void ovcheck(void)
 
 MAIN(macLibTest)
 {
-    testPlan(93);
+    testPlan(190);
 
     if (macCreateHandle(&h, NULL))
         testAbort("macCreateHandle() failed");
@@ -207,6 +265,12 @@ MAIN(macLibTest)
     check("$(FOO)$(FOO1)", "!VAL2$(FOO1,undefined)");
     check("$(FOO1)$(FOO)", "!$(FOO1,undefined)VAL2");
 
+    macPutValue(h, "Q", "q");
+    check("\"$(Q)\"'$(Q)'\\$(Q)", " \"q\"'$(Q)'\\$(Q)");
+    check("\"'\"$(Q)'", " \"'\"q'");
+    check("$(Q=\"a\")$(Q,Q=\\))", " q)");
+    check("$(Q", " q");
+
     macPutValue(h, "BAR","${FOO}");
         /* FOO = "${BAR}" */
         /* BAR = "${FOO}" */
@@ -221,6 +285,7 @@ MAIN(macLibTest)
     check("${FOO}", "!$(BAR)");
 
     ovcheck();
+    hashcheck();
 
     return testDone();
 }